@@ -23,6 +23,8 @@ int ceph_arch_intel_ssse3 = 0;
 int ceph_arch_intel_sse3 = 0;
 int ceph_arch_intel_sse2 = 0;
 int ceph_arch_intel_aesni = 0;
+int ceph_arch_intel_avx2 = 0;
+int ceph_arch_intel_avx512bw = 0;
 
 #ifdef __x86_64__
 #include <cpuid.h>
@@ -36,6 +38,23 @@ int ceph_arch_intel_aesni = 0;
 #define CPUID_SSE3	(1)
 #define CPUID_SSE2	(1 << 26)
 #define CPUID_AESNI (1 << 25)
+#define CPUID_OSXSAVE	(1 << 27)
+
+/* leaf 7, subleaf 0, ebx */
+#define CPUID_AVX2	(1 << 5)
+#define CPUID_AVX512F	(1 << 16)
+#define CPUID_AVX512BW	(1 << 30)
+
+/* XCR0: the OS saves the xmm/ymm state and the opmask/zmm state */
+#define XCR0_YMM	0x06
+#define XCR0_ZMM	0xe6
+
+static unsigned long long xgetbv(void)
+{
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+}
 
 int ceph_arch_intel_probe(void)
 {
@@ -65,6 +84,18 @@ int ceph_arch_intel_probe(void)
   if ((ecx & CPUID_AESNI) != 0) {
           ceph_arch_intel_aesni = 1;
   }
+	if ((ecx & CPUID_OSXSAVE) != 0 && __get_cpuid_max(0, NULL) >= 7) {
+		unsigned long long xcr0 = xgetbv();
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		if ((ebx & CPUID_AVX2) != 0 &&
+		    (xcr0 & XCR0_YMM) == XCR0_YMM) {
+			ceph_arch_intel_avx2 = 1;
+		}
+		if ((ebx & CPUID_AVX512F) != 0 && (ebx & CPUID_AVX512BW) != 0 &&
+		    (xcr0 & XCR0_ZMM) == XCR0_ZMM) {
+			ceph_arch_intel_avx512bw = 1;
+		}
+	}
 
 	return 0;
 }
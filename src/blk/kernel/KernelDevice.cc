@@ -21,6 +21,7 @@
 
 #include "KernelDevice.h"
 #include "include/intarith.h"
+#include "include/mempool.h"
 #include "include/types.h"
 #include "include/compat.h"
 #include "include/stringify.h"
@@ -1039,7 +1040,7 @@ int KernelDevice::read(uint64_t off, uint64_t len, bufferlist *pbl,
 
   auto start1 = mono_clock::now();
 
-  auto p = ceph::buffer::ptr_node::create(ceph::buffer::create_small_page_aligned(len));
+  auto p = ceph::buffer::ptr_node::create(create_read_buffer(len));
   int r = ::pread(buffered ? fd_buffereds[WRITE_LIFE_NOT_SET] : fd_directs[WRITE_LIFE_NOT_SET],
 		  p->c_str(), len, off);
   auto age = cct->_conf->bdev_debug_aio_log_age;
@@ -1089,7 +1090,7 @@ int KernelDevice::aio_read(
     ioc->pending_aios.push_back(aio_t(ioc, fd_directs[WRITE_LIFE_NOT_SET]));
     ++ioc->num_pending;
     aio_t& aio = ioc->pending_aios.back();
-    bufferptr p = ceph::buffer::create_small_page_aligned(len);
+    bufferptr p = create_read_buffer(len);
     aio.bl.append(std::move(p));
     aio.bl.prepare_iov(&aio.iov);
     aio.preadv(off, len);
@@ -1106,6 +1107,16 @@ int KernelDevice::aio_read(
   return r;
 }
 
+ceph::unique_leakable_ptr<ceph::buffer::raw>
+KernelDevice::create_read_buffer(uint64_t len)
+{
+  if (cct->_conf->bdev_read_buffer_pool) {
+    return ceph::buffer::create_pooled(len, CEPH_PAGE_SIZE,
+				       mempool::mempool_buffer_anon);
+  }
+  return ceph::buffer::create_small_page_aligned(len);
+}
+
 int KernelDevice::direct_read_unaligned(uint64_t off, uint64_t len, char *buf)
 {
   uint64_t aligned_off = p2align(off, block_size);
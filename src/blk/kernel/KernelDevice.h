@@ -96,6 +96,7 @@ class KernelDevice : public BlockDevice {
   int _lock();
 
   int direct_read_unaligned(uint64_t off, uint64_t len, char *buf);
+  ceph::unique_leakable_ptr<ceph::buffer::raw> create_read_buffer(uint64_t len);
 
   // stalled aio debugging
   aio_list_t debug_queue;
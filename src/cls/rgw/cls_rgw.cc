@@ -459,6 +459,13 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
   // between wanting to return the requested # of entries, but not
   // wanting to slow down this op with too many omap reads
   constexpr int max_attempts = 8;
+  // when a call to get_obj_vals ended in the middle of a common
+  // prefix, the keys right after that prefix most likely begin the
+  // next one; read just a few of them rather than a full batch that
+  // would mostly get collapsed, and don't count those reads against
+  // max_attempts, as long as they don't add up to more keys than the
+  // full attempts could have read
+  constexpr uint32_t prefix_skip_entries = 16;
 
   auto iter = in->cbegin();
 
@@ -496,6 +503,8 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
   bool done = false;   // whether we need to keep calling get_obj_vals
   bool more = true;    // output parameter of get_obj_vals
   bool has_delimiter = !op.delimiter.empty();
+  bool skipped_prefix = false; // last get_obj_vals ended in a common prefix
+  uint64_t skip_budget = uint64_t(max_attempts) * op.num_entries;
 
   if (has_delimiter &&
       boost::algorithm::ends_with(start_after_key, op.delimiter)) {
@@ -504,16 +513,23 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
     start_after_key = cls_rgw_after_delim(start_after_key);
   }
 
-  for (int attempt = 0;
-       attempt < max_attempts &&
+  int attempt = 0;
+  while (attempt < max_attempts &&
 	 more &&
 	 !done &&
-	 name_entry_map.size() < op.num_entries;
-       ++attempt) {
+	 name_entry_map.size() < op.num_entries) {
+    uint32_t max_entries = op.num_entries - name_entry_map.size();
+    if (skipped_prefix && skip_budget >= prefix_skip_entries) {
+      max_entries = std::min(max_entries, prefix_skip_entries);
+      skip_budget -= prefix_skip_entries;
+    } else {
+      ++attempt;
+    }
+    skipped_prefix = false;
+
     map<string, bufferlist> keys;
     rc = get_obj_vals(hctx, start_after_key, op.filter_prefix,
-		      op.num_entries - name_entry_map.size(),
-		      &keys, &more);
+		      max_entries, &keys, &more);
     if (rc < 0) {
       return rc;
     }
@@ -600,6 +616,7 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 	  // advance to past this subdirectory, but then back up one,
 	  // so the loop increment will put us in the right place
 	  kiter = keys.lower_bound(start_after_key);
+	  skipped_prefix = (kiter == keys.end());
 	  --kiter;
 
           continue;
@@ -618,7 +635,7 @@ int rgw_bucket_list(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
 		int(name_entry_map.size()));
       }
     } // for (auto kiter...
-  } // for (int attempt...
+  } // while (attempt...
 
   ret.is_truncated = more && !done;
   encode(ret, *out);
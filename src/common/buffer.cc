@@ -277,6 +277,204 @@ static ceph::spinlock debug_lock;
     }
   };
 
+  /*
+   * raw_pooled data comes from size-classed slabs that are never handed
+   * back to the heap.  Free slots are cached per thread and spill over to
+   * a shared depot in batches, so a buffer that is allocated on one
+   * thread (e.g. the messenger) and released on another (e.g. an OSD
+   * worker) still finds its way back to the allocating side.
+   */
+  namespace {
+    constexpr unsigned POOL_MIN_SHIFT = 8;   // 256 bytes
+    constexpr unsigned POOL_MAX_SHIFT = 16;  // 64 KiB
+    constexpr unsigned POOL_CLASSES = POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1;
+    constexpr size_t POOL_SLAB_BYTES = 256 * 1024;
+    constexpr size_t POOL_THREAD_CACHE_BYTES = 128 * 1024; // per class
+    constexpr unsigned POOL_THREAD_CACHE_MIN = 4;
+
+    struct pool_slot;
+  }
+
+  class buffer::raw_pooled : public buffer::raw {
+    size_t alignment;
+  public:
+    raw_pooled(char *dataptr, unsigned l, unsigned align, int mempool)
+      : raw(dataptr, l, mempool),
+	alignment(align) {}
+    raw* clone_empty() override {
+      return create_pooled(len, alignment, mempool).release();
+    }
+    static void operator delete(void *ptr);
+  };
+
+  namespace {
+    struct pool_slot {
+      std::aligned_storage_t<sizeof(buffer::raw_pooled),
+			     alignof(buffer::raw_pooled)> raw;
+      char *data;
+      pool_slot *next;
+      unsigned cls;
+    };
+
+    struct pool_list {
+      pool_slot *head = nullptr;
+      unsigned count = 0;
+
+      void push(pool_slot *s) {
+	s->next = head;
+	head = s;
+	++count;
+      }
+      pool_slot *pop() {
+	pool_slot *s = head;
+	head = s->next;
+	--count;
+	return s;
+      }
+      /// move up to n slots from the front of this list to another
+      void move_to(pool_list& o, unsigned n) {
+	while (n-- && head) {
+	  o.push(pop());
+	}
+      }
+    };
+
+    struct pool_depot {
+      ceph::spinlock lock[POOL_CLASSES];
+      pool_list free[POOL_CLASSES];
+      std::atomic<size_t> slab_bytes = {0};
+      size_t max_slab_bytes;
+
+      pool_depot() {
+	int mb = get_env_int("CEPH_BUFFER_POOL_MAX_MB");
+	max_slab_bytes = (mb > 0 ? mb : 128) * (1ull << 20);
+      }
+    };
+
+    pool_depot& get_pool_depot() {
+      // never destroyed: buffers may be released during static destruction
+      static pool_depot *depot = new pool_depot;
+      return *depot;
+    }
+
+    inline size_t pool_class_size(unsigned cls) {
+      return size_t(1) << (cls + POOL_MIN_SHIFT);
+    }
+
+    inline unsigned pool_thread_cache_max(unsigned cls) {
+      return std::max<unsigned>(POOL_THREAD_CACHE_MIN,
+				POOL_THREAD_CACHE_BYTES / pool_class_size(cls));
+    }
+
+    struct pool_thread_cache {
+      pool_list free[POOL_CLASSES];
+      ~pool_thread_cache();
+    };
+
+    // the cache itself is reached through a trivially destructible
+    // pointer so that buffers released late in thread exit, after the
+    // cache has been flushed, go straight to the depot.
+    thread_local pool_thread_cache *pool_tcache = nullptr;
+    thread_local bool pool_tcache_gone = false;
+
+    pool_thread_cache::~pool_thread_cache() {
+      auto& depot = get_pool_depot();
+      for (unsigned i = 0; i < POOL_CLASSES; ++i) {
+	std::lock_guard l(depot.lock[i]);
+	free[i].move_to(depot.free[i], free[i].count);
+      }
+      pool_tcache = nullptr;
+      pool_tcache_gone = true;
+    }
+
+    pool_thread_cache *get_pool_tcache() {
+      if (!pool_tcache && !pool_tcache_gone) {
+	static thread_local pool_thread_cache cache;
+	pool_tcache = &cache;
+      }
+      return pool_tcache;
+    }
+
+    /// carve a new slab for cls into out; false if over the pool limit
+    bool pool_new_slab(unsigned cls, pool_list& out) {
+      auto& depot = get_pool_depot();
+      size_t size = pool_class_size(cls);
+      size_t bytes = std::max(POOL_SLAB_BYTES, size * 4);
+      if (depot.slab_bytes.fetch_add(bytes) + bytes > depot.max_slab_bytes) {
+	depot.slab_bytes -= bytes;
+	return false;
+      }
+      char *data = nullptr;
+      if (::posix_memalign((void**)(void*)&data, CEPH_PAGE_SIZE, bytes)) {
+	depot.slab_bytes -= bytes;
+	return false;
+      }
+      unsigned n = bytes / size;
+      auto slots = new pool_slot[n];
+      mempool::get_pool(mempool::mempool_buffer_meta).adjust_count(
+	n, n * sizeof(pool_slot));
+      for (unsigned i = 0; i < n; ++i) {
+	slots[i].data = data + i * size;
+	slots[i].cls = cls;
+	out.push(&slots[i]);
+      }
+      return true;
+    }
+
+    pool_slot *pool_get(unsigned cls) {
+      auto tc = get_pool_tcache();
+      if (tc && tc->free[cls].count) {
+	return tc->free[cls].pop();
+      }
+      auto& depot = get_pool_depot();
+      pool_list batch;
+      {
+	std::lock_guard l(depot.lock[cls]);
+	depot.free[cls].move_to(batch, pool_thread_cache_max(cls) / 2 + 1);
+      }
+      if (!batch.count && !pool_new_slab(cls, batch)) {
+	return nullptr;
+      }
+      pool_slot *s = batch.pop();
+      if (batch.count) {
+	if (tc) {
+	  batch.move_to(tc->free[cls], batch.count);
+	} else {
+	  std::lock_guard l(depot.lock[cls]);
+	  batch.move_to(depot.free[cls], batch.count);
+	}
+      }
+      return s;
+    }
+
+    void pool_put(pool_slot *s) {
+      unsigned cls = s->cls;
+      auto tc = get_pool_tcache();
+      auto& depot = get_pool_depot();
+      if (!tc) {
+	std::lock_guard l(depot.lock[cls]);
+	depot.free[cls].push(s);
+	return;
+      }
+      auto& mine = tc->free[cls];
+      mine.push(s);
+      unsigned max = pool_thread_cache_max(cls);
+      if (mine.count > max) {
+	// hand back half so a thread that only frees does not hoard
+	std::lock_guard l(depot.lock[cls]);
+	mine.move_to(depot.free[cls], max / 2);
+      }
+    }
+  }
+
+  void buffer::raw_pooled::operator delete(void *ptr) {
+    pool_put(reinterpret_cast<pool_slot*>(ptr));
+  }
+
+  size_t buffer::get_pool_slab_bytes() {
+    return get_pool_depot().slab_bytes;
+  }
+
   ceph::unique_leakable_ptr<buffer::raw> buffer::copy(const char *c, unsigned len) {
     auto r = buffer::create_aligned(len, sizeof(size_t));
     memcpy(r->get_data(), c, len);
@@ -345,6 +543,27 @@ static ceph::spinlock debug_lock;
 				     mempool::mempool_buffer_anon);
   }
 
+  ceph::unique_leakable_ptr<buffer::raw> buffer::create_pooled(
+    unsigned len, unsigned align, int mempool)
+  {
+    unsigned shift = POOL_MIN_SHIFT;
+    while ((size_t(1) << shift) < std::max(len, align)) {
+      ++shift;
+    }
+    // slabs are page aligned, so a slot is aligned to its size up to a page
+    if (shift > POOL_MAX_SHIFT ||
+	align > std::min<size_t>(size_t(1) << shift, CEPH_PAGE_SIZE)) {
+      return create_aligned_in_mempool(len, align, mempool);
+    }
+    pool_slot *s = pool_get(shift - POOL_MIN_SHIFT);
+    if (!s) {
+      return create_aligned_in_mempool(len, align, mempool);
+    }
+    static_assert(offsetof(pool_slot, raw) == 0);
+    return ceph::unique_leakable_ptr<buffer::raw>(
+      new (&s->raw) raw_pooled(s->data, len, align, mempool));
+  }
+
   ceph::unique_leakable_ptr<buffer::raw> buffer::create_page_aligned(unsigned len) {
     return create_aligned(len, CEPH_PAGE_SIZE);
   }
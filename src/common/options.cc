@@ -974,6 +974,22 @@ std::vector<Option> get_global_options() {
     .set_default(0)
     .set_description("Size of TCP socket receive buffer"),
 
+    Option("ms_tcp_zerocopy", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Send large payloads with MSG_ZEROCOPY (ms_type=async+posix, Linux only)")
+    .set_long_description("The kernel transmits straight from the message buffers "
+                          "instead of copying them into the socket. The buffers stay "
+                          "referenced until the kernel reports completion on the "
+                          "socket's error queue.")
+    .add_see_also("ms_tcp_zerocopy_min_size"),
+
+    Option("ms_tcp_zerocopy_min_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(64_K)
+    .set_description("Smallest send that uses MSG_ZEROCOPY")
+    .set_long_description("Pinning pages and handling completion notifications costs "
+                          "more than copying for small sends.")
+    .add_see_also("ms_tcp_zerocopy"),
+
     Option("ms_tcp_prefetch_max_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
     .set_default(4_K)
     .set_description("Maximum amount of data to prefetch out of the socket receive buffer"),
@@ -1019,6 +1035,12 @@ std::vector<Option> get_global_options() {
     .set_default(100_M)
     .set_description("Limit messages that are read off the network but still being processed"),
 
+    Option("ms_rx_buffer_pool", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Allocate received frame segments from the pooled buffer allocator")
+    .set_long_description("Segments up to 64 KiB are served from per-thread cached, size-classed slabs instead of the heap.  Slab memory is retained by the process, up to CEPH_BUFFER_POOL_MAX_MB (default 128) in total.")
+    .add_see_also("bdev_read_buffer_pool"),
+
     Option("ms_bind_ipv4", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(true)
     .set_description("Bind servers to IPv4 address(es)")
@@ -1226,6 +1248,12 @@ std::vector<Option> get_global_options() {
     .set_default("ib")
     .set_description(""),
 
+    Option("ms_async_uring_queue_depth", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(256)
+    .set_min_max(8, 32768)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Submission queue depth of the io_uring owned by each worker (ms_type=async+uring)"),
+
     Option("ms_dpdk_port_id", Option::TYPE_INT, Option::LEVEL_ADVANCED)
     .set_default(0)
     .set_description(""),
@@ -1392,6 +1420,14 @@ std::vector<Option> get_global_options() {
     .add_service("mon")
     .set_description("The minimum amount of bytes to be kept mapped in memory for osd monitor caches."),
 
+    Option("mon_osd_cache_prefill", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_flag(Option::FLAG_RUNTIME)
+    .add_service("mon")
+    .set_description("encode each new OSDMap for the feature sets of recent subscribers in the background")
+    .set_long_description("When a new osdmap epoch is committed, the full and incremental maps are encoded on the monitor's cpu threads for every feature set a subscriber has asked for recently, so that sending them does not involve encoding. A map that is requested before its prefill ran is encoded by the requester instead, and nothing is prefilled when mon_cpu_threads is 0.")
+    .add_see_also("mon_cpu_threads"),
+
     Option("mon_memory_target", Option::TYPE_SIZE, Option::LEVEL_BASIC)
     .set_default(2_G)
     .set_flag(Option::FLAG_RUNTIME)
@@ -2474,6 +2510,18 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("objecter_prebuild_osdmaps", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Decode and apply incoming OSD maps before taking the objecter map lock")
+    .set_long_description("The objecter builds each new OSD map epoch on a private copy while holding its map lock shared, so that op submission is only held up while the finished maps are swapped in and outstanding ops are rescanned, not while maps are decoded."),
+
+    Option("objecter_mclock_service_tracker", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Send dmclock distributed QoS tags with each op")
+    .set_long_description("Track the replies received from each OSD and send the dmclock delta/rho tags along with each op, so that OSDs running the mclock scheduler enforce a client's reservation and limit across the whole cluster rather than per OSD.")
+    .add_see_also("osd_op_queue"),
+
     Option("filer_max_purge_ops", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(10)
     .set_description("Max in-flight operations for purging a striped range (e.g., MDS journal)"),
@@ -2968,6 +3016,18 @@ std::vector<Option> get_global_options() {
     .set_description("")
     .add_see_also("osd_op_num_shards"),
 
+    Option("osd_op_batch_max", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_min_max(1, 64)
+    .set_description("Maximum number of consecutive ops for the same PG a shard "
+                     "worker runs under a single PG lock acquisition")
+    .set_long_description("Only ops the scheduler hands out back to back for the "
+                          "same PG are batched, so op ordering and QoS are "
+                          "unchanged. Replica writes in a batch are submitted to "
+                          "the object store as a single transaction group. "
+                          "1 disables batching.")
+    .add_see_also("osd_op_num_threads_per_shard"),
+
     Option("osd_skip_data_digest", Option::TYPE_BOOL, Option::LEVEL_DEV)
     .set_default(false)
     .set_description("Do not store full-object checksums if the backend (bluestore) does its own checksums.  Only usable with all BlueStore OSDs."),
@@ -3002,7 +3062,7 @@ std::vector<Option> get_global_options() {
     Option("osd_mclock_scheduler_client_lim", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(999999)
     .set_description("IO limit for each client (default) over reservation")
-    .set_long_description("Only considered for osd_op_queue = mClockScheduler")
+    .set_long_description("Only considered for osd_op_queue = mClockScheduler. Pools may override the client defaults with the mclock_client_res, mclock_client_wgt and mclock_client_lim pool options.")
     .add_see_also("osd_op_queue"),
 
     Option("osd_mclock_scheduler_background_recovery_res", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
@@ -3054,6 +3114,32 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("osd_ec_parity_delta_writes", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_flag(Option::FLAG_RUNTIME)
+    .set_description("Write small partial-stripe overwrites of erasure coded objects as parity deltas")
+    .set_long_description("Instead of reading and re-encoding whole stripes, read only the data chunks being overwritten and send the coding shards the delta to fold into their chunks. Only used by plugins that support it (jerasure reed_sol_van and reed_sol_r6_op, isa), when the PG is clean and at most half the data chunks of each stripe change. Requires require_osd_release >= pacific."),
+
+    Option("osd_ec_stripe_cache", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_flag(Option::FLAG_STARTUP)
+    .add_see_also({"osd_ec_stripe_cache_size", "osd_ec_stripe_cache_ratio"})
+    .set_description("Cache decoded stripes of erasure coded objects on the primary")
+    .set_long_description("Keep the content of recently read and written stripes of erasure coded objects so that later reads of them are served without reading and decoding shards. The cache is shared by all PGs of the OSD and dropped for a PG whenever its interval changes."),
+
+    Option("osd_ec_stripe_cache_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(64_M)
+    .set_flag(Option::FLAG_STARTUP)
+    .add_see_also("osd_ec_stripe_cache")
+    .set_description("Size of the EC stripe cache when the object store does not autotune its caches"),
+
+    Option("osd_ec_stripe_cache_ratio", Option::TYPE_FLOAT, Option::LEVEL_DEV)
+    .set_default(.05)
+    .set_flag(Option::FLAG_STARTUP)
+    .add_see_also({"osd_ec_stripe_cache", "bluestore_cache_autotune"})
+    .set_description("Ratio of autotuned cache memory given to the EC stripe cache")
+    .set_long_description("Relative to bluestore_cache_kv_ratio, bluestore_cache_meta_ratio and bluestore_cache_data_ratio when memory left over at each priority is shared out among the caches."),
+
     // Only use clone_overlap for recovery if there are fewer than
     // osd_recover_clone_overlap_limit entries in the overlap set
     Option("osd_recover_clone_overlap_limit", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
@@ -3512,6 +3598,15 @@ std::vector<Option> get_global_options() {
     .add_see_also("osd_min_pg_log_entries")
     .add_see_also("osd_max_pg_log_entries"),
 
+    Option("osd_pg_log_chunk_entries", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_min_max(0, 1024)
+    .set_description("number of PG log entries stored under one omap key")
+    .set_long_description("When non-zero, PG log entries are persisted in chunks covering this many consecutive versions, and trimming removes whole chunks instead of one key per entry. Entries of the newest chunk are written under their own keys and folded into a chunk key once the chunk is complete. This cuts the number of keys and deletion tombstones the log leaves in the key/value store, at the cost of writing each entry twice. 0 stores one key per entry, which is the only layout older releases can read. Logs are converted the next time they are written after this changes.")
+    .add_service("osd")
+    .add_see_also("osd_pg_log_trim_min")
+    .add_see_also("osd_max_pg_log_entries"),
+
     Option("osd_op_complaint_time", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(30)
     .set_description(""),
@@ -3795,6 +3890,11 @@ std::vector<Option> get_global_options() {
     .set_default(1048576)
     .set_description("The number of keys required to invoke DeleteRange when deleting muliple keys."),
 
+    Option("rocksdb_iterator_scan_readahead", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(0)
+    .set_description("Readahead size for iterators that scan a range of keys, such as omap listing")
+    .set_long_description("0 lets RocksDB pick: it starts with a small readahead once an iterator reads sequentially and grows it as the scan goes on."),
+
     Option("rocksdb_bloom_bits_per_key", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
     .set_default(20)
     .set_description("Number of bits per key to use for RocksDB's bloom filters.")
@@ -4092,6 +4192,12 @@ std::vector<Option> get_global_options() {
     Option("bdev_async_discard", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description(""),
+
+    Option("bdev_read_buffer_pool", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Allocate read buffers from the pooled buffer allocator")
+    .set_long_description("Page aligned read buffers up to 64 KiB are served from per-thread cached, size-classed slabs instead of posix_memalign.  Slab memory is retained by the process, up to CEPH_BUFFER_POOL_MAX_MB (default 128) in total.")
+    .add_see_also("ms_rx_buffer_pool"),
     
     Option("bdev_flock_retry_interval", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(0.1)
@@ -4141,6 +4247,11 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description(""),
 
+    Option("bluefs_compact_log_async_thread", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(true)
+    .set_description("Run async metadata log compaction in a dedicated thread")
+    .set_long_description("When set, the thread that notices the bluefs log needs compaction (usually a rocksdb WAL fsync) only wakes a background thread instead of compacting the log itself.  Has no effect if bluefs_compact_log_sync is set."),
+
     Option("bluefs_buffered_io", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
     .set_default(false)
     .set_description("Enabled buffered IO for bluefs reads.")
@@ -4434,6 +4545,20 @@ std::vector<Option> get_global_options() {
     .set_enum_allowed({"2q", "lru"})
     .set_description("Cache replacement algorithm"),
 
+    Option("bluestore_onode_cache_type", Option::TYPE_STR, Option::LEVEL_ADVANCED)
+    .set_default("lru")
+    .set_enum_allowed({"lru", "compact"})
+    .set_description("Onode cache replacement algorithm")
+    .set_long_description("With 'compact', onodes trimmed from the lru are kept in their encoded (on-disk) form, which is much smaller than a decoded onode, and decoded again on access instead of being read from the kv store.")
+    .add_see_also("bluestore_onode_cache_compact_ratio"),
+
+    Option("bluestore_onode_cache_compact_ratio", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
+    .set_default(.25)
+    .set_min_max(0.0, 1.0)
+    .set_description("Ratio of the metadata cache used for encoded onodes")
+    .set_long_description("Only used when bluestore_onode_cache_type is 'compact'.")
+    .add_see_also("bluestore_onode_cache_type"),
+
     Option("bluestore_2q_cache_kin_ratio", Option::TYPE_FLOAT, Option::LEVEL_DEV)
     .set_default(.5)
     .set_description("2Q paper suggests .5"),
@@ -4489,9 +4614,9 @@ std::vector<Option> get_global_options() {
 
     Option("bluestore_allocator", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("hybrid")
-    .set_enum_allowed({"bitmap", "stupid", "avl", "hybrid", "zoned"})
+    .set_enum_allowed({"bitmap", "stupid", "avl", "hybrid", "sharded", "zoned"})
     .set_description("Allocator policy")
-    .set_long_description("Allocator to use for bluestore.  Stupid should only be used for testing."),
+    .set_long_description("Allocator to use for bluestore.  Stupid should only be used for testing. Sharded splits the device into regions each managed by a hybrid allocator with its own lock, for devices under many concurrent writes."),
 
     Option("bluestore_freelist_blocks_per_key", Option::TYPE_SIZE, Option::LEVEL_DEV)
     .set_default(128)
@@ -4579,6 +4704,12 @@ std::vector<Option> get_global_options() {
     .set_default(false)
     .set_description("Try to submit metadata transaction to rocksdb in queuing thread context"),
 
+    Option("bluestore_kv_sync_shards", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(1)
+    .set_min_max(1, 32)
+    .set_description("Number of threads used by the kv sync thread to submit metadata transactions to rocksdb")
+    .set_long_description("Queued transactions are partitioned by sequencer (collection) across this many submit threads, preserving per-sequencer order; all of them are then made durable by a single shared sync commit.  1 submits everything from the kv sync thread itself."),
+
     Option("bluestore_fsck_read_bytes_cap", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
     .set_default(64_M)
     .set_flag(Option::FLAG_RUNTIME)
@@ -4747,6 +4878,11 @@ std::vector<Option> get_global_options() {
     .set_default(5)
     .set_description("log omap iteration operation if it's slower than this age (seconds)"),
 
+    Option("bluestore_omap_scan_fill_cache", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_description("Let omap listings fill the kv block cache")
+    .set_long_description("Listing a large omap, e.g. an rgw bucket index shard, reads each block once. By default such scans bypass the block cache so that they do not evict the blocks that point lookups keep coming back to."),
+
     Option("bluestore_log_collection_list_age", Option::TYPE_FLOAT, Option::LEVEL_ADVANCED)
     .set_default(60)
     .set_description("log collection list operation if it's slower than this age (seconds)"),
@@ -4781,6 +4917,19 @@ std::vector<Option> get_global_options() {
     .set_default(64_M)
     .set_description("Maximum RAM hybrid allocator should use before enabling bitmap supplement"),
 
+    Option("bluestore_allocator_shards", Option::TYPE_UINT, Option::LEVEL_DEV)
+    .set_default(16)
+    .set_min(1)
+    .add_see_also("bluestore_allocator")
+    .set_description("Number of independently locked regions the sharded allocator splits a device into")
+    .set_long_description("Regions are at least 1 GiB, so small devices get fewer. bluestore_hybrid_alloc_mem_cap is split evenly between the regions."),
+
+    Option("bluestore_alloc_snapshot", Option::TYPE_BOOL, Option::LEVEL_ADVANCED)
+    .set_default(false)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Save the allocator state on clean shutdown and load it on startup instead of scanning the freelist")
+    .set_long_description("The snapshot is kept in BlueFS and is only used if nothing has been written to the DB since it was saved; otherwise the freelist is scanned as usual. Requires BlueFS."),
+
     Option("bluestore_volume_selection_policy", Option::TYPE_STR, Option::LEVEL_DEV)
     .set_default("use_some_extra")
     .set_enum_allowed({ "rocksdb_original", "use_some_extra", "fit_to_fast" })
@@ -5589,6 +5738,18 @@ std::vector<Option> get_rgw_options() {
     .set_long_description("The window size may be dynamically adjusted, but will not surpass this value.")
     .add_see_also({"rgw_put_obj_min_window_size", "rgw_max_chunk_size"}),
 
+    Option("rgw_put_obj_transform_threads", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(4)
+    .set_flag(Option::FLAG_STARTUP)
+    .set_description("Number of threads compressing and encrypting uploads")
+    .set_long_description(
+        "Compression and encryption of uploaded data run on a pool of this many "
+        "threads, so that several chunks of an object are processed at once while "
+        "earlier ones are written to RADOS. At most rgw_put_obj_min_window_size "
+        "bytes of an object are processed at a time. With 0, the data is "
+        "compressed and encrypted by the thread handling the request.")
+    .add_see_also({"rgw_put_obj_min_window_size"}),
+
     Option("rgw_max_put_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
     .set_default(5_G)
     .set_description("Max size (in bytes) of regular (non multi-part) object upload.")
@@ -5683,8 +5844,22 @@ std::vector<Option> get_rgw_options() {
     .set_default(10000)
     .set_description("Max number of items in RGW metadata cache.")
     .set_long_description(
-        "When full, the RGW metadata cache evicts least recently used entries.")
-    .add_see_also("rgw_cache_enabled"),
+        "When full, the RGW metadata cache evicts entries that were not used "
+        "recently, approximating LRU with the CLOCK algorithm.")
+    .add_see_also({"rgw_cache_enabled", "rgw_cache_shards"}),
+
+    Option("rgw_cache_shards", Option::TYPE_UINT, Option::LEVEL_ADVANCED)
+    .set_default(16)
+    .set_min(1)
+    .set_description("Number of shards of the RGW metadata cache.")
+    .set_long_description(
+        "The metadata cache is partitioned by hash of the object name into "
+        "this many shards, each with its own lock and an equal share of "
+        "rgw_cache_lru_size, so that concurrent requests looking up "
+        "different users and buckets don't contend with each other. The "
+        "caches of decoded bucket and user info chained to it are "
+        "partitioned into as many shards.")
+    .add_see_also("rgw_cache_lru_size"),
 
     Option("rgw_socket_path", Option::TYPE_STR, Option::LEVEL_ADVANCED)
     .set_default("")
@@ -6479,7 +6654,28 @@ std::vector<Option> get_rgw_options() {
     Option("rgw_get_obj_window_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
     .set_default(16_M)
     .set_description("RGW object read window size")
-    .set_long_description("The window size in bytes for a single object read request"),
+    .set_long_description(
+        "The initial window size in bytes for a single object read request. The "
+        "window is then adjusted so that the reads in flight cover the RADOS read "
+        "latency at the rate the client accepts data, between "
+        "rgw_get_obj_max_req_size and rgw_get_obj_max_window_size.")
+    .add_see_also({"rgw_get_obj_max_window_size", "rgw_get_obj_window_budget"}),
+
+    Option("rgw_get_obj_max_window_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(128_M)
+    .set_description("RGW object read maximum window size")
+    .set_long_description(
+        "The largest window size in bytes a single object read request can grow to.")
+    .add_see_also({"rgw_get_obj_window_size", "rgw_get_obj_window_budget"}),
+
+    Option("rgw_get_obj_window_budget", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
+    .set_default(1_G)
+    .set_description("RGW object read window budget")
+    .set_long_description(
+        "The total size in bytes of the windows of all concurrent object read "
+        "requests. A request only grows its window past rgw_get_obj_max_req_size "
+        "when the budget allows. 0 means no limit.")
+    .add_see_also({"rgw_get_obj_window_size", "rgw_get_obj_max_window_size"}),
 
     Option("rgw_get_obj_max_req_size", Option::TYPE_SIZE, Option::LEVEL_ADVANCED)
     .set_default(4_M)
@@ -9,6 +9,7 @@
 #include <boost/icl/interval_map.hpp>
 #include <boost/algorithm/string/join.hpp>
 
+#include "common/ceph_time.h"
 #include "common/SubProcess.h"
 #include "common/fork_function.h"
 
@@ -729,6 +730,83 @@ int CrushTester::test()
   return 0;
 }
 
+int CrushTester::benchmark()
+{
+  if (min_rule < 0 || max_rule < 0) {
+    min_rule = 0;
+    max_rule = crush.get_max_rules() - 1;
+  }
+  if (min_x < 0 || max_x < 0) {
+    min_x = 0;
+    max_x = 1023;
+  }
+
+  vector<__u32> weight;
+  for (int o = 0; o < crush.get_max_devices(); o++) {
+    if (device_weight.count(o)) {
+      weight.push_back(device_weight[o]);
+    } else if (crush.check_item_present(o)) {
+      weight.push_back(0x10000);
+    } else {
+      weight.push_back(0);
+    }
+  }
+  adjust_weights(weight);
+
+  vector<int> xs;
+  for (int x = min_x; x <= max_x; x++) {
+    int real_x = x;
+    if (pool_id != -1) {
+      real_x = crush_hash32_2(CRUSH_HASH_RJENKINS1, x, (uint32_t)pool_id);
+    }
+    xs.push_back(real_x);
+  }
+
+  int ret = 0;
+  for (int r = min_rule; r < crush.get_max_rules() && r <= max_rule; r++) {
+    if (!crush.rule_exists(r)) {
+      continue;
+    }
+    if (ruleset >= 0 &&
+	crush.get_rule_mask_ruleset(r) != ruleset) {
+      continue;
+    }
+    int minr = min_rep, maxr = max_rep;
+    if (min_rep < 0 || max_rep < 0) {
+      minr = crush.get_rule_mask_min_size(r);
+      maxr = crush.get_rule_mask_max_size(r);
+    }
+    for (int nr = minr; nr <= maxr; nr++) {
+      vector<vector<int>> single(xs.size());
+      auto start = ceph::mono_clock::now();
+      for (size_t i = 0; i < xs.size(); i++) {
+	crush.do_rule(r, xs[i], single[i], nr, weight, 0);
+      }
+      std::chrono::duration<double> single_time =
+	ceph::mono_clock::now() - start;
+
+      vector<vector<int>> batch;
+      start = ceph::mono_clock::now();
+      crush.do_rule_batch(r, xs, &batch, nr, weight, 0);
+      std::chrono::duration<double> batch_time =
+	ceph::mono_clock::now() - start;
+
+      cout << "rule " << r << " (" << crush.get_rule_name(r)
+	   << ") num_rep " << nr << ": " << xs.size() << " mappings, "
+	   << (uint64_t)(xs.size() / single_time.count())
+	   << " mappings/sec, "
+	   << (uint64_t)(xs.size() / batch_time.count())
+	   << " mappings/sec batched" << std::endl;
+      if (batch != single) {
+	err << "rule " << r << " num_rep " << nr
+	    << ": batched mappings differ" << std::endl;
+	ret = -EINVAL;
+      }
+    }
+  }
+  return ret;
+}
+
 int CrushTester::compare(CrushWrapper& crush2)
 {
   if (min_rule < 0 || max_rule < 0) {
@@ -359,6 +359,11 @@ public:
   void check_overlapped_rules() const;
   int test();
   int test_with_fork(int timeout);
+  /**
+   * time the mapping of the --test inputs one at a time and in one
+   * batch, and check that both give the same mappings
+   */
+  int benchmark();
 
   int compare(CrushWrapper& other);
 };
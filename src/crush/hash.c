@@ -120,6 +120,37 @@ __u32 crush_hash32_3(int type, __u32 a, __u32 b, __u32 c)
 	}
 }
 
+void crush_hash32_3_batch(int type, __u32 a, const __s32 *b, __u32 c,
+			  __u32 *out, unsigned int n)
+{
+	unsigned int i;
+
+	switch (type) {
+	case CRUSH_HASH_RJENKINS1:
+		/*
+		 * crush_hash32_rjenkins1_3() spelled out: no branches and
+		 * only 32-bit add/sub/xor/shift, so the compiler vectorizes
+		 * the loop across items
+		 */
+		for (i = 0; i < n; i++) {
+			__u32 ta = a, tb = b[i], tc = c;
+			__u32 hash = crush_hash_seed ^ ta ^ tb ^ tc;
+			__u32 x = 231232;
+			__u32 y = 1232;
+			crush_hashmix(ta, tb, hash);
+			crush_hashmix(tc, x, hash);
+			crush_hashmix(y, ta, hash);
+			crush_hashmix(tb, x, hash);
+			crush_hashmix(y, tc, hash);
+			out[i] = hash;
+		}
+		break;
+	default:
+		for (i = 0; i < n; i++)
+			out[i] = 0;
+	}
+}
+
 __u32 crush_hash32_4(int type, __u32 a, __u32 b, __u32 c, __u32 d)
 {
 	switch (type) {
@@ -78,6 +78,23 @@ extern int crush_do_rule(const struct crush_map *map,
 			 const __u32 *weights, int weight_max,
 			 void *cwin, const struct crush_choose_arg *choose_args);
 
+/** @ingroup API
+ *
+ * Like crush_do_rule(), for each of the __count__ inputs in __x__.
+ * The result for x[i] is stored at __result__ + i * __result_max__ and
+ * its size in __result_len__[i].  __cwin__ is initialized once by the
+ * caller and reused for every input.
+ *
+ * @return the number of inputs mapped
+ */
+extern int crush_do_rule_batch(const struct crush_map *map,
+			       int ruleno,
+			       const int *x, int count,
+			       int *result, int result_max, int *result_len,
+			       const __u32 *weights, int weight_max,
+			       void *cwin,
+			       const struct crush_choose_arg *choose_args);
+
 /* Returns the exact amount of workspace that will need to be used
    for a given combination of crush_map and result_max. The caller can
    then allocate this much on its own, either on the stack, in a
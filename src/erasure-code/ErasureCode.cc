@@ -203,6 +203,62 @@ int ErasureCode::encode(const set<int> &want_to_encode,
   return 0;
 }
 
+void ErasureCode::encode_delta(const bufferlist &old_data,
+                               const bufferlist &new_data,
+                               bufferlist *delta)
+{
+  ceph_assert(old_data.length() == new_data.length());
+  unsigned len = old_data.length();
+  bufferptr buf(buffer::create_aligned(len, SIMD_ALIGN));
+  old_data.begin().copy(len, buf.c_str());
+  auto p = new_data.begin();
+  char *out = buf.c_str();
+  while (p != new_data.end()) {
+    const char *in;
+    unsigned n = p.get_ptr_and_advance(len - p.get_off(), &in);
+    for (unsigned i = 0; i < n; i++) {
+      *out++ ^= in[i];
+    }
+  }
+  delta->clear();
+  delta->push_back(std::move(buf));
+}
+
+void ErasureCode::apply_delta(const map<int, bufferlist> &deltas,
+                              map<int, bufferlist> &coding)
+{
+  // generic version for linear codes: encode a stripe holding nothing
+  // but the deltas and add the resulting coding chunks to the old ones
+  if (coding.empty())
+    return;
+  unsigned int k = get_data_chunk_count();
+  unsigned int m = get_chunk_count() - k;
+  unsigned blocksize = coding.begin()->second.length();
+  map<int, bufferlist> encoded;
+  for (unsigned int i = 0; i < k + m; i++) {
+    int chunk = chunk_index(i);
+    bufferptr buf(buffer::create_aligned(blocksize, SIMD_ALIGN));
+    auto d = deltas.find(chunk);
+    if (i < k && d != deltas.end()) {
+      ceph_assert(d->second.length() == blocksize);
+      d->second.begin().copy(blocksize, buf.c_str());
+    } else {
+      buf.zero();
+    }
+    encoded[chunk].push_back(std::move(buf));
+  }
+  set<int> want;
+  for (auto &i : coding)
+    want.insert(i.first);
+  encode_chunks(want, &encoded);
+  for (auto &[chunk, bl] : coding) {
+    ceph_assert(bl.length() == blocksize);
+    bufferlist delta;
+    encode_delta(bl, encoded[chunk], &delta);
+    bl = std::move(delta);
+  }
+}
+
 int ErasureCode::_decode(const set<int> &want_to_read,
 			 const map<int, bufferlist> &chunks,
 			 map<int, bufferlist> *decoded)
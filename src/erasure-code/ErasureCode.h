@@ -79,6 +79,17 @@ namespace ceph {
                        const bufferlist &in,
                        std::map<int, bufferlist> *encoded) override;
 
+    bool supports_parity_delta() const override {
+      return false;
+    }
+
+    void encode_delta(const bufferlist &old_data,
+                      const bufferlist &new_data,
+                      bufferlist *delta) override;
+
+    void apply_delta(const std::map<int, bufferlist> &deltas,
+                     std::map<int, bufferlist> &coding) override;
+
     int decode(const std::set<int> &want_to_read,
                 const std::map<int, bufferlist> &chunks,
                 std::map<int, bufferlist> *decoded, int chunk_size) override;
@@ -370,6 +370,45 @@ namespace ceph {
     virtual int encode_chunks(const std::set<int> &want_to_encode,
                               std::map<int, bufferlist> *encoded) = 0;
 
+    /**
+     * Return true if **apply_delta** updates coding chunks more
+     * cheaply than encoding the whole stripe again. A partial stripe
+     * overwrite may then be written by sending the delta of the
+     * modified data chunks to the coding chunks, without reading the
+     * data chunks that do not change.
+     *
+     * @return **true** if the plugin implements parity deltas natively
+     */
+    virtual bool supports_parity_delta() const = 0;
+
+    /**
+     * Compute in **delta** the difference between the **old_data**
+     * and the **new_data** content of a data chunk, to be given to
+     * **apply_delta**. Both buffers must have the same size.
+     *
+     * @param [in] old_data current content of the data chunk
+     * @param [in] new_data content the data chunk is overwritten with
+     * @param [out] delta difference between the two
+     */
+    virtual void encode_delta(const bufferlist &old_data,
+                              const bufferlist &new_data,
+                              bufferlist *delta) = 0;
+
+    /**
+     * Update the **coding** chunks in place so that they match the
+     * data chunks once **deltas** have been applied to them.
+     *
+     * On return **coding** holds the updated coding chunks, whose
+     * buffers may have been modified in place: the caller must own
+     * them exclusively. All buffers must have the same size.
+     *
+     * @param [in] deltas map data chunk indexes to the output of
+     *             **encode_delta** for that chunk
+     * @param [in,out] coding map coding chunk indexes to chunk data
+     */
+    virtual void apply_delta(const std::map<int, bufferlist> &deltas,
+                             std::map<int, bufferlist> &coding) = 0;
+
     /**
      * Decode the **chunks** and store at least **want_to_read**
      * chunks in **decoded**.
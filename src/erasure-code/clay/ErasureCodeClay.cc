@@ -83,8 +83,110 @@ int ErasureCodeClay::init(ErasureCodeProfile &profile,
 		       pft.profile,
 		       &pft.erasure_code,
 		       ss);
-  return r;
+  if (r)
+    return r;
+  init_pft();
+  return 0;
+}
+
+void ErasureCodeClay::init_pft()
+{
+  // the pairwise transform is a (2,2) code applied to every pair of
+  // coupled sub-chunks. when the scalar code is a byte-wise GF(2^8)
+  // matrix code, learn its generator once and solve each transform with
+  // a vectorized region op, instead of paying for a decode matrix
+  // inversion per sub-chunk. bit-matrix techniques keep the plugin path.
+  pft_fast = false;
+  unsigned len = pft.erasure_code->get_chunk_size(1);
+  uint8_t g[4][2] = {{1, 0}, {0, 1}, {0, 0}, {0, 0}};
+  for (int x = 0; x < 3; x++) {
+    // x == 0, 1: unit data in chunk x; x == 2: check against random data
+    map<int, bufferlist> encoded;
+    for (int i = 0; i < 4; i++) {
+      bufferptr ptr(buffer::create_aligned(len, SIMD_ALIGN));
+      for (unsigned b = 0; b < len; b++) {
+	ptr[b] = (i >= 2) ? 0 : (x < 2) ? (i == x) : (char)(b * 37 + i * 101 + 7);
+      }
+      encoded[i].push_back(std::move(ptr));
+    }
+    if (pft.erasure_code->encode_chunks({0, 1, 2, 3}, &encoded))
+      return;
+    const uint8_t *d0 = (const uint8_t*)encoded[0].c_str();
+    const uint8_t *d1 = (const uint8_t*)encoded[1].c_str();
+    for (int i = 2; i < 4; i++) {
+      const uint8_t *c = (const uint8_t*)encoded[i].c_str();
+      if (x < 2) {
+	g[i][x] = c[0];
+      }
+      for (unsigned b = 0; b < len; b++) {
+	if (c[b] != (gf8_mul(g[i][0], d0[b]) ^ gf8_mul(g[i][1], d1[b]))) {
+	  dout(10) << __func__ << " " << pft.profile
+		   << " is not a byte-wise code, using it as is" << dendl;
+	  return;
+	}
+      }
+    }
+  }
 
+  // sub-chunk l from known sub-chunks i and j (all arithmetic in GF(2^8),
+  // where subtraction is addition)
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      if (i == j)
+	continue;
+      uint8_t det = gf8_mul(g[i][0], g[j][1]) ^ gf8_mul(g[i][1], g[j][0]);
+      if (det == 0)
+	return;
+      uint8_t inv = gf8_inv(det);
+      for (int l = 0; l < 4; l++) {
+	uint8_t ci = gf8_mul(inv, gf8_mul(g[l][0], g[j][1]) ^ gf8_mul(g[l][1], g[j][0]));
+	uint8_t cj = gf8_mul(inv, gf8_mul(g[l][0], g[i][1]) ^ gf8_mul(g[l][1], g[i][0]));
+	gf8_coef_init(&pft_coef[i][j][l][0], ci);
+	gf8_coef_init(&pft_coef[i][j][l][1], cj);
+      }
+    }
+  }
+  pft_fast = true;
+  dout(10) << __func__ << " pairwise transform uses " << gf8_region_impl()
+	   << " region ops" << dendl;
+}
+
+void ErasureCodeClay::pft_decode(const set<int>& want, char* sc[4], int sc_size)
+{
+  // sc[i] is sub-chunk i of the pairwise transform, or nullptr if it is
+  // of no interest; the ones in want are computed from the two others
+  if (pft_fast) {
+    int known[2];
+    int n = 0;
+    for (int i = 0; i < 4; i++) {
+      if (sc[i] && want.count(i) == 0)
+	known[n++] = i;
+    }
+    ceph_assert(n == 2);
+    const uint8_t *a = (const uint8_t*)sc[known[0]];
+    const uint8_t *b = (const uint8_t*)sc[known[1]];
+    for (auto l : want) {
+      const gf8_coef *c = pft_coef[known[0]][known[1]][l];
+      gf8_region_mul2(c[0], a, c[1], b, (uint8_t*)sc[l], sc_size);
+    }
+    return;
+  }
+
+  map<int, bufferlist> known_subchunks;
+  map<int, bufferlist> pftsubchunks;
+  bufferptr scratch;
+  for (int i = 0; i < 4; i++) {
+    if (sc[i]) {
+      pftsubchunks[i].push_back(buffer::create_static(sc_size, sc[i]));
+      if (want.count(i) == 0)
+	known_subchunks[i] = pftsubchunks[i];
+    } else {
+      if (!scratch.have_raw())
+	scratch = buffer::create_aligned(sc_size, SIMD_ALIGN);
+      pftsubchunks[i].push_back(scratch);
+    }
+  }
+  pft.erasure_code->decode_chunks(want, known_subchunks, &pftsubchunks);
 }
 
 unsigned int ErasureCodeClay::get_chunk_size(unsigned int object_size) const
@@ -474,10 +576,6 @@ int ErasureCodeClay::repair_one_lost_chunk(map<int, bufferlist> &recovered_data,
   int count_retrieved_sub_chunks = 0;
   int plane_ind = 0;
 
-  bufferptr buf(buffer::create_aligned(sub_chunksize, SIMD_ALIGN));
-  bufferlist temp_buf;
-  temp_buf.push_back(buf);
-
   for (auto [index,count] : repair_sub_chunks_ind) {
     for (int j = index; j < index + count; j++) {
       get_plane_vector(j, z_vec);
@@ -536,9 +634,7 @@ int ErasureCodeClay::repair_one_lost_chunk(map<int, bufferlist> &recovered_data,
       for (int y = 0; y < t; y++) {
 	for (int x = 0; x < q; x++) {
 	  int node_xy = y*q + x;
-	  map<int, bufferlist> known_subchunks;
-	  map<int, bufferlist> pftsubchunks;
-	  set<int> pft_erasures;
+	  char* sc[4] = {nullptr, nullptr, nullptr, nullptr};
 	  if (erasures.count(node_xy) == 0) {
 	    assert(helper_data.count(node_xy) > 0);
 	    int z_sw = z + (x - z_vec[y])*pow_int(q,t-1-y);
@@ -553,33 +649,19 @@ int ErasureCodeClay::repair_one_lost_chunk(map<int, bufferlist> &recovered_data,
 	    if (aloof_nodes.count(node_sw) > 0) {
 	      assert(repair_plane_to_ind.count(z) > 0);
 	      assert(repair_plane_to_ind.count(z_sw) > 0);
-	      pft_erasures.insert(i2);
-	      known_subchunks[i0].substr_of(helper_data[node_xy], repair_plane_to_ind[z]*sub_chunksize, sub_chunksize);
-	      known_subchunks[i3].substr_of(U_buf[node_sw], z_sw*sub_chunksize, sub_chunksize);
-	      pftsubchunks[i0] = known_subchunks[i0];
-	      pftsubchunks[i1] = temp_buf;
-	      pftsubchunks[i2].substr_of(U_buf[node_xy], z*sub_chunksize, sub_chunksize);
-	      pftsubchunks[i3] = known_subchunks[i3];
-	      for (int i=0; i<3; i++) {
-		pftsubchunks[i].rebuild_aligned(SIMD_ALIGN);
-	      }
-	      pft.erasure_code->decode_chunks(pft_erasures, known_subchunks, &pftsubchunks);
+	      sc[i0] = helper_data[node_xy].c_str() + repair_plane_to_ind[z]*sub_chunksize;
+	      sc[i2] = U_buf[node_xy].c_str() + z*sub_chunksize;
+	      sc[i3] = U_buf[node_sw].c_str() + z_sw*sub_chunksize;
+	      pft_decode({i2}, sc, sub_chunksize);
 	    } else {
 	      ceph_assert(helper_data.count(node_sw) > 0);
 	      ceph_assert(repair_plane_to_ind.count(z) > 0);
 	      if (z_vec[y] != x){
-		pft_erasures.insert(i2);
 		ceph_assert(repair_plane_to_ind.count(z_sw) > 0);
-		known_subchunks[i0].substr_of(helper_data[node_xy], repair_plane_to_ind[z]*sub_chunksize, sub_chunksize);
-		known_subchunks[i1].substr_of(helper_data[node_sw], repair_plane_to_ind[z_sw]*sub_chunksize, sub_chunksize);
-		pftsubchunks[i0] = known_subchunks[i0];
-		pftsubchunks[i1] = known_subchunks[i1];
-		pftsubchunks[i2].substr_of(U_buf[node_xy], z*sub_chunksize, sub_chunksize);
-		pftsubchunks[i3].substr_of(temp_buf, 0, sub_chunksize);
-		for (int i=0; i<3; i++) {
-		  pftsubchunks[i].rebuild_aligned(SIMD_ALIGN);
-		}
-		pft.erasure_code->decode_chunks(pft_erasures, known_subchunks, &pftsubchunks);
+		sc[i0] = helper_data[node_xy].c_str() + repair_plane_to_ind[z]*sub_chunksize;
+		sc[i1] = helper_data[node_sw].c_str() + repair_plane_to_ind[z_sw]*sub_chunksize;
+		sc[i2] = U_buf[node_xy].c_str() + z*sub_chunksize;
+		pft_decode({i2}, sc, sub_chunksize);
 	      } else {
 		char* uncoupled_chunk = U_buf[node_xy].c_str();
 		char* coupled_chunk = helper_data[node_xy].c_str();
@@ -599,9 +681,6 @@ int ErasureCodeClay::repair_one_lost_chunk(map<int, bufferlist> &recovered_data,
 	int y = i / q;
 	int node_sw = y*q+z_vec[y];
 	int z_sw = z + (x - z_vec[y]) * pow_int(q,t-1-y);
-	set<int> pft_erasures;
-	map<int, bufferlist> known_subchunks;
-	map<int, bufferlist> pftsubchunks;
 	int i0 = 0, i1 = 1, i2 = 2, i3 = 3;
 	if (z_vec[y] > x) {
 	  i0 = 1;
@@ -622,18 +701,11 @@ int ErasureCodeClay::repair_one_lost_chunk(map<int, bufferlist> &recovered_data,
 	    ceph_assert(y == lost_chunk / q);
 	    ceph_assert(node_sw == lost_chunk);
 	    ceph_assert(helper_data.count(i) > 0);
-	    pft_erasures.insert(i1);
-	    known_subchunks[i0].substr_of(helper_data[i], repair_plane_to_ind[z]*sub_chunksize, sub_chunksize);
-	    known_subchunks[i2].substr_of(U_buf[i], z*sub_chunksize, sub_chunksize);
-
-	    pftsubchunks[i0] = known_subchunks[i0];
-	    pftsubchunks[i1].substr_of(recovered_data[node_sw], z_sw*sub_chunksize, sub_chunksize);
-	    pftsubchunks[i2] = known_subchunks[i2];
-	    pftsubchunks[i3] = temp_buf;
-	    for (int i=0; i<3; i++) {
-	      pftsubchunks[i].rebuild_aligned(SIMD_ALIGN);
-	    }
-	    pft.erasure_code->decode_chunks(pft_erasures, known_subchunks, &pftsubchunks);
+	    char* sc[4] = {nullptr, nullptr, nullptr, nullptr};
+	    sc[i0] = helper_data[i].c_str() + repair_plane_to_ind[z]*sub_chunksize;
+	    sc[i1] = recovered_data[node_sw].c_str() + z_sw*sub_chunksize;
+	    sc[i2] = U_buf[i].c_str() + z*sub_chunksize;
+	    pft_decode({i1}, sc, sub_chunksize);
 	  }
 	}
       } // recover all erasures
@@ -777,17 +849,10 @@ void ErasureCodeClay::recover_type1_erasure(map<int, bufferlist>* chunks,
 					    int x, int y, int z,
 					    int* z_vec, int sc_size)
 {
-  set<int> erased_chunks;
-
   int node_xy = y*q+x;
   int node_sw = y*q+z_vec[y];
   int z_sw = z + (x - z_vec[y]) * pow_int(q,t-1-y);
 
-  map<int, bufferlist> known_subchunks;
-  map<int, bufferlist> pftsubchunks;
-  bufferptr ptr(buffer::create_aligned(sc_size, SIMD_ALIGN));
-  ptr.zero();
-
   int i0 = 0, i1 = 1, i2 = 2, i3 = 3;
   if (z_vec[y] > x) {
     i0 = 1;
@@ -796,54 +861,34 @@ void ErasureCodeClay::recover_type1_erasure(map<int, bufferlist>* chunks,
     i3 = 2;
   }
 
-  erased_chunks.insert(i0);
-  pftsubchunks[i0].substr_of((*chunks)[node_xy], z * sc_size, sc_size);
-  known_subchunks[i1].substr_of((*chunks)[node_sw], z_sw * sc_size, sc_size);
-  known_subchunks[i2].substr_of(U_buf[node_xy], z * sc_size, sc_size);
-  pftsubchunks[i1] = known_subchunks[i1];
-  pftsubchunks[i2] = known_subchunks[i2];
-  pftsubchunks[i3].push_back(ptr);
-
-  for (int i=0; i<3; i++) {
-    pftsubchunks[i].rebuild_aligned_size_and_memory(sc_size, SIMD_ALIGN);
-  }
-
-  pft.erasure_code->decode_chunks(erased_chunks, known_subchunks, &pftsubchunks);
+  char* sc[4] = {nullptr, nullptr, nullptr, nullptr};
+  sc[i0] = (*chunks)[node_xy].c_str() + z * sc_size;
+  sc[i1] = (*chunks)[node_sw].c_str() + z_sw * sc_size;
+  sc[i2] = U_buf[node_xy].c_str() + z * sc_size;
+  pft_decode({i0}, sc, sc_size);
 }
 
 void ErasureCodeClay::get_coupled_from_uncoupled(map<int, bufferlist>* chunks,
 						 int x, int y, int z,
 						 int* z_vec, int sc_size)
 {
-  set<int> erased_chunks = {0, 1};
-
   int node_xy = y*q+x;
   int node_sw = y*q+z_vec[y];
   int z_sw = z + (x - z_vec[y]) * pow_int(q,t-1-y);
 
   ceph_assert(z_vec[y] < x);
-  map<int, bufferlist> uncoupled_subchunks;
-  uncoupled_subchunks[2].substr_of(U_buf[node_xy], z * sc_size, sc_size);
-  uncoupled_subchunks[3].substr_of(U_buf[node_sw], z_sw * sc_size, sc_size);
-
-  map<int, bufferlist> pftsubchunks;
-  pftsubchunks[0].substr_of((*chunks)[node_xy], z * sc_size, sc_size);
-  pftsubchunks[1].substr_of((*chunks)[node_sw], z_sw * sc_size, sc_size);
-  pftsubchunks[2] = uncoupled_subchunks[2];
-  pftsubchunks[3] = uncoupled_subchunks[3];
-
-  for (int i=0; i<3; i++) {
-    pftsubchunks[i].rebuild_aligned_size_and_memory(sc_size, SIMD_ALIGN);
-  }
-  pft.erasure_code->decode_chunks(erased_chunks, uncoupled_subchunks, &pftsubchunks);
+  char* sc[4];
+  sc[0] = (*chunks)[node_xy].c_str() + z * sc_size;
+  sc[1] = (*chunks)[node_sw].c_str() + z_sw * sc_size;
+  sc[2] = U_buf[node_xy].c_str() + z * sc_size;
+  sc[3] = U_buf[node_sw].c_str() + z_sw * sc_size;
+  pft_decode({0, 1}, sc, sc_size);
 }
 
 void ErasureCodeClay::get_uncoupled_from_coupled(map<int, bufferlist>* chunks,
 						 int x, int y, int z,
 						 int* z_vec, int sc_size)
 {
-  set<int> erased_chunks = {2, 3};
-
   int node_xy = y*q+x;
   int node_sw = y*q+z_vec[y];
   int z_sw = z + (x - z_vec[y]) * pow_int(q,t-1-y);
@@ -855,19 +900,12 @@ void ErasureCodeClay::get_uncoupled_from_coupled(map<int, bufferlist>* chunks,
     i2 = 3;
     i3 = 2;
   }
-  map<int, bufferlist> coupled_subchunks;
-  coupled_subchunks[i0].substr_of((*chunks)[node_xy], z * sc_size, sc_size);
-  coupled_subchunks[i1].substr_of((*chunks)[node_sw], z_sw * sc_size, sc_size);
-
-  map<int, bufferlist> pftsubchunks;
-  pftsubchunks[0] = coupled_subchunks[0];
-  pftsubchunks[1] = coupled_subchunks[1];
-  pftsubchunks[i2].substr_of(U_buf[node_xy], z * sc_size, sc_size);
-  pftsubchunks[i3].substr_of(U_buf[node_sw], z_sw * sc_size, sc_size);
-  for (int i=0; i<3; i++) {
-    pftsubchunks[i].rebuild_aligned_size_and_memory(sc_size, SIMD_ALIGN);
-  }
-  pft.erasure_code->decode_chunks(erased_chunks, coupled_subchunks, &pftsubchunks);
+  char* sc[4];
+  sc[i0] = (*chunks)[node_xy].c_str() + z * sc_size;
+  sc[i1] = (*chunks)[node_sw].c_str() + z_sw * sc_size;
+  sc[i2] = U_buf[node_xy].c_str() + z * sc_size;
+  sc[i3] = U_buf[node_sw].c_str() + z_sw * sc_size;
+  pft_decode({i2, i3}, sc, sc_size);
 }
 
 int ErasureCodeClay::get_max_iscore(set<int>& erased_chunks)
@@ -21,6 +21,8 @@
 #include "include/buffer_fwd.h"
 #include "erasure-code/ErasureCode.h"
 
+#include "gf_region.h"
+
 class ErasureCodeClay final : public ceph::ErasureCode {
 public:
   std::string DEFAULT_K{"4"};
@@ -40,6 +42,10 @@ public:
   ScalarMDS pft;
   const std::string directory;
 
+  // true if the pairwise transform runs as a GF(2^8) region op rather
+  // than through pft.erasure_code, see init_pft()
+  bool pft_fast = false;
+
   explicit ErasureCodeClay(const std::string& dir)
     : directory(dir)
   {}
@@ -85,6 +91,10 @@ public:
   virtual int parse(ceph::ErasureCodeProfile &profile, std::ostream *ss);
 
 private:
+  // pft_coef[i][j][l]: coefficients of sub-chunks i and j that give
+  // sub-chunk l of the pairwise transform
+  gf8_coef pft_coef[4][4][4][2];
+
   int minimum_to_repair(const std::set<int> &want_to_read,
                         const std::set<int> &available_chunks,
                         std::map<int, std::vector<std::pair<int, int>>> *minimum);
@@ -120,6 +130,10 @@ private:
 
   void get_plane_vector(int z, int* z_vec);
 
+  void init_pft();
+
+  void pft_decode(const std::set<int>& want, char* sc[4], int sc_size);
+
   int get_max_iscore(std::set<int>& erased_chunks);
 };
 
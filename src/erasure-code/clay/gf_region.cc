@@ -0,0 +1,227 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "gf_region.h"
+
+#include "arch/probe.h"
+#include "arch/intel.h"
+#include "arch/arm.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+uint8_t gf8_mul(uint8_t a, uint8_t b)
+{
+  uint8_t p = 0;
+  while (b) {
+    if (b & 1)
+      p ^= a;
+    b >>= 1;
+    a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+  }
+  return p;
+}
+
+uint8_t gf8_inv(uint8_t a)
+{
+  // a^254 == a^-1 in GF(2^8)
+  uint8_t r = 1;
+  for (int e = 254; e; e >>= 1) {
+    if (e & 1)
+      r = gf8_mul(r, a);
+    a = gf8_mul(a, a);
+  }
+  return r;
+}
+
+void gf8_coef_init(gf8_coef *t, uint8_t c)
+{
+  for (int i = 0; i < 16; i++) {
+    t->lo[i] = gf8_mul(c, i);
+    t->hi[i] = gf8_mul(c, i << 4);
+  }
+}
+
+static inline void mul2_tail(const gf8_coef &ca, const uint8_t *a,
+			     const gf8_coef &cb, const uint8_t *b,
+			     uint8_t *dst, size_t off, size_t len)
+{
+  for (size_t i = off; i < len; i++) {
+    dst[i] = ca.lo[a[i] & 0xf] ^ ca.hi[a[i] >> 4] ^
+             cb.lo[b[i] & 0xf] ^ cb.hi[b[i] >> 4];
+  }
+}
+
+static void mul2_generic(const gf8_coef &ca, const uint8_t *a,
+			 const gf8_coef &cb, const uint8_t *b,
+			 uint8_t *dst, size_t len)
+{
+  mul2_tail(ca, a, cb, b, dst, 0, len);
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("ssse3")))
+static void mul2_ssse3(const gf8_coef &ca, const uint8_t *a,
+		       const gf8_coef &cb, const uint8_t *b,
+		       uint8_t *dst, size_t len)
+{
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i alo = _mm_loadu_si128((const __m128i*)ca.lo);
+  const __m128i ahi = _mm_loadu_si128((const __m128i*)ca.hi);
+  const __m128i blo = _mm_loadu_si128((const __m128i*)cb.lo);
+  const __m128i bhi = _mm_loadu_si128((const __m128i*)cb.hi);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+    __m128i r = _mm_xor_si128(
+      _mm_shuffle_epi8(alo, _mm_and_si128(va, mask)),
+      _mm_shuffle_epi8(ahi, _mm_and_si128(_mm_srli_epi64(va, 4), mask)));
+    r = _mm_xor_si128(r, _mm_shuffle_epi8(blo, _mm_and_si128(vb, mask)));
+    r = _mm_xor_si128(r, _mm_shuffle_epi8(
+			bhi, _mm_and_si128(_mm_srli_epi64(vb, 4), mask)));
+    _mm_storeu_si128((__m128i*)(dst + i), r);
+  }
+  mul2_tail(ca, a, cb, b, dst, i, len);
+}
+
+__attribute__((target("avx2")))
+static void mul2_avx2(const gf8_coef &ca, const uint8_t *a,
+		      const gf8_coef &cb, const uint8_t *b,
+		      uint8_t *dst, size_t len)
+{
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  const __m256i alo = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i*)ca.lo));
+  const __m256i ahi = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i*)ca.hi));
+  const __m256i blo = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i*)cb.lo));
+  const __m256i bhi = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i*)cb.hi));
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    __m256i r = _mm256_xor_si256(
+      _mm256_shuffle_epi8(alo, _mm256_and_si256(va, mask)),
+      _mm256_shuffle_epi8(ahi, _mm256_and_si256(_mm256_srli_epi64(va, 4), mask)));
+    r = _mm256_xor_si256(r, _mm256_shuffle_epi8(blo, _mm256_and_si256(vb, mask)));
+    r = _mm256_xor_si256(r, _mm256_shuffle_epi8(
+			   bhi, _mm256_and_si256(_mm256_srli_epi64(vb, 4), mask)));
+    _mm256_storeu_si256((__m256i*)(dst + i), r);
+  }
+  mul2_tail(ca, a, cb, b, dst, i, len);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void mul2_avx512(const gf8_coef &ca, const uint8_t *a,
+			const gf8_coef &cb, const uint8_t *b,
+			uint8_t *dst, size_t len)
+{
+  const __m512i mask = _mm512_set1_epi8(0x0f);
+  const __m512i alo = _mm512_broadcast_i32x4(
+    _mm_loadu_si128((const __m128i*)ca.lo));
+  const __m512i ahi = _mm512_broadcast_i32x4(
+    _mm_loadu_si128((const __m128i*)ca.hi));
+  const __m512i blo = _mm512_broadcast_i32x4(
+    _mm_loadu_si128((const __m128i*)cb.lo));
+  const __m512i bhi = _mm512_broadcast_i32x4(
+    _mm_loadu_si128((const __m128i*)cb.hi));
+  size_t i = 0;
+  for (; i + 64 <= len; i += 64) {
+    __m512i va = _mm512_loadu_si512((const void*)(a + i));
+    __m512i vb = _mm512_loadu_si512((const void*)(b + i));
+    __m512i r = _mm512_xor_si512(
+      _mm512_shuffle_epi8(alo, _mm512_and_si512(va, mask)),
+      _mm512_shuffle_epi8(ahi, _mm512_and_si512(_mm512_srli_epi64(va, 4), mask)));
+    r = _mm512_xor_si512(r, _mm512_shuffle_epi8(blo, _mm512_and_si512(vb, mask)));
+    r = _mm512_xor_si512(r, _mm512_shuffle_epi8(
+			   bhi, _mm512_and_si512(_mm512_srli_epi64(vb, 4), mask)));
+    _mm512_storeu_si512((void*)(dst + i), r);
+  }
+  mul2_tail(ca, a, cb, b, dst, i, len);
+}
+
+#elif defined(__aarch64__)
+
+static void mul2_neon(const gf8_coef &ca, const uint8_t *a,
+		      const gf8_coef &cb, const uint8_t *b,
+		      uint8_t *dst, size_t len)
+{
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+  const uint8x16_t alo = vld1q_u8(ca.lo);
+  const uint8x16_t ahi = vld1q_u8(ca.hi);
+  const uint8x16_t blo = vld1q_u8(cb.lo);
+  const uint8x16_t bhi = vld1q_u8(cb.hi);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t va = vld1q_u8(a + i);
+    uint8x16_t vb = vld1q_u8(b + i);
+    uint8x16_t r = veorq_u8(vqtbl1q_u8(alo, vandq_u8(va, mask)),
+			    vqtbl1q_u8(ahi, vshrq_n_u8(va, 4)));
+    r = veorq_u8(r, vqtbl1q_u8(blo, vandq_u8(vb, mask)));
+    r = veorq_u8(r, vqtbl1q_u8(bhi, vshrq_n_u8(vb, 4)));
+    vst1q_u8(dst + i, r);
+  }
+  mul2_tail(ca, a, cb, b, dst, i, len);
+}
+
+#endif
+
+typedef void (*mul2_fn)(const gf8_coef&, const uint8_t*,
+			const gf8_coef&, const uint8_t*,
+			uint8_t*, size_t);
+
+struct mul2_impl {
+  mul2_fn fn;
+  const char *name;
+};
+
+static mul2_impl pick_mul2()
+{
+  ceph_arch_probe();
+#if defined(__x86_64__)
+  if (ceph_arch_intel_avx512bw)
+    return {mul2_avx512, "avx512"};
+  if (ceph_arch_intel_avx2)
+    return {mul2_avx2, "avx2"};
+  if (ceph_arch_intel_ssse3)
+    return {mul2_ssse3, "ssse3"};
+#elif defined(__aarch64__)
+  if (ceph_arch_neon)
+    return {mul2_neon, "neon"};
+#endif
+  return {mul2_generic, "generic"};
+}
+
+static const mul2_impl &get_mul2()
+{
+  static const mul2_impl impl = pick_mul2();
+  return impl;
+}
+
+void gf8_region_mul2(const gf8_coef &ca, const uint8_t *a,
+		     const gf8_coef &cb, const uint8_t *b,
+		     uint8_t *dst, size_t len)
+{
+  get_mul2().fn(ca, a, cb, b, dst, len);
+}
+
+const char *gf8_region_impl()
+{
+  return get_mul2().name;
+}
@@ -0,0 +1,42 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_ERASURE_CODE_CLAY_GF_REGION_H
+#define CEPH_ERASURE_CODE_CLAY_GF_REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// GF(2^8) arithmetic over the 0x11d polynomial used by jerasure (w=8)
+// and isa, with region operations vectorized as split nibble table
+// lookups (pshufb/vpshufb/tbl).
+
+uint8_t gf8_mul(uint8_t a, uint8_t b);
+uint8_t gf8_inv(uint8_t a);
+
+/// product tables of one coefficient: c*x == lo[x & 0xf] ^ hi[x >> 4]
+struct gf8_coef {
+  uint8_t lo[16];
+  uint8_t hi[16];
+};
+
+void gf8_coef_init(gf8_coef *t, uint8_t c);
+
+/// dst = ca * a + cb * b, byte by byte, over len bytes
+void gf8_region_mul2(const gf8_coef &ca, const uint8_t *a,
+		     const gf8_coef &cb, const uint8_t *b,
+		     uint8_t *dst, size_t len);
+
+/// name of the implementation gf8_region_mul2() dispatches to
+const char *gf8_region_impl();
+
+#endif
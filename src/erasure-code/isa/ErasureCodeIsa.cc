@@ -146,6 +146,33 @@ ErasureCodeIsaDefault::erasure_contains(int *erasures, int i)
 
 
 
+// -----------------------------------------------------------------------------
+
+void
+ErasureCodeIsaDefault::apply_delta(const map<int, bufferlist> &deltas,
+                                   map<int, bufferlist> &coding)
+{
+  for (auto &[chunk, bl] : coding) {
+    ceph_assert(chunk >= k && chunk < k + m);
+    unsigned char *parity = (unsigned char*) bl.c_str();
+    for (auto &[i, delta] : deltas) {
+      ceph_assert(i >= 0 && i < k);
+      ceph_assert(delta.length() == bl.length());
+      bufferlist contiguous = delta;
+      unsigned char *region = (unsigned char*) contiguous.c_str();
+      if (m == 1) {
+        // single parity stripe
+        byte_xor(region, parity, region + bl.length());
+      } else {
+        // the tables of coding chunk j start at j * k * 32
+        ec_encode_data_update(bl.length(), k, 1, i,
+                              encode_tbls + (chunk - k) * k * 32,
+                              region, &parity);
+      }
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 
 int
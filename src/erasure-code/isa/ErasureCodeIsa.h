@@ -136,6 +136,13 @@ public:
 
   virtual bool erasure_contains(int *erasures, int i);
 
+  bool supports_parity_delta() const override {
+    return true;
+  }
+
+  void apply_delta(const std::map<int, ceph::buffer::list> &deltas,
+                   std::map<int, ceph::buffer::list> &coding) override;
+
   int isa_decode(int *erasures,
                          char **data,
                          char **coding,
@@ -152,6 +152,37 @@ bool ErasureCodeJerasure::is_prime(int value)
   return false;
 }
 
+void ErasureCodeJerasure::apply_matrix_delta(const int *matrix,
+					     const map<int, bufferlist> &deltas,
+					     map<int, bufferlist> &coding)
+{
+  // coding[j] += matrix[j][i] * delta[i] for every modified data chunk i
+  for (auto &[chunk, bl] : coding) {
+    ceph_assert(chunk >= k && chunk < k + m);
+    char *parity = bl.c_str();
+    for (auto &[i, delta] : deltas) {
+      ceph_assert(i >= 0 && i < k);
+      ceph_assert(delta.length() == bl.length());
+      bufferlist contiguous = delta;
+      char *region = contiguous.c_str();
+      int multby = matrix[(chunk - k) * k + i];
+      switch (w) {
+      case 8:
+	galois_w08_region_multiply(region, multby, bl.length(), parity, 1);
+	break;
+      case 16:
+	galois_w16_region_multiply(region, multby, bl.length(), parity, 1);
+	break;
+      case 32:
+	galois_w32_region_multiply(region, multby, bl.length(), parity, 1);
+	break;
+      default:
+	ceph_abort_msg("unsupported word size");
+      }
+    }
+  }
+}
+
 // 
 // ErasureCodeJerasureReedSolomonVandermonde
 //
@@ -77,6 +77,9 @@ public:
   static bool is_prime(int value);
 protected:
   virtual int parse(ceph::ErasureCodeProfile &profile, std::ostream *ss);
+  void apply_matrix_delta(const int *matrix,
+			  const std::map<int, ceph::buffer::list> &deltas,
+			  std::map<int, ceph::buffer::list> &coding);
 };
 class ErasureCodeJerasureReedSolomonVandermonde : public ErasureCodeJerasure {
 public:
@@ -102,6 +105,13 @@ public:
                                char **data,
                                char **coding,
                                int blocksize) override;
+  bool supports_parity_delta() const override {
+    return true;
+  }
+  void apply_delta(const std::map<int, ceph::buffer::list> &deltas,
+		   std::map<int, ceph::buffer::list> &coding) override {
+    apply_matrix_delta(matrix, deltas, coding);
+  }
   unsigned get_alignment() const override;
   void prepare() override;
 private:
@@ -132,6 +142,13 @@ public:
                                char **data,
                                char **coding,
                                int blocksize) override;
+  bool supports_parity_delta() const override {
+    return true;
+  }
+  void apply_delta(const std::map<int, ceph::buffer::list> &deltas,
+		   std::map<int, ceph::buffer::list> &coding) override {
+    apply_matrix_delta(matrix, deltas, coding);
+  }
   unsigned get_alignment() const override;
   void prepare() override;
 private:
@@ -117,6 +117,8 @@ struct error_code;
   int get_missed_crc();
   /// enable/disable tracking of cached crcs
   void track_cached_crc(bool b);
+  /// bytes of slab memory held by the create_pooled() allocator
+  size_t get_pool_slab_bytes();
 
   /*
    * an abstract raw buffer.  with a reference count.
@@ -131,6 +133,7 @@ struct error_code;
   class raw_unshareable; // diagnostic, unshareable char buffer
   class raw_combined;
   class raw_claim_buffer;
+  class raw_pooled;
 
 
   /*
@@ -148,6 +151,10 @@ struct error_code;
   ceph::unique_leakable_ptr<raw> create_aligned_in_mempool(unsigned len, unsigned align, int mempool);
   ceph::unique_leakable_ptr<raw> create_page_aligned(unsigned len);
   ceph::unique_leakable_ptr<raw> create_small_page_aligned(unsigned len);
+  /// like create_aligned_in_mempool(), but served from per-thread cached,
+  /// size-classed slabs when len and align are small enough
+  ceph::unique_leakable_ptr<raw> create_pooled(unsigned len, unsigned align,
+					       int mempool);
   ceph::unique_leakable_ptr<raw> claim_buffer(unsigned len, char *buf, deleter del);
 
 #ifdef HAVE_SEASTAR
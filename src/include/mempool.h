@@ -151,6 +151,7 @@ namespace mempool {
   f(bluestore_alloc)		      \
   f(bluestore_cache_data)	      \
   f(bluestore_cache_onode)	      \
+  f(bluestore_cache_onode_compact)   \
   f(bluestore_cache_meta)	      \
   f(bluestore_cache_other)	      \
   f(bluestore_Buffer)		      \
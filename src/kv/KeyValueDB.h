@@ -7,6 +7,7 @@
 #include <ostream>
 #include <set>
 #include <map>
+#include <optional>
 #include <string>
 #include <boost/scoped_ptr.hpp>
 #include "include/encoding.h"
@@ -262,7 +263,7 @@ public:
   };
   typedef std::shared_ptr< WholeSpaceIteratorImpl > WholeSpaceIterator;
 
-private:
+protected:
   // This class filters a WholeSpaceIterator by a prefix.
   class PrefixIteratorImpl : public IteratorImpl {
     const std::string prefix;
@@ -314,8 +315,20 @@ private:
 public:
   typedef uint32_t IteratorOpts;
   static const uint32_t ITERATOR_NOCACHE = 1;
+  // a forward scan over many keys: read ahead
+  static const uint32_t ITERATOR_SCAN = 2;
+
+  // Keys (without prefix) an iterator will stay within.  The store may
+  // stop at a bound instead of stepping over the tombstones beyond it;
+  // a store that does not support bounds ignores them.
+  struct IteratorBounds {
+    std::optional<std::string> lower_bound;  ///< inclusive
+    std::optional<std::string> upper_bound;  ///< exclusive
+  };
+
   virtual WholeSpaceIterator get_wholespace_iterator(IteratorOpts opts = 0) = 0;
-  virtual Iterator get_iterator(const std::string &prefix, IteratorOpts opts = 0) {
+  virtual Iterator get_iterator(const std::string &prefix, IteratorOpts opts = 0,
+				IteratorBounds bounds = IteratorBounds()) {
     return std::make_shared<PrefixIteratorImpl>(
       prefix,
       get_wholespace_iterator(opts));
@@ -413,6 +426,11 @@ public:
     uint64_t *out) {
     return false;
   }
+
+  /// sequence number of the latest committed write, or 0 if unsupported
+  virtual uint64_t get_latest_sequence_number() {
+    return 0;
+  }
 protected:
   /// List of matching prefixes/ColumnFamilies and merge operators
   std::vector<std::pair<std::string,
@@ -640,6 +640,30 @@ rocksdb::ColumnFamilyHandle *RocksDBStore::get_cf_handle(const std::string& pref
   }
 }
 
+rocksdb::ColumnFamilyHandle *RocksDBStore::get_cf_handle(const std::string& prefix,
+							 const IteratorBounds& bounds) {
+  // all keys within the bounds hash to the same shard if both bounds
+  // agree on every byte up to the end of the hashed range
+  auto iter = cf_handles.find(prefix);
+  if (iter == cf_handles.end()) {
+    return nullptr;
+  }
+  if (iter->second.handles.size() == 1) {
+    return iter->second.handles[0];
+  }
+  if (!bounds.lower_bound || !bounds.upper_bound) {
+    return nullptr;
+  }
+  const std::string& lower = *bounds.lower_bound;
+  const std::string& upper = *bounds.upper_bound;
+  uint32_t hash_h = iter->second.hash_h;
+  if (lower.size() < hash_h || upper.size() < hash_h ||
+      lower.compare(0, hash_h, upper, 0, hash_h) != 0) {
+    return nullptr;
+  }
+  return get_cf_handle(prefix, lower);
+}
+
 rocksdb::ColumnFamilyHandle *RocksDBStore::get_cf_handle(const std::string& prefix, const char* key, size_t keylen) {
   auto iter = cf_handles.find(prefix);
   if (iter == cf_handles.end()) {
@@ -1913,6 +1937,19 @@ void RocksDBStore::compact_range(const string& start, const string& end)
   }
 }
 
+RocksDBStore::RocksDBWholeSpaceIteratorImpl::RocksDBWholeSpaceIteratorImpl(
+  const RocksDBStore* store,
+  rocksdb::ColumnFamilyHandle* cf,
+  IteratorOpts opts,
+  IteratorBounds bounds_)
+  : bounds(std::move(bounds_))
+{
+  dbiter = store->db->NewIterator(
+    store->get_iterator_read_options(opts, bounds,
+				     &iterate_lower_bound, &iterate_upper_bound),
+    cf);
+}
+
 RocksDBStore::RocksDBWholeSpaceIteratorImpl::~RocksDBWholeSpaceIteratorImpl()
 {
   delete dbiter;
@@ -2046,10 +2083,20 @@ class CFIteratorImpl : public KeyValueDB::IteratorImpl {
 protected:
   string prefix;
   rocksdb::Iterator *dbiter;
+  const KeyValueDB::IteratorBounds bounds;
+  rocksdb::Slice iterate_lower_bound, iterate_upper_bound;
 public:
-  explicit CFIteratorImpl(const std::string& p,
-				 rocksdb::Iterator *iter)
-    : prefix(p), dbiter(iter) { }
+  explicit CFIteratorImpl(const RocksDBStore* db,
+			  const std::string& p,
+			  rocksdb::ColumnFamilyHandle* cf,
+			  KeyValueDB::IteratorOpts opts,
+			  KeyValueDB::IteratorBounds bounds_)
+    : prefix(p), bounds(std::move(bounds_)) {
+    dbiter = db->db->NewIterator(
+      db->get_iterator_read_options(opts, bounds,
+				    &iterate_lower_bound, &iterate_upper_bound),
+      cf);
+  }
   ~CFIteratorImpl() {
     delete dbiter;
   }
@@ -2581,16 +2628,22 @@ private:
   const RocksDBStore* db;
   KeyLess keyless;
   string prefix;
+  const KeyValueDB::IteratorBounds bounds;
+  rocksdb::Slice iterate_lower_bound, iterate_upper_bound;
   std::vector<rocksdb::Iterator*> iters;
 public:
   explicit ShardMergeIteratorImpl(const RocksDBStore* db,
 				  const std::string& prefix,
-				  const std::vector<rocksdb::ColumnFamilyHandle*>& shards)
-    : db(db), keyless(db->comparator), prefix(prefix)
+				  const std::vector<rocksdb::ColumnFamilyHandle*>& shards,
+				  KeyValueDB::IteratorOpts opts,
+				  KeyValueDB::IteratorBounds bounds_)
+    : db(db), keyless(db->comparator), prefix(prefix), bounds(std::move(bounds_))
   {
+    rocksdb::ReadOptions ropts = db->get_iterator_read_options(
+      opts, bounds, &iterate_lower_bound, &iterate_upper_bound);
     iters.reserve(shards.size());
     for (auto& s : shards) {
-      iters.push_back(db->db->NewIterator(rocksdb::ReadOptions(), s));
+      iters.push_back(db->db->NewIterator(ropts, s));
     }
   }
   ~ShardMergeIteratorImpl() {
@@ -2761,23 +2814,67 @@ public:
   }
 };
 
-KeyValueDB::Iterator RocksDBStore::get_iterator(const std::string& prefix, IteratorOpts opts)
+KeyValueDB::Iterator RocksDBStore::get_iterator(const std::string& prefix,
+						IteratorOpts opts,
+						IteratorBounds bounds)
 {
   auto cf_it = cf_handles.find(prefix);
   if (cf_it != cf_handles.end()) {
-    if (cf_it->second.handles.size() == 1) {
+    // a bounded range may live in a single shard
+    if (auto cf = get_cf_handle(prefix, bounds); cf) {
       return std::make_shared<CFIteratorImpl>(
+        this,
         prefix,
-        db->NewIterator(rocksdb::ReadOptions(), cf_it->second.handles[0]));
+        cf,
+        opts,
+        std::move(bounds));
     } else {
       return std::make_shared<ShardMergeIteratorImpl>(
         this,
         prefix,
-        cf_it->second.handles);
+        cf_it->second.handles,
+        opts,
+        std::move(bounds));
     }
   } else {
-    return KeyValueDB::get_iterator(prefix, opts);
-  }
+    // keys in the default column family carry the prefix; never step
+    // out of it
+    IteratorBounds full;
+    full.lower_bound = combine_strings(prefix, bounds.lower_bound.value_or(""));
+    full.upper_bound = bounds.upper_bound ?
+      combine_strings(prefix, *bounds.upper_bound) : past_prefix(prefix);
+    return std::make_shared<PrefixIteratorImpl>(
+      prefix,
+      std::make_shared<RocksDBWholeSpaceIteratorImpl>(
+	this, default_cf, opts, std::move(full)));
+  }
+}
+
+rocksdb::ReadOptions RocksDBStore::get_iterator_read_options(
+  IteratorOpts opts,
+  const IteratorBounds& bounds,
+  rocksdb::Slice* lower,
+  rocksdb::Slice* upper) const
+{
+  rocksdb::ReadOptions ropts;
+  if (opts & ITERATOR_NOCACHE) {
+    ropts.fill_cache = false;
+  }
+  if (opts & ITERATOR_SCAN) {
+    // 0 leaves it to rocksdb, which ramps readahead up by itself once
+    // it sees sequential reads
+    ropts.readahead_size =
+      cct->_conf.get_val<Option::size_t>("rocksdb_iterator_scan_readahead");
+  }
+  if (bounds.lower_bound) {
+    *lower = rocksdb::Slice(*bounds.lower_bound);
+    ropts.iterate_lower_bound = lower;
+  }
+  if (bounds.upper_bound) {
+    *upper = rocksdb::Slice(*bounds.upper_bound);
+    ropts.iterate_upper_bound = upper;
+  }
+  return ropts;
 }
 
 rocksdb::Iterator* RocksDBStore::new_shard_iterator(rocksdb::ColumnFamilyHandle* cf)
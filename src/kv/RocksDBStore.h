@@ -84,6 +84,7 @@ class RocksDBStore : public KeyValueDB {
   uint64_t cache_size = 0;
   bool set_cache_flag = false;
   friend class ShardMergeIteratorImpl;
+  friend class CFIteratorImpl;
   friend class WholeMergeIteratorImpl;
   /*
    *  See RocksDB's definition of a column family(CF) and how to use it.
@@ -121,6 +122,7 @@ private:
   bool is_column_family(const std::string& prefix);
   rocksdb::ColumnFamilyHandle *get_cf_handle(const std::string& prefix, const std::string& key);
   rocksdb::ColumnFamilyHandle *get_cf_handle(const std::string& prefix, const char* key, size_t keylen);
+  rocksdb::ColumnFamilyHandle *get_cf_handle(const std::string& prefix, const IteratorBounds& bounds);
 
   int submit_common(rocksdb::WriteOptions& woptions, KeyValueDB::Transaction t);
   int install_cf_mergeop(const std::string &cf_name, rocksdb::ColumnFamilyOptions *cf_opt);
@@ -257,6 +259,10 @@ public:
     const std::string &property,
     uint64_t *out) final;
 
+  uint64_t get_latest_sequence_number() override {
+    return db->GetLatestSequenceNumber();
+  }
+
   int64_t estimate_prefix_size(const std::string& prefix,
 			       const std::string& key_prefix) override;
   struct RocksWBHandler;
@@ -332,9 +338,16 @@ public:
     public KeyValueDB::WholeSpaceIteratorImpl {
   protected:
     rocksdb::Iterator *dbiter;
+    IteratorBounds bounds;
+    rocksdb::Slice iterate_lower_bound, iterate_upper_bound;
   public:
     explicit RocksDBWholeSpaceIteratorImpl(rocksdb::Iterator *iter) :
       dbiter(iter) { }
+    /// bounds are full keys, i.e. prefix included
+    RocksDBWholeSpaceIteratorImpl(const RocksDBStore* store,
+				  rocksdb::ColumnFamilyHandle* cf,
+				  IteratorOpts opts,
+				  IteratorBounds bounds);
     //virtual ~RocksDBWholeSpaceIteratorImpl() { }
     ~RocksDBWholeSpaceIteratorImpl() override;
 
@@ -357,10 +370,17 @@ public:
     size_t value_size() override;
   };
 
-  Iterator get_iterator(const std::string& prefix, IteratorOpts opts = 0) override;
+  Iterator get_iterator(const std::string& prefix, IteratorOpts opts = 0,
+			IteratorBounds bounds = IteratorBounds()) override;
 private:
   /// this iterator spans single cf
   rocksdb::Iterator* new_shard_iterator(rocksdb::ColumnFamilyHandle* cf);
+  /// read options for an iterator; the bound slices, which must outlive
+  /// the iterator, point into bounds
+  rocksdb::ReadOptions get_iterator_read_options(IteratorOpts opts,
+						 const IteratorBounds& bounds,
+						 rocksdb::Slice* lower,
+						 rocksdb::Slice* upper) const;
 public:
   /// Utility
   static std::string combine_strings(const std::string &prefix, const std::string &value) {
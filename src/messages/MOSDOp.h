@@ -36,7 +36,7 @@ namespace _mosdop {
 template<typename V>
 class MOSDOp final : public MOSDFastDispatchOp {
 private:
-  static constexpr int HEAD_VERSION = 8;
+  static constexpr int HEAD_VERSION = 9;
   static constexpr int COMPAT_VERSION = 3;
 
 private:
@@ -65,6 +65,12 @@ private:
   bool bdata_encode;
   osd_reqid_t reqid; // reqid explicitly set by sender
 
+  // dmclock distributed tags: replies (delta) and reservation-phase
+  // replies (rho) received from other osds since the last request here
+  uint32_t qos_delta = 0;
+  uint32_t qos_rho = 0;
+  int8_t qos_phase = -1;  // mclock phase served in, echoed in the reply
+
 public:
   friend MOSDOpReply;
 
@@ -163,6 +169,22 @@ public:
   int get_retry_attempt() const {
     return retry_attempt;
   }
+
+  void set_qos_params(uint32_t delta, uint32_t rho) {
+    qos_delta = delta;
+    qos_rho = rho;
+  }
+  uint32_t get_qos_delta() const {
+    ceph_assert(!partial_decode_needed);
+    return qos_delta;
+  }
+  uint32_t get_qos_rho() const {
+    ceph_assert(!partial_decode_needed);
+    return qos_rho;
+  }
+  void set_qos_phase(int8_t phase) { qos_phase = phase; }
+  int8_t get_qos_phase() const { return qos_phase; }
+
   uint64_t get_features() const {
     if (features)
       return features;
@@ -361,8 +383,8 @@ struct ceph_osd_request_head {
       encode(retry_attempt, payload);
       encode(features, payload);
     } else {
-      // latest v8 encoding with hobject_t hash separate from pgid, no
-      // reassert version
+      // latest v9 encoding with hobject_t hash separate from pgid, no
+      // reassert version; v8 lacks the qos tags
       header.version = HEAD_VERSION;
 
       encode(pgid, payload);
@@ -371,6 +393,12 @@ struct ceph_osd_request_head {
       encode(flags, payload);
       encode(reqid, payload);
       encode_trace(payload, features);
+      if (HAVE_FEATURE(features, SERVER_PACIFIC)) {
+	encode(qos_delta, payload);
+	encode(qos_rho, payload);
+      } else {
+	header.version = 8;
+      }
 
       // -- above decoded up front; below decoded post-dispatch thread --
 
@@ -399,7 +427,7 @@ struct ceph_osd_request_head {
     p = std::cbegin(payload);
 
     // Always keep here the newest version of decoding order/rule
-    if (header.version == HEAD_VERSION) {
+    if (header.version >= 8) {
       decode(pgid, p);      // actual pgid
       uint32_t hash;
       decode(hash, p); // raw hash value
@@ -408,6 +436,10 @@ struct ceph_osd_request_head {
       decode(flags, p);
       decode(reqid, p);
       decode_trace(p);
+      if (header.version >= 9) {
+	decode(qos_delta, p);
+	decode(qos_rho, p);
+      }
     } else if (header.version == 7) {
       decode(pgid.pgid, p);      // raw pgid
       hobj.set_hash(pgid.pgid.ps());
@@ -31,7 +31,7 @@
 
 class MOSDOpReply final : public Message {
 private:
-  static constexpr int HEAD_VERSION = 8;
+  static constexpr int HEAD_VERSION = 9;
   static constexpr int COMPAT_VERSION = 2;
 
   object_t oid;
@@ -47,6 +47,7 @@ private:
   int32_t retry_attempt = -1;
   bool do_redirect;
   request_redirect_t redirect;
+  int8_t qos_phase = -1;  ///< dmclock phase served in, -1 if not mclock
 
 public:
   const object_t& get_oid() const { return oid; }
@@ -96,6 +97,8 @@ public:
 
   void add_flags(int f) { flags |= f; }
 
+  int8_t get_qos_phase() const { return qos_phase; }
+
   void claim_op_out_data(std::vector<OSDOp>& o) {
     ceph_assert(ops.size() == o.size());
     for (unsigned i = 0; i < o.size(); i++) {
@@ -154,6 +157,7 @@ public:
     user_version = 0;
     retry_attempt = req->get_retry_attempt();
     do_redirect = false;
+    qos_phase = req->get_qos_phase();
 
     for (unsigned i = 0; i < ops.size(); i++) {
       // zero out input data
@@ -223,6 +227,7 @@ public:
         }
       }
       encode_trace(payload, features);
+      encode(qos_phase, payload);
     }
   }
   void decode_payload() override {
@@ -256,6 +261,7 @@ public:
       if (do_redirect)
 	decode(redirect, p);
       decode_trace(p);
+      decode(qos_phase, p);
     } else if (header.version < 2) {
       ceph_osd_reply_head head;
       decode(head, p);
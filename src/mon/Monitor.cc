@@ -751,6 +751,14 @@ int Monitor::preinit()
         "ewon", PerfCountersBuilder::PRIO_INTERESTING);
     pcb.add_u64_counter(l_mon_election_lose, "election_lose", "Elections lost",
         "elst", PerfCountersBuilder::PRIO_INTERESTING);
+    pcb.add_u64_counter(l_mon_osdmap_encode_hit, "osdmap_encode_hit",
+        "OSDMaps sent from the encode cache");
+    pcb.add_u64_counter(l_mon_osdmap_encode_miss, "osdmap_encode_miss",
+        "OSDMaps read and encoded when sent");
+    pcb.add_u64_counter(l_mon_osdmap_encode_prefill, "osdmap_encode_prefill",
+        "OSDMaps encoded in advance for subscribers' features");
+    pcb.add_time_avg(l_mon_osdmap_encode_lat, "osdmap_encode_lat",
+        "Latency of reading and encoding an OSDMap for a feature set");
     logger = pcb.create_perf_counters();
     cct->get_perfcounters_collection()->add(logger);
   }
@@ -96,6 +96,10 @@ enum {
   l_mon_election_call,
   l_mon_election_win,
   l_mon_election_lose,
+  l_mon_osdmap_encode_hit,
+  l_mon_osdmap_encode_miss,
+  l_mon_osdmap_encode_prefill,
+  l_mon_osdmap_encode_lat,
   l_mon_last,
 };
 
@@ -113,6 +113,7 @@ using ceph::ErasureCodeProfile;
 using ceph::Formatter;
 using ceph::JSONFormatter;
 using ceph::make_message;
+using ceph::mono_clock;
 
 #define dout_subsys ceph_subsys_mon
 static const string OSD_PG_CREATING_PREFIX("osd_pg_creating");
@@ -450,6 +451,7 @@ OSDMonitor::OSDMonitor(
    cct(cct),
    inc_osd_cache(g_conf()->mon_osd_cache_size),
    full_osd_cache(g_conf()->mon_osd_cache_size),
+   encode_wq(this, &mn.cpu_tp),
    has_osdmap_manifest(false),
    mapper(mn.cct, &mn.cpu_tp)
 {
@@ -929,6 +931,7 @@ void OSDMonitor::update_from_paxos(bool *need_bootstrap)
   }
   // XXX: need to trim MonSession connected with a osd whose id > max_osd?
 
+  prefill_encoded(osdmap.get_epoch());
   check_osdmap_subs();
   check_pg_creates_subs();
 
@@ -1130,6 +1133,8 @@ void OSDMonitor::on_shutdown()
   list<MonOpRequestRef> ls;
   take_all_failures(ls);
   ls.clear();
+
+  encode_wq.drain();
 }
 
 void OSDMonitor::update_logger()
@@ -1615,7 +1620,7 @@ void OSDMonitor::encode_pending(MonitorDBStore::TransactionRef t)
 	pending_inc.new_last_in_change = pending_inc.modified;
         break;
       }
-    } else if (!!i.second != !!osdmap.osd_weight[i.first]) {
+    } else if (!!i.second != !!osdmap.get_weight(i.first)) {
       // existing osd marked in or out
       pending_inc.new_last_in_change = pending_inc.modified;
       break;
@@ -3081,7 +3086,7 @@ bool OSDMonitor::prepare_mark_me_dead(MonOpRequestRef op)
   mon.clog->info() << "osd." << target_osd << " marked itself dead as of e"
 		    << m->get_epoch();
   if (!pending_inc.new_xinfo.count(target_osd)) {
-    pending_inc.new_xinfo[target_osd] = osdmap.osd_xinfo[target_osd];
+    pending_inc.new_xinfo[target_osd] = osdmap.get_xinfo(target_osd);
   }
   pending_inc.new_xinfo[target_osd].dead_epoch = m->get_epoch();
   wait_for_finished_proposal(
@@ -3293,7 +3298,7 @@ void OSDMonitor::force_failure(int target_osd, int by)
   dout(1) << " we're forcing failure of osd." << target_osd << dendl;
   pending_inc.new_state[target_osd] = CEPH_OSD_UP;
   if (!pending_inc.new_xinfo.count(target_osd)) {
-    pending_inc.new_xinfo[target_osd] = osdmap.osd_xinfo[target_osd];
+    pending_inc.new_xinfo[target_osd] = osdmap.get_xinfo(target_osd);
   }
   pending_inc.new_xinfo[target_osd].dead_epoch = pending_inc.epoch;
 
@@ -3432,7 +3437,7 @@ bool OSDMonitor::grace_interval_threshold_exceeded(int last_failed_interval)
 void OSDMonitor::set_default_laggy_params(int target_osd)
 {
   if (pending_inc.new_xinfo.count(target_osd) == 0) {
-    pending_inc.new_xinfo[target_osd] = osdmap.osd_xinfo[target_osd];
+    pending_inc.new_xinfo[target_osd] = osdmap.get_xinfo(target_osd);
   }
   osd_xinfo_t& xi = pending_inc.new_xinfo[target_osd];
   xi.down_stamp = pending_inc.modified;
@@ -3683,7 +3688,7 @@ bool OSDMonitor::prepare_boot(MonOpRequestRef op)
     }
 
     if (pending_inc.new_xinfo.count(from) == 0)
-      pending_inc.new_xinfo[from] = osdmap.osd_xinfo[from];
+      pending_inc.new_xinfo[from] = osdmap.get_xinfo(from);
     osd_xinfo_t& xi = pending_inc.new_xinfo[from];
     if (m->boot_epoch == 0) {
       xi.laggy_probability *= (1.0 - g_conf()->mon_osd_laggy_weight);
@@ -4401,10 +4406,10 @@ bool OSDMonitor::prepare_beacon(MonOpRequestRef op)
     last_epoch_clean.report(pg, beacon->min_last_epoch_clean);
   }
 
-  if (osdmap.osd_xinfo[from].last_purged_snaps_scrub <
+  if (osdmap.get_xinfo(from).last_purged_snaps_scrub <
       beacon->last_purged_snaps_scrub) {
     if (pending_inc.new_xinfo.count(from) == 0) {
-      pending_inc.new_xinfo[from] = osdmap.osd_xinfo[from];
+      pending_inc.new_xinfo[from] = osdmap.get_xinfo(from);
     }
     pending_inc.new_xinfo[from].last_purged_snaps_scrub =
       beacon->last_purged_snaps_scrub;
@@ -4476,6 +4481,7 @@ void OSDMonitor::send_full(MonOpRequestRef op)
 {
   op->mark_osdmon_event(__func__);
   dout(5) << "send_full to " << op->get_req()->get_orig_source_inst() << dendl;
+  note_subscriber_features(op->get_session()->con_features);
   mon.send_reply(op, build_latest_full(op->get_session()->con_features));
 }
 
@@ -4512,6 +4518,7 @@ void OSDMonitor::send_incremental(epoch_t first,
   // use quorum_con_features, if it's an anonymous connection.
   uint64_t features = session->con_features ? session->con_features :
     mon.get_quorum_con_features();
+  note_subscriber_features(features);
 
   if (first <= session->osd_epoch) {
     dout(10) << __func__ << " " << session->name << " should already have epoch "
@@ -4609,12 +4616,121 @@ void OSDMonitor::reencode_full_map(bufferlist& bl, uint64_t features)
   m.encode(bl, f | CEPH_FEATURE_RESERVED);
 }
 
+bool OSDMonitor::lookup_encoded(osdmap_cache_t& cache, version_t ver,
+				uint64_t significant_features, bool full,
+				bufferlist *bl)
+{
+  {
+    // don't wait for cpu_tp, which may be busy mapping pgs: claim the
+    // prefill if it hasn't run yet and let the caller encode inline
+    std::lock_guard l(encode_lock);
+    if (encoding.erase({ver, significant_features, full})) {
+      dout(20) << __func__ << " e" << ver << (full ? " full" : " inc")
+	       << " features 0x" << std::hex << significant_features
+	       << std::dec << " still being prefilled" << dendl;
+    }
+  }
+  if (cache.lookup({ver, significant_features}, bl)) {
+    mon.logger->inc(l_mon_osdmap_encode_hit);
+    return true;
+  }
+  mon.logger->inc(l_mon_osdmap_encode_miss);
+  return false;
+}
+
+void OSDMonitor::note_subscriber_features(uint64_t features)
+{
+  uint64_t significant_features = OSDMap::get_significant_features(features);
+  if (significant_features ==
+      OSDMap::get_significant_features(mon.get_quorum_con_features())) {
+    // that's what we commit with; there is nothing to encode
+    return;
+  }
+  subscriber_features[significant_features] = {features, osdmap.get_epoch()};
+}
+
+void OSDMonitor::prefill_encoded(epoch_t e)
+{
+  if (!g_conf().get_val<bool>("mon_osd_cache_prefill") ||
+      mon.cpu_tp.get_num_threads() == 0) {
+    // nothing would ever run the prefill
+    subscriber_features.clear();
+    return;
+  }
+  // forget about feature sets nobody asked for in a while
+  const epoch_t max_idle = g_conf()->mon_min_osdmap_epochs;
+  uint64_t quorum_features = mon.get_quorum_con_features();
+  for (auto p = subscriber_features.begin();
+       p != subscriber_features.end(); ) {
+    if (p->second.second + max_idle < e ||
+	p->first == OSDMap::get_significant_features(quorum_features)) {
+      p = subscriber_features.erase(p);
+      continue;
+    }
+    for (bool full : {false, true}) {
+      {
+	std::lock_guard l(encode_lock);
+	if (!encoding.insert({e, p->first, full}).second) {
+	  continue;
+	}
+      }
+      dout(20) << __func__ << " e" << e << (full ? " full" : " inc")
+	       << " features 0x" << std::hex << p->first << std::dec
+	       << dendl;
+      encode_wq.queue(new encode_item_t{e, p->second.first, quorum_features,
+					full});
+    }
+    ++p;
+  }
+}
+
+void OSDMonitor::encode_one(const encode_item_t& i)
+{
+  uint64_t significant_features = OSDMap::get_significant_features(i.features);
+  {
+    std::lock_guard l(encode_lock);
+    if (!encoding.count({i.ver, significant_features, i.full})) {
+      // claimed by a lookup, which encoded it inline
+      return;
+    }
+  }
+  auto& cache = i.full ? full_osd_cache : inc_osd_cache;
+  bufferlist bl;
+  if (!cache.lookup({i.ver, significant_features}, &bl)) {
+    auto start = mono_clock::now();
+    int r = i.full ? PaxosService::get_version_full(i.ver, bl) :
+      PaxosService::get_version(i.ver, bl);
+    if (r >= 0) {
+      if (significant_features !=
+	  OSDMap::get_significant_features(i.quorum_features)) {
+	if (i.full) {
+	  reencode_full_map(bl, i.features);
+	} else {
+	  reencode_incremental_map(bl, i.features);
+	}
+      }
+      cache.add_bytes({i.ver, significant_features}, bl);
+      mon.logger->inc(l_mon_osdmap_encode_prefill);
+      mon.logger->tinc(l_mon_osdmap_encode_lat, mono_clock::now() - start);
+    }
+  }
+  std::lock_guard l(encode_lock);
+  encoding.erase({i.ver, significant_features, i.full});
+}
+
+void OSDMonitor::EncodeWQ::_process(encode_item_t *i, ThreadPool::TPHandle &h)
+{
+  osdmon->encode_one(*i);
+  delete i;
+}
+
 int OSDMonitor::get_version(version_t ver, uint64_t features, bufferlist& bl)
 {
   uint64_t significant_features = OSDMap::get_significant_features(features);
-  if (inc_osd_cache.lookup({ver, significant_features}, &bl)) {
+  if (lookup_encoded(inc_osd_cache, ver, significant_features, false, &bl)) {
     return 0;
   }
+  auto start = mono_clock::now();
   int ret = PaxosService::get_version(ver, bl);
   if (ret < 0) {
     return ret;
@@ -4628,6 +4744,7 @@ int OSDMonitor::get_version(version_t ver, uint64_t features, bufferlist& bl)
     reencode_incremental_map(bl, features);
   }
   inc_osd_cache.add_bytes({ver, significant_features}, bl);
+  mon.logger->tinc(l_mon_osdmap_encode_lat, mono_clock::now() - start);
   return 0;
 }
 
@@ -4757,9 +4874,10 @@ int OSDMonitor::get_version_full(version_t ver, uint64_t features,
 				 bufferlist& bl)
 {
   uint64_t significant_features = OSDMap::get_significant_features(features);
-  if (full_osd_cache.lookup({ver, significant_features}, &bl)) {
+  if (lookup_encoded(full_osd_cache, ver, significant_features, true, &bl)) {
     return 0;
   }
+  auto start = mono_clock::now();
   int ret = PaxosService::get_version_full(ver, bl);
   if (ret == -ENOENT) {
     // build map?
@@ -4777,6 +4895,7 @@ int OSDMonitor::get_version_full(version_t ver, uint64_t features,
     reencode_full_map(bl, features);
   }
   full_osd_cache.add_bytes({ver, significant_features}, bl);
+  mon.logger->tinc(l_mon_osdmap_encode_lat, mono_clock::now() - start);
   return 0;
 }
 
@@ -5203,8 +5322,8 @@ void OSDMonitor::tick()
 
 	  // remember previous weight
 	  if (pending_inc.new_xinfo.count(o) == 0)
-	    pending_inc.new_xinfo[o] = osdmap.osd_xinfo[o];
-	  pending_inc.new_xinfo[o].old_weight = osdmap.osd_weight[o];
+	    pending_inc.new_xinfo[o] = osdmap.get_xinfo(o);
+	  pending_inc.new_xinfo[o].old_weight = osdmap.get_weight(o);
 
 	  do_propose = true;
 
@@ -5397,7 +5516,8 @@ namespace {
     CSUM_TYPE, CSUM_MAX_BLOCK, CSUM_MIN_BLOCK, FINGERPRINT_ALGORITHM,
     PG_AUTOSCALE_MODE, PG_NUM_MIN, TARGET_SIZE_BYTES, TARGET_SIZE_RATIO,
     PG_AUTOSCALE_BIAS, DEDUP_TIER, DEDUP_CHUNK_ALGORITHM, 
-    DEDUP_CDC_CHUNK_SIZE };
+    DEDUP_CDC_CHUNK_SIZE, MCLOCK_CLIENT_RES, MCLOCK_CLIENT_WGT,
+    MCLOCK_CLIENT_LIM };
 
   std::set<osd_pool_get_choices>
     subtract_second_from_first(const std::set<osd_pool_get_choices>& first,
@@ -6135,6 +6255,9 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
       {"dedup_tier", DEDUP_TIER},
       {"dedup_chunk_algorithm", DEDUP_CHUNK_ALGORITHM},
       {"dedup_cdc_chunk_size", DEDUP_CDC_CHUNK_SIZE},
+      {"mclock_client_res", MCLOCK_CLIENT_RES},
+      {"mclock_client_wgt", MCLOCK_CLIENT_WGT},
+      {"mclock_client_lim", MCLOCK_CLIENT_LIM},
     };
 
     typedef std::set<osd_pool_get_choices> choices_set_t;
@@ -6354,6 +6477,9 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	  case DEDUP_TIER:
 	  case DEDUP_CHUNK_ALGORITHM:
 	  case DEDUP_CDC_CHUNK_SIZE:
+	  case MCLOCK_CLIENT_RES:
+	  case MCLOCK_CLIENT_WGT:
+	  case MCLOCK_CLIENT_LIM:
             pool_opts_t::key_t key = pool_opts_t::get_opt_desc(i->first).key;
             if (p->opts.is_set(key)) {
               if(*it == CSUM_TYPE) {
@@ -6514,6 +6640,9 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	  case DEDUP_TIER:
 	  case DEDUP_CHUNK_ALGORITHM:
 	  case DEDUP_CDC_CHUNK_SIZE:
+	  case MCLOCK_CLIENT_RES:
+	  case MCLOCK_CLIENT_WGT:
+	  case MCLOCK_CLIENT_LIM:
 	    for (i = ALL_CHOICES.begin(); i != ALL_CHOICES.end(); ++i) {
 	      if (i->second == *it)
 		break;
@@ -8716,6 +8845,19 @@ int OSDMonitor::prepare_command_pool_set(const cmdmap_t& cmdmap,
         ss << "error parsing int value '" << val << "': " << interr;
         return -EINVAL;
       }
+    } else if (var == "mclock_client_res" ||
+	       var == "mclock_client_wgt" ||
+	       var == "mclock_client_lim") {
+      if (!unset) {
+        if (interr.length()) {
+          ss << "error parsing int value '" << val << "': " << interr;
+          return -EINVAL;
+        }
+        if (n < 0) {
+          ss << var << " must be non-negative";
+          return -EINVAL;
+        }
+      }
     }
 
     pool_opts_t::opt_desc_t desc = pool_opts_t::get_opt_desc(var);
@@ -11555,7 +11697,7 @@ bool OSDMonitor::prepare_command_impl(MonOpRequestRef op,
 	  }
 	  if (definitely_dead) {
 	    if (!pending_inc.new_xinfo.count(osd)) {
-	      pending_inc.new_xinfo[osd] = osdmap.osd_xinfo[osd];
+	      pending_inc.new_xinfo[osd] = osdmap.get_xinfo(osd);
 	    }
 	    if (pending_inc.new_xinfo[osd].dead_epoch < pending_inc.epoch) {
 	      any = true;
@@ -11568,11 +11710,11 @@ bool OSDMonitor::prepare_command_impl(MonOpRequestRef op,
 	      ss << "osd." << osd << " is already out. ";
 	  } else {
 	    pending_inc.new_weight[osd] = CEPH_OSD_OUT;
-	    if (osdmap.osd_weight[osd]) {
+	    if (osdmap.get_weight(osd)) {
 	      if (pending_inc.new_xinfo.count(osd) == 0) {
-	        pending_inc.new_xinfo[osd] = osdmap.osd_xinfo[osd];
+	        pending_inc.new_xinfo[osd] = osdmap.get_xinfo(osd);
 	      }
-	      pending_inc.new_xinfo[osd].old_weight = osdmap.osd_weight[osd];
+	      pending_inc.new_xinfo[osd].old_weight = osdmap.get_weight(osd);
 	    }
 	    ss << "marked out osd." << osd << ". ";
             std::ostringstream msg;
@@ -11594,10 +11736,10 @@ bool OSDMonitor::prepare_command_impl(MonOpRequestRef op,
             if (verbose)
 	      ss << "osd." << osd << " is already in. ";
 	  } else {
-	    if (osdmap.osd_xinfo[osd].old_weight > 0) {
-	      pending_inc.new_weight[osd] = osdmap.osd_xinfo[osd].old_weight;
+	    if (osdmap.get_xinfo(osd).old_weight > 0) {
+	      pending_inc.new_weight[osd] = osdmap.get_xinfo(osd).old_weight;
 	      if (pending_inc.new_xinfo.count(osd) == 0) {
-	        pending_inc.new_xinfo[osd] = osdmap.osd_xinfo[osd];
+	        pending_inc.new_xinfo[osd] = osdmap.get_xinfo(osd);
 	      }
 	      pending_inc.new_xinfo[osd].old_weight = 0;
 	    } else {
@@ -14154,7 +14296,7 @@ int OSDMonitor::_prepare_remove_pool(
     }
   }
   // remove any pg_upmap mappings for this pool
-  for (auto& p : osdmap.pg_upmap) {
+  for (auto& p : *osdmap.pg_upmap) {
     if (p.first.pool() == pool) {
       dout(10) << __func__ << " " << pool
                << " removing obsolete pg_upmap "
@@ -14177,7 +14319,7 @@ int OSDMonitor::_prepare_remove_pool(
     }
   }
   // remove any pg_upmap_items mappings for this pool
-  for (auto& p : osdmap.pg_upmap_items) {
+  for (auto& p : *osdmap.pg_upmap_items) {
     if (p.first.pool() == pool) {
       dout(10) << __func__ << " " << pool
                << " removing obsolete pg_upmap_items " << p.first
@@ -21,8 +21,10 @@
 #ifndef CEPH_OSDMONITOR_H
 #define CEPH_OSDMONITOR_H
 
+#include <deque>
 #include <map>
 #include <set>
+#include <tuple>
 #include <utility>
 
 #include "include/types.h"
@@ -240,6 +242,67 @@ public:
   osdmap_cache_t inc_osd_cache;
   osdmap_cache_t full_osd_cache;
 
+  /*
+   * New epochs are encoded on the cpu threads, ahead of the subscribers
+   * asking for them, for every feature set they have recently asked
+   * with.  Lookups wait for an encode in progress rather than redoing it.
+   */
+  struct encode_item_t {
+    version_t ver;
+    uint64_t features;
+    uint64_t quorum_features;
+    bool full;
+  };
+  std::deque<encode_item_t*> encode_q;
+
+  struct EncodeWQ : public ThreadPool::WorkQueue<encode_item_t> {
+    OSDMonitor *osdmon;
+
+    EncodeWQ(OSDMonitor *o, ThreadPool *tp)
+      : ThreadPool::WorkQueue<encode_item_t>("OSDMonitor::EncodeWQ",
+					     ceph::timespan::zero(),
+					     ceph::timespan::zero(),
+					     tp),
+	osdmon(o) {}
+
+    bool _enqueue(encode_item_t *i) override {
+      osdmon->encode_q.push_back(i);
+      return true;
+    }
+    void _dequeue(encode_item_t *i) override {
+      ceph_abort();
+    }
+    encode_item_t *_dequeue() override {
+      if (osdmon->encode_q.empty()) {
+	return nullptr;
+      }
+      encode_item_t *i = osdmon->encode_q.front();
+      osdmon->encode_q.pop_front();
+      return i;
+    }
+    void _process(encode_item_t *i, ThreadPool::TPHandle &h) override;
+    void _clear() override {
+      ceph_assert(_empty());
+    }
+    bool _empty() override {
+      return osdmon->encode_q.empty();
+    }
+  } encode_wq;
+
+  ceph::mutex encode_lock = ceph::make_mutex("OSDMonitor::encode_lock");
+  /// (version, significant features, full) queued for prefill; a lookup
+  /// that finds its item here claims it rather than waiting for it
+  std::set<std::tuple<version_t, uint64_t, bool>> encoding;
+  /// significant features -> (features, last epoch sent with them)
+  std::map<uint64_t, std::pair<uint64_t, epoch_t>> subscriber_features;
+
+  bool lookup_encoded(osdmap_cache_t& cache, version_t ver,
+		      uint64_t significant_features, bool full,
+		      ceph::buffer::list *bl);
+  void note_subscriber_features(uint64_t features);
+  void prefill_encoded(epoch_t e);
+  void encode_one(const encode_item_t& i);
+
   bool has_osdmap_manifest;
   osdmap_manifest_t osdmap_manifest;
 
@@ -1163,8 +1163,10 @@ void PGMap::apply_incremental(CephContext *cct, const Incremental& inc)
     auto pg_stat_iter = pg_stat.find(update_pg);
     pool_stat_t &pool_sum_ref = pg_pool_sum[update_pool];
     if (pg_stat_iter == pg_stat.end()) {
+      update_purged_snaps(update_pool, nullptr, &update_stat);
       pg_stat.insert(make_pair(update_pg, update_stat));
     } else {
+      update_purged_snaps(update_pool, &pg_stat_iter->second, &update_stat);
       stat_pg_sub(update_pg, pg_stat_iter->second);
       pool_sum_ref.sub(pg_stat_iter->second);
       pg_stat_iter->second = update_stat;
@@ -1217,6 +1219,7 @@ void PGMap::apply_incremental(CephContext *cct, const Incremental& inc)
     auto s = pg_stat.find(removed_pg);
     bool pool_erased = false;
     if (s != pg_stat.end()) {
+      update_purged_snaps(removed_pg.pool(), &s->second, nullptr);
       pool_erased = stat_pg_sub(removed_pg, s->second);
 
       // decrease pool stats if pg was removed
@@ -1295,6 +1298,10 @@ void PGMap::calc_stats()
   pg_sum = pool_stat_t();
   osd_sum = osd_stat_t();
   osd_sum_by_class.clear();
+  osd_class.clear();
+  osd_class_epoch = 0;
+  purged_snaps_valid = false;
+  purged_snaps_dirty.clear();
   num_pg_by_state.clear();
   num_pg_by_pool_state.clear();
   num_pg_by_osd.clear();
@@ -1453,11 +1460,54 @@ bool PGMap::stat_pg_sub(const pg_t &pgid, const pg_stat_t &s,
   return pool_erased;
 }
 
+void PGMap::update_purged_snaps(int64_t pool,
+				const pg_stat_t *old_stat,
+				const pg_stat_t *new_stat)
+{
+  if (!purged_snaps_valid || purged_snaps_dirty.count(pool)) {
+    return;
+  }
+  if ((old_stat && old_stat->state == 0) ||
+      (new_stat && new_stat->state == 0)) {
+    // the pool has or had unknown pgs
+    purged_snaps_dirty.insert(pool);
+    return;
+  }
+  if (old_stat && new_stat &&
+      old_stat->purged_snaps == new_stat->purged_snaps) {
+    return;
+  }
+  auto p = purged_snaps.find(pool);
+  if (!old_stat && p != purged_snaps.end()) {
+    // a new pg can only shrink the intersection
+    p->second.intersection_of(new_stat->purged_snaps);
+    return;
+  }
+  // a changed or removed pg may grow it, or this is the pool's first pg
+  purged_snaps_dirty.insert(pool);
+}
+
 void PGMap::calc_purged_snaps()
 {
-  purged_snaps.clear();
+  if (purged_snaps_valid && purged_snaps_dirty.empty()) {
+    return;
+  }
+  // recompute all pools, or only those an incremental has invalidated
+  auto dirty = [this](int64_t pool) {
+    return !purged_snaps_valid || purged_snaps_dirty.count(pool);
+  };
+  if (purged_snaps_valid) {
+    for (auto pool : purged_snaps_dirty) {
+      purged_snaps.erase(pool);
+    }
+  } else {
+    purged_snaps.clear();
+  }
   set<int64_t> unknown;
   for (auto& i : pg_stat) {
+    if (!dirty(i.first.pool())) {
+      continue;
+    }
     if (i.second.state == 0) {
       unknown.insert(i.first.pool());
       purged_snaps.erase(i.first.pool());
@@ -1473,23 +1523,43 @@ void PGMap::calc_purged_snaps()
       j->second.intersection_of(i.second.purged_snaps);
     }
   }
+  purged_snaps_valid = true;
+  purged_snaps_dirty.clear();
 }
 
 void PGMap::calc_osd_sum_by_class(const OSDMap& osdmap)
 {
+  if (osd_class_epoch && osd_class_epoch == osdmap.get_epoch()) {
+    // kept current by stat_osd_add/sub since the classes were last read
+    return;
+  }
   osd_sum_by_class.clear();
-  for (auto& i : osd_stat) {
-    const char *class_name = osdmap.crush->get_item_class(i.first);
+  osd_class.clear();
+  for (int osd = 0; osd < osdmap.get_max_osd(); ++osd) {
+    const char *class_name = osdmap.crush->get_item_class(osd);
     if (class_name) {
-      osd_sum_by_class[class_name].add(i.second);
+      osd_class[osd] = class_name;
     }
   }
+  for (auto& i : osd_stat) {
+    auto p = osd_class.find(i.first);
+    if (p != osd_class.end()) {
+      osd_sum_by_class[p->second].add(i.second);
+    }
+  }
+  osd_class_epoch = osdmap.get_epoch();
 }
 
 void PGMap::stat_osd_add(int osd, const osd_stat_t &s)
 {
   num_osd++;
   osd_sum.add(s);
+  if (osd_class_epoch) {
+    auto p = osd_class.find(osd);
+    if (p != osd_class.end()) {
+      osd_sum_by_class[p->second].add(s);
+    }
+  }
   if (osd >= (int)osd_last_seq.size()) {
     osd_last_seq.resize(osd + 1);
   }
@@ -1500,6 +1570,12 @@ void PGMap::stat_osd_sub(int osd, const osd_stat_t &s)
 {
   num_osd--;
   osd_sum.sub(s);
+  if (osd_class_epoch) {
+    auto p = osd_class.find(osd);
+    if (p != osd_class.end()) {
+      osd_sum_by_class[p->second].sub(s);
+    }
+  }
   ceph_assert(osd < (int)osd_last_seq.size());
   osd_last_seq[osd] = 0;
 }
@@ -307,6 +307,16 @@ public:
   mempool::pgmap::list<std::pair<pool_stat_t, utime_t> > pg_sum_deltas;
   mempool::pgmap::unordered_map<int64_t,mempool::pgmap::unordered_map<uint64_t,int32_t>> num_pg_by_pool_state;
 
+  // purged_snaps and osd_sum_by_class are kept current by
+  // apply_incremental() so that encode_digest() need not walk every pg
+  // and osd: pools whose purged_snaps must be recomputed (all of them
+  // unless purged_snaps_valid), and the crush class of each osd as of
+  // osd_class_epoch (0 if osd_sum_by_class is not being maintained).
+  mempool::pgmap::set<int64_t> purged_snaps_dirty;
+  bool purged_snaps_valid = false;
+  mempool::pgmap::unordered_map<int32_t,std::string> osd_class;
+  epoch_t osd_class_epoch = 0;
+
   utime_t stamp;
 
   void update_pool_deltas(
@@ -325,6 +335,8 @@ public:
     }
 
     pg_pool_sum.erase(pool);
+    purged_snaps.erase(pool);
+    purged_snaps_dirty.erase(pool);
     num_pg_by_pool_state.erase(pool);
     num_pg_by_pool.erase(pool);
     per_pool_sum_deltas.erase(pool);
@@ -333,6 +345,10 @@ public:
   }
 
  private:
+  void update_purged_snaps(int64_t pool,
+			   const pg_stat_t *old_stat,
+			   const pg_stat_t *new_stat);
+
   void update_delta(
     CephContext *cct,
     const utime_t ts,
@@ -369,6 +369,12 @@ void AsyncConnection::process() {
 
   ldout(async_msgr->cct, 20) << __func__ << dendl;
 
+  if (cs) {
+    // a pending send completion keeps the socket signalled, whether or
+    // not the protocol is going to read or write now
+    cs.reap_send_completions();
+  }
+
   switch (state) {
     case STATE_NONE: {
       ldout(async_msgr->cct, 20) << __func__ << " enter none state" << dendl;
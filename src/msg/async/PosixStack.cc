@@ -19,8 +19,12 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <algorithm>
+#include <deque>
 
 #include "PosixStack.h"
 
@@ -37,16 +41,100 @@
 #undef dout_prefix
 #define dout_prefix *_dout << "PosixStack "
 
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+#define HAVE_MSG_ZEROCOPY
+#endif
+
 class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   ceph::NetHandler &handler;
   int _fd;
   entity_addr_t sa;
   bool connected;
+  PerfCounters *logger;
+
+#ifdef HAVE_MSG_ZEROCOPY
+  /// data handed to the kernel with MSG_ZEROCOPY by one send() call; it
+  /// has to stay around until every sendmsg() involved is reported done
+  struct zc_pinned_t {
+    uint32_t first_seq;
+    uint32_t pending;   ///< sendmsg() calls not yet reported done
+    uint32_t calls;
+    uint64_t bytes;     ///< sent with MSG_ZEROCOPY
+    bool copied;        ///< the kernel fell back to copying
+    ceph::buffer::list bl;
+  };
+  uint64_t zc_min_size = 0;  ///< 0 if zero-copy is off for this socket
+  uint32_t zc_next_seq = 0;
+  uint32_t zc_calls = 0;
+  uint64_t zc_bytes = 0;
+  std::deque<zc_pinned_t> zc_pinned;
+
+  void zerocopy_done(uint32_t lo, uint32_t hi, bool copied) {
+    // notification ids wrap around, so work with offsets from lo
+    int32_t end = hi - lo;
+    for (auto p = zc_pinned.begin(); p != zc_pinned.end(); ) {
+      int32_t s = p->first_seq - lo;
+      int32_t e = s + (int32_t)p->calls - 1;
+      int32_t overlap = std::min(e, end) - std::max(s, 0) + 1;
+      if (overlap > 0) {
+        p->pending -= std::min<uint32_t>(overlap, p->pending);
+        p->copied |= copied;
+      }
+      if (p->pending == 0) {
+        logger->inc(p->copied ? l_msgr_send_copied_bytes :
+                    l_msgr_send_zerocopy_bytes, p->bytes);
+        p = zc_pinned.erase(p);
+      } else {
+        ++p;
+      }
+    }
+    if (copied) {
+      // the route (e.g. loopback) does not support it, so zero-copy would
+      // only add the notification overhead from now on
+      zc_min_size = 0;
+    }
+  }
+
+  void reap_zerocopy() {
+    while (!zc_pinned.empty()) {
+      char control[128];
+      struct msghdr msg;
+      // FIPS zeroization audit 20191115: this memset is not security related.
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(_fd, &msg, MSG_ERRQUEUE) < 0)
+        break;
+      for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm;
+           cm = CMSG_NXTHDR(&msg, cm)) {
+        if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+            !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+          continue;
+        auto serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+        if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+          continue;
+        zerocopy_done(serr->ee_info, serr->ee_data,
+                      serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED);
+      }
+    }
+  }
+#endif
 
  public:
   explicit PosixConnectedSocketImpl(ceph::NetHandler &h, const entity_addr_t &sa,
-				    int f, bool connected)
-      : handler(h), _fd(f), sa(sa), connected(connected) {}
+				    int f, bool connected, PerfCounters *l)
+      : handler(h), _fd(f), sa(sa), connected(connected), logger(l) {}
+
+  // completion notifications raise EPOLLERR until they are read off the
+  // error queue, so AsyncConnection reaps them on every wakeup
+  void enable_zerocopy(uint64_t min_size) {
+#ifdef HAVE_MSG_ZEROCOPY
+    int one = 1;
+    if (::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0)
+      zc_min_size = min_size;
+#endif
+  }
 
   int is_connected() override {
     if (connected)
@@ -63,6 +151,13 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
     }
   }
 
+  void reap_send_completions() override {
+#ifdef HAVE_MSG_ZEROCOPY
+    if (!zc_pinned.empty())
+      reap_zerocopy();
+#endif
+  }
+
   ssize_t read(char *buf, size_t len) override {
     #ifdef _WIN32
     ssize_t r = ::recv(_fd, buf, len, 0);
@@ -77,13 +172,18 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
   // return the sent length
   // < 0 means error occurred
   #ifndef _WIN32
-  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more)
+  ssize_t do_sendmsg(struct msghdr &msg, unsigned len, bool more)
   {
     size_t sent = 0;
+    int flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+#ifdef HAVE_MSG_ZEROCOPY
+    if (zc_min_size && len >= zc_min_size)
+      flags |= MSG_ZEROCOPY;
+#endif
     while (1) {
       MSGR_SIGPIPE_STOPPER;
       ssize_t r;
-      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+      r = ::sendmsg(_fd, &msg, flags);
       if (r < 0) {
         int err = ceph_sock_errno();
         if (err == EINTR) {
@@ -91,9 +191,22 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
         } else if (err == EAGAIN) {
           break;
         }
+#ifdef HAVE_MSG_ZEROCOPY
+        if (err == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+          // no room for more completion notifications, copy this one
+          flags &= ~MSG_ZEROCOPY;
+          continue;
+        }
+#endif
         return -err;
       }
 
+#ifdef HAVE_MSG_ZEROCOPY
+      if (flags & MSG_ZEROCOPY) {
+        ++zc_calls;
+        zc_bytes += r;
+      }
+#endif
       sent += r;
       if (len == sent) break;
 
@@ -115,6 +228,12 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 
   ssize_t send(ceph::buffer::list &bl, bool more) override {
     size_t sent_bytes = 0;
+#ifdef HAVE_MSG_ZEROCOPY
+    if (!zc_pinned.empty())
+      reap_zerocopy();
+    zc_calls = 0;
+    zc_bytes = 0;
+#endif
     auto pb = std::cbegin(bl.buffers());
     uint64_t left_pbrs = bl.get_num_buffers();
     while (left_pbrs) {
@@ -133,7 +252,7 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 	msglen += pb->length();
 	++pb;
       }
-      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+      ssize_t r = do_sendmsg(msg, msglen, left_pbrs || more);
       if (r < 0)
         return r;
 
@@ -150,8 +269,19 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
         bl.splice(sent_bytes, bl.length()-sent_bytes, &swapped);
         bl.swap(swapped);
       } else {
-        bl.clear();
+        swapped.swap(bl);
+      }
+      // "swapped" is what was sent now
+#ifdef HAVE_MSG_ZEROCOPY
+      if (zc_calls) {
+        zc_pinned.push_back(zc_pinned_t{zc_next_seq, zc_calls, zc_calls,
+                                        zc_bytes, false, std::move(swapped)});
+        zc_next_seq += zc_calls;
       }
+      logger->inc(l_msgr_send_copied_bytes, sent_bytes - zc_bytes);
+#else
+      logger->inc(l_msgr_send_copied_bytes, sent_bytes);
+#endif
     }
 
     return static_cast<ssize_t>(sent_bytes);
@@ -188,6 +318,7 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
     }
 
     if (total_sent_bytes) {
+      logger->inc(l_msgr_send_copied_bytes, total_sent_bytes);
       bufferlist swapped;
       if (total_sent_bytes < bl.length()) {
         bl.splice(total_sent_bytes, bl.length()-total_sent_bytes, &swapped);
@@ -259,7 +390,10 @@ int PosixServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &op
   out->set_sockaddr((sockaddr*)&ss);
   handler.set_priority(sd, opt.priority, out->get_family());
 
-  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(handler, *out, sd, true));
+  std::unique_ptr<PosixConnectedSocketImpl> csi(
+    new PosixConnectedSocketImpl(handler, *out, sd, true, w->get_perf_counter()));
+  if (w->cct->_conf.get_val<bool>("ms_tcp_zerocopy"))
+    csi->enable_zerocopy(w->cct->_conf.get_val<Option::size_t>("ms_tcp_zerocopy_min_size"));
   *sock = ConnectedSocket(std::move(csi));
   return 0;
 }
@@ -327,8 +461,11 @@ int PosixWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, C
   }
 
   net.set_priority(sd, opts.priority, addr.get_family());
-  *socket = ConnectedSocket(
-      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock)));
+  std::unique_ptr<PosixConnectedSocketImpl> csi(
+    new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock, perf_logger));
+  if (cct->_conf.get_val<bool>("ms_tcp_zerocopy"))
+    csi->enable_zerocopy(cct->_conf.get_val<Option::size_t>("ms_tcp_zerocopy_min_size"));
+  *socket = ConnectedSocket(std::move(csi));
   return 0;
 }
 
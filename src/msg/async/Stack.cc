@@ -20,6 +20,9 @@
 #include "common/Cond.h"
 #include "common/errno.h"
 #include "PosixStack.h"
+#ifdef HAVE_LIBURING
+#include "UringStack.h"
+#endif
 #ifdef HAVE_RDMA
 #include "rdma/RDMAStack.h"
 #endif
@@ -70,6 +73,10 @@ std::shared_ptr<NetworkStack> NetworkStack::create(CephContext *c,
 
   if (t == "posix")
     stack.reset(new PosixNetworkStack(c));
+#ifdef HAVE_LIBURING
+  else if (t == "uring")
+    stack.reset(new UringNetworkStack(c));
+#endif
 #ifdef HAVE_RDMA
   else if (t == "rdma")
     stack.reset(new RDMAStack(c));
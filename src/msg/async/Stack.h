@@ -32,6 +32,7 @@ class ConnectedSocketImpl {
   virtual void shutdown() = 0;
   virtual void close() = 0;
   virtual int fd() const = 0;
+  virtual void reap_send_completions() {}
 };
 
 class ConnectedSocket;
@@ -99,6 +100,15 @@ class ConnectedSocket {
   ssize_t send(ceph::buffer::list &bl, bool more) {
     return _csi->send(bl, more);
   }
+  /// Collects the completions of earlier sends.
+  ///
+  /// Called whenever the connection's socket wakes it up, so that
+  /// pending completions (e.g. MSG_ZEROCOPY notifications, which keep
+  /// the socket's error condition raised) are consumed even while the
+  /// connection is neither reading nor writing.
+  void reap_send_completions() {
+    _csi->reap_send_completions();
+  }
   /// Disables output to the socket.
   ///
   /// Current or future writes that have not been successfully flushed
@@ -203,6 +213,9 @@ enum {
   l_msgr_send_messages_queue_lat,
   l_msgr_handle_ack_lat,
 
+  l_msgr_send_zerocopy_bytes,
+  l_msgr_send_copied_bytes,
+
   l_msgr_last,
 };
 
@@ -246,6 +259,9 @@ class Worker {
     plb.add_time_avg(l_msgr_send_messages_queue_lat, "msgr_send_messages_queue_lat", "Network sent messages lat");
     plb.add_time_avg(l_msgr_handle_ack_lat, "msgr_handle_ack_lat", "Connection handle ack lat");
 
+    plb.add_u64_counter(l_msgr_send_zerocopy_bytes, "msgr_send_zerocopy_bytes", "Network bytes the kernel sent without copying (MSG_ZEROCOPY)", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_msgr_send_copied_bytes, "msgr_send_copied_bytes", "Network bytes copied into the socket", NULL, 0, unit_t(UNIT_BYTES));
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
   }
@@ -0,0 +1,758 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <deque>
+
+#include "liburing.h"
+
+#include "UringStack.h"
+
+#include "common/ceph_mutex.h"
+#include "common/errno.h"
+#include "common/dout.h"
+#include "include/compat.h"
+#include "include/sock_compat.h"
+
+#define dout_subsys ceph_subsys_ms
+#undef dout_prefix
+#define dout_prefix *_dout << "UringStack "
+
+/*
+ * Sockets are kept in blocking mode: io_uring completes a request on a
+ * blocking socket once it can make progress, while a non-blocking one
+ * would just bounce -EAGAIN back to us.  The event center never polls the
+ * sockets themselves.  Each one exposes an eventfd as its fd() instead,
+ * which is signalled whenever a completion changes what read(), send() or
+ * is_connected() would return, just like the RDMA stack does.
+ *
+ * Data is not received through the ring.  read() has the caller's buffer
+ * only for the duration of the call, so a receive issued ahead of it would
+ * have to land in a buffer of our own and be copied out again.  Instead
+ * the ring polls the socket for input, and read() recv()s straight into
+ * the caller's buffer, copying each byte once like the posix stack.
+ */
+
+static void notify_fd_signal(int fd)
+{
+  eventfd_write(fd, 1);
+}
+
+static void notify_fd_drain(int fd)
+{
+  eventfd_t v;
+  eventfd_read(fd, &v);
+}
+
+class UringSocket : public UringFile {
+  CephContext *cct;
+  UringWorker *worker;
+  entity_addr_t peer;
+  int sd;
+  int notify_fd;
+
+  ceph::mutex lock = ceph::make_mutex("UringSocket::lock");
+  int connected;       ///< 1 established, 0 in progress, < 0 failed
+  int error = 0;       ///< sticky socket error, reported by read()/send()
+  bool shut = false;
+  bool closed = false;
+
+  bool rx_polling = false;       ///< waiting for the socket to be readable
+
+  bool tx_inflight = false;
+  bool tx_more = false;
+  ceph::buffer::list pending_bl;   ///< claimed by send(), not yet submitted
+  ceph::buffer::list inflight_bl;  ///< referenced by the in-flight sendmsg
+  std::vector<struct iovec> tx_iov;
+  struct msghdr tx_msg;
+
+  void notify() {
+    notify_fd_signal(notify_fd);
+  }
+
+  void maybe_close_sd() {
+    if (closed && sd >= 0 && !tx_inflight) {
+      ::close(sd);
+      sd = -1;
+    }
+  }
+
+  void arm_poll() {
+    if (rx_polling || error || closed || connected != 1)
+      return;
+    io_uring_sqe *sqe = worker->get_sqe();
+    if (!sqe) {
+      error = -ESHUTDOWN;
+      notify();
+      return;
+    }
+    io_uring_prep_poll_add(sqe, sd, POLLIN);
+    worker->queue(sqe, new UringOp(shared_from_this(), UringOp::OP_POLL));
+    worker->get_uring_logger()->inc(l_msgr_uring_rx_polls);
+    rx_polling = true;
+  }
+
+  void start_send() {
+    ceph_assert(!tx_inflight);
+    inflight_bl.claim_append(pending_bl);
+    if (!inflight_bl.length() || error || connected != 1)
+      return;
+    io_uring_sqe *sqe = worker->get_sqe();
+    if (!sqe) {
+      error = -ESHUTDOWN;
+      notify();
+      return;
+    }
+    unsigned n = std::min<unsigned>(inflight_bl.get_num_buffers(), IOV_MAX);
+    tx_iov.resize(n);
+    auto pb = std::cbegin(inflight_bl.buffers());
+    for (unsigned i = 0; i < n; ++i, ++pb) {
+      tx_iov[i].iov_base = (void*)(pb->c_str());
+      tx_iov[i].iov_len = pb->length();
+    }
+    // FIPS zeroization audit 20191115: this memset is not security related.
+    memset(&tx_msg, 0, sizeof(tx_msg));
+    tx_msg.msg_iov = tx_iov.data();
+    tx_msg.msg_iovlen = n;
+    bool more = tx_more || n < inflight_bl.get_num_buffers();
+    io_uring_prep_sendmsg(sqe, sd, &tx_msg,
+			  MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+    worker->queue(sqe, new UringOp(shared_from_this(), UringOp::OP_SEND));
+    tx_inflight = true;
+  }
+
+  void complete_poll(int res) {
+    rx_polling = false;
+    if (closed)
+      return;
+    if (res == -EAGAIN || res == -EINTR) {
+      arm_poll();
+      return;
+    } else if (res < 0) {
+      error = res;
+    }
+    // errors and hangups on the socket itself are left for recv() to report
+    notify();
+  }
+
+  void complete_send(int res) {
+    tx_inflight = false;
+    if (res > 0) {
+      if ((unsigned)res < inflight_bl.length())
+	inflight_bl.splice(0, res);
+      else
+	inflight_bl.clear();
+    } else if (res < 0 && res != -EAGAIN && res != -EINTR) {
+      ldout(cct, 1) << __func__ << " sendmsg to " << peer << " failed: "
+		    << cpp_strerror(res) << dendl;
+      error = res;
+      inflight_bl.clear();
+      pending_bl.clear();
+      if (!closed)
+	notify();
+    }
+    if (!error)
+      start_send();
+    maybe_close_sd();
+  }
+
+  void complete_connect(int res) {
+    if (res == 0) {
+      connected = 1;
+    } else {
+      ldout(cct, 10) << __func__ << " connect to " << peer << " failed: "
+		     << cpp_strerror(res) << dendl;
+      connected = res;
+    }
+    if (closed)
+      return;
+    if (connected == 1) {
+      arm_poll();
+      start_send();
+    }
+    notify();
+  }
+
+ public:
+  UringSocket(CephContext *cct, UringWorker *w, const entity_addr_t &peer,
+	      int sd, bool connected)
+    : cct(cct), worker(w), peer(peer), sd(sd),
+      connected(connected ? 1 : 0) {
+    // an accepted socket starts out readable so that its owner gets to
+    // call read(), which arms the first poll on the right thread
+    notify_fd = eventfd(connected ? 1 : 0, EFD_CLOEXEC|EFD_NONBLOCK);
+  }
+  ~UringSocket() override {
+    if (sd >= 0)
+      ::close(sd);
+    if (notify_fd >= 0)
+      ::close(notify_fd);
+  }
+
+  bool is_valid() const {
+    return notify_fd >= 0;
+  }
+
+  int start_connect() {
+    std::lock_guard l(lock);
+    io_uring_sqe *sqe = worker->get_sqe();
+    if (!sqe)
+      return -ESHUTDOWN;
+    io_uring_prep_connect(sqe, sd, const_cast<sockaddr*>(peer.get_sockaddr()),
+			  peer.get_sockaddr_len());
+    worker->queue(sqe, new UringOp(shared_from_this(), UringOp::OP_CONNECT));
+    return 0;
+  }
+
+  void complete(int type, int res) override {
+    std::lock_guard l(lock);
+    switch (type) {
+    case UringOp::OP_POLL:
+      complete_poll(res);
+      break;
+    case UringOp::OP_SEND:
+      complete_send(res);
+      break;
+    case UringOp::OP_CONNECT:
+      complete_connect(res);
+      break;
+    default:
+      ceph_abort_msg("unexpected completion on a connected socket");
+    }
+  }
+
+  int is_connected() {
+    std::lock_guard l(lock);
+    return connected;
+  }
+
+  ssize_t read(char *buf, size_t len) {
+    notify_fd_drain(notify_fd);
+    std::lock_guard l(lock);
+    if (error)
+      return error;
+    if (closed)
+      return 0;
+    if (connected != 1)
+      return -EAGAIN;
+    ssize_t r = ::recv(sd, buf, len, MSG_DONTWAIT);
+    if (r >= 0)
+      return r;
+    r = -ceph_sock_errno();
+    if (r == -EAGAIN || r == -EWOULDBLOCK || r == -EINTR) {
+      arm_poll();
+      return -EAGAIN;
+    }
+    error = r;
+    return r;
+  }
+
+  ssize_t send(ceph::buffer::list &bl, bool more) {
+    std::lock_guard l(lock);
+    if (error)
+      return error;
+    if (shut || closed)
+      return -EPIPE;
+    if (connected < 0)
+      return connected;
+    ssize_t len = bl.length();
+    pending_bl.claim_append(bl);
+    tx_more = more;
+    if (!tx_inflight)
+      start_send();
+    return len;
+  }
+
+  void shutdown() {
+    std::lock_guard l(lock);
+    shut = true;
+    if (sd >= 0)
+      ::shutdown(sd, SHUT_RDWR);
+  }
+
+  void close() {
+    std::lock_guard l(lock);
+    if (closed)
+      return;
+    closed = true;
+    // wake up the poll we may have in flight; it holds its own
+    // reference to the file, so closing the descriptor would not
+    if (sd >= 0)
+      ::shutdown(sd, SHUT_RD);
+    // whatever was already handed to us is still sent, as it would have
+    // been sitting in the kernel's send buffer for a posix socket
+    if (!tx_inflight)
+      pending_bl.clear();
+    maybe_close_sd();
+  }
+
+  int fd() const {
+    return notify_fd;
+  }
+};
+
+class UringConnectedSocketImpl final : public ConnectedSocketImpl {
+  std::shared_ptr<UringSocket> s;
+
+ public:
+  explicit UringConnectedSocketImpl(std::shared_ptr<UringSocket> s)
+    : s(std::move(s)) {}
+  ~UringConnectedSocketImpl() override {
+    s->close();
+  }
+
+  int is_connected() override {
+    return s->is_connected();
+  }
+  ssize_t read(char *buf, size_t len) override {
+    return s->read(buf, len);
+  }
+  ssize_t send(ceph::buffer::list &bl, bool more) override {
+    return s->send(bl, more);
+  }
+  void shutdown() override {
+    s->shutdown();
+  }
+  void close() override {
+    s->close();
+  }
+  int fd() const override {
+    return s->fd();
+  }
+};
+
+class UringListener : public UringFile {
+  CephContext *cct;
+  UringWorker *worker;
+  int sd;
+  int notify_fd;
+
+  ceph::mutex lock = ceph::make_mutex("UringListener::lock");
+  bool aborted = false;
+  bool accept_inflight = false;
+  int error = 0;
+  struct sockaddr_storage ss;
+  socklen_t slen;
+  std::deque<std::pair<int, struct sockaddr_storage>> accepted;
+
+  void arm_accept() {
+    if (accept_inflight || aborted)
+      return;
+    io_uring_sqe *sqe = worker->get_sqe();
+    if (!sqe) {
+      error = -ESHUTDOWN;
+      notify_fd_signal(notify_fd);
+      return;
+    }
+    slen = sizeof(ss);
+    io_uring_prep_accept(sqe, sd, (sockaddr*)&ss, &slen, SOCK_CLOEXEC);
+    worker->queue(sqe, new UringOp(shared_from_this(), UringOp::OP_ACCEPT));
+    accept_inflight = true;
+  }
+
+ public:
+  UringListener(CephContext *cct, UringWorker *w, int sd)
+    : cct(cct), worker(w), sd(sd) {
+    notify_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+  }
+  ~UringListener() override {
+    for (auto& p : accepted)
+      ::close(p.first);
+    if (sd >= 0)
+      ::close(sd);
+    if (notify_fd >= 0)
+      ::close(notify_fd);
+  }
+
+  bool is_valid() const {
+    return notify_fd >= 0;
+  }
+
+  void start() {
+    std::lock_guard l(lock);
+    arm_accept();
+  }
+
+  void complete(int type, int res) override {
+    ceph_assert(type == UringOp::OP_ACCEPT);
+    std::lock_guard l(lock);
+    accept_inflight = false;
+    if (aborted) {
+      if (res >= 0)
+	::close(res);
+      return;
+    }
+    if (res >= 0) {
+      accepted.emplace_back(res, ss);
+      arm_accept();
+    } else if (res == -EAGAIN || res == -EINTR) {
+      arm_accept();
+      return;
+    } else {
+      // hold off until the error is reported, so that running out of
+      // descriptors does not turn into a busy loop
+      error = res;
+    }
+    notify_fd_signal(notify_fd);
+  }
+
+  int accept(int *out_sd, struct sockaddr_storage *out_ss) {
+    notify_fd_drain(notify_fd);
+    std::lock_guard l(lock);
+    if (!accepted.empty()) {
+      *out_sd = accepted.front().first;
+      *out_ss = accepted.front().second;
+      accepted.pop_front();
+      return 0;
+    }
+    if (error) {
+      int r = error;
+      error = 0;
+      arm_accept();
+      return r;
+    }
+    if (aborted)
+      return -EINVAL;
+    return -EAGAIN;
+  }
+
+  void abort() {
+    std::lock_guard l(lock);
+    if (aborted)
+      return;
+    aborted = true;
+    // a pending accept pins the listening socket; shutting it down is
+    // what actually stops the kernel from queueing new connections
+    ::shutdown(sd, SHUT_RDWR);
+    ::close(sd);
+    sd = -1;
+  }
+
+  int fd() const {
+    return notify_fd;
+  }
+};
+
+class UringServerSocketImpl : public ServerSocketImpl {
+  UringWorker *worker;
+  std::shared_ptr<UringListener> l;
+
+ public:
+  UringServerSocketImpl(UringWorker *w, std::shared_ptr<UringListener> l,
+			const entity_addr_t& listen_addr, unsigned slot)
+    : ServerSocketImpl(listen_addr.get_type(), slot),
+      worker(w), l(std::move(l)) {}
+  int accept(ConnectedSocket *sock, const SocketOptions &opts, entity_addr_t *out, Worker *w) override;
+  void abort_accept() override {
+    l->abort();
+  }
+  int fd() const override {
+    return l->fd();
+  }
+};
+
+int UringServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &opt, entity_addr_t *out, Worker *w) {
+  ceph_assert(sock);
+  int sd;
+  sockaddr_storage ss;
+  int r = l->accept(&sd, &ss);
+  if (r < 0)
+    return r;
+
+  ceph::NetHandler &net = worker->get_net();
+  r = net.set_socket_options(sd, opt.nodelay, opt.rcbuf_size);
+  if (r < 0) {
+    ::close(sd);
+    return -ceph_sock_errno();
+  }
+
+  ceph_assert(NULL != out); //out should not be NULL in accept connection
+
+  out->set_type(addr_type);
+  out->set_sockaddr((sockaddr*)&ss);
+  net.set_priority(sd, opt.priority, out->get_family());
+
+  auto s = std::make_shared<UringSocket>(
+    worker->cct, static_cast<UringWorker*>(w), *out, sd, true);
+  if (!s->is_valid())
+    return -errno;
+  *sock = ConnectedSocket(std::make_unique<UringConnectedSocketImpl>(std::move(s)));
+  return 0;
+}
+
+class C_handle_uring_cq : public EventCallback {
+  UringWorker *worker;
+
+ public:
+  explicit C_handle_uring_cq(UringWorker *w): worker(w) {}
+  void do_request(uint64_t fd) override {
+    worker->handle_completions();
+  }
+};
+
+class C_handle_uring_submit : public EventCallback {
+  UringWorker *worker;
+
+ public:
+  explicit C_handle_uring_submit(UringWorker *w): worker(w) {}
+  void do_request(uint64_t id) override {
+    worker->submit();
+  }
+};
+
+UringWorker::UringWorker(CephContext *c, unsigned i)
+  : Worker(c, i), net(c),
+    cq_handler(new C_handle_uring_cq(this)),
+    submit_handler(new C_handle_uring_submit(this))
+{
+  char name[128];
+  sprintf(name, "AsyncMessenger::UringWorker-%u", id);
+  PerfCountersBuilder plb(cct, name, l_msgr_uring_first, l_msgr_uring_last);
+
+  plb.add_u64_avg(l_msgr_uring_submit_batch, "submit_batch", "Requests passed to the kernel per io_uring_submit");
+  plb.add_u64_counter(l_msgr_uring_completions, "completions", "Reaped completions");
+  plb.add_u64_counter(l_msgr_uring_rx_polls, "rx_polls", "Polls armed after a read found no data");
+
+  uring_logger = plb.create_perf_counters();
+  cct->get_perfcounters_collection()->add(uring_logger);
+}
+
+UringWorker::~UringWorker()
+{
+  delete cq_handler;
+  delete submit_handler;
+  cct->get_perfcounters_collection()->remove(uring_logger);
+  delete uring_logger;
+}
+
+void UringWorker::initialize()
+{
+  ring.reset(new io_uring);
+  unsigned depth = cct->_conf.get_val<uint64_t>("ms_async_uring_queue_depth");
+  int r = io_uring_queue_init(depth, ring.get(), 0);
+  if (r < 0) {
+    lderr(cct) << __func__ << " failed to set up io_uring: "
+	       << cpp_strerror(r) << dendl;
+    ceph_abort();
+  }
+
+  cq_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+  if (cq_fd < 0) {
+    lderr(cct) << __func__ << " failed to create eventfd: "
+	       << cpp_strerror(errno) << dendl;
+    ceph_abort();
+  }
+  r = io_uring_register_eventfd(ring.get(), cq_fd);
+  if (r < 0) {
+    lderr(cct) << __func__ << " failed to register eventfd: "
+	       << cpp_strerror(r) << dendl;
+    ceph_abort();
+  }
+  center.create_file_event(cq_fd, EVENT_READABLE, cq_handler);
+  ring_ready = true;
+  ldout(cct, 10) << __func__ << " queue depth " << depth << dendl;
+}
+
+void UringWorker::destroy()
+{
+  if (!ring_ready)
+    return;
+  ldout(cct, 10) << __func__ << " " << inflight.size()
+		 << " requests in flight" << dendl;
+  center.delete_file_event(cq_fd, EVENT_READABLE);
+  io_uring_queue_exit(ring.get());
+  ring_ready = false;
+  submit_scheduled = false;
+  unsubmitted = 0;
+  // the ring is gone along with its requests, drop their references
+  inflight.clear_and_dispose([](UringOp *op) { delete op; });
+  ::close(cq_fd);
+  cq_fd = -1;
+}
+
+io_uring_sqe *UringWorker::get_sqe()
+{
+  ceph_assert(center.in_thread());
+  if (!ring_ready)
+    return nullptr;
+  io_uring_sqe *sqe = io_uring_get_sqe(ring.get());
+  if (!sqe) {
+    // submission queue is full, flush it early
+    submit();
+    sqe = io_uring_get_sqe(ring.get());
+  }
+  return sqe;
+}
+
+void UringWorker::queue(io_uring_sqe *sqe, UringOp *op)
+{
+  io_uring_sqe_set_data(sqe, op);
+  inflight.push_back(*op);
+  ++unsubmitted;
+  if (!submit_scheduled) {
+    submit_scheduled = true;
+    center.dispatch_event_external(submit_handler);
+  }
+}
+
+void UringWorker::submit()
+{
+  submit_scheduled = false;
+  if (!unsubmitted || !ring_ready)
+    return;
+  int r = io_uring_submit(ring.get());
+  if (r == -EBUSY) {
+    // completion queue overflowed, make room and retry
+    handle_completions();
+    r = io_uring_submit(ring.get());
+  }
+  if (r < 0) {
+    lderr(cct) << __func__ << " io_uring_submit failed: " << cpp_strerror(r)
+	       << dendl;
+    if (!submit_scheduled) {
+      submit_scheduled = true;
+      center.dispatch_event_external(submit_handler);
+    }
+    return;
+  }
+  ldout(cct, 30) << __func__ << " submitted " << r << dendl;
+  uring_logger->inc(l_msgr_uring_submit_batch, r);
+  unsubmitted -= std::min<unsigned>(r, unsubmitted);
+}
+
+void UringWorker::handle_completions()
+{
+  notify_fd_drain(cq_fd);
+  if (!ring_ready)
+    return;
+
+  io_uring_cqe *cqe;
+  unsigned head;
+  unsigned n = 0;
+  reaped.clear();
+  io_uring_for_each_cqe(ring.get(), head, cqe) {
+    reaped.emplace_back((UringOp*)io_uring_cqe_get_data(cqe), cqe->res);
+    ++n;
+  }
+  io_uring_cq_advance(ring.get(), n);
+  uring_logger->inc(l_msgr_uring_completions, n);
+
+  for (auto& p : reaped) {
+    UringOp *op = p.first;
+    inflight.erase(inflight.iterator_to(*op));
+    op->file->complete(op->type, p.second);
+    delete op;
+  }
+  reaped.clear();
+}
+
+int UringWorker::listen(entity_addr_t &sa,
+			unsigned addr_slot,
+			const SocketOptions &opt,
+			ServerSocket *sock)
+{
+  int listen_sd = net.create_socket(sa.get_family(), true);
+  if (listen_sd < 0) {
+    return -ceph_sock_errno();
+  }
+
+  int r = net.set_socket_options(listen_sd, opt.nodelay, opt.rcbuf_size);
+  if (r < 0) {
+    ::close(listen_sd);
+    return -ceph_sock_errno();
+  }
+
+  r = ::bind(listen_sd, sa.get_sockaddr(), sa.get_sockaddr_len());
+  if (r < 0) {
+    r = -ceph_sock_errno();
+    ldout(cct, 10) << __func__ << " unable to bind to " << sa.get_sockaddr()
+                   << ": " << cpp_strerror(r) << dendl;
+    ::close(listen_sd);
+    return r;
+  }
+
+  r = ::listen(listen_sd, cct->_conf->ms_tcp_listen_backlog);
+  if (r < 0) {
+    r = -ceph_sock_errno();
+    lderr(cct) << __func__ << " unable to listen on " << sa << ": " << cpp_strerror(r) << dendl;
+    ::close(listen_sd);
+    return r;
+  }
+
+  auto l = std::make_shared<UringListener>(cct, this, listen_sd);
+  if (!l->is_valid())
+    return -errno;
+  if (center.in_thread()) {
+    l->start();
+  } else {
+    center.submit_to(center.get_id(), [l]() { l->start(); }, true);
+  }
+
+  *sock = ServerSocket(
+          std::unique_ptr<UringServerSocketImpl>(
+	    new UringServerSocketImpl(this, std::move(l), sa, addr_slot)));
+  return 0;
+}
+
+int UringWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, ConnectedSocket *socket) {
+  if (!opts.nonblock) {
+    int sd = net.connect(addr, opts.connect_bind_addr);
+    if (sd < 0)
+      return -ceph_sock_errno();
+    net.set_priority(sd, opts.priority, addr.get_family());
+    auto s = std::make_shared<UringSocket>(cct, this, addr, sd, true);
+    if (!s->is_valid())
+      return -errno;
+    *socket = ConnectedSocket(std::make_unique<UringConnectedSocketImpl>(std::move(s)));
+    return 0;
+  }
+
+  int sd = net.create_socket(addr.get_family());
+  if (sd < 0) {
+    return -ceph_sock_errno();
+  }
+  net.set_socket_options(sd, cct->_conf->ms_tcp_nodelay, cct->_conf->ms_tcp_rcvbuf);
+
+  entity_addr_t bind_addr = opts.connect_bind_addr;
+  if (cct->_conf->ms_bind_before_connect && (!bind_addr.is_blank_ip())) {
+    bind_addr.set_port(0);
+    int r = ::bind(sd, bind_addr.get_sockaddr(), bind_addr.get_sockaddr_len());
+    if (r < 0) {
+      r = -ceph_sock_errno();
+      ldout(cct, 2) << __func__ << " client bind error " << ", " << cpp_strerror(r) << dendl;
+      ::close(sd);
+      return r;
+    }
+  }
+  net.set_priority(sd, opts.priority, addr.get_family());
+
+  auto s = std::make_shared<UringSocket>(cct, this, addr, sd, false);
+  if (!s->is_valid())
+    return -errno;
+  int r = s->start_connect();
+  if (r < 0)
+    return r;
+  *socket = ConnectedSocket(std::make_unique<UringConnectedSocketImpl>(std::move(s)));
+  return 0;
+}
+
+UringNetworkStack::UringNetworkStack(CephContext *c)
+    : NetworkStack(c)
+{
+}
@@ -0,0 +1,135 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MSG_ASYNC_URINGSTACK_H
+#define CEPH_MSG_ASYNC_URINGSTACK_H
+
+#include <memory>
+#include <thread>
+
+#include <boost/intrusive/list.hpp>
+
+#include "common/perf_counters.h"
+#include "include/buffer.h"
+#include "msg/msg_types.h"
+#include "msg/async/net_handler.h"
+
+#include "Stack.h"
+
+struct io_uring;
+struct io_uring_sqe;
+
+enum {
+  l_msgr_uring_first = 96000,
+
+  l_msgr_uring_submit_batch,
+  l_msgr_uring_completions,
+  l_msgr_uring_rx_polls,
+
+  l_msgr_uring_last,
+};
+
+/// something with requests in flight on a worker's ring
+class UringFile : public std::enable_shared_from_this<UringFile> {
+ public:
+  virtual ~UringFile() {}
+  /// called on the owning worker's thread once a request completes
+  virtual void complete(int type, int res) = 0;
+};
+
+/// a submitted request; owned by the ring until its completion is reaped
+struct UringOp {
+  enum {
+    OP_POLL,
+    OP_SEND,
+    OP_CONNECT,
+    OP_ACCEPT,
+  };
+
+  boost::intrusive::list_member_hook<> inflight_item;
+  std::shared_ptr<UringFile> file;  ///< keeps the file alive while in flight
+  int type;
+
+  UringOp(std::shared_ptr<UringFile> f, int t)
+    : file(std::move(f)), type(t) {}
+};
+
+class UringWorker : public Worker {
+  ceph::NetHandler net;
+  std::unique_ptr<io_uring> ring;
+  bool ring_ready = false;
+  int cq_fd = -1;              ///< eventfd signalled by the ring on completion
+  EventCallbackRef cq_handler;
+  EventCallbackRef submit_handler;
+  bool submit_scheduled = false;
+  unsigned unsubmitted = 0;
+  PerfCounters *uring_logger = nullptr;
+
+  boost::intrusive::list<
+    UringOp,
+    boost::intrusive::member_hook<
+      UringOp,
+      boost::intrusive::list_member_hook<>,
+      &UringOp::inflight_item> > inflight;
+  std::vector<std::pair<UringOp*, int>> reaped;
+
+  void initialize() override;
+  void destroy() override;
+
+ public:
+  UringWorker(CephContext *c, unsigned i);
+  ~UringWorker() override;
+
+  int listen(entity_addr_t &addr,
+	     unsigned addr_slot,
+	     const SocketOptions &opts,
+	     ServerSocket *) override;
+  int connect(const entity_addr_t &addr, const SocketOptions &opts,
+	      ConnectedSocket *socket) override;
+
+  ceph::NetHandler &get_net() { return net; }
+  PerfCounters *get_uring_logger() { return uring_logger; }
+
+  /// get a free sqe, or nullptr if the ring is gone. owner thread only.
+  io_uring_sqe *get_sqe();
+  /// hand a prepared sqe over; all queued sqes are submitted together
+  /// once the current event loop iteration is done
+  void queue(io_uring_sqe *sqe, UringOp *op);
+  void submit();
+  void handle_completions();
+};
+
+class UringNetworkStack : public NetworkStack {
+  std::vector<std::thread> threads;
+
+  Worker* create_worker(CephContext *c, unsigned worker_id) override {
+    return new UringWorker(c, worker_id);
+  }
+
+ public:
+  explicit UringNetworkStack(CephContext *c);
+
+  // connect completes through the ring, which signals the socket's
+  // notify fd; there is no need to wait for writability
+  bool nonblock_connect_need_writable_event() const override { return false; }
+
+  void spawn_worker(unsigned i, std::function<void ()> &&func) override {
+    threads.resize(i+1);
+    threads[i] = std::thread(func);
+  }
+  void join_worker(unsigned i) override {
+    ceph_assert(threads.size() > i && threads[i].joinable());
+    threads[i].join();
+  }
+};
+
+#endif //CEPH_MSG_ASYNC_URINGSTACK_H
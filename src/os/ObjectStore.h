@@ -42,6 +42,10 @@ namespace ceph {
   class Formatter;
 }
 
+namespace PriorityCache {
+  struct PriCache;
+}
+
 /*
  * low-level interface to the local OSD file system
  */
@@ -266,6 +270,20 @@ public:
 
   virtual void set_cache_shards(unsigned num) { }
 
+  /**
+   * Let the store's cache autotuner balance memory for a cache owned by
+   * the caller against its own caches.
+   *
+   * @returns true if the cache is being tuned, false if the store does
+   * not autotune and the caller should size the cache itself
+   */
+  virtual bool add_priority_cache(
+    const std::string& name,
+    std::shared_ptr<PriorityCache::PriCache> cache) {
+    return false;
+  }
+  virtual void remove_priority_cache(const std::string& name) { }
+
   /**
    * Returns 0 if the hobject is valid, -error otherwise
    *
@@ -6,6 +6,7 @@
 #include "BitmapAllocator.h"
 #include "AvlAllocator.h"
 #include "HybridAllocator.h"
+#include "ShardedAllocator.h"
 #ifdef HAVE_LIBZBD
 #include "ZonedAllocator.h"
 #endif
@@ -138,6 +139,11 @@ Allocator *Allocator::create(CephContext* cct, string type,
     return new HybridAllocator(cct, size, block_size,
       cct->_conf.get_val<uint64_t>("bluestore_hybrid_alloc_mem_cap"),
       name);
+  } else if (type == "sharded") {
+    return new ShardedAllocator(cct, size, block_size,
+      cct->_conf.get_val<uint64_t>("bluestore_allocator_shards"),
+      cct->_conf.get_val<uint64_t>("bluestore_hybrid_alloc_mem_cap"),
+      name);
 #ifdef HAVE_LIBZBD
   } else if (type == "zoned") {
     return new ZonedAllocator(cct, size, block_size, name);
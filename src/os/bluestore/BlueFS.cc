@@ -180,6 +180,7 @@ private:
 
 BlueFS::BlueFS(CephContext* cct)
   : cct(cct),
+    log_compact_thread(this),
     bdev(MAX_BDEV),
     ioc(MAX_BDEV),
     block_reserved(MAX_BDEV),
@@ -240,6 +241,13 @@ void BlueFS::_init_logger()
 	    "jlen", PerfCountersBuilder::PRIO_INTERESTING, unit_t(UNIT_BYTES));
   b.add_u64_counter(l_bluefs_log_compactions, "log_compactions",
 		    "Compactions of the metadata log");
+  b.add_time_avg(l_bluefs_log_compaction_lat, "log_compaction_lat",
+		 "Average metadata log compaction time");
+  b.add_time_avg(l_bluefs_log_compaction_stall_lat, "log_compaction_stall_lat",
+		 "Average time writers were blocked by metadata log compaction",
+		 "jstl", PerfCountersBuilder::PRIO_USEFUL);
+  b.add_u64_counter(l_bluefs_log_sync_grouped, "log_sync_grouped",
+		    "Log syncs satisfied by a concurrent log flush");
   b.add_u64_counter(l_bluefs_logged_bytes, "logged_bytes",
 		    "Bytes written to the metadata log", "j",
 		    PerfCountersBuilder::PRIO_CRITICAL, unit_t(UNIT_BYTES));
@@ -471,6 +479,37 @@ int BlueFS::get_block_extents(unsigned id, interval_set<uint64_t> *extents)
   return 0;
 }
 
+int BlueFS::dump_shared_space(
+  unsigned id,
+  std::function<void(uint64_t offset, uint64_t length)> notify)
+{
+  dout(10) << __func__ << " bdev " << id << dendl;
+  ceph_assert(id < alloc.size());
+  ceph_assert(is_shared_alloc(id));
+
+  // settle everything that is on its way back to the allocator
+  _stop_log_compact_thread();
+  sync_metadata(true);
+  if (bdev[id]) {
+    bdev[id]->discard_drain();
+  }
+
+  std::lock_guard l(lock);
+  if (new_log || log_flushing || !pending_release[id].empty()) {
+    dout(1) << __func__ << " bdev " << id << " busy" << dendl;
+    return -EBUSY;
+  }
+  for (auto& p : file_map) {
+    for (auto& q : p.second->fnode.extents) {
+      if (q.bdev == id) {
+        notify(q.offset, q.length);
+      }
+    }
+  }
+  alloc[id]->dump(notify);
+  return 0;
+}
+
 int BlueFS::mkfs(uuid_d osd_uuid, const bluefs_layout_t& layout)
 {
   std::unique_lock l(lock);
@@ -666,6 +705,7 @@ int BlueFS::mount()
            << std::hex << log_writer->pos << std::dec
            << dendl;
 
+  _start_log_compact_thread();
   return 0;
 
  out:
@@ -694,6 +734,7 @@ void BlueFS::umount(bool avoid_compact)
 {
   dout(1) << __func__ << dendl;
 
+  _stop_log_compact_thread();
   sync_metadata(avoid_compact);
 
   _close_writer(log_writer);
@@ -1945,6 +1986,10 @@ void BlueFS::compact_log()
 {
   std::unique_lock<ceph::mutex> l(lock);
   if (!cct->_conf->bluefs_replay_recovery_disable_compact) {
+    // let an in-flight background compaction finish first
+    while (new_log) {
+      log_cond.wait(l);
+    }
     if (cct->_conf->bluefs_compact_log_sync) {
       _compact_log_sync();
     } else {
@@ -1953,6 +1998,52 @@ void BlueFS::compact_log()
   }
 }
 
+void BlueFS::_log_compact_thread()
+{
+  std::unique_lock l(lock);
+  dout(10) << __func__ << " start" << dendl;
+  while (true) {
+    if (log_compact_requested) {
+      log_compact_requested = false;
+      // re-check: the log may have been compacted in the meantime
+      if (_should_compact_log()) {
+	_compact_log_async(l);
+      }
+      continue;
+    }
+    if (log_compact_stop) {
+      break;
+    }
+    log_compact_cond.wait(l);
+  }
+  dout(10) << __func__ << " finish" << dendl;
+}
+
+void BlueFS::_start_log_compact_thread()
+{
+  if (!cct->_conf->bluefs_compact_log_async_thread ||
+      cct->_conf->bluefs_compact_log_sync) {
+    return;
+  }
+  log_compact_stop = false;
+  log_compact_requested = false;
+  log_compact_thread.create("bfs_log_compact");
+}
+
+void BlueFS::_stop_log_compact_thread()
+{
+  if (!log_compact_thread.is_started()) {
+    return;
+  }
+  {
+    std::lock_guard l(lock);
+    log_compact_stop = true;
+    log_compact_cond.notify_all();
+  }
+  log_compact_thread.join();
+  log_compact_stop = false;
+}
+
 bool BlueFS::_should_compact_log()
 {
   uint64_t current = log_writer->file->fnode.size;
@@ -2129,9 +2220,10 @@ void BlueFS::_rewrite_log_and_layout_sync(bool allocate_with_fallback,
  * old extent(s) won't be written to, and reflect everything to compact.
  * New events will be written to the new region that we'll keep.
  *
- * 2. While still holding the lock, encode a bufferlist that dumps all of the
- * in-memory fnodes and names.  This will become the new beginning of the
+ * 2. While still holding the lock, dump all of the in-memory fnodes and
+ * names into a transaction.  This will become the new beginning of the
  * log.  The last event will jump to the log continuation extent from #1.
+ * The transaction is encoded with the lock dropped.
  *
  * 3. Queue a write to a new extent for the new beginnging of the log.
  *
@@ -2148,6 +2240,7 @@ void BlueFS::_rewrite_log_and_layout_sync(bool allocate_with_fallback,
 void BlueFS::_compact_log_async(std::unique_lock<ceph::mutex>& l)
 {
   dout(10) << __func__ << dendl;
+  auto start = mono_clock::now();
   File *log_file = log_writer->file.get();
   ceph_assert(!new_log);
   ceph_assert(!new_log_writer);
@@ -2212,14 +2305,19 @@ void BlueFS::_compact_log_async(std::unique_lock<ceph::mutex>& l)
   // we might have some more ops in log_t due to _allocate call
   t.claim_ops(log_t);
 
-  bufferlist bl;
-  encode(t, bl);
-  _pad_bl(bl);
-
   dout(10) << __func__ << " new_log_jump_to 0x" << std::hex << new_log_jump_to
 	   << std::dec << dendl;
 
   new_log_writer = _create_writer(new_log);
+
+  // t is a private snapshot now; encode it without the lock so that
+  // writers can keep appending to the old log past old_log_jump_to.
+  l.unlock();
+  bufferlist bl;
+  encode(t, bl);
+  _pad_bl(bl);
+  l.lock();
+
   new_log_writer->append(bl);
 
   // 3. flush
@@ -2303,6 +2401,7 @@ void BlueFS::_compact_log_async(std::unique_lock<ceph::mutex>& l)
 
   dout(10) << __func__ << " log extents " << log_file->fnode.extents << dendl;
   logger->inc(l_bluefs_log_compactions);
+  logger->tinc(l_bluefs_log_compaction_lat, mono_clock::now() - start);
 }
 
 void BlueFS::_pad_bl(bufferlist& bl)
@@ -2320,16 +2419,22 @@ int BlueFS::_flush_and_sync_log(std::unique_lock<ceph::mutex>& l,
 				uint64_t want_seq,
 				uint64_t jump_to)
 {
+  bool waited = false;
   while (log_flushing) {
     dout(10) << __func__ << " want_seq " << want_seq
 	     << " log is currently flushing, waiting" << dendl;
     ceph_assert(!jump_to);
     log_cond.wait(l);
+    waited = true;
   }
   if (want_seq && want_seq <= log_seq_stable) {
     dout(10) << __func__ << " want_seq " << want_seq << " <= log_seq_stable "
 	     << log_seq_stable << ", done" << dendl;
     ceph_assert(!jump_to);
+    if (waited) {
+      // our updates rode along with the flush we were waiting for
+      logger->inc(l_bluefs_log_sync_grouped);
+    }
     return 0;
   }
   if (log_t.empty() && dirty_files.empty()) {
@@ -2367,9 +2472,14 @@ int BlueFS::_flush_and_sync_log(std::unique_lock<ceph::mutex>& l,
   if (runway < (int64_t)cct->_conf->bluefs_min_log_runway) {
     dout(10) << __func__ << " allocating more log runway (0x"
 	     << std::hex << runway << std::dec  << " remaining)" << dendl;
-    while (new_log_writer) {
-      dout(10) << __func__ << " waiting for async compaction" << dendl;
-      log_cond.wait(l);
+    if (new_log_writer) {
+      auto stall_start = mono_clock::now();
+      while (new_log_writer) {
+	dout(10) << __func__ << " waiting for async compaction" << dendl;
+	log_cond.wait(l);
+      }
+      logger->tinc(l_bluefs_log_compaction_stall_lat,
+		   mono_clock::now() - stall_start);
     }
     vselector->sub_usage(log_writer->file->vselector_hint, log_writer->file->fnode);
     int r = _allocate(
@@ -3005,9 +3115,19 @@ void BlueFS::_maybe_compact_log(std::unique_lock<ceph::mutex>& l)
   if (!cct->_conf->bluefs_replay_recovery_disable_compact &&
       _should_compact_log()) {
     if (cct->_conf->bluefs_compact_log_sync) {
+      auto start = mono_clock::now();
       _compact_log_sync();
+      logger->tinc(l_bluefs_log_compaction_stall_lat, mono_clock::now() - start);
+    } else if (log_compact_thread.is_started()) {
+      // hand it off; the caller is likely a WAL fsync we do not want to stall
+      if (!log_compact_requested) {
+	log_compact_requested = true;
+	log_compact_cond.notify_all();
+      }
     } else {
+      auto start = mono_clock::now();
       _compact_log_async(l);
+      logger->tinc(l_bluefs_log_compaction_stall_lat, mono_clock::now() - start);
     }
   }
 }
@@ -10,6 +10,7 @@
 #include "blk/BlockDevice.h"
 
 #include "common/RefCountedObj.h"
+#include "common/Thread.h"
 #include "common/ceph_context.h"
 #include "global/global_context.h"
 #include "include/common_fwd.h"
@@ -30,6 +31,9 @@ enum {
   l_bluefs_num_files,
   l_bluefs_log_bytes,
   l_bluefs_log_compactions,
+  l_bluefs_log_compaction_lat,
+  l_bluefs_log_compaction_stall_lat,
+  l_bluefs_log_sync_grouped,
   l_bluefs_logged_bytes,
   l_bluefs_files_written_wal,
   l_bluefs_files_written_sst,
@@ -320,6 +324,18 @@ private:
   FileRef new_log = nullptr;
   FileWriter *new_log_writer = nullptr;
 
+  struct LogCompactThread : public Thread {
+    BlueFS *fs;
+    explicit LogCompactThread(BlueFS *fs) : fs(fs) {}
+    void *entry() override {
+      fs->_log_compact_thread();
+      return nullptr;
+    }
+  } log_compact_thread;
+  ceph::condition_variable log_compact_cond;
+  bool log_compact_requested = false; ///< _should_compact_log() tripped
+  bool log_compact_stop = false;
+
   /*
    * There are up to 3 block devices:
    *
@@ -399,6 +415,9 @@ private:
 				  int flags);
   void _compact_log_sync();
   void _compact_log_async(std::unique_lock<ceph::mutex>& l);
+  void _log_compact_thread();
+  void _start_log_compact_thread();
+  void _stop_log_compact_thread();
 
   void _rewrite_log_and_layout_sync(bool allocate_with_fallback,
 				    int super_dev,
@@ -493,6 +512,14 @@ public:
 
   /// get current extents that we own for given block device
   int get_block_extents(unsigned id, interval_set<uint64_t> *extents);
+  /**
+   * enumerate the extents we own on a device shared with our owner and
+   * then the free extents of the shared allocator, with nothing moving
+   * between the two in the meantime.  Stops background log compaction:
+   * only to be used right before umount(), with no other users left.
+   */
+  int dump_shared_space(unsigned id,
+    std::function<void(uint64_t offset, uint64_t length)> notify);
 
   int open_for_write(
     const std::string& dir,
@@ -65,6 +65,10 @@ using bid_t = decltype(BlueStore::Blob::id);
 MEMPOOL_DEFINE_OBJECT_FACTORY(BlueStore::Onode, bluestore_onode,
 			      bluestore_cache_onode);
 
+// bluestore_cache_onode_compact
+MEMPOOL_DEFINE_OBJECT_FACTORY(BlueStore::CompactOnode, bluestore_compact_onode,
+			      bluestore_cache_onode_compact);
+
 // bluestore_cache_other
 MEMPOOL_DEFINE_OBJECT_FACTORY(BlueStore::Buffer, bluestore_buffer,
 			      bluestore_Buffer);
@@ -123,6 +127,10 @@ const string PREFIX_ZONED_CL_INFO = "G";  // (per-zone cleaner metadata)
 
 const string BLUESTORE_GLOBAL_STATFS_KEY = "bluestore_statfs";
 
+// allocator snapshot, kept in BlueFS (see _save_alloc_snapshot)
+const string ALLOC_SNAPSHOT_DIR = "alloc";
+const string ALLOC_SNAPSHOT_FILE = "snapshot";
+
 // write a label in the first block.  always use this size.  note that
 // bluefs makes a matching assumption about the location of its
 // superblock (always the second block of the device).
@@ -1105,6 +1113,7 @@ struct LruOnodeCacheShard : public BlueStore::OnodeCacheShard {
       }
       auto pinned = !o->pop_cache();
       ceph_assert(!pinned);
+      _evict(o);
       o->c->onode_map._remove(o->oid);
     }
   }
@@ -1127,6 +1136,87 @@ struct LruOnodeCacheShard : public BlueStore::OnodeCacheShard {
     *onodes += num;
     *pinned_onodes += num_pinned;
   }
+
+protected:
+  /// called for each onode trimmed from the lru, before it is dropped
+  virtual void _evict(BlueStore::Onode* o) {}
+};
+
+// CompactLruOnodeCacheShard
+//
+// Onodes trimmed from the lru are re-encoded into the form they have in
+// the kv store and kept in a second, byte-bounded lru.  An encoded onode
+// is a single buffer instead of the Onode/ExtentMap/Blob/SharedBlob graph,
+// so many more of them fit in the same memory; a lookup that finds one
+// skips the kv read and decodes it straight back into a full Onode.
+struct CompactLruOnodeCacheShard : public LruOnodeCacheShard {
+  typedef boost::intrusive::list<
+    BlueStore::CompactOnode,
+    boost::intrusive::member_hook<
+      BlueStore::CompactOnode,
+      boost::intrusive::list_member_hook<>,
+      &BlueStore::CompactOnode::lru_item> > compact_list_t;
+
+  compact_list_t compact_lru;
+  uint64_t compact_bytes = 0;
+  std::atomic<uint64_t> compact_max = {0};
+
+  explicit CompactLruOnodeCacheShard(CephContext *cct)
+    : LruOnodeCacheShard(cct) {}
+
+  void set_compact_max(uint64_t bytes) override
+  {
+    compact_max = bytes;
+  }
+  void _rm_compact(BlueStore::CompactOnode* co) override
+  {
+    compact_lru.erase(compact_lru.iterator_to(*co));
+    ceph_assert(compact_bytes >= co->v.length());
+    compact_bytes -= co->v.length();
+  }
+  void _trim_to(uint64_t new_size) override
+  {
+    LruOnodeCacheShard::_trim_to(new_size);
+    // a flush drops the encoded onodes too
+    _trim_compact_to(new_size ? compact_max.load() : 0);
+  }
+
+protected:
+  void _evict(BlueStore::Onode* o) override
+  {
+    if (!compact_max) {
+      return;
+    }
+    bufferptr v;
+    if (!o->encode_compact(&v)) {
+      dout(20) << __func__ << " " << o->oid << " not encodable" << dendl;
+      return;
+    }
+    auto& compact_map = o->c->onode_map.compact_map;
+    auto p = compact_map.find(o->oid);
+    if (p != compact_map.end()) {
+      // stale; an object is never both decoded and encoded
+      _rm_compact(p->second);
+      delete p->second;
+      compact_map.erase(p);
+    }
+    auto co = new BlueStore::CompactOnode(&o->c->onode_map, std::move(v));
+    p = compact_map.emplace(o->oid, co).first;
+    co->oid = &p->first;
+    compact_lru.push_front(*co);
+    compact_bytes += co->v.length();
+    dout(20) << __func__ << " " << o->oid << " kept " << co->v.length()
+	     << " bytes, compact_bytes=" << compact_bytes << dendl;
+  }
+  void _trim_compact_to(uint64_t max_bytes)
+  {
+    while (compact_bytes > max_bytes) {
+      ceph_assert(!compact_lru.empty());
+      BlueStore::CompactOnode *co = &compact_lru.back();
+      dout(20) << __func__ << "  rm " << *co->oid << dendl;
+      co->space->_rm_compact(*co->oid);
+    }
+  }
 };
 
 // OnodeCacheShard
@@ -1136,8 +1226,10 @@ BlueStore::OnodeCacheShard *BlueStore::OnodeCacheShard::create(
     PerfCounters *logger)
 {
   BlueStore::OnodeCacheShard *c = nullptr;
-  // Currently we only implement an LRU cache for onodes
-  c = new LruOnodeCacheShard(cct);
+  if (type == "compact")
+    c = new CompactLruOnodeCacheShard(cct);
+  else
+    c = new LruOnodeCacheShard(cct);
   c->logger = logger;
   return c;
 }
@@ -1847,6 +1939,37 @@ void BlueStore::OnodeSpace::_remove(const ghobject_t& oid)
   onode_map.erase(oid);
 }
 
+void BlueStore::OnodeSpace::_rm_compact(const ghobject_t& oid)
+{
+  auto p = compact_map.find(oid);
+  if (p == compact_map.end()) {
+    return;
+  }
+  ldout(cache->cct, 20) << __func__ << " " << oid << dendl;
+  cache->_rm_compact(p->second);
+  delete p->second;
+  compact_map.erase(p);
+}
+
+bool BlueStore::OnodeSpace::take_compact(const ghobject_t& oid,
+					 bufferlist *v)
+{
+  std::lock_guard l(cache->lock);
+  auto p = compact_map.find(oid);
+  if (p == compact_map.end()) {
+    return false;
+  }
+  ldout(cache->cct, 20) << __func__ << " " << oid << " "
+			<< p->second->v.length() << " bytes" << dendl;
+  cache->_rm_compact(p->second);
+  if (v) {
+    v->append(std::move(p->second->v));
+  }
+  delete p->second;
+  compact_map.erase(p);
+  return true;
+}
+
 BlueStore::OnodeRef BlueStore::OnodeSpace::lookup(const ghobject_t& oid)
 {
   ldout(cache->cct, 30) << __func__ << dendl;
@@ -1889,6 +2012,11 @@ void BlueStore::OnodeSpace::clear()
     cache->_rm(p.second.get());
   }
   onode_map.clear();
+  for (auto &p : compact_map) {
+    cache->_rm_compact(p.second);
+    delete p.second;
+  }
+  compact_map.clear();
 }
 
 bool BlueStore::OnodeSpace::empty()
@@ -1906,6 +2034,8 @@ void BlueStore::OnodeSpace::rename(
   std::lock_guard l(cache->lock);
   ldout(cache->cct, 30) << __func__ << " " << old_oid << " -> " << new_oid
 			<< dendl;
+  _rm_compact(old_oid);
+  _rm_compact(new_oid);
   ceph::unordered_map<ghobject_t,OnodeRef>::iterator po, pn;
   po = onode_map.find(old_oid);
   pn = onode_map.find(new_oid);
@@ -3575,6 +3705,47 @@ BlueStore::Onode* BlueStore::Onode::decode(
   return on;
 }
 
+bool BlueStore::Onode::encode_compact(bufferptr *out)
+{
+  if (!exists || extent_map.needs_reshard()) {
+    return false;
+  }
+  if (onode.extent_map_shards.empty()) {
+    if (extent_map.inline_bl.length() == 0) {
+      return false; // dirty
+    }
+  } else {
+    for (auto& s : extent_map.shards) {
+      if (s.dirty) {
+	return false;
+      }
+    }
+  }
+
+  // same layout as _record_onode()
+  size_t bound = 0;
+  denc(onode, bound);
+  extent_map.bound_encode_spanning_blobs(bound);
+  if (onode.extent_map_shards.empty()) {
+    denc(extent_map.inline_bl, bound);
+  }
+  bufferlist bl;
+  {
+    auto p = bl.get_contiguous_appender(bound, true);
+    denc(onode, p);
+    extent_map.encode_spanning_blobs(p);
+    if (onode.extent_map_shards.empty()) {
+      denc(extent_map.inline_bl, p);
+    }
+  }
+
+  // copy into an exactly sized buffer; the bound is generous
+  *out = bufferptr(buffer::create_in_mempool(
+    bl.length(), mempool::mempool_bluestore_cache_onode_compact));
+  bl.begin().copy(bl.length(), out->c_str());
+  return true;
+}
+
 void BlueStore::Onode::flush()
 {
   if (flushing_count.load()) {
@@ -3937,8 +4108,16 @@ BlueStore::OnodeRef BlueStore::Collection::get_onode(
   int r = -ENOENT;
   Onode *on;
   if (!is_createop) {
-    r = store->db->get(PREFIX_OBJ, key.c_str(), key.size(), &v);
-    ldout(store->cct, 20) << " r " << r << " v.len " << v.length() << dendl;
+    if (onode_map.take_compact(oid, &v)) {
+      r = 0;
+      store->logger->inc(l_bluestore_onode_compact_hits);
+      ldout(store->cct, 20) << " compact v.len " << v.length() << dendl;
+    } else {
+      r = store->db->get(PREFIX_OBJ, key.c_str(), key.size(), &v);
+      ldout(store->cct, 20) << " r " << r << " v.len " << v.length() << dendl;
+    }
+  } else {
+    onode_map.take_compact(oid, nullptr);
   }
   if (v.length() == 0) {
     ceph_assert(r == -ENOENT);
@@ -3961,6 +4140,25 @@ void BlueStore::Collection::split_cache(
 {
   ldout(store->cct, 10) << __func__ << " to " << dest << dendl;
 
+  // encoded onodes of objects moving to dest are simply dropped; they
+  // are reloaded from the kv store on demand
+  {
+    std::lock_guard l(get_onode_cache()->lock);
+    spg_t destpg;
+    bool is_pg = dest->cid.is_pg(&destpg);
+    ceph_assert(is_pg);
+    auto& compact_map = onode_map.compact_map;
+    for (auto p = compact_map.begin(); p != compact_map.end();) {
+      if (p->first.match(dest->cnode.bits, destpg.pgid.ps())) {
+	get_onode_cache()->_rm_compact(p->second);
+	delete p->second;
+	p = compact_map.erase(p);
+      } else {
+	++p;
+      }
+    }
+  }
+
   // lock (one or both) cache shards
   std::lock(cache->lock, dest->cache->lock);
   std::lock_guard l(cache->lock, std::adopt_lock);
@@ -4069,6 +4267,9 @@ void *BlueStore::MempoolThread::entry()
     pcm->insert("kv", binned_kv_cache, true);
     pcm->insert("meta", meta_cache, true);
     pcm->insert("data", data_cache, true);
+    for (auto& [name, cache] : external_caches) {
+      pcm->insert(name, cache, true);
+    }
   }
 
   utime_t next_balance = ceph_clock_now();
@@ -4195,15 +4396,22 @@ void BlueStore::MempoolThread::_resize_shards(bool interval_stats)
                    << " data_used: " << data_used << dendl;
   }
 
+  int64_t compact_alloc =
+     static_cast<int64_t>(store->cache_onode_compact_ratio * meta_alloc);
   uint64_t max_shard_onodes = static_cast<uint64_t>(
-      (meta_alloc / (double) onode_shards) / meta_cache->get_bytes_per_onode());
+      ((meta_alloc - compact_alloc) / (double) onode_shards) /
+      meta_cache->get_bytes_per_onode());
+  uint64_t max_shard_compact =
+      static_cast<uint64_t>(compact_alloc / onode_shards);
   uint64_t max_shard_buffer = static_cast<uint64_t>(data_alloc / buffer_shards);
 
   dout(30) << __func__ << " max_shard_onodes: " << max_shard_onodes
+                 << " max_shard_compact: " << max_shard_compact
                  << " max_shard_buffer: " << max_shard_buffer << dendl;
 
   for (auto i : store->onode_cache_shards) {
     i->set_max(max_shard_onodes);
+    i->set_compact_max(max_shard_compact);
   }
   for (auto i : store->buffer_cache_shards) {
     i->set_max(max_shard_buffer);
@@ -4734,11 +4942,20 @@ int BlueStore::_set_cache_sizes()
     // deal with floating point imprecision
     cache_data_ratio = 0;
   }
+
+  if (cct->_conf.get_val<std::string>("bluestore_onode_cache_type") ==
+      "compact") {
+    cache_onode_compact_ratio =
+      cct->_conf.get_val<double>("bluestore_onode_cache_compact_ratio");
+  } else {
+    cache_onode_compact_ratio = 0;
+  }
     
   dout(1) << __func__ << " cache_size " << cache_size
           << " meta " << cache_meta_ratio
 	  << " kv " << cache_kv_ratio
 	  << " data " << cache_data_ratio
+	  << " onode compact " << cache_onode_compact_ratio
 	  << dendl;
   return 0;
 }
@@ -4866,6 +5083,9 @@ void BlueStore::_init_logger()
 		    "Sum for onode-lookups hit in the cache");
   b.add_u64_counter(l_bluestore_onode_misses, "bluestore_onode_misses",
 		    "Sum for onode-lookups missed in the cache");
+  b.add_u64_counter(l_bluestore_onode_compact_hits,
+		    "bluestore_onode_compact_hits",
+		    "Sum for onodes decoded from their cached encoded form");
   b.add_u64_counter(l_bluestore_onode_shard_hits, "bluestore_onode_shard_hits",
 		    "Sum for onode-shard lookups hit in the cache");
   b.add_u64_counter(l_bluestore_onode_shard_misses,
@@ -4942,6 +5162,10 @@ void BlueStore::_init_logger()
     "Average collection listing latency");
   b.add_time_avg(l_bluestore_remove_lat, "remove_lat",
     "Average removal latency");
+  b.add_time_avg(l_bluestore_alloc_init_lat, "alloc_init_lat",
+    "Average time to load the allocator state at mount");
+  b.add_u64_counter(l_bluestore_alloc_snapshot_loads, "alloc_snapshot_loads",
+    "Allocator states loaded from a snapshot rather than the freelist");
 
   logger = b.create_perf_counters();
   cct->get_perfcounters_collection()->add(logger);
@@ -5366,20 +5590,34 @@ int BlueStore::_init_alloc()
   }
 
   uint64_t num = 0, bytes = 0;
-
-  dout(1) << __func__ << " opening allocation metadata" << dendl;
-  // initialize from freelist
-  fm->enumerate_reset();
-  uint64_t offset, length;
-  while (fm->enumerate_next(db, &offset, &length)) {
-    shared_alloc.a->init_add_free(offset, length);
-    ++num;
-    bytes += length;
+  auto start = mono_clock::now();
+  bool from_snapshot = false;
+
+  if (cct->_conf.get_val<bool>("bluestore_alloc_snapshot") &&
+      bluefs && !bdev->is_smr()) {
+    from_snapshot = _load_alloc_snapshot(&num, &bytes) == 0;
+  }
+  if (!from_snapshot) {
+    dout(1) << __func__ << " opening allocation metadata" << dendl;
+    // initialize from freelist
+    fm->enumerate_reset();
+    uint64_t offset, length;
+    while (fm->enumerate_next(db, &offset, &length)) {
+      shared_alloc.a->init_add_free(offset, length);
+      ++num;
+      bytes += length;
+    }
+    fm->enumerate_reset();
+  } else {
+    logger->inc(l_bluestore_alloc_snapshot_loads);
   }
-  fm->enumerate_reset();
+  auto elapsed = mono_clock::now() - start;
+  logger->tinc(l_bluestore_alloc_init_lat, elapsed);
 
   dout(1) << __func__
           << " loaded " << byte_u_t(bytes) << " in " << num << " extents"
+          << " from " << (from_snapshot ? "snapshot" : "freelist")
+          << " in " << timespan_str(elapsed)
           << std::hex
           << ", allocator type " << shared_alloc.a->get_type()
           << ", capacity 0x" << shared_alloc.a->get_capacity()
@@ -5391,6 +5629,248 @@ int BlueStore::_init_alloc()
   return 0;
 }
 
+namespace {
+
+// precedes the extents of an allocator snapshot
+struct alloc_snapshot_header_t {
+  uint64_t seq = 0;    ///< DB sequence number the snapshot matches
+  uint64_t size = 0;   ///< allocator capacity
+  uint64_t unit = 0;   ///< offsets and lengths are in these units
+  uint64_t num = 0;    ///< number of extents
+  uint64_t bytes = 0;  ///< their total length
+  uint32_t crc = 0;    ///< crc32c of the encoded extents
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(1, 1, bl);
+    ceph::encode(seq, bl);
+    ceph::encode(size, bl);
+    ceph::encode(unit, bl);
+    ceph::encode(num, bl);
+    ceph::encode(bytes, bl);
+    ceph::encode(crc, bl);
+    ENCODE_FINISH(bl);
+  }
+  void decode(bufferlist::const_iterator& p) {
+    DECODE_START(1, p);
+    ceph::decode(seq, p);
+    ceph::decode(size, p);
+    ceph::decode(unit, p);
+    ceph::decode(num, p);
+    ceph::decode(bytes, p);
+    ceph::decode(crc, p);
+    DECODE_FINISH(p);
+  }
+};
+
+} // anonymous namespace
+
+/*
+ * The snapshot holds what the freelist considers free: the allocator's
+ * free space plus what BlueFS owns on the shared device (which BlueFS
+ * takes out of the allocator again when it mounts).  Nothing but DB
+ * transactions changes that, so the snapshot is valid as long as the
+ * DB's sequence number is the one it was saved with.
+ */
+int BlueStore::_load_alloc_snapshot(uint64_t *num, uint64_t *bytes)
+{
+  ceph_assert(bluefs);
+  uint64_t size = 0;
+  int r = bluefs->stat(ALLOC_SNAPSHOT_DIR, ALLOC_SNAPSHOT_FILE, &size, nullptr);
+  if (r < 0) {
+    dout(10) << __func__ << " no snapshot" << dendl;
+    return r;
+  }
+  BlueFS::FileReader *h = nullptr;
+  r = bluefs->open_for_read(ALLOC_SNAPSHOT_DIR, ALLOC_SNAPSHOT_FILE, &h);
+  if (r < 0) {
+    derr << __func__ << " failed to open snapshot: " << cpp_strerror(r)
+	 << dendl;
+    return r;
+  }
+  bufferlist bl;
+  while (bl.length() < size) {
+    bufferlist t;
+    int64_t got = bluefs->read(h, bl.length(), size - bl.length(), &t, nullptr);
+    if (got <= 0) {
+      r = got < 0 ? got : -EIO;
+      break;
+    }
+    bl.claim_append(t);
+  }
+  delete h;
+  if (r < 0) {
+    derr << __func__ << " failed to read snapshot: " << cpp_strerror(r)
+	 << dendl;
+    return r;
+  }
+
+  alloc_snapshot_header_t hdr;
+  bufferlist body;
+  try {
+    auto p = bl.cbegin();
+    hdr.decode(p);
+    p.copy(p.get_remaining(), body);
+  } catch (ceph::buffer::error& e) {
+    derr << __func__ << " unable to decode snapshot header" << dendl;
+    return -EIO;
+  }
+  uint64_t seq = db->get_latest_sequence_number();
+  if (hdr.seq == 0 || hdr.seq != seq) {
+    dout(1) << __func__ << " snapshot is stale, seq " << hdr.seq
+	    << " != " << seq << dendl;
+    return -ESTALE;
+  }
+  if (hdr.size != shared_alloc.a->get_capacity() || hdr.unit == 0) {
+    dout(1) << __func__ << " snapshot doesn't match the allocator" << std::hex
+	    << ", size 0x" << hdr.size << " unit 0x" << hdr.unit
+	    << std::dec << dendl;
+    return -EINVAL;
+  }
+  if (body.crc32c(-1) != hdr.crc) {
+    derr << __func__ << " snapshot crc mismatch" << dendl;
+    return -EIO;
+  }
+
+  // check everything before the allocator gets to see any of it
+  if (body.get_num_buffers() > 1) {
+    body.rebuild();
+  }
+  auto for_each_extent = [&](auto&& f) {
+    if (hdr.num == 0) {
+      return;
+    }
+    auto p = body.front().begin();
+    for (uint64_t i = 0; i < hdr.num; ++i) {
+      uint64_t offset, length;
+      denc_varint(offset, p);
+      denc_varint(length, p);
+      f(offset * hdr.unit, length * hdr.unit);
+    }
+  };
+  uint64_t n = 0, b = 0;
+  bool valid = true;
+  try {
+    for_each_extent([&](uint64_t offset, uint64_t length) {
+      if (length == 0 || offset + length > hdr.size) {
+	valid = false;
+      }
+      ++n;
+      b += length;
+    });
+  } catch (ceph::buffer::error& e) {
+    valid = false;
+  }
+  if (!valid || n != hdr.num || b != hdr.bytes) {
+    derr << __func__ << " snapshot is inconsistent" << dendl;
+    return -EIO;
+  }
+
+  for_each_extent([&](uint64_t offset, uint64_t length) {
+    shared_alloc.a->init_add_free(offset, length);
+  });
+  *num = n;
+  *bytes = b;
+  dout(10) << __func__ << " seq " << seq << dendl;
+  return 0;
+}
+
+void BlueStore::_save_alloc_snapshot(uint64_t seq)
+{
+  ceph_assert(bluefs);
+  ceph_assert(shared_alloc.a);
+  if (!cct->_conf.get_val<bool>("bluestore_alloc_snapshot") ||
+      bdev->is_smr() || seq == 0) {
+    // don't keep one around that nobody updates
+    if (bluefs->stat(ALLOC_SNAPSHOT_DIR, ALLOC_SNAPSHOT_FILE,
+		     nullptr, nullptr) == 0) {
+      bluefs->unlink(ALLOC_SNAPSHOT_DIR, ALLOC_SNAPSHOT_FILE);
+    }
+    return;
+  }
+  auto start = mono_clock::now();
+
+  // releases that are still being discarded haven't reached the
+  // allocator yet
+  bdev->discard_drain();
+
+  alloc_snapshot_header_t hdr;
+  hdr.seq = seq;
+  hdr.size = shared_alloc.a->get_capacity();
+  hdr.unit = bdev->get_block_size();
+  bufferlist body;
+  std::vector<std::pair<uint64_t, uint64_t>> pending;
+  auto flush = [&]() {
+    // a varint takes at most 10 bytes
+    auto app = body.get_contiguous_appender(pending.size() * 20);
+    for (auto& [offset, length] : pending) {
+      denc_varint(offset, app);
+      denc_varint(length, app);
+    }
+    pending.clear();
+  };
+  bool misaligned = false;
+  int r = bluefs->dump_shared_space(bluefs_layout.shared_bdev,
+    [&](uint64_t offset, uint64_t length) {
+      if (p2phase(offset, hdr.unit) || p2phase(length, hdr.unit)) {
+	misaligned = true;
+	return;
+      }
+      pending.emplace_back(offset / hdr.unit, length / hdr.unit);
+      ++hdr.num;
+      hdr.bytes += length;
+      if (pending.size() >= 4096) {
+	flush();
+      }
+    });
+  if (r < 0 || misaligned) {
+    derr << __func__ << " unable to take a consistent snapshot" << dendl;
+    return;
+  }
+  flush();
+  hdr.crc = body.crc32c(-1);
+
+  bufferlist bl;
+  hdr.encode(bl);
+  bl.claim_append(body);
+
+  // write it aside and rename, never leaving a partial one in place
+  const string tmp = ALLOC_SNAPSHOT_FILE + ".tmp";
+  if (!bluefs->dir_exists(ALLOC_SNAPSHOT_DIR)) {
+    r = bluefs->mkdir(ALLOC_SNAPSHOT_DIR);
+    if (r < 0) {
+      derr << __func__ << " mkdir failed: " << cpp_strerror(r) << dendl;
+      return;
+    }
+  }
+  BlueFS::FileWriter *h = nullptr;
+  r = bluefs->open_for_write(ALLOC_SNAPSHOT_DIR, tmp, &h, false);
+  if (r < 0) {
+    derr << __func__ << " open_for_write failed: " << cpp_strerror(r)
+	 << dendl;
+    return;
+  }
+  for (auto& p : bl.buffers()) {
+    h->append(p.c_str(), p.length());
+    bluefs->try_flush(h);
+  }
+  r = bluefs->fsync(h);
+  bluefs->close_writer(h);
+  if (r == 0) {
+    r = bluefs->rename(ALLOC_SNAPSHOT_DIR, tmp,
+		       ALLOC_SNAPSHOT_DIR, ALLOC_SNAPSHOT_FILE);
+  }
+  if (r < 0) {
+    derr << __func__ << " failed to write snapshot: " << cpp_strerror(r)
+	 << dendl;
+    bluefs->unlink(ALLOC_SNAPSHOT_DIR, tmp);
+    return;
+  }
+  dout(1) << __func__ << " saved " << byte_u_t(hdr.bytes)
+	  << " in " << hdr.num << " extents (" << byte_u_t(bl.length())
+	  << "), seq " << seq
+	  << " in " << timespan_str(mono_clock::now() - start) << dendl;
+}
+
 void BlueStore::_close_alloc()
 {
   ceph_assert(bdev);
@@ -5836,9 +6316,9 @@ out_fm:
   return r;
 }
 
-void BlueStore::_close_db_and_around(bool read_only)
+void BlueStore::_close_db_and_around(bool read_only, bool save_alloc)
 {
-  _close_db(read_only);
+  _close_db(read_only, save_alloc);
   _close_fm();
   _close_alloc();
   _close_bdev();
@@ -6058,12 +6538,17 @@ int BlueStore::_open_db(bool create, bool to_repair_db, bool read_only)
   return 0;
 }
 
-void BlueStore::_close_db(bool cold_close)
+void BlueStore::_close_db(bool cold_close, bool save_alloc)
 {
   ceph_assert(db);
+  uint64_t seq = save_alloc ? db->get_latest_sequence_number() : 0;
   delete db;
   db = NULL;
   if (bluefs) {
+    if (save_alloc) {
+      // BlueFS has no other users left
+      _save_alloc_snapshot(seq);
+    }
     _close_bluefs(cold_close);
   }
 }
@@ -6859,9 +7344,10 @@ void BlueStore::set_cache_shards(unsigned num)
   onode_cache_shards.resize(num);
   buffer_cache_shards.resize(num);
   for (unsigned i = oold; i < num; ++i) {
-    onode_cache_shards[i] = 
-        OnodeCacheShard::create(cct, cct->_conf->bluestore_cache_type,
-                                 logger);
+    onode_cache_shards[i] =
+        OnodeCacheShard::create(
+          cct, cct->_conf.get_val<std::string>("bluestore_onode_cache_type"),
+          logger);
   }
   for (unsigned i = bold; i < num; ++i) {
     buffer_cache_shards[i] = 
@@ -6870,6 +7356,33 @@ void BlueStore::set_cache_shards(unsigned num)
   }
 }
 
+bool BlueStore::add_priority_cache(
+  const std::string& name,
+  std::shared_ptr<PriorityCache::PriCache> cache)
+{
+  if (!cache_autotune || !db || db->get_priority_cache() == nullptr) {
+    return false;
+  }
+  dout(10) << __func__ << " " << name << dendl;
+  std::lock_guard l(mempool_thread.lock);
+  ceph_assert(!mempool_thread.external_caches.count(name));
+  mempool_thread.external_caches.emplace(name, cache);
+  if (mempool_thread.pcm != nullptr) {
+    mempool_thread.pcm->insert(name, cache, true);
+  }
+  return true;
+}
+
+void BlueStore::remove_priority_cache(const std::string& name)
+{
+  dout(10) << __func__ << " " << name << dendl;
+  std::lock_guard l(mempool_thread.lock);
+  if (mempool_thread.external_caches.erase(name) &&
+      mempool_thread.pcm != nullptr) {
+    mempool_thread.pcm->erase(name);
+  }
+}
+
 int BlueStore::_mount()
 {
   dout(1) << __func__ << " path " << path << dendl;
@@ -6976,7 +7489,8 @@ int BlueStore::umount()
     dout(20) << __func__ << " closing" << dendl;
 
   }
-  _close_db_and_around(false);
+  // with the kv threads stopped the allocator agrees with the freelist
+  _close_db_and_around(false, !_kv_only);
 
   if (cct->_conf->bluestore_fsck_on_umount) {
     int rc = fsck(cct->_conf->bluestore_fsck_on_umount_deep);
@@ -10434,6 +10948,29 @@ int BlueStore::_omap_get(
   return r;
 }
 
+KeyValueDB::Iterator BlueStore::_get_omap_iterator(const OnodeRef& o,
+						  bool with_header)
+{
+  // bound the iterator to this object's keys so that the kv store stops
+  // at the tail instead of walking the tombstones of removed keys after
+  // it, and treat it as a scan: omap listings read each key once
+  KeyValueDB::IteratorBounds bounds;
+  string lower, upper;
+  if (with_header) {
+    o->get_omap_header(&lower);
+  } else {
+    o->get_omap_key(string(), &lower);
+  }
+  o->get_omap_tail(&upper);
+  bounds.lower_bound = std::move(lower);
+  bounds.upper_bound = std::move(upper);
+  KeyValueDB::IteratorOpts opts = KeyValueDB::ITERATOR_SCAN;
+  if (!cct->_conf.get_val<bool>("bluestore_omap_scan_fill_cache")) {
+    opts |= KeyValueDB::ITERATOR_NOCACHE;
+  }
+  return db->get_iterator(o->get_omap_prefix(), opts, std::move(bounds));
+}
+
 int BlueStore::_onode_omap_get(
   const OnodeRef &o,           ///< [in] Object containing omap
   bufferlist *header,          ///< [out] omap header
@@ -10449,8 +10986,7 @@ int BlueStore::_onode_omap_get(
     goto out;
   o->flush();
   {
-    const string& prefix = o->get_omap_prefix();
-    KeyValueDB::Iterator it = db->get_iterator(prefix);
+    KeyValueDB::Iterator it = _get_omap_iterator(o, true);
     string head, tail;
     o->get_omap_header(&head);
     o->get_omap_tail(&tail);
@@ -10534,8 +11070,7 @@ int BlueStore::omap_get_keys(
     goto out;
   o->flush();
   {
-    const string& prefix = o->get_omap_prefix();
-    KeyValueDB::Iterator it = db->get_iterator(prefix);
+    KeyValueDB::Iterator it = _get_omap_iterator(o);
     string head, tail;
     o->get_omap_key(string(), &head);
     o->get_omap_tail(&tail);
@@ -10723,7 +11258,7 @@ ObjectMap::ObjectMapIterator BlueStore::get_omap_iterator(
   }
   o->flush();
   dout(10) << __func__ << " has_omap = " << (int)o->onode.has_omap() <<dendl;
-  KeyValueDB::Iterator it = db->get_iterator(o->get_omap_prefix());
+  KeyValueDB::Iterator it = _get_omap_iterator(o);
   return ObjectMap::ObjectMapIterator(new OmapIteratorImpl(c, o, it));
 }
 
@@ -11705,6 +12240,7 @@ void BlueStore::_kv_start()
   dout(10) << __func__ << dendl;
 
   finisher.start();
+  _kv_start_shards(cct->_conf->bluestore_kv_sync_shards);
   kv_sync_thread.create("bstore_kv_sync");
   kv_finalize_thread.create("bstore_kv_final");
 }
@@ -11730,6 +12266,7 @@ void BlueStore::_kv_stop()
   }
   kv_sync_thread.join();
   kv_finalize_thread.join();
+  _kv_stop_shards();
   ceph_assert(removed_collections.empty());
   {
     std::lock_guard l(kv_lock);
@@ -11874,12 +12411,17 @@ void BlueStore::_kv_sync_thread()
 	dout(10) << __func__ << " new_blobid_max " << new_blobid_max << dendl;
       }
 
+      // with more than one txc to submit, hand them to the shard threads;
+      // they still get committed by the single synct below.
+      bool sharded = kv_sync_shards.size() > 1 && kv_submitting.size() > 1;
       for (auto txc : kv_committing) {
 	throttle.log_state_latency(*txc, logger, l_bluestore_state_kv_queued_lat);
 	if (txc->get_state() == TransContext::STATE_KV_QUEUED) {
 	  ++kv_submitted;
-	  _txc_apply_kv(txc, false);
-	  --txc->osr->kv_committing_serially;
+	  if (!sharded) {
+	    _txc_apply_kv(txc, false);
+	    --txc->osr->kv_committing_serially;
+	  }
 	} else {
 	  ceph_assert(txc->get_state() == TransContext::STATE_KV_SUBMITTED);
 	}
@@ -11887,6 +12429,12 @@ void BlueStore::_kv_sync_thread()
 	  --txc->osr->txc_with_unstable_io;
 	}
       }
+      if (sharded) {
+	// note: kv_committing_serially is only dropped once a txc has been
+	// submitted, so no later txc of the same osr can overtake it via
+	// the sync submit path in the meantime.
+	_kv_submit_sharded(kv_submitting, new_nid_max || new_blobid_max);
+      }
 
       // release throttle *before* we commit.  this allows new ops
       // to be prepared and enter pipeline while we are waiting on
@@ -12012,6 +12560,115 @@ void BlueStore::_kv_sync_thread()
   kv_sync_started = false;
 }
 
+void BlueStore::_kv_start_shards(unsigned num)
+{
+  ceph_assert(kv_sync_shards.empty());
+  if (num <= 1) {
+    return;
+  }
+  dout(10) << __func__ << " " << num << " shards" << dendl;
+  for (unsigned i = 0; i < num; ++i) {
+    auto shard = std::make_unique<KVSyncShard>(this, i);
+    PerfCountersBuilder b(cct, "bluestore-kv-shard-" + stringify(i),
+			  l_bluestore_kv_shard_first, l_bluestore_kv_shard_last);
+    b.add_time_avg(l_bluestore_kv_shard_submit_lat, "submit_lat",
+		   "Average latency to submit one batch of transactions");
+    b.add_u64_avg(l_bluestore_kv_shard_batch, "batch",
+		  "Average number of transactions submitted per batch");
+    shard->logger = b.create_perf_counters();
+    cct->get_perfcounters_collection()->add(shard->logger);
+    shard->create("bstore_kv_shard");
+    kv_sync_shards.push_back(std::move(shard));
+  }
+}
+
+void BlueStore::_kv_stop_shards()
+{
+  {
+    std::lock_guard l(kv_shard_lock);
+    kv_shard_stop = true;
+    kv_shard_cond.notify_all();
+  }
+  for (auto& shard : kv_sync_shards) {
+    shard->join();
+    ceph_assert(shard->q.empty());
+    cct->get_perfcounters_collection()->remove(shard->logger);
+    delete shard->logger;
+  }
+  kv_sync_shards.clear();
+  {
+    std::lock_guard l(kv_shard_lock);
+    kv_shard_stop = false;
+  }
+}
+
+void BlueStore::_kv_submit_sharded(deque<TransContext*>& kv_submitting,
+				   bool front_first)
+{
+  auto p = kv_submitting.begin();
+  if (front_first) {
+    // the first txc carries the new {nid,blobid}_max; submit it before
+    // anything that may already use the newly reserved ids.
+    ceph_assert(p != kv_submitting.end());
+    _txc_apply_kv(*p, false);
+    --(*p)->osr->kv_committing_serially;
+    ++p;
+  }
+
+  std::unique_lock l(kv_shard_lock);
+  ceph_assert(kv_shard_pending == 0);
+  // all txcs of one osr land on the same shard, in queue order
+  for (; p != kv_submitting.end(); ++p) {
+    auto& shard = kv_sync_shards[(*p)->osr->get_sequencer_id() %
+				 kv_sync_shards.size()];
+    if (shard->q.empty()) {
+      ++kv_shard_pending;
+    }
+    shard->q.push_back(*p);
+  }
+  if (kv_shard_pending) {
+    kv_shard_cond.notify_all();
+    kv_shard_done_cond.wait(l, [this] { return kv_shard_pending == 0; });
+  }
+}
+
+void BlueStore::_kv_sync_shard_thread(KVSyncShard *shard)
+{
+  deque<TransContext*> kv_submitting;
+  dout(10) << __func__ << " " << shard->id << " start" << dendl;
+  std::unique_lock l(kv_shard_lock);
+  while (true) {
+    ceph_assert(kv_submitting.empty());
+    if (shard->q.empty()) {
+      if (kv_shard_stop)
+	break;
+      kv_shard_cond.wait(l);
+    } else {
+      kv_submitting.swap(shard->q);
+      l.unlock();
+
+      auto start = mono_clock::now();
+      for (auto txc : kv_submitting) {
+	_txc_apply_kv(txc, false);
+	--txc->osr->kv_committing_serially;
+      }
+      auto dur = mono_clock::now() - start;
+      dout(20) << __func__ << " " << shard->id << " submitted "
+	       << kv_submitting.size() << " in " << dur << dendl;
+      shard->logger->inc(l_bluestore_kv_shard_batch, kv_submitting.size());
+      shard->logger->tinc(l_bluestore_kv_shard_submit_lat, dur);
+      kv_submitting.clear();
+
+      l.lock();
+      ceph_assert(kv_shard_pending > 0);
+      if (--kv_shard_pending == 0) {
+	kv_shard_done_cond.notify_one();
+      }
+    }
+  }
+  dout(10) << __func__ << " " << shard->id << " finish" << dendl;
+}
+
 void BlueStore::_kv_finalize_thread()
 {
   deque<TransContext*> kv_committed;
@@ -110,6 +110,7 @@ enum {
   l_bluestore_pinned_onodes,
   l_bluestore_onode_hits,
   l_bluestore_onode_misses,
+  l_bluestore_onode_compact_hits,
   l_bluestore_onode_shard_hits,
   l_bluestore_onode_shard_misses,
   l_bluestore_extents,
@@ -144,9 +145,18 @@ enum {
   l_bluestore_omap_get_values_lat,
   l_bluestore_clist_lat,
   l_bluestore_remove_lat,
+  l_bluestore_alloc_init_lat,
+  l_bluestore_alloc_snapshot_loads,
   l_bluestore_last
 };
 
+enum {
+  l_bluestore_kv_shard_first = 732530,
+  l_bluestore_kv_shard_submit_lat,
+  l_bluestore_kv_shard_batch,
+  l_bluestore_kv_shard_last
+};
+
 #define META_POOL_ID ((uint64_t)-1ull)
 
 class BlueStore : public ObjectStore,
@@ -1129,6 +1139,10 @@ public:
       const std::string& key,
       const ceph::buffer::list& v);
 
+    /// re-encode a clean onode into its kv representation; false if
+    /// it has state that is not reflected in the kv store
+    bool encode_compact(ceph::buffer::ptr *out);
+
     void dump(ceph::Formatter* f) const;
 
     void flush();
@@ -1165,6 +1179,21 @@ public:
   };
   typedef boost::intrusive_ptr<Onode> OnodeRef;
 
+  struct OnodeSpace;
+
+  /// an onode evicted from the cache, kept in its kv-encoded form
+  struct CompactOnode {
+    MEMPOOL_CLASS_HELPERS();
+
+    OnodeSpace *space;
+    const ghobject_t *oid = nullptr;  ///< our key in space->compact_map
+    ceph::buffer::ptr v;              ///< value stored under PREFIX_OBJ
+    boost::intrusive::list_member_hook<> lru_item;
+
+    CompactOnode(OnodeSpace *s, ceph::buffer::ptr&& v)
+      : space(s), v(std::move(v)) {}
+  };
+
   /// A generic Cache Shard
   struct CacheShard {
     CephContext *cct;
@@ -1234,6 +1263,12 @@ public:
 
     virtual void move_pinned(OnodeCacheShard *to, Onode *o) = 0;
     virtual void add_stats(uint64_t *onodes, uint64_t *pinned_onodes) = 0;
+
+    /// byte budget for onodes kept in encoded form (if supported)
+    virtual void set_compact_max(uint64_t bytes) {}
+    virtual void _rm_compact(CompactOnode* co) {
+      ceph_abort_msg("shard does not keep compact onodes");
+    }
     bool empty() {
       return _get_num() == 0;
     }
@@ -1290,11 +1325,16 @@ public:
   private:
     /// forward lookups
     mempool::bluestore_cache_meta::unordered_map<ghobject_t,OnodeRef> onode_map;
+    /// onodes evicted from onode_map, kept in encoded form
+    mempool::bluestore_cache_onode_compact::unordered_map<
+      ghobject_t,CompactOnode*> compact_map;
 
     friend struct Collection; // for split_cache()
     friend struct Onode; // for put()
     friend struct LruOnodeCacheShard;
+    friend struct CompactLruOnodeCacheShard;
     void _remove(const ghobject_t& oid);
+    void _rm_compact(const ghobject_t& oid);
   public:
     OnodeSpace(OnodeCacheShard *c) : cache(c) {}
     ~OnodeSpace() {
@@ -1303,6 +1343,8 @@ public:
 
     OnodeRef add(const ghobject_t& oid, OnodeRef& o);
     OnodeRef lookup(const ghobject_t& o);
+    /// remove the encoded onode for oid, if any, handing its value to *v
+    bool take_compact(const ghobject_t& oid, ceph::buffer::list *v);
     void rename(OnodeRef& o, const ghobject_t& old_oid,
 		const ghobject_t& new_oid,
 		const mempool::bluestore_cache_meta::string& new_okey);
@@ -1986,6 +2028,17 @@ public:
       return NULL;
     }
   };
+  struct KVSyncShard : public Thread {
+    BlueStore *store;
+    const unsigned id;
+    PerfCounters *logger = nullptr;
+    std::deque<TransContext*> q;  ///< txcs to submit, protected by kv_shard_lock
+    KVSyncShard(BlueStore *s, unsigned i) : store(s), id(i) {}
+    void *entry() override {
+      store->_kv_sync_shard_thread(this);
+      return NULL;
+    }
+  };
   struct ZonedCleanerThread : public Thread {
     BlueStore *store;
     explicit ZonedCleanerThread(BlueStore *s) : store(s) {}
@@ -2101,6 +2154,14 @@ private:
   std::deque<DeferredBatch*> deferred_done_queue;   ///< deferred ios done
   bool kv_sync_in_progress = false;
 
+  /// parallel submitters used by kv_sync_thread (empty if not sharded)
+  std::vector<std::unique_ptr<KVSyncShard>> kv_sync_shards;
+  ceph::mutex kv_shard_lock = ceph::make_mutex("BlueStore::kv_shard_lock");
+  ceph::condition_variable kv_shard_cond;       ///< wakes the shard threads
+  ceph::condition_variable kv_shard_done_cond;  ///< wakes kv_sync_thread
+  unsigned kv_shard_pending = 0;  ///< shards that still have txcs to submit
+  bool kv_shard_stop = false;
+
   KVFinalizeThread kv_finalize_thread;
   ceph::mutex kv_finalize_lock = ceph::make_mutex("BlueStore::kv_finalize_lock");
   ceph::condition_variable kv_finalize_cond;
@@ -2167,6 +2228,7 @@ private:
   double cache_meta_ratio = 0;   ///< cache ratio dedicated to metadata
   double cache_kv_ratio = 0;     ///< cache ratio dedicated to kv (e.g., rocksdb)
   double cache_data_ratio = 0;   ///< cache ratio dedicated to object data
+  double cache_onode_compact_ratio = 0; ///< share of meta cache for encoded onodes
   bool cache_autotune = false;   ///< cache autotune setting
   double cache_autotune_interval = 0; ///< time to wait between cache rebalancing
   uint64_t osd_memory_target = 0;   ///< OSD memory target when autotuning cache
@@ -2194,6 +2256,8 @@ private:
     bool stop = false;
     std::shared_ptr<PriorityCache::PriCache> binned_kv_cache = nullptr;
     std::shared_ptr<PriorityCache::Manager> pcm = nullptr;
+    /// caches owned by the OSD, see add_priority_cache()
+    std::map<std::string, std::shared_ptr<PriorityCache::PriCache>> external_caches;
 
     struct MempoolCache : public PriorityCache::PriCache {
       BlueStore *store;
@@ -2267,6 +2331,7 @@ private:
           mempool::bluestore_cache_meta::allocated_bytes() +
           mempool::bluestore_cache_other::allocated_bytes() +
 	   mempool::bluestore_cache_onode::allocated_bytes() +
+          mempool::bluestore_cache_onode_compact::allocated_bytes() +
           mempool::bluestore_SharedBlob::allocated_bytes() +
           mempool::bluestore_inline_bl::allocated_bytes();
       }
@@ -2282,7 +2347,10 @@ private:
       }
 
       double get_bytes_per_onode() const {
-        return (double)_get_used_bytes() / (double)_get_num_onodes();
+        // encoded onodes are budgeted separately, see _resize_shards()
+        return (double)(_get_used_bytes() -
+          mempool::bluestore_cache_onode_compact::allocated_bytes()) /
+          (double)_get_num_onodes();
       }
     };
     std::shared_ptr<MetaCache> meta_cache;
@@ -2371,7 +2439,7 @@ private:
   * in the proper order
   */
   int _open_db_and_around(bool read_only, bool to_repair = false);
-  void _close_db_and_around(bool read_only);
+  void _close_db_and_around(bool read_only, bool save_alloc = false);
 
   int _prepare_db_environment(bool create, bool read_only,
 			      std::string* kv_dir, std::string* kv_backend);
@@ -2383,12 +2451,16 @@ private:
   int _open_db(bool create,
 	       bool to_repair_db=false,
 	       bool read_only = false);
-  void _close_db(bool read_only);
+  void _close_db(bool read_only, bool save_alloc = false);
   int _open_fm(KeyValueDB::Transaction t, bool read_only);
   void _close_fm();
   int _write_out_fm_meta(uint64_t target_size);
   int _create_alloc();
   int _init_alloc();
+  /// initialize the allocator from a valid snapshot, if there is one
+  int _load_alloc_snapshot(uint64_t *num, uint64_t *bytes);
+  /// save a snapshot matching DB sequence number seq, DB closed
+  void _save_alloc_snapshot(uint64_t seq);
   void _close_alloc();
   int _open_collections();
   void _fsck_collections(int64_t* errors);
@@ -2471,6 +2543,11 @@ private:
   void _kv_stop();
   void _kv_sync_thread();
   void _kv_finalize_thread();
+  void _kv_start_shards(unsigned num);
+  void _kv_stop_shards();
+  void _kv_submit_sharded(std::deque<TransContext*>& kv_submitting,
+			  bool front_first);
+  void _kv_sync_shard_thread(KVSyncShard *shard);
 
   void _zoned_cleaner_start();
   void _zoned_cleaner_stop();
@@ -2640,6 +2717,10 @@ public:
   }
 
   void set_cache_shards(unsigned num) override;
+  bool add_priority_cache(
+    const std::string& name,
+    std::shared_ptr<PriorityCache::PriCache> cache) override;
+  void remove_priority_cache(const std::string& name) override;
   void dump_cache_stats(ceph::Formatter *f) override {
     int onode_count = 0, buffers_bytes = 0;
     for (auto i: onode_cache_shards) {
@@ -2872,6 +2953,9 @@ public:
     ceph::buffer::list *header,      ///< [out] omap header
     std::map<std::string, ceph::buffer::list> *out /// < [out] Key to value map
     );
+  /// iterator over the omap of o, from its header if with_header
+  KeyValueDB::Iterator _get_omap_iterator(const OnodeRef& o,
+					  bool with_header = false);
   int _onode_omap_get(
     const OnodeRef &o,           ///< [in] Object containing omap
     ceph::buffer::list *header,          ///< [out] omap header
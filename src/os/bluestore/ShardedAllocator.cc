@@ -0,0 +1,278 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include "ShardedAllocator.h"
+
+#include <algorithm>
+
+#include "common/debug.h"
+#include "include/intarith.h"
+#include "include/stringify.h"
+
+#define dout_context cct
+#define dout_subsys ceph_subsys_bluestore
+#undef  dout_prefix
+#define dout_prefix *_dout << "ShardedAllocator(" << this << ") "
+
+ShardedAllocator::ShardedAllocator(CephContext* cct,
+				   int64_t device_size,
+				   int64_t block_size,
+				   unsigned num_shards,
+				   uint64_t max_mem,
+				   const std::string& name) :
+  Allocator(name, device_size, block_size),
+  cct(cct)
+{
+  uint64_t size = device_size;
+  uint64_t n = std::clamp<uint64_t>(size / MIN_SHARD_SIZE, 1, std::max(num_shards, 1u));
+  if (n > 1) {
+    // keep region boundaries aligned for any sane allocation unit
+    shard_size = p2roundup(div_round_up(size, n), MIN_SHARD_SIZE);
+    n = div_round_up(size, shard_size);
+  } else {
+    shard_size = std::max<uint64_t>(size, 1);
+  }
+  ldout(cct, 10) << __func__ << " 0x" << std::hex << size
+		 << " in " << std::dec << n << " shards of 0x"
+		 << std::hex << shard_size << std::dec << dendl;
+
+  shards.reserve(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    auto s = std::make_unique<Shard>();
+    s->base = i * shard_size;
+    s->size = std::min(shard_size, size - s->base);
+    s->alloc = std::make_unique<HybridAllocator>(
+      cct, s->size, block_size, max_mem / n,
+      name.empty() ? name : name + "." + stringify(i));
+    shards.push_back(std::move(s));
+  }
+}
+
+ShardedAllocator::~ShardedAllocator()
+{
+  shutdown();
+}
+
+void ShardedAllocator::_update_stats(Shard& s)
+{
+  s.free = s.alloc->get_free();
+  s.frag_permille = s.alloc->get_fragmentation() * 1000;
+}
+
+int64_t ShardedAllocator::_allocate(
+  Shard& s,
+  uint64_t want,
+  uint64_t unit,
+  uint64_t max_alloc_size,
+  int64_t hint,
+  PExtentVector *extents)
+{
+  auto pos = extents->size();
+  // HybridAllocator may fail after allocating part of the request and
+  // leave what it got in extents; count (and keep) whatever is there
+  s.alloc->allocate(want, unit, max_alloc_size, hint, extents);
+  int64_t got = 0;
+  for (auto i = pos; i < extents->size(); ++i) {
+    auto& e = (*extents)[i];
+    e.offset += s.base;
+    got += e.length;
+  }
+  _update_stats(s);
+  return got;
+}
+
+template <typename F>
+void ShardedAllocator::_for_each_shard(uint64_t offset, uint64_t length, F&& f)
+{
+  while (length > 0) {
+    size_t i = _shard_of(offset);
+    ceph_assert(i < shards.size());
+    Shard& s = *shards[i];
+    uint64_t l = std::min(length, s.base + s.size - offset);
+    f(i, offset - s.base, l);
+    offset += l;
+    length -= l;
+  }
+}
+
+int64_t ShardedAllocator::allocate(
+  uint64_t want,
+  uint64_t unit,
+  uint64_t max_alloc_size,
+  int64_t  hint,
+  PExtentVector* extents)
+{
+  ldout(cct, 10) << __func__ << std::hex
+                 << " want 0x" << want
+                 << " unit 0x" << unit
+                 << " max_alloc_size 0x" << max_alloc_size
+                 << " hint 0x" << hint
+                 << std::dec << dendl;
+  ceph_assert(isp2(unit));
+  ceph_assert(want % unit == 0);
+
+  size_t start = 0;
+  if (hint > 0 && hint < get_capacity()) {
+    start = _shard_of(hint);
+  }
+  auto local_hint = [&](const Shard& s) -> int64_t {
+    return hint >= (int64_t)s.base && hint < (int64_t)(s.base + s.size) ?
+      hint - s.base : 0;
+  };
+
+  // a single region that has room for the whole request and that
+  // nobody else is busy with
+  uint64_t got = 0;
+  for (size_t k = 0; k < shards.size() && got < want; ++k) {
+    Shard& s = *shards[(start + k) % shards.size()];
+    if (s.free < want - got) {
+      continue;
+    }
+    std::unique_lock l(s.lock, std::try_to_lock);
+    if (!l.owns_lock()) {
+      continue;
+    }
+    got += _allocate(s, want - got, unit, max_alloc_size, local_hint(s),
+		     extents);
+  }
+
+  if (got < want) {
+    // gather from every region, least fragmented and emptiest first
+    std::vector<Shard*> order;
+    order.reserve(shards.size());
+    for (auto& s : shards) {
+      if (s->free > 0) {
+	order.push_back(s.get());
+      }
+    }
+    auto weight = [](const Shard* s) {
+      return s->free / 1000 * (1000 - std::min(s->frag_permille.load(), 1000u));
+    };
+    std::stable_sort(order.begin(), order.end(),
+      [&](const Shard* a, const Shard* b) {
+	return weight(a) > weight(b);
+      });
+    for (auto s : order) {
+      std::lock_guard l(s->lock);
+      got += _allocate(*s, want - got, unit, max_alloc_size, local_hint(*s),
+		       extents);
+      if (got >= want) {
+	break;
+      }
+    }
+  }
+  ldout(cct, 20) << __func__ << " got 0x" << std::hex << got << std::dec
+		 << dendl;
+  return got ? (int64_t)got : -ENOSPC;
+}
+
+void ShardedAllocator::release(const interval_set<uint64_t>& release_set)
+{
+  // release_set is sorted: hand each shard its part in one go
+  size_t cur = 0;
+  interval_set<uint64_t> local;
+  auto flush = [&]() {
+    if (!local.empty()) {
+      Shard& s = *shards[cur];
+      std::lock_guard l(s.lock);
+      s.alloc->release(local);
+      _update_stats(s);
+      local.clear();
+    }
+  };
+  for (auto p = release_set.begin(); p != release_set.end(); ++p) {
+    _for_each_shard(p.get_start(), p.get_len(),
+      [&](size_t i, uint64_t offset, uint64_t length) {
+	if (i != cur) {
+	  flush();
+	  cur = i;
+	}
+	local.insert(offset, length);
+      });
+  }
+  flush();
+}
+
+uint64_t ShardedAllocator::get_free()
+{
+  uint64_t free = 0;
+  for (auto& s : shards) {
+    free += s->free;
+  }
+  return free;
+}
+
+double ShardedAllocator::get_fragmentation()
+{
+  uint64_t free = 0;
+  double f = 0;
+  for (auto& s : shards) {
+    std::lock_guard l(s->lock);
+    uint64_t shard_free = s->alloc->get_free();
+    f += s->alloc->get_fragmentation() * shard_free;
+    free += shard_free;
+  }
+  return free ? f / free : 0.0;
+}
+
+void ShardedAllocator::dump()
+{
+  for (size_t i = 0; i < shards.size(); ++i) {
+    Shard& s = *shards[i];
+    std::lock_guard l(s.lock);
+    ldout(cct, 0) << __func__ << " shard " << i << std::hex
+		  << " 0x" << s.base << "~" << s.size
+		  << std::dec << dendl;
+    s.alloc->dump();
+  }
+}
+
+void ShardedAllocator::dump(std::function<void(uint64_t offset, uint64_t length)> notify)
+{
+  for (auto& s : shards) {
+    std::lock_guard l(s->lock);
+    uint64_t base = s->base;
+    s->alloc->dump([&](uint64_t offset, uint64_t length) {
+      notify(base + offset, length);
+    });
+  }
+}
+
+void ShardedAllocator::init_add_free(uint64_t offset, uint64_t length)
+{
+  ldout(cct, 10) << __func__ << std::hex
+                 << " offset 0x" << offset
+                 << " length 0x" << length
+                 << std::dec << dendl;
+  _for_each_shard(offset, length,
+    [&](size_t i, uint64_t o, uint64_t l) {
+      Shard& s = *shards[i];
+      std::lock_guard sl(s.lock);
+      s.alloc->init_add_free(o, l);
+      _update_stats(s);
+    });
+}
+
+void ShardedAllocator::init_rm_free(uint64_t offset, uint64_t length)
+{
+  ldout(cct, 10) << __func__ << std::hex
+                 << " offset 0x" << offset
+                 << " length 0x" << length
+                 << std::dec << dendl;
+  _for_each_shard(offset, length,
+    [&](size_t i, uint64_t o, uint64_t l) {
+      Shard& s = *shards[i];
+      std::lock_guard sl(s.lock);
+      s.alloc->init_rm_free(o, l);
+      _update_stats(s);
+    });
+}
+
+void ShardedAllocator::shutdown()
+{
+  for (auto& s : shards) {
+    std::lock_guard l(s->lock);
+    s->alloc->shutdown();
+    _update_stats(*s);
+  }
+}
@@ -0,0 +1,87 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Allocator.h"
+#include "HybridAllocator.h"
+
+/*
+ * Splits the device into contiguous regions, each managed by its own
+ * HybridAllocator under its own lock, so that concurrent allocations
+ * and releases in different regions don't serialize on a single mutex.
+ *
+ * Allocation first looks for a single region able to satisfy the whole
+ * request, skipping regions whose lock is held by somebody else.  If
+ * there is none, it falls back to collecting space from every region,
+ * least fragmented first.  Extents never span a region boundary.
+ */
+class ShardedAllocator : public Allocator {
+  struct Shard {
+    std::mutex lock;
+    std::unique_ptr<HybridAllocator> alloc;
+    uint64_t base = 0;
+    uint64_t size = 0;
+    // lock-free hints for placement, refreshed with the lock held
+    std::atomic<uint64_t> free = {0};
+    std::atomic<uint32_t> frag_permille = {0};
+  };
+
+  CephContext* cct;
+  uint64_t shard_size = 0;
+  std::vector<std::unique_ptr<Shard>> shards;
+
+  size_t _shard_of(uint64_t offset) const {
+    return offset / shard_size;
+  }
+  /// refresh the placement hints of a locked shard
+  void _update_stats(Shard& s);
+  /// allocate from a locked shard, extents at device offsets
+  int64_t _allocate(Shard& s,
+		    uint64_t want,
+		    uint64_t unit,
+		    uint64_t max_alloc_size,
+		    int64_t hint,
+		    PExtentVector *extents);
+  /// call f(shard, local offset, length) for each shard a range spans
+  template <typename F>
+  void _for_each_shard(uint64_t offset, uint64_t length, F&& f);
+
+public:
+  /// regions are at least this large, and aligned to it
+  static constexpr uint64_t MIN_SHARD_SIZE = 1ull << 30;
+
+  ShardedAllocator(CephContext* cct, int64_t device_size, int64_t block_size,
+		   unsigned num_shards, uint64_t max_mem,
+		   const std::string& name);
+  ~ShardedAllocator() override;
+
+  const char* get_type() const override
+  {
+    return "sharded";
+  }
+  int64_t allocate(
+    uint64_t want,
+    uint64_t unit,
+    uint64_t max_alloc_size,
+    int64_t  hint,
+    PExtentVector *extents) override;
+  void release(const interval_set<uint64_t>& release_set) override;
+  uint64_t get_free() override;
+  double get_fragmentation() override;
+
+  void dump() override;
+  void dump(std::function<void(uint64_t offset, uint64_t length)> notify) override;
+  void init_add_free(uint64_t offset, uint64_t length) override;
+  void init_rm_free(uint64_t offset, uint64_t length) override;
+  void shutdown() override;
+
+  size_t get_num_shards() const {
+    return shards.size();
+  }
+};
@@ -23,6 +23,7 @@
 #include "messages/MOSDECSubOpRead.h"
 #include "messages/MOSDECSubOpReadReply.h"
 #include "ECMsgTypes.h"
+#include "ECStripeCache.h"
 
 #include "PrimaryLogPG.h"
 
@@ -174,6 +175,7 @@ ostream &operator<<(ostream &lhs, const ECBackend::Op &rhs)
       << " pending_commit=" << rhs.pending_commit
       << " plan.to_read=" << rhs.plan.to_read
       << " plan.will_write=" << rhs.plan.will_write
+      << " plan.parity_delta=" << rhs.plan.parity_delta
       << ")";
   return lhs;
 }
@@ -883,6 +885,7 @@ struct SubWriteCommitted : public Context {
   ceph_tid_t tid;
   eversion_t version;
   eversion_t last_complete;
+  int result;
   const ZTracer::Trace trace;
   SubWriteCommitted(
     ECBackend *pg,
@@ -890,24 +893,27 @@ struct SubWriteCommitted : public Context {
     ceph_tid_t tid,
     eversion_t version,
     eversion_t last_complete,
+    int result,
     const ZTracer::Trace &trace)
     : pg(pg), msg(msg), tid(tid),
-      version(version), last_complete(last_complete), trace(trace) {}
+      version(version), last_complete(last_complete), result(result),
+      trace(trace) {}
   void finish(int) override {
     if (msg)
       msg->mark_event("sub_op_committed");
-    pg->sub_write_committed(tid, version, last_complete, trace);
+    pg->sub_write_committed(tid, version, last_complete, result, trace);
   }
 };
 void ECBackend::sub_write_committed(
   ceph_tid_t tid, eversion_t version, eversion_t last_complete,
-  const ZTracer::Trace &trace) {
+  int result, const ZTracer::Trace &trace) {
   if (get_parent()->pgb_is_primary()) {
     ECSubWriteReply reply;
     reply.tid = tid;
     reply.last_complete = last_complete;
     reply.committed = true;
     reply.applied = true;
+    reply.result = result;
     reply.from = get_parent()->whoami_shard();
     handle_sub_write_reply(
       get_parent()->whoami_shard(),
@@ -922,6 +928,7 @@ void ECBackend::sub_write_committed(
     r->op.last_complete = last_complete;
     r->op.committed = true;
     r->op.applied = true;
+    r->op.result = result;
     r->op.from = get_parent()->whoami_shard();
     r->set_priority(CEPH_MSG_PRIO_HIGH);
     r->trace = trace;
@@ -979,6 +986,28 @@ void ECBackend::handle_sub_write(
       dout(30) << " entry is_delete " << e.is_delete() << dendl;
     }
   }
+  int result = 0;
+  if (!op.parity_deltas.empty()) {
+    ceph_assert(!op.backfill_or_async_recovery);
+    result = apply_parity_deltas(op.parity_deltas, &op.t);
+    if (result < 0) {
+      // the coding chunks are stale now: remember the objects as
+      // missing until recovery rebuilds them, and tell the primary
+      get_parent()->clog_error() << "Error " << result
+				 << " reading coding chunks of "
+				 << op.parity_deltas.size()
+				 << " object(s) to update parity of "
+				 << op.soid;
+      async = true;
+      for (auto &&e: op.log_entries) {
+	if (op.parity_deltas.count(e.soid) && !pmissing.is_missing(e.soid)) {
+	  dout(10) << __func__ << " marking " << e.soid << " missing" << dendl;
+	  get_parent()->add_local_next_event(e);
+	}
+      }
+    }
+  }
+
   get_parent()->log_operation(
     std::move(op.log_entries),
     op.updated_hit_set_history,
@@ -999,7 +1028,7 @@ void ECBackend::handle_sub_write(
       new SubWriteCommitted(
 	this, msg, op.tid,
 	op.at_version,
-	get_parent()->get_info().last_complete, trace)));
+	get_parent()->get_info().last_complete, result, trace)));
   vector<ObjectStore::Transaction> tls;
   tls.reserve(2);
   tls.push_back(std::move(op.t));
@@ -1012,6 +1041,20 @@ void ECBackend::handle_sub_write(
   }
 }
 
+int ECBackend::apply_parity_deltas(
+  const ECTransaction::parity_delta_map_t &deltas,
+  ObjectStore::Transaction *t)
+{
+  return ECTransaction::apply_parity_deltas(
+    ec_impl,
+    store,
+    ch,
+    get_parent()->whoami_shard().shard,
+    deltas,
+    t,
+    get_parent()->get_dpp());
+}
+
 void ECBackend::handle_sub_read(
   pg_shard_t from,
   const ECSubRead &op,
@@ -1167,6 +1210,18 @@ void ECBackend::handle_sub_write_reply(
     ceph_assert(i->second.pending_apply.count(from));
     i->second.pending_apply.erase(from);
   }
+  if (op.result < 0) {
+    // the shard couldn't update the parity of the objects it was sent
+    // deltas for; have recovery rebuild their chunks from the full
+    // stripes, and later writes to them won't use deltas until then
+    dout(0) << __func__ << " shard " << from << " failed to apply "
+	    << i->second << ": " << cpp_strerror(op.result) << dendl;
+    for (auto &&e : i->second.log_entries) {
+      if (i->second.plan.delta_shards.count(e.soid)) {
+	get_parent()->on_failed_sub_write(from, e.soid, e.version);
+      }
+    }
+  }
 
   if (i->second.pending_commit.empty() &&
       i->second.on_all_commit &&
@@ -1483,6 +1538,9 @@ void ECBackend::on_change()
   in_progress_client_reads.clear();
   shard_to_read_map.clear();
   clear_recovery_state();
+  if (ECStripeCache *stripe_cache = get_parent()->get_ec_stripe_cache()) {
+    stripe_cache->clear_pg(get_parent()->whoami_spg_t());
+  }
 }
 
 void ECBackend::clear_recovery_state()
@@ -1899,6 +1957,31 @@ void ECBackend::start_rmw(Op *op, PGTransactionUPtr &&t)
   check_ops();
 }
 
+bool ECBackend::can_write_parity_delta(const Op &op) const
+{
+  if (!cct->_conf.get_val<bool>("osd_ec_parity_delta_writes") ||
+      get_osdmap()->require_osd_release < ceph_release_t::pacific ||
+      !ec_impl->supports_parity_delta() ||
+      !ec_impl->get_chunk_mapping().empty()) {
+    return false;
+  }
+  // every shard must hold the current chunks the deltas apply to
+  const auto &shards = get_parent()->get_acting_recovery_backfill_shards();
+  if (shards.size() != ec_impl->get_chunk_count() ||
+      !get_parent()->get_backfill_shards().empty()) {
+    return false;
+  }
+  for (auto &&i : op.plan.delta_shards) {
+    for (auto &&shard : shards) {
+      auto missing = get_parent()->maybe_get_shard_missing(shard);
+      if (!missing || missing->is_missing(i.first)) {
+	return false;
+      }
+    }
+  }
+  return true;
+}
+
 bool ECBackend::try_state_to_reads()
 {
   if (waiting_state.empty())
@@ -1914,7 +1997,17 @@ bool ECBackend::try_state_to_reads()
     return false;
   }
 
-  if (!pipeline_state.caching_enabled()) {
+  if (!op->plan.delta_shards.empty() &&
+      waiting_reads.empty() &&
+      can_write_parity_delta(*op)) {
+    // the old chunks are read and the new ones written around the
+    // cache, so later rmws must not trust it until this op is done
+    dout(20) << __func__ << ": writing parity deltas, invalidating cache"
+	     << " after this op" << dendl;
+    op->plan.parity_delta = true;
+    op->using_cache = false;
+    pipeline_state.invalidate();
+  } else if (!pipeline_state.caching_enabled()) {
     op->using_cache = false;
   } else if (op->invalidates_cache()) {
     dout(20) << __func__ << ": invalidating cache after this op"
@@ -1925,7 +2018,18 @@ bool ECBackend::try_state_to_reads()
   waiting_state.pop_front();
   waiting_reads.push_back(*op);
 
-  if (op->using_cache) {
+  if (op->plan.parity_delta) {
+    for (auto &&[hoid, stripes] : op->plan.delta_shards) {
+      auto &remote_read = op->remote_read[hoid];
+      for (auto &&[stripe_off, shards] : stripes) {
+	for (int shard : shards) {
+	  remote_read.union_insert(
+	    stripe_off + shard * sinfo.get_chunk_size(),
+	    sinfo.get_chunk_size());
+	}
+      }
+    }
+  } else if (op->using_cache) {
     cache.open_write_pin(op->pin);
 
     extent_set empty;
@@ -1960,14 +2064,22 @@ bool ECBackend::try_state_to_reads()
 
   if (!op->remote_read.empty()) {
     ceph_assert(get_parent()->get_pool().allows_ecoverwrites());
-    objects_read_async_no_cache(
-      op->remote_read,
+    auto on_complete =
       [this, op](map<hobject_t,pair<int, extent_map> > &&results) {
 	for (auto &&i: results) {
 	  op->remote_read_result.emplace(i.first, i.second.second);
 	}
 	check_ops();
-      });
+      };
+    if (op->plan.parity_delta) {
+      objects_read_chunks(
+	op->plan.delta_shards,
+	make_gen_lambda_context<
+	  map<hobject_t,pair<int, extent_map> > &&, decltype(on_complete)>(
+	    std::move(on_complete)));
+    } else {
+      objects_read_async_no_cache(op->remote_read, std::move(on_complete));
+    }
   }
 
   return true;
@@ -2014,6 +2126,7 @@ bool ECBackend::try_reads_to_commit()
   op->trace.event("start ec write");
 
   map<hobject_t,extent_map> written;
+  map<shard_id_t, ECTransaction::parity_delta_map_t> parity_deltas;
   if (op->plan.t) {
     ECTransaction::generate_transactions(
       op->plan,
@@ -2027,7 +2140,8 @@ bool ECBackend::try_reads_to_commit()
       &(op->temp_added),
       &(op->temp_cleared),
       get_parent()->get_dpp(),
-      get_osdmap()->require_osd_release);
+      get_osdmap()->require_osd_release,
+      &parity_deltas);
   }
 
   dout(20) << __func__ << ": " << cache << dendl;
@@ -2049,7 +2163,8 @@ bool ECBackend::try_reads_to_commit()
     written_set[i.first] = i.second.get_interval_set();
   }
   dout(20) << __func__ << ": written_set: " << written_set << dendl;
-  ceph_assert(written_set == op->plan.will_write);
+  // parity delta writes neither write whole stripes nor touch the cache
+  ceph_assert(op->plan.parity_delta || written_set == op->plan.will_write);
 
   if (op->using_cache) {
     for (auto &&hpair: written) {
@@ -2057,6 +2172,15 @@ bool ECBackend::try_reads_to_commit()
       cache.present_rmw_update(hpair.first, op->pin, hpair.second);
     }
   }
+  if (ECStripeCache *stripe_cache = get_parent()->get_ec_stripe_cache()) {
+    spg_t pgid = get_parent()->whoami_spg_t();
+    for (auto &&hpair: op->plan.hash_infos) {
+      stripe_cache->invalidate(pgid, hpair.first);
+    }
+    for (auto &&hpair: written) {
+      stripe_cache->insert(pgid, hpair.first, hpair.second);
+    }
+  }
   op->remote_read.clear();
   op->remote_read_result.clear();
 
@@ -2096,6 +2220,12 @@ bool ECBackend::try_reads_to_commit()
       op->temp_added,
       op->temp_cleared,
       !should_send);
+    if (should_send) {
+      auto diter = parity_deltas.find(i->shard);
+      if (diter != parity_deltas.end()) {
+	sop.parity_deltas.swap(diter->second);
+      }
+    }
 
     ZTracer::Trace trace;
     if (op->trace) {
@@ -2316,15 +2446,57 @@ void ECBackend::objects_read_async(
       to_read.clear();
     }
   };
+  auto func = make_gen_lambda_context<
+    map<hobject_t,pair<int, extent_map> > &&, cb>(
+      cb(this,
+	 hoid,
+	 to_read,
+	 on_complete));
+
+  extent_map cached;
+  if (!es.empty() && stripe_cache_lookup(hoid, es, &cached)) {
+    // still complete in order with the reads ahead of us
+    in_progress_client_reads.emplace_back(1, std::move(func));
+    in_progress_client_reads.back().complete_object(
+      hoid, 0, std::move(cached));
+    kick_reads();
+    return;
+  }
+
   objects_read_and_reconstruct(
     reads,
     fast_read,
-    make_gen_lambda_context<
-      map<hobject_t,pair<int, extent_map> > &&, cb>(
-	cb(this,
-	   hoid,
-	   to_read,
-	   on_complete)));
+    std::move(func));
+}
+
+bool ECBackend::stripe_cache_lookup(
+  const hobject_t &hoid,
+  const extent_set &want,
+  extent_map *out)
+{
+  ECStripeCache *stripe_cache = get_parent()->get_ec_stripe_cache();
+  if (!stripe_cache) {
+    return false;
+  }
+  PerfCounters *logger = get_parent()->get_logger();
+  logger->inc(l_osd_ec_stripe_cache_total);
+  if (!stripe_cache->lookup(get_parent()->whoami_spg_t(), hoid, want, out)) {
+    return false;
+  }
+  logger->inc(l_osd_ec_stripe_cache_hit);
+  dout(20) << __func__ << ": " << hoid << " " << want << " hit" << dendl;
+  return true;
+}
+
+void ECBackend::stripe_cache_insert(
+  const hobject_t &hoid,
+  uint64_t off,
+  const bufferlist &bl)
+{
+  ECStripeCache *stripe_cache = get_parent()->get_ec_stripe_cache();
+  if (stripe_cache) {
+    stripe_cache->insert(get_parent()->whoami_spg_t(), hoid, off, bl);
+  }
 }
 
 struct CallClientContexts :
@@ -2369,6 +2541,10 @@ struct CallClientContexts :
         res.r = r;
         goto out;
       }
+      if (!(read.get<2>() & (CEPH_OSD_OP_FLAG_FADVISE_DONTNEED |
+			     CEPH_OSD_OP_FLAG_FADVISE_NOCACHE))) {
+	ec->stripe_cache_insert(hoid, adjusted.first, bl);
+      }
       bufferlist trimmed;
       trimmed.substr_of(
 	bl,
@@ -2385,6 +2561,111 @@ out:
   }
 };
 
+struct CallChunkReadContexts :
+  public GenContext<pair<RecoveryMessages*, ECBackend::read_result_t& > &> {
+  hobject_t hoid;
+  ECBackend *ec;
+  ECBackend::ClientAsyncReadStatus *status;
+  map<uint64_t, set<int>> to_read;
+  CallChunkReadContexts(
+    hobject_t hoid,
+    ECBackend *ec,
+    ECBackend::ClientAsyncReadStatus *status,
+    const map<uint64_t, set<int>> &to_read)
+    : hoid(hoid), ec(ec), status(status), to_read(to_read) {}
+  void finish(pair<RecoveryMessages *, ECBackend::read_result_t &> &in) override {
+    ECBackend::read_result_t &res = in.second;
+    const uint64_t chunk_size = ec->sinfo.get_chunk_size();
+    extent_map result;
+    if (res.r != 0)
+      goto out;
+    ceph_assert(res.returned.size() == to_read.size());
+    ceph_assert(res.errors.empty());
+    for (auto &&[stripe_off, shards] : to_read) {
+      ceph_assert(res.returned.front().get<0>() == stripe_off);
+      map<int, bufferlist> to_decode;
+      for (auto &&j : res.returned.front().get<2>()) {
+	to_decode[j.first.shard] = std::move(j.second);
+      }
+      map<int, bufferlist> chunks;
+      map<int, bufferlist*> out;
+      for (int shard : shards) {
+	out[shard] = &chunks[shard];
+      }
+      int r = ECUtil::decode(ec->sinfo, ec->ec_impl, to_decode, out);
+      if (r < 0) {
+	res.r = r;
+	goto out;
+      }
+      for (auto &&[shard, bl] : chunks) {
+	if (bl.length() != chunk_size) {
+	  res.r = -EIO;
+	  goto out;
+	}
+	result.insert(stripe_off + shard * chunk_size, chunk_size,
+		      std::move(bl));
+      }
+      res.returned.pop_front();
+    }
+out:
+    status->complete_object(hoid, res.r, std::move(result));
+    ec->kick_reads();
+  }
+};
+
+void ECBackend::objects_read_chunks(
+  const map<hobject_t, map<uint64_t, set<int>>> &reads,
+  GenContextURef<map<hobject_t,pair<int, extent_map> > &&> &&func)
+{
+  in_progress_client_reads.emplace_back(
+    reads.size(), std::move(func));
+  if (!reads.size()) {
+    kick_reads();
+    return;
+  }
+
+  map<hobject_t, set<int>> obj_want_to_read;
+  map<hobject_t, read_request_t> for_read_op;
+  for (auto &&[hoid, stripes] : reads) {
+    set<int> want_to_read;
+    list<boost::tuple<uint64_t, uint64_t, uint32_t> > to_read;
+    for (auto &&[stripe_off, shards] : stripes) {
+      want_to_read.insert(shards.begin(), shards.end());
+      to_read.emplace_back(stripe_off, sinfo.get_stripe_width(), 0);
+    }
+    map<pg_shard_t, vector<pair<int, int>>> shards;
+    int r = get_min_avail_to_read_shards(
+      hoid,
+      want_to_read,
+      false,
+      false,
+      &shards);
+    ceph_assert(r == 0);
+
+    CallChunkReadContexts *c = new CallChunkReadContexts(
+      hoid,
+      this,
+      &(in_progress_client_reads.back()),
+      stripes);
+    for_read_op.insert(
+      make_pair(
+	hoid,
+	read_request_t(
+	  to_read,
+	  shards,
+	  false,
+	  c)));
+    obj_want_to_read.insert(make_pair(hoid, want_to_read));
+  }
+
+  start_read_op(
+    CEPH_MSG_PRIO_DEFAULT,
+    obj_want_to_read,
+    for_read_op,
+    OpRequestRef(),
+    false, false);
+}
+
 void ECBackend::objects_read_and_reconstruct(
   const map<hobject_t,
     std::list<boost::tuple<uint64_t, uint64_t, uint32_t> >
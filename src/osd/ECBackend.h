@@ -61,6 +61,7 @@ public:
     ceph_tid_t tid,
     eversion_t version,
     eversion_t last_complete,
+    int result,
     const ZTracer::Trace &trace);
   void handle_sub_write(
     pg_shard_t from,
@@ -68,6 +69,9 @@ public:
     ECSubWrite &op,
     const ZTracer::Trace &trace
     );
+  int apply_parity_deltas(
+    const ECTransaction::parity_delta_map_t &deltas,
+    ObjectStore::Transaction *t);
   void handle_sub_read(
     pg_shard_t from,
     const ECSubRead &op,
@@ -193,6 +197,28 @@ public:
       std::map<hobject_t,std::pair<int, extent_map> > &&, Func>(
 	  std::forward<Func>(on_complete)));
   }
+  /**
+   * Read the old content of the chunks of the given data shards in
+   * each stripe (keyed by logical offset), as needed to compute parity
+   * deltas, and return it at its logical offsets. Chunks on
+   * unavailable shards are reconstructed.
+   */
+  void objects_read_chunks(
+    const std::map<hobject_t, std::map<uint64_t, std::set<int>>> &reads,
+    GenContextURef<std::map<hobject_t,std::pair<int, extent_map> > &&> &&func);
+  friend struct CallChunkReadContexts;
+
+  /// serve a client read of the stripe aligned extents want from the
+  /// OSD's stripe cache, if it holds all of them
+  bool stripe_cache_lookup(
+    const hobject_t &hoid,
+    const extent_set &want,
+    extent_map *out);
+  void stripe_cache_insert(
+    const hobject_t &hoid,
+    uint64_t off,
+    const ceph::buffer::list &bl);
+
   void kick_reads() {
     while (in_progress_client_reads.size() &&
 	   in_progress_client_reads.front().is_complete()) {
@@ -561,6 +587,7 @@ public:
   eversion_t completed_to;
   eversion_t committed_to;
   void start_rmw(Op *op, PGTransactionUPtr &&t);
+  bool can_write_parity_delta(const Op &op) const;
   bool try_state_to_reads();
   bool try_reads_to_commit();
   bool try_finish_rmw();
@@ -24,7 +24,8 @@ using ceph::Formatter;
 
 void ECSubWrite::encode(bufferlist &bl) const
 {
-  ENCODE_START(4, 1, bl);
+  // a shard that would ignore the parity deltas must not decode this
+  ENCODE_START(5, parity_deltas.empty() ? 1 : 5, bl);
   encode(from, bl);
   encode(tid, bl);
   encode(reqid, bl);
@@ -39,12 +40,13 @@ void ECSubWrite::encode(bufferlist &bl) const
   encode(updated_hit_set_history, bl);
   encode(roll_forward_to, bl);
   encode(backfill_or_async_recovery, bl);
+  encode(parity_deltas, bl);
   ENCODE_FINISH(bl);
 }
 
 void ECSubWrite::decode(bufferlist::const_iterator &bl)
 {
-  DECODE_START(4, bl);
+  DECODE_START(5, bl);
   decode(from, bl);
   decode(tid, bl);
   decode(reqid, bl);
@@ -70,6 +72,9 @@ void ECSubWrite::decode(bufferlist::const_iterator &bl)
     // The old protocol used an empty transaction to indicate backfill or async_recovery
     backfill_or_async_recovery = t.empty();
   }
+  if (struct_v >= 5) {
+    decode(parity_deltas, bl);
+  }
   DECODE_FINISH(bl);
 }
 
@@ -85,6 +90,8 @@ std::ostream &operator<<(
     lhs << ", has_updated_hit_set_history";
   if (rhs.backfill_or_async_recovery)
     lhs << ", backfill_or_async_recovery";
+  if (!rhs.parity_deltas.empty())
+    lhs << ", parity_deltas=" << rhs.parity_deltas.size();
   return lhs <<  ")";
 }
 
@@ -98,6 +105,24 @@ void ECSubWrite::dump(Formatter *f) const
   f->dump_bool("has_updated_hit_set_history",
       static_cast<bool>(updated_hit_set_history));
   f->dump_bool("backfill_or_async_recovery", backfill_or_async_recovery);
+  f->open_array_section("parity_deltas");
+  for (auto &[oid, chunks] : parity_deltas) {
+    for (auto &[off, deltas] : chunks) {
+      f->open_object_section("delta");
+      f->dump_stream("oid") << oid;
+      f->dump_unsigned("offset", off);
+      f->open_array_section("shards");
+      for (auto &[shard, bl] : deltas) {
+	f->open_object_section("shard");
+	f->dump_int("shard", shard);
+	f->dump_unsigned("length", bl.length());
+	f->close_section();
+      }
+      f->close_section();
+      f->close_section();
+    }
+  }
+  f->close_section();
 }
 
 void ECSubWrite::generate_test_instances(list<ECSubWrite*> &o)
@@ -117,27 +142,37 @@ void ECSubWrite::generate_test_instances(list<ECSubWrite*> &o)
   o.back()->at_version = eversion_t(10, 300);
   o.back()->trim_to = eversion_t(5, 42);
   o.back()->roll_forward_to = eversion_t(8, 250);
+  o.push_back(new ECSubWrite());
+  o.back()->tid = 12;
+  o.back()->at_version = eversion_t(10, 301);
+  o.back()->parity_deltas[hobject_t()][4096][1].append("delta");
 }
 
 void ECSubWriteReply::encode(bufferlist &bl) const
 {
-  ENCODE_START(1, 1, bl);
+  ENCODE_START(2, 1, bl);
   encode(from, bl);
   encode(tid, bl);
   encode(last_complete, bl);
   encode(committed, bl);
   encode(applied, bl);
+  encode(result, bl);
   ENCODE_FINISH(bl);
 }
 
 void ECSubWriteReply::decode(bufferlist::const_iterator &bl)
 {
-  DECODE_START(1, bl);
+  DECODE_START(2, bl);
   decode(from, bl);
   decode(tid, bl);
   decode(last_complete, bl);
   decode(committed, bl);
   decode(applied, bl);
+  if (struct_v >= 2) {
+    decode(result, bl);
+  } else {
+    result = 0;
+  }
   DECODE_FINISH(bl);
 }
 
@@ -148,7 +183,8 @@ std::ostream &operator<<(
     << "ECSubWriteReply(tid=" << rhs.tid
     << ", last_complete=" << rhs.last_complete
     << ", committed=" << rhs.committed
-    << ", applied=" << rhs.applied << ")";
+    << ", applied=" << rhs.applied
+    << ", result=" << rhs.result << ")";
 }
 
 void ECSubWriteReply::dump(Formatter *f) const
@@ -157,6 +193,7 @@ void ECSubWriteReply::dump(Formatter *f) const
   f->dump_stream("last_complete") << last_complete;
   f->dump_bool("committed", committed);
   f->dump_bool("applied", applied);
+  f->dump_int("result", result);
 }
 
 void ECSubWriteReply::generate_test_instances(list<ECSubWriteReply*>& o)
@@ -169,6 +206,11 @@ void ECSubWriteReply::generate_test_instances(list<ECSubWriteReply*>& o)
   o.back()->tid = 80;
   o.back()->last_complete = eversion_t(50, 200);
   o.back()->applied = true;
+  o.push_back(new ECSubWriteReply());
+  o.back()->tid = 90;
+  o.back()->committed = true;
+  o.back()->applied = true;
+  o.back()->result = -EIO;
 }
 
 void ECSubRead::encode(bufferlist &bl, uint64_t features) const
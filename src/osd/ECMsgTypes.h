@@ -35,6 +35,10 @@ struct ECSubWrite {
   std::set<hobject_t> temp_removed;
   std::optional<pg_hit_set_history_t> updated_hit_set_history;
   bool backfill_or_async_recovery = false;
+  /// parity deltas to fold into this shard's chunks once t is applied:
+  /// object -> chunk offset -> data shard -> delta of that data chunk
+  std::map<hobject_t, std::map<uint64_t, std::map<int, ceph::buffer::list>>>
+    parity_deltas;
   ECSubWrite() : tid(0) {}
   ECSubWrite(
     pg_shard_t from,
@@ -76,6 +80,7 @@ struct ECSubWrite {
     temp_removed.swap(other.temp_removed);
     updated_hit_set_history = other.updated_hit_set_history;
     backfill_or_async_recovery = other.backfill_or_async_recovery;
+    parity_deltas.swap(other.parity_deltas);
   }
   void encode(ceph::buffer::list &bl) const;
   void decode(ceph::buffer::list::const_iterator &bl);
@@ -94,6 +99,7 @@ struct ECSubWriteReply {
   eversion_t last_complete;
   bool committed;
   bool applied;
+  int32_t result = 0; ///< < 0 if the parity deltas couldn't be applied
   ECSubWriteReply() : tid(0), committed(false), applied(false) {}
   void encode(ceph::buffer::list &bl) const;
   void decode(ceph::buffer::list::const_iterator &bl);
@@ -0,0 +1,211 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include "ECStripeCache.h"
+
+#include "common/ceph_context.h"
+#include "common/dout.h"
+
+#define dout_context cct
+#define dout_subsys ceph_subsys_osd
+#undef dout_prefix
+#define dout_prefix *_dout << "ECStripeCache "
+
+ECStripeCache::ECStripeCache(CephContext *cct)
+  : cct(cct),
+    max_bytes(cct->_conf.get_val<Option::size_t>("osd_ec_stripe_cache_size")),
+    cache_ratio(cct->_conf.get_val<double>("osd_ec_stripe_cache_ratio"))
+{
+}
+
+ECStripeCache::~ECStripeCache()
+{
+  std::lock_guard l(lock);
+  lru.clear();
+  pgs.clear();
+}
+
+void ECStripeCache::set_autotune(bool a)
+{
+  std::lock_guard l(lock);
+  autotune = a;
+  _trim();
+}
+
+bool ECStripeCache::lookup(
+  const spg_t &pgid,
+  const hobject_t &hoid,
+  const extent_set &want,
+  extent_map *out)
+{
+  std::lock_guard l(lock);
+  auto pp = pgs.find(pgid);
+  if (pp == pgs.end()) {
+    return false;
+  }
+  auto p = pp->second.find(hoid);
+  if (p == pp->second.end()) {
+    return false;
+  }
+  Object &o = p->second;
+  extent_set have = o.data.get_interval_set();
+  for (auto &&i : want) {
+    if (!have.contains(i.first, i.second)) {
+      return false;
+    }
+  }
+  for (auto &&i : want) {
+    out->insert(o.data.intersect(i.first, i.second));
+  }
+  lru.erase(lru.iterator_to(o));
+  lru.push_back(o);
+  return true;
+}
+
+void ECStripeCache::insert(
+  const spg_t &pgid,
+  const hobject_t &hoid,
+  uint64_t off,
+  const ceph::buffer::list &bl)
+{
+  if (bl.length() == 0) {
+    return;
+  }
+  // copy so that we neither pin nor account for the (possibly much
+  // larger) buffers the data came in
+  ceph::buffer::list copy = bl;
+  copy.rebuild();
+
+  std::lock_guard l(lock);
+  auto &objects = pgs[pgid];
+  auto [p, inserted] = objects.try_emplace(hoid, pgid, hoid);
+  Object &o = p->second;
+  if (inserted) {
+    ++num_objects;
+  } else {
+    lru.erase(lru.iterator_to(o));
+  }
+  lru.push_back(o);
+  o.data.insert(off, copy.length(), std::move(copy));
+  bytes -= o.bytes;
+  o.bytes = o.data.get_interval_set().size();
+  bytes += o.bytes;
+  _trim();
+}
+
+void ECStripeCache::insert(
+  const spg_t &pgid,
+  const hobject_t &hoid,
+  const extent_map &data)
+{
+  for (auto &&i : data) {
+    insert(pgid, hoid, i.get_off(), i.get_val());
+  }
+}
+
+void ECStripeCache::invalidate(const spg_t &pgid, const hobject_t &hoid)
+{
+  std::lock_guard l(lock);
+  auto pp = pgs.find(pgid);
+  if (pp == pgs.end()) {
+    return;
+  }
+  auto p = pp->second.find(hoid);
+  if (p != pp->second.end()) {
+    _erase(p->second);
+  }
+}
+
+void ECStripeCache::clear_pg(const spg_t &pgid)
+{
+  std::lock_guard l(lock);
+  auto pp = pgs.find(pgid);
+  if (pp == pgs.end()) {
+    return;
+  }
+  ldout(cct, 20) << __func__ << " " << pgid << " dropping "
+		 << pp->second.size() << " objects" << dendl;
+  for (auto &&[hoid, o] : pp->second) {
+    lru.erase(lru.iterator_to(o));
+    bytes -= o.bytes;
+    --num_objects;
+  }
+  pgs.erase(pp);
+}
+
+uint64_t ECStripeCache::get_bytes() const
+{
+  std::lock_guard l(lock);
+  return bytes;
+}
+
+uint64_t ECStripeCache::get_num_objects() const
+{
+  std::lock_guard l(lock);
+  return num_objects;
+}
+
+void ECStripeCache::_erase(Object &o)
+{
+  lru.erase(lru.iterator_to(o));
+  bytes -= o.bytes;
+  --num_objects;
+  auto pp = pgs.find(o.pgid);
+  ceph_assert(pp != pgs.end());
+  pp->second.erase(pp->second.find(o.hoid));  // destroys o
+  if (pp->second.empty()) {
+    pgs.erase(pp);
+  }
+}
+
+void ECStripeCache::_trim()
+{
+  uint64_t target = _get_target();
+  while (bytes > target && !lru.empty()) {
+    _erase(lru.front());
+  }
+}
+
+int64_t ECStripeCache::request_cache_bytes(
+  PriorityCache::Priority pri, uint64_t total_cache) const
+{
+  int64_t assigned = get_cache_bytes(pri);
+  switch (pri) {
+  // like the BlueStore mempool caches, ask for what we hold at PRI1 and
+  // grow from our share of whatever is left over
+  case PriorityCache::Priority::PRI1:
+    {
+      int64_t request = get_bytes();
+      return (request > assigned) ? request - assigned : 0;
+    }
+  default:
+    break;
+  }
+  return -EOPNOTSUPP;
+}
+
+int64_t ECStripeCache::get_cache_bytes() const
+{
+  int64_t total = 0;
+  for (int i = 0; i < PriorityCache::Priority::LAST + 1; i++) {
+    total += get_cache_bytes(static_cast<PriorityCache::Priority>(i));
+  }
+  return total;
+}
+
+int64_t ECStripeCache::commit_cache_size(uint64_t total_cache)
+{
+  std::lock_guard l(lock);
+  committed_bytes = PriorityCache::get_chunk(get_cache_bytes(), total_cache);
+  _trim();
+  return committed_bytes;
+}
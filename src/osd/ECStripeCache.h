@@ -0,0 +1,148 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_OSD_ECSTRIPECACHE_H
+#define CEPH_OSD_ECSTRIPECACHE_H
+
+#include <map>
+#include <boost/intrusive/list.hpp>
+
+#include "common/ceph_mutex.h"
+#include "common/PriorityCache.h"
+#include "include/common_fwd.h"
+#include "osd/ExtentCache.h"
+#include "osd/osd_types.h"
+
+/**
+   ECStripeCache
+
+   Keeps the decoded (logical) content of recently read and written EC
+   stripes on the primary so that subsequent reads of the same stripes
+   can be served without reading and decoding shards.
+
+   One instance is shared by all the PGs of an OSD.  Content is keyed by
+   PG and object and kept as stripe aligned extents; whole objects are
+   evicted in LRU order.  The backend must invalidate an object before
+   it is modified and drop a PG's content whenever the PG changes
+   interval: the cache never validates what it returns.
+
+   When the object store autotunes its caches the cache is registered
+   with the store's PriorityCache::Manager and sized by it, otherwise it
+   is bounded by osd_ec_stripe_cache_size.
+ */
+class ECStripeCache : public PriorityCache::PriCache {
+public:
+  explicit ECStripeCache(CephContext *cct);
+  ~ECStripeCache() override;
+
+  /// the store balances our memory; see ObjectStore::add_priority_cache()
+  void set_autotune(bool a);
+
+  /**
+   * Look up extents of an object
+   *
+   * @param want stripe aligned extents to read
+   * @param out receives want, if all of it is cached
+   * @returns true on a hit
+   */
+  bool lookup(
+    const spg_t &pgid,
+    const hobject_t &hoid,
+    const extent_set &want,
+    extent_map *out);
+
+  /// add stripe aligned content of an object
+  void insert(
+    const spg_t &pgid,
+    const hobject_t &hoid,
+    uint64_t off,
+    const ceph::buffer::list &bl);
+  void insert(
+    const spg_t &pgid,
+    const hobject_t &hoid,
+    const extent_map &data);
+
+  /// drop anything cached for an object
+  void invalidate(const spg_t &pgid, const hobject_t &hoid);
+  /// drop anything cached for a PG
+  void clear_pg(const spg_t &pgid);
+
+  uint64_t get_bytes() const;
+  uint64_t get_num_objects() const;
+
+  // PriorityCache::PriCache
+  int64_t request_cache_bytes(
+    PriorityCache::Priority pri, uint64_t total_cache) const override;
+  int64_t get_cache_bytes(PriorityCache::Priority pri) const override {
+    return cache_bytes[pri];
+  }
+  int64_t get_cache_bytes() const override;
+  void set_cache_bytes(PriorityCache::Priority pri, int64_t bytes) override {
+    cache_bytes[pri] = bytes;
+  }
+  void add_cache_bytes(PriorityCache::Priority pri, int64_t bytes) override {
+    cache_bytes[pri] += bytes;
+  }
+  int64_t commit_cache_size(uint64_t total_cache) override;
+  int64_t get_committed_size() const override {
+    return committed_bytes;
+  }
+  double get_cache_ratio() const override {
+    return cache_ratio;
+  }
+  void set_cache_ratio(double ratio) override {
+    cache_ratio = ratio;
+  }
+  std::string get_cache_name() const override {
+    return "EC Stripe Cache";
+  }
+
+private:
+  struct Object {
+    boost::intrusive::list_member_hook<> lru_item;
+    spg_t pgid;
+    hobject_t hoid;
+    extent_map data;
+    uint64_t bytes = 0;
+
+    Object(const spg_t &pgid, const hobject_t &hoid)
+      : pgid(pgid), hoid(hoid) {}
+  };
+  using lru_t = boost::intrusive::list<
+    Object,
+    boost::intrusive::member_hook<
+      Object,
+      boost::intrusive::list_member_hook<>,
+      &Object::lru_item>>;
+
+  CephContext *cct;
+  mutable ceph::mutex lock = ceph::make_mutex("ECStripeCache::lock");
+  std::map<spg_t, std::map<hobject_t, Object>> pgs;
+  lru_t lru;  ///< least recently used at the front
+  uint64_t bytes = 0;
+  uint64_t num_objects = 0;
+
+  const uint64_t max_bytes;  ///< limit unless autotuned
+  bool autotune = false;
+
+  int64_t cache_bytes[PriorityCache::Priority::LAST+1] = {0};
+  int64_t committed_bytes = 0;
+  double cache_ratio;
+
+  uint64_t _get_target() const {
+    return autotune ? committed_bytes : max_bytes;
+  }
+  void _trim();
+  void _erase(Object &o);
+};
+
+#endif
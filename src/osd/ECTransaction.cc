@@ -105,6 +105,144 @@ bool ECTransaction::requires_overwrite(
       (op.truncate->first < prev_size)));
 }
 
+static bufferlist get_chunk(
+  const extent_map &m,
+  uint64_t off,
+  uint64_t len) {
+  bufferlist bl;
+  uint64_t next = off;
+  for (auto &&extent : m.intersect(off, len)) {
+    ceph_assert(extent.get_off() == next);
+    bl.append(extent.get_val());
+    next += extent.get_len();
+  }
+  ceph_assert(next == off + len);
+  return bl;
+}
+
+void delta_and_write(
+  pg_t pgid,
+  const hobject_t &oid,
+  const ECUtil::stripe_info_t &sinfo,
+  ErasureCodeInterfaceRef &ecimpl,
+  uint64_t stripe_off,
+  const set<int> &shards,
+  const extent_map &old_chunks,
+  const extent_map &new_chunks,
+  uint32_t flags,
+  map<shard_id_t, ObjectStore::Transaction> *transactions,
+  map<shard_id_t, ECTransaction::parity_delta_map_t> *parity_deltas,
+  DoutPrefixProvider *dpp) {
+  const uint64_t chunk_size = sinfo.get_chunk_size();
+  const uint64_t chunk_off = sinfo.logical_to_prev_chunk_offset(stripe_off);
+  const int k = ecimpl->get_data_chunk_count();
+
+  map<int, bufferlist> deltas;
+  for (int shard : shards) {
+    uint64_t off = stripe_off + shard * chunk_size;
+    bufferlist old_bl = get_chunk(old_chunks, off, chunk_size);
+    bufferlist new_bl = get_chunk(new_chunks, off, chunk_size);
+    ecimpl->encode_delta(old_bl, new_bl, &deltas[shard]);
+
+    auto iter = transactions->find(shard_id_t(shard));
+    if (iter != transactions->end()) {
+      iter->second.write(
+	coll_t(spg_t(pgid, iter->first)),
+	ghobject_t(oid, ghobject_t::NO_GEN, iter->first),
+	chunk_off,
+	new_bl.length(),
+	new_bl,
+	flags);
+    }
+  }
+
+  ldpp_dout(dpp, 20) << __func__ << ": " << oid
+		     << " stripe " << stripe_off
+		     << " data shards " << shards
+		     << dendl;
+
+  for (auto &&i : *transactions) {
+    if (i.first.id < k)
+      continue;
+    (*parity_deltas)[i.first][oid][chunk_off] = deltas;
+  }
+}
+
+bool ECTransaction::get_parity_delta_shards(
+  const ECUtil::stripe_info_t &sinfo,
+  uint64_t size,
+  const PGTransaction::ObjectOperation &op,
+  const extent_set &write_set,
+  map<uint64_t, set<int>> *shards)
+{
+  if (!op.is_none() || op.truncate || write_set.empty())
+    return false;
+  uint64_t k = sinfo.get_stripe_width() / sinfo.get_chunk_size();
+  for (auto &&extent : write_set) {
+    uint64_t end = extent.first + extent.second;
+    if (end > size)
+      return false;
+    for (uint64_t off = extent.first; off < end; ) {
+      uint64_t stripe = sinfo.logical_to_prev_stripe_offset(off);
+      uint64_t stripe_end = std::min(end, stripe + sinfo.get_stripe_width());
+      uint64_t first = (off - stripe) / sinfo.get_chunk_size();
+      uint64_t last = (stripe_end - 1 - stripe) / sinfo.get_chunk_size();
+      auto &s = (*shards)[stripe];
+      for (uint64_t shard = first; shard <= last; ++shard)
+	s.insert(shard);
+      off = stripe_end;
+    }
+  }
+  // reading and shipping deltas for more than half the data shards of
+  // a stripe costs about as much as rewriting it
+  for (auto &&i : *shards) {
+    if (i.second.size() * 2 > k)
+      return false;
+  }
+  return true;
+}
+
+int ECTransaction::apply_parity_deltas(
+  ErasureCodeInterfaceRef &ecimpl,
+  ObjectStore *store,
+  ObjectStore::CollectionHandle &ch,
+  shard_id_t shard,
+  const parity_delta_map_t &deltas,
+  ObjectStore::Transaction *t,
+  DoutPrefixProvider *dpp)
+{
+  ObjectStore::Transaction updates;
+  for (auto &&[hoid, chunks] : deltas) {
+    ghobject_t goid(hoid, ghobject_t::NO_GEN, shard);
+    for (auto &&[off, data_deltas] : chunks) {
+      ceph_assert(!data_deltas.empty());
+      uint64_t len = data_deltas.begin()->second.length();
+      // reads see the transactions queued before this one, which is
+      // what the primary computed the deltas against
+      bufferlist old;
+      int r = store->read(ch, goid, off, len, old);
+      if (r != (int)len) {
+	ldpp_dout(dpp, 0) << __func__ << ": unable to read " << goid << " "
+			  << off << "~" << len
+			  << " to apply parity delta: r=" << r << dendl;
+	return r < 0 ? r : -EIO;
+      }
+      // the store may still reference the buffers it returned
+      bufferptr p(len);
+      old.begin().copy(len, p.c_str());
+      map<int, bufferlist> coding;
+      coding[shard.id].push_back(std::move(p));
+      ecimpl->apply_delta(data_deltas, coding);
+      ldpp_dout(dpp, 20) << __func__ << ": " << goid << " " << off << "~"
+			 << len << " data shards " << data_deltas.size()
+			 << dendl;
+      updates.write(ch->get_cid(), goid, off, len, coding[shard.id]);
+    }
+  }
+  t->append(updates);
+  return 0;
+}
+
 void ECTransaction::generate_transactions(
   WritePlan &plan,
   ErasureCodeInterfaceRef &ecimpl,
@@ -117,7 +255,8 @@ void ECTransaction::generate_transactions(
   set<hobject_t> *temp_added,
   set<hobject_t> *temp_removed,
   DoutPrefixProvider *dpp,
-  const ceph_release_t require_osd_release)
+  const ceph_release_t require_osd_release,
+  map<shard_id_t, parity_delta_map_t> *parity_deltas)
 {
   ceph_assert(written_map);
   ceph_assert(transactions);
@@ -553,7 +692,61 @@ void ECTransaction::generate_transactions(
       for (unsigned i = 0; i < ecimpl->get_chunk_count(); ++i) {
 	want.insert(i);
       }
-      auto to_overwrite = to_write.intersect(0, append_after);
+      auto stash_overwritten = [&](uint64_t restore_from,
+				   uint64_t restore_len) {
+	ldpp_dout(dpp, 20) << __func__ << ": overwriting "
+			   << restore_from << "~" << restore_len
+			   << dendl;
+	if (rollback_extents.empty()) {
+	  for (auto &&st : *transactions) {
+	    st.second.touch(
+	      coll_t(spg_t(pgid, st.first)),
+	      ghobject_t(oid, entry->version.version, st.first));
+	  }
+	}
+	rollback_extents.emplace_back(make_pair(restore_from, restore_len));
+	for (auto &&st : *transactions) {
+	  st.second.clone_range(
+	    coll_t(spg_t(pgid, st.first)),
+	    ghobject_t(oid, ghobject_t::NO_GEN, st.first),
+	    ghobject_t(oid, entry->version.version, st.first),
+	    restore_from,
+	    restore_len,
+	    restore_from);
+	}
+      };
+
+      extent_map to_overwrite;
+      if (plan.parity_delta) {
+	/* Only the touched data chunks were read: write them back with
+	 * the update applied and hand the parity shards the deltas.
+	 * Every shard still stashes the stripe for rollback. */
+	ceph_assert(parity_deltas);
+	ceph_assert(pextiter != partial_extents.end());
+	ceph_assert(append_after == orig_size && new_size == orig_size);
+	for (auto &&[stripe_off, shards] : plan.delta_shards.at(oid)) {
+	  if (entry) {
+	    stash_overwritten(
+	      sinfo.aligned_logical_offset_to_chunk_offset(stripe_off),
+	      sinfo.get_chunk_size());
+	  }
+	  delta_and_write(
+	    pgid,
+	    oid,
+	    sinfo,
+	    ecimpl,
+	    stripe_off,
+	    shards,
+	    pextiter->second,
+	    to_write,
+	    fadvise_flags,
+	    transactions,
+	    parity_deltas,
+	    dpp);
+	}
+      } else {
+	to_overwrite = to_write.intersect(0, append_after);
+      }
       ldpp_dout(dpp, 20) << __func__ << ": to_overwrite: "
 			 << to_overwrite
 			 << dendl;
@@ -562,30 +755,9 @@ void ECTransaction::generate_transactions(
 	ceph_assert(sinfo.logical_offset_is_stripe_aligned(extent.get_off()));
 	ceph_assert(sinfo.logical_offset_is_stripe_aligned(extent.get_len()));
 	if (entry) {
-	  uint64_t restore_from = sinfo.aligned_logical_offset_to_chunk_offset(
-	    extent.get_off());
-	  uint64_t restore_len = sinfo.aligned_logical_offset_to_chunk_offset(
-	    extent.get_len());
-	  ldpp_dout(dpp, 20) << __func__ << ": overwriting "
-			     << restore_from << "~" << restore_len
-			     << dendl;
-	  if (rollback_extents.empty()) {
-	    for (auto &&st : *transactions) {
-	      st.second.touch(
-		coll_t(spg_t(pgid, st.first)),
-		ghobject_t(oid, entry->version.version, st.first));
-	    }
-	  }
-	  rollback_extents.emplace_back(make_pair(restore_from, restore_len));
-	  for (auto &&st : *transactions) {
-	    st.second.clone_range(
-	      coll_t(spg_t(pgid, st.first)),
-	      ghobject_t(oid, ghobject_t::NO_GEN, st.first),
-	      ghobject_t(oid, entry->version.version, st.first),
-	      restore_from,
-	      restore_len,
-	      restore_from);
-	  }
+	  stash_overwritten(
+	    sinfo.aligned_logical_offset_to_chunk_offset(extent.get_off()),
+	    sinfo.aligned_logical_offset_to_chunk_offset(extent.get_len()));
 	}
 	encode_and_write(
 	  pgid,
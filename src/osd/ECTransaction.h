@@ -23,6 +23,11 @@
 #include "ExtentCache.h"
 
 namespace ECTransaction {
+  /// object -> chunk offset -> data shard -> delta, see ECSubWrite
+  using parity_delta_map_t =
+    std::map<hobject_t,
+	     std::map<uint64_t, std::map<int, ceph::buffer::list>>>;
+
   struct WritePlan {
     PGTransactionUPtr t;
     bool invalidates_cache = false; // Yes, both are possible
@@ -30,12 +35,37 @@ namespace ECTransaction {
     std::map<hobject_t,extent_set> will_write; // superset of to_read
 
     std::map<hobject_t,ECUtil::HashInfoRef> hash_infos;
+
+    /// data shards written in each stripe (by logical offset) if every
+    /// object of the op is a small partial overwrite, whose parity may
+    /// then be updated with deltas instead of rewriting whole stripes
+    std::map<hobject_t, std::map<uint64_t, std::set<int>>> delta_shards;
+    bool parity_delta = false; // set once ECBackend picks the delta path
   };
 
   bool requires_overwrite(
     uint64_t prev_size,
     const PGTransaction::ObjectOperation &op);
 
+  bool get_parity_delta_shards(
+    const ECUtil::stripe_info_t &sinfo,
+    uint64_t size,
+    const PGTransaction::ObjectOperation &op,
+    const extent_set &write_set,
+    std::map<uint64_t, std::set<int>> *shards);
+
+  /// fold the parity deltas a sub-write carries into this shard's
+  /// coding chunks, writing the updated chunks to t; fails, leaving t
+  /// alone, if a coding chunk can't be read
+  int apply_parity_deltas(
+    ErasureCodeInterfaceRef &ecimpl,
+    ObjectStore *store,
+    ObjectStore::CollectionHandle &ch,
+    shard_id_t shard,
+    const parity_delta_map_t &deltas,
+    ObjectStore::Transaction *t,
+    DoutPrefixProvider *dpp);
+
   template <typename F>
   WritePlan get_write_plan(
     const ECUtil::stripe_info_t &sinfo,
@@ -43,6 +73,7 @@ namespace ECTransaction {
     F &&get_hinfo,
     DoutPrefixProvider *dpp) {
     WritePlan plan;
+    bool parity_delta = true;
     t->safe_create_traverse(
       [&](std::pair<const hobject_t, PGTransaction::ObjectOperation> &i) {
 	ECUtil::HashInfoRef hinfo = get_hinfo(i.first);
@@ -150,6 +181,13 @@ namespace ECTransaction {
 	  }
 	}
 
+	if (parity_delta &&
+	    !get_parity_delta_shards(sinfo, orig_size, i.second,
+				     raw_write_set,
+				     &plan.delta_shards[i.first])) {
+	  parity_delta = false;
+	}
+
 	if (i.second.truncate &&
 	    i.second.truncate->second > projected_size) {
 	  uint64_t truncating_to =
@@ -178,6 +216,9 @@ namespace ECTransaction {
 	       (!plan.to_read.at(i.first).empty() &&
 		!i.second.has_source()));
       });
+    if (!parity_delta) {
+      plan.delta_shards.clear();
+    }
     plan.t = std::move(t);
     return plan;
   }
@@ -194,7 +235,8 @@ namespace ECTransaction {
     std::set<hobject_t> *temp_added,
     std::set<hobject_t> *temp_removed,
     DoutPrefixProvider *dpp,
-    const ceph_release_t require_osd_release = ceph_release_t::unknown);
+    const ceph_release_t require_osd_release = ceph_release_t::unknown,
+    std::map<shard_id_t, parity_delta_map_t> *parity_deltas = nullptr);
 };
 
 #endif
@@ -38,6 +38,7 @@
 #include "osd/PG.h"
 #include "osd/scrub_machine.h"
 #include "osd/pg_scrubber.h"
+#include "osd/ECStripeCache.h"
 
 #include "include/types.h"
 #include "include/compat.h"
@@ -3410,6 +3411,15 @@ int OSD::init()
   dout(2) << "journal looks like " << (journal_is_rotational ? "hdd" : "ssd")
           << dendl;
 
+  if (cct->_conf.get_val<bool>("osd_ec_stripe_cache")) {
+    service.ec_stripe_cache = std::make_shared<ECStripeCache>(cct);
+    bool autotune = store->add_priority_cache(
+      "ec_stripe", service.ec_stripe_cache);
+    service.ec_stripe_cache->set_autotune(autotune);
+    dout(2) << "ec stripe cache " << (autotune ? "autotuned" : "fixed size")
+	    << dendl;
+  }
+
   enable_disable_fuse(false);
 
   dout(2) << "boot" << dendl;
@@ -3584,6 +3594,10 @@ int OSD::init()
     std::lock_guard l(shard->osdmap_lock);
     shard->shard_osdmap = osdmap;
   }
+  for (auto& shard : shards) {
+    std::lock_guard l(shard->shard_lock);
+    shard->scheduler->update_from_osdmap(*osdmap);
+  }
 
   // load up pgs (as they previously existed)
   load_pgs();
@@ -4325,6 +4339,10 @@ int OSD::shutdown()
   service.shutdown();
 
   std::lock_guard lock(osd_lock);
+  if (service.ec_stripe_cache) {
+    store->remove_priority_cache("ec_stripe");
+    service.ec_stripe_cache.reset();
+  }
   store->umount();
   delete store;
   store = nullptr;
@@ -8038,14 +8056,28 @@ void OSD::handle_osd_map(MOSDMap *m)
 
       OSDMap *o = new OSDMap;
       if (e > 1) {
-	bufferlist obl;
-        bool got = get_map_bl(e - 1, obl);
-	if (!got) {
-	  auto p = added_maps_bl.find(e - 1);
-	  ceph_assert(p != added_maps_bl.end());
-	  obl = p->second;
+	// start from the previous map if we have it in memory: o then
+	// shares everything the incremental doesn't touch with it
+	OSDMapRef prev;
+	auto q = added_maps.find(e - 1);
+	if (q != added_maps.end()) {
+	  prev = q->second;
+	} else {
+	  std::lock_guard l(service.map_cache_lock);
+	  prev = service.map_cache.lookup(e - 1);
+	}
+	if (prev) {
+	  o->deepish_copy_from(*prev);
+	} else {
+	  bufferlist obl;
+	  bool got = get_map_bl(e - 1, obl);
+	  if (!got) {
+	    auto p = added_maps_bl.find(e - 1);
+	    ceph_assert(p != added_maps_bl.end());
+	    obl = p->second;
+	  }
+	  o->decode(obl);
 	}
-	o->decode(obl);
       }
 
       OSDMap::Incremental inc;
@@ -10240,6 +10272,7 @@ void OSDShard::consume_map(
   dout(10) << new_osdmap->get_epoch()
            << " (was " << (old_osdmap ? old_osdmap->get_epoch() : 0) << ")"
 	   << dendl;
+  scheduler->update_from_osdmap(*new_osdmap);
   bool queued = false;
 
   // check slots
@@ -10704,6 +10737,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
  retry_pg:
   PGRef pg = slot->pg;
+  std::optional<ceph::mono_time> pg_locked_at;
 
   // lock pg (if we have it)
   if (pg) {
@@ -10714,6 +10748,7 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
     sdata->shard_lock.unlock();
     osd->service.maybe_inject_dispatch_delay();
     pg->lock();
+    pg_locked_at = ceph::mono_clock::now();
     osd->service.maybe_inject_dispatch_delay();
     sdata->shard_lock.lock();
 
@@ -10862,6 +10897,14 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
       return;
     }
   }
+
+  // while we hold the pg lock, also take the ops for this pg that come
+  // next anyway, so they do not each have to wait for the lock again
+  std::vector<OpSchedulerItem> batch;
+  if (pg_locked_at && qi.can_batch()) {
+    _take_op_batch(sdata, token, slot, &batch);
+    osd->logger->inc(l_osd_op_batch_size, 1 + batch.size());
+  }
   sdata->shard_lock.unlock();
 
   if (!new_children.empty()) {
@@ -10893,7 +10936,24 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   delete f;
   *_dout << dendl;
 
-  qi.run(osd, sdata, pg, tp_handle);
+  if (batch.empty()) {
+    qi.run(osd, sdata, pg, tp_handle);
+  } else {
+    dout(20) << __func__ << " " << token << " running " << qi
+	     << " and " << batch.size() << " more" << dendl;
+    pg->start_op_batch();
+    qi.run_batched(osd, sdata, pg, tp_handle);
+    for (auto& i : batch) {
+      tp_handle.reset_tp_timeout();
+      i.run_batched(osd, sdata, pg, tp_handle);
+    }
+    pg->finish_op_batch();
+    pg->unlock();
+  }
+  if (pg_locked_at) {
+    osd->logger->tinc(l_osd_pg_lock_hold_lat,
+		      ceph::mono_clock::now() - *pg_locked_at);
+  }
 
   {
 #ifdef WITH_LTTNG
@@ -10909,6 +10969,44 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   handle_oncommits(oncommits);
 }
 
+void OSD::ShardedOpWQ::_take_op_batch(
+  OSDShard *sdata,
+  const spg_t& token,
+  OSDShardPGSlot *slot,
+  std::vector<OpSchedulerItem> *batch)
+{
+  ceph_assert(ceph_mutex_is_locked_by_me(sdata->shard_lock));
+  unsigned max = osd->cct->_conf->osd_op_batch_max;
+  while (batch->size() + 1 < max) {
+    if (!slot->to_process.empty()) {
+      // another worker dequeued this one and is waiting for the pg lock;
+      // it will find nothing left to do, just as if it lost a race with
+      // _wake_pg_slot
+      if (!slot->to_process.front().can_batch()) {
+	break;
+      }
+      batch->push_back(std::move(slot->to_process.front()));
+      slot->to_process.pop_front();
+      continue;
+    }
+    if (sdata->scheduler->empty()) {
+      break;
+    }
+    WorkItem work_item = sdata->scheduler->dequeue();
+    auto next = std::get_if<OpSchedulerItem>(&work_item);
+    if (!next) {
+      // only due in the future
+      break;
+    }
+    if (next->get_ordering_token() != token || !next->can_batch()) {
+      // still the next item up, just not one of ours
+      sdata->scheduler->enqueue_front(std::move(*next));
+      break;
+    }
+    batch->push_back(std::move(*next));
+  }
+}
+
 void OSD::ShardedOpWQ::_enqueue(OpSchedulerItem&& item) {
   uint32_t shard_index =
     item.get_ordering_token().hash_to_shard(osd->shards.size());
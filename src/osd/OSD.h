@@ -78,6 +78,7 @@ class KeyStore;
 
 class Watch;
 class PrimaryLogPG;
+class ECStripeCache;
 
 class TestOpsSocketHook;
 struct C_FinishSplits;
@@ -116,6 +117,9 @@ public:
   md_config_cacher_t<Option::size_t> osd_max_object_size;
   md_config_cacher_t<bool> osd_skip_data_digest;
 
+  /// decoded EC stripes shared by all EC PGs, null unless enabled
+  std::shared_ptr<ECStripeCache> ec_stripe_cache;
+
   void enqueue_back(OpSchedulerItem&& qi);
   void enqueue_front(OpSchedulerItem&& qi);
 
@@ -1620,6 +1624,13 @@ protected:
       OSDShardPGSlot *slot,
       OpSchedulerItem&& qi);
 
+    /// pull further ops for the same (locked) pg to run under one lock
+    void _take_op_batch(
+      OSDShard *sdata,
+      const spg_t& token,
+      OSDShardPGSlot *slot,
+      std::vector<OpSchedulerItem> *batch);
+
     /// try to do some work
     void _process(uint32_t thread_index, ceph::heartbeat_handle_d *hb) override;
 
@@ -1398,17 +1398,18 @@ void OSDMap::get_blocklist(std::set<entity_addr_t> *bl) const
 void OSDMap::set_max_osd(int m)
 {
   max_osd = m;
-  osd_state.resize(max_osd, 0);
-  osd_weight.resize(max_osd, CEPH_OSD_OUT);
-  osd_info.resize(max_osd);
-  osd_xinfo.resize(max_osd);
-  osd_addrs->client_addrs.resize(max_osd);
-  osd_addrs->cluster_addrs.resize(max_osd);
-  osd_addrs->hb_back_addrs.resize(max_osd);
-  osd_addrs->hb_front_addrs.resize(max_osd);
-  osd_uuid->resize(max_osd);
+  _mut(osd_state).resize(max_osd, 0);
+  _mut(osd_weight).resize(max_osd, CEPH_OSD_OUT);
+  _mut(osd_info).resize(max_osd);
+  _mut(osd_xinfo).resize(max_osd);
+  auto& addrs = _mut(osd_addrs);
+  addrs.client_addrs.resize(max_osd);
+  addrs.cluster_addrs.resize(max_osd);
+  addrs.hb_back_addrs.resize(max_osd);
+  addrs.hb_front_addrs.resize(max_osd);
+  _mut(osd_uuid).resize(max_osd);
   if (osd_primary_affinity)
-    osd_primary_affinity->resize(max_osd, CEPH_OSD_DEFAULT_PRIMARY_AFFINITY);
+    _mut(osd_primary_affinity).resize(max_osd, CEPH_OSD_DEFAULT_PRIMARY_AFFINITY);
 
   calc_num_osds();
 }
@@ -1419,9 +1420,9 @@ int OSDMap::calc_num_osds()
   num_up_osd = 0;
   num_in_osd = 0;
   for (int i=0; i<max_osd; i++) {
-    if (osd_state[i] & CEPH_OSD_EXISTS) {
+    if ((*osd_state)[i] & CEPH_OSD_EXISTS) {
       ++num_osd;
-      if (osd_state[i] & CEPH_OSD_UP) {
+      if ((*osd_state)[i] & CEPH_OSD_UP) {
 	++num_up_osd;
       }
       if (get_weight(i) != CEPH_OSD_OUT) {
@@ -1449,11 +1450,11 @@ void OSDMap::get_full_pools(CephContext *cct,
   vector<int> nearfull_osds;
   for (int i = 0; i < max_osd; ++i) {
     if (exists(i) && is_up(i) && is_in(i)) {
-      if (osd_state[i] & CEPH_OSD_FULL)
+      if ((*osd_state)[i] & CEPH_OSD_FULL)
         full_osds.push_back(i);
-      else if (osd_state[i] & CEPH_OSD_BACKFILLFULL)
+      else if ((*osd_state)[i] & CEPH_OSD_BACKFILLFULL)
 	backfillfull_osds.push_back(i);
-      else if (osd_state[i] & CEPH_OSD_NEARFULL)
+      else if ((*osd_state)[i] & CEPH_OSD_NEARFULL)
 	nearfull_osds.push_back(i);
     }
   }
@@ -1477,11 +1478,11 @@ void OSDMap::get_full_osd_counts(set<int> *full, set<int> *backfill,
   nearfull->clear();
   for (int i = 0; i < max_osd; ++i) {
     if (exists(i) && is_up(i) && is_in(i)) {
-      if (osd_state[i] & CEPH_OSD_FULL)
+      if ((*osd_state)[i] & CEPH_OSD_FULL)
 	full->emplace(i);
-      else if (osd_state[i] & CEPH_OSD_BACKFILLFULL)
+      else if ((*osd_state)[i] & CEPH_OSD_BACKFILLFULL)
 	backfill->emplace(i);
-      else if (osd_state[i] & CEPH_OSD_NEARFULL)
+      else if ((*osd_state)[i] & CEPH_OSD_NEARFULL)
 	nearfull->emplace(i);
     }
   }
@@ -1601,7 +1602,7 @@ uint64_t OSDMap::get_features(int entity_type, uint64_t *pmask) const
   }
   mask |= CEPH_FEATURES_CRUSH;
 
-  if (!pg_upmap.empty() || !pg_upmap_items.empty())
+  if (!pg_upmap->empty() || !pg_upmap_items->empty())
     features |= CEPH_FEATUREMASK_OSDMAP_PG_UPMAP;
   mask |= CEPH_FEATUREMASK_OSDMAP_PG_UPMAP;
 
@@ -1740,57 +1741,61 @@ void OSDMap::dedup(const OSDMap *o, OSDMap *n)
   int diff = 0;
 
   // do addrs match?
-  if (o->max_osd != n->max_osd)
-    diff++;
-  for (int i = 0; i < o->max_osd && i < n->max_osd; i++) {
-    if ( n->osd_addrs->client_addrs[i] &&  o->osd_addrs->client_addrs[i] &&
-	*n->osd_addrs->client_addrs[i] == *o->osd_addrs->client_addrs[i])
-      n->osd_addrs->client_addrs[i] = o->osd_addrs->client_addrs[i];
-    else
-      diff++;
-    if ( n->osd_addrs->cluster_addrs[i] &&  o->osd_addrs->cluster_addrs[i] &&
-	*n->osd_addrs->cluster_addrs[i] == *o->osd_addrs->cluster_addrs[i])
-      n->osd_addrs->cluster_addrs[i] = o->osd_addrs->cluster_addrs[i];
-    else
-      diff++;
-    if ( n->osd_addrs->hb_back_addrs[i] &&  o->osd_addrs->hb_back_addrs[i] &&
-	*n->osd_addrs->hb_back_addrs[i] == *o->osd_addrs->hb_back_addrs[i])
-      n->osd_addrs->hb_back_addrs[i] = o->osd_addrs->hb_back_addrs[i];
-    else
+  if (o->osd_addrs != n->osd_addrs) {
+    if (o->max_osd != n->max_osd)
       diff++;
-    if ( n->osd_addrs->hb_front_addrs[i] &&  o->osd_addrs->hb_front_addrs[i] &&
-	*n->osd_addrs->hb_front_addrs[i] == *o->osd_addrs->hb_front_addrs[i])
-      n->osd_addrs->hb_front_addrs[i] = o->osd_addrs->hb_front_addrs[i];
-    else
-      diff++;
-  }
-  if (diff == 0) {
-    // zoinks, no differences at all!
-    n->osd_addrs = o->osd_addrs;
+    auto& addrs = _mut(n->osd_addrs);
+    for (int i = 0; i < o->max_osd && i < n->max_osd; i++) {
+      if ( addrs.client_addrs[i] &&  o->osd_addrs->client_addrs[i] &&
+	  *addrs.client_addrs[i] == *o->osd_addrs->client_addrs[i])
+	addrs.client_addrs[i] = o->osd_addrs->client_addrs[i];
+      else
+	diff++;
+      if ( addrs.cluster_addrs[i] &&  o->osd_addrs->cluster_addrs[i] &&
+	  *addrs.cluster_addrs[i] == *o->osd_addrs->cluster_addrs[i])
+	addrs.cluster_addrs[i] = o->osd_addrs->cluster_addrs[i];
+      else
+	diff++;
+      if ( addrs.hb_back_addrs[i] &&  o->osd_addrs->hb_back_addrs[i] &&
+	  *addrs.hb_back_addrs[i] == *o->osd_addrs->hb_back_addrs[i])
+	addrs.hb_back_addrs[i] = o->osd_addrs->hb_back_addrs[i];
+      else
+	diff++;
+      if ( addrs.hb_front_addrs[i] &&  o->osd_addrs->hb_front_addrs[i] &&
+	  *addrs.hb_front_addrs[i] == *o->osd_addrs->hb_front_addrs[i])
+	addrs.hb_front_addrs[i] = o->osd_addrs->hb_front_addrs[i];
+      else
+	diff++;
+    }
+    if (diff == 0) {
+      // zoinks, no differences at all!
+      n->osd_addrs = o->osd_addrs;
+    }
   }
 
   // does crush match?
-  ceph::buffer::list oc, nc;
-  encode(*o->crush, oc, CEPH_FEATURES_SUPPORTED_DEFAULT);
-  encode(*n->crush, nc, CEPH_FEATURES_SUPPORTED_DEFAULT);
-  if (oc.contents_equal(nc)) {
-    n->crush = o->crush;
-  }
-
-  // does pg_temp match?
-  if (*o->pg_temp == *n->pg_temp)
-    n->pg_temp = o->pg_temp;
-
-  // does primary_temp match?
-  if (o->primary_temp->size() == n->primary_temp->size()) {
-    if (*o->primary_temp == *n->primary_temp)
-      n->primary_temp = o->primary_temp;
-  }
-
-  // do uuids match?
-  if (o->osd_uuid->size() == n->osd_uuid->size() &&
-      *o->osd_uuid == *n->osd_uuid)
-    n->osd_uuid = o->osd_uuid;
+  if (o->crush != n->crush) {
+    ceph::buffer::list oc, nc;
+    encode(*o->crush, oc, CEPH_FEATURES_SUPPORTED_DEFAULT);
+    encode(*n->crush, nc, CEPH_FEATURES_SUPPORTED_DEFAULT);
+    if (oc.contents_equal(nc)) {
+      n->crush = o->crush;
+    }
+  }
+
+  // the rest is either shared already (n was copied from o, or from a
+  // map sharing with o) or shared if equal
+  _dedup_member(o->pg_temp, n->pg_temp);
+  _dedup_member(o->primary_temp, n->primary_temp);
+  _dedup_member(o->osd_uuid, n->osd_uuid);
+  _dedup_member(o->osd_state, n->osd_state);
+  _dedup_member(o->osd_weight, n->osd_weight);
+  _dedup_member(o->osd_info, n->osd_info);
+  _dedup_member(o->osd_xinfo, n->osd_xinfo);
+  _dedup_member(o->pg_upmap, n->pg_upmap);
+  _dedup_member(o->pg_upmap_items, n->pg_upmap_items);
+  if (o->osd_primary_affinity && n->osd_primary_affinity)
+    _dedup_member(o->osd_primary_affinity, n->osd_primary_affinity);
 }
 
 void OSDMap::clean_temps(CephContext *cct,
@@ -1876,10 +1881,10 @@ void OSDMap::clean_temps(CephContext *cct,
 
 void OSDMap::get_upmap_pgs(vector<pg_t> *upmap_pgs) const
 {
-  upmap_pgs->reserve(pg_upmap.size() + pg_upmap_items.size());
-  for (auto& p : pg_upmap)
+  upmap_pgs->reserve(pg_upmap->size() + pg_upmap_items->size());
+  for (auto& p : *pg_upmap)
     upmap_pgs->push_back(p.first);
-  for (auto& p : pg_upmap_items)
+  for (auto& p : *pg_upmap_items)
     upmap_pgs->push_back(p.first);
 }
 
@@ -1959,16 +1964,16 @@ bool OSDMap::check_pg_upmaps(
       continue;
     // okay, upmap is valid
     // continue to check if it is still necessary
-    auto i = pg_upmap.find(pg);
-    if (i != pg_upmap.end() && raw == i->second) {
+    auto i = pg_upmap->find(pg);
+    if (i != pg_upmap->end() && raw == i->second) {
       ldout(cct, 10) << " removing redundant pg_upmap "
                      << i->first << " " << i->second
                      << dendl;
       to_cancel->push_back(pg);
       continue;
     }
-    auto j = pg_upmap_items.find(pg);
-    if (j != pg_upmap_items.end()) {
+    auto j = pg_upmap_items->find(pg);
+    if (j != pg_upmap_items->end()) {
       mempool::osdmap::vector<pair<int,int>> newmap;
       for (auto& p : j->second) {
         if (std::find(raw.begin(), raw.end(), p.first) == raw.end()) {
@@ -1976,7 +1981,7 @@ bool OSDMap::check_pg_upmaps(
           continue;
         }
         if (p.second != CRUSH_ITEM_NONE && p.second < max_osd &&
-            p.second >= 0 && osd_weight[p.second] == 0) {
+            p.second >= 0 && (*osd_weight)[p.second] == 0) {
           // cancel mapping if target osd is out
           continue;
         }
@@ -2016,8 +2021,8 @@ void OSDMap::clean_pg_upmaps(
                      << dendl;
       pending_inc->new_pg_upmap.erase(i);
     }
-    auto j = pg_upmap.find(pg);
-    if (j != pg_upmap.end()) {
+    auto j = pg_upmap->find(pg);
+    if (j != pg_upmap->end()) {
       ldout(cct, 10) << __func__ << " cancel invalid pg_upmap entry "
                      << j->first << "->" << j->second
                      << dendl;
@@ -2031,8 +2036,8 @@ void OSDMap::clean_pg_upmaps(
                      << dendl;
       pending_inc->new_pg_upmap_items.erase(p);
     }
-    auto q = pg_upmap_items.find(pg);
-    if (q != pg_upmap_items.end()) {
+    auto q = pg_upmap_items->find(pg);
+    if (q != pg_upmap_items->end()) {
       ldout(cct, 10) << __func__ << " cancel invalid "
                      << "pg_upmap_items entry "
                      << q->first << "->" << q->second
@@ -2156,8 +2161,8 @@ int OSDMap::apply_incremental(const Incremental &inc)
     // if we are marking in, clear the AUTOOUT and NEW bits, and clear
     // xinfo old_weight.
     if (weight.second) {
-      osd_state[weight.first] &= ~(CEPH_OSD_AUTOOUT | CEPH_OSD_NEW);
-      osd_xinfo[weight.first].old_weight = 0;
+      _mut(osd_state)[weight.first] &= ~(CEPH_OSD_AUTOOUT | CEPH_OSD_NEW);
+      _mut(osd_xinfo)[weight.first].old_weight = 0;
     }
   }
 
@@ -2177,95 +2182,100 @@ int OSDMap::apply_incremental(const Incremental &inc)
   for (const auto &state : inc.new_state) {
     const auto osd = state.first;
     int s = state.second ? state.second : CEPH_OSD_UP;
-    if ((osd_state[osd] & CEPH_OSD_UP) &&
+    if (((*osd_state)[osd] & CEPH_OSD_UP) &&
 	(s & CEPH_OSD_UP)) {
-      osd_info[osd].down_at = epoch;
-      osd_xinfo[osd].down_stamp = modified;
+      _mut(osd_info)[osd].down_at = epoch;
+      _mut(osd_xinfo)[osd].down_stamp = modified;
     }
-    if ((osd_state[osd] & CEPH_OSD_EXISTS) &&
+    if (((*osd_state)[osd] & CEPH_OSD_EXISTS) &&
 	(s & CEPH_OSD_EXISTS)) {
       // osd is destroyed; clear out anything interesting.
-      (*osd_uuid)[osd] = uuid_d();
-      osd_info[osd] = osd_info_t();
-      osd_xinfo[osd] = osd_xinfo_t();
+      _mut(osd_uuid)[osd] = uuid_d();
+      _mut(osd_info)[osd] = osd_info_t();
+      _mut(osd_xinfo)[osd] = osd_xinfo_t();
       set_primary_affinity(osd, CEPH_OSD_DEFAULT_PRIMARY_AFFINITY);
-      osd_addrs->client_addrs[osd].reset(new entity_addrvec_t());
-      osd_addrs->cluster_addrs[osd].reset(new entity_addrvec_t());
-      osd_addrs->hb_front_addrs[osd].reset(new entity_addrvec_t());
-      osd_addrs->hb_back_addrs[osd].reset(new entity_addrvec_t());
-      osd_state[osd] = 0;
+      auto& addrs = _mut(osd_addrs);
+      addrs.client_addrs[osd].reset(new entity_addrvec_t());
+      addrs.cluster_addrs[osd].reset(new entity_addrvec_t());
+      addrs.hb_front_addrs[osd].reset(new entity_addrvec_t());
+      addrs.hb_back_addrs[osd].reset(new entity_addrvec_t());
+      _mut(osd_state)[osd] = 0;
     } else {
-      osd_state[osd] ^= s;
+      _mut(osd_state)[osd] ^= s;
     }
   }
 
   for (const auto &client : inc.new_up_client) {
-    osd_state[client.first] |= CEPH_OSD_EXISTS | CEPH_OSD_UP;
-    osd_state[client.first] &= ~CEPH_OSD_STOP; // if any
-    osd_addrs->client_addrs[client.first].reset(
+    auto& state = _mut(osd_state);
+    state[client.first] |= CEPH_OSD_EXISTS | CEPH_OSD_UP;
+    state[client.first] &= ~CEPH_OSD_STOP; // if any
+    auto& addrs = _mut(osd_addrs);
+    addrs.client_addrs[client.first].reset(
       new entity_addrvec_t(client.second));
-    osd_addrs->hb_back_addrs[client.first].reset(
+    addrs.hb_back_addrs[client.first].reset(
       new entity_addrvec_t(inc.new_hb_back_up.find(client.first)->second));
-    osd_addrs->hb_front_addrs[client.first].reset(
+    addrs.hb_front_addrs[client.first].reset(
       new entity_addrvec_t(inc.new_hb_front_up.find(client.first)->second));
 
-    osd_info[client.first].up_from = epoch;
+    _mut(osd_info)[client.first].up_from = epoch;
   }
 
   for (const auto &cluster : inc.new_up_cluster)
-    osd_addrs->cluster_addrs[cluster.first].reset(
+    _mut(osd_addrs).cluster_addrs[cluster.first].reset(
       new entity_addrvec_t(cluster.second));
 
   // info
   for (const auto &thru : inc.new_up_thru)
-    osd_info[thru.first].up_thru = thru.second;
+    _mut(osd_info)[thru.first].up_thru = thru.second;
   
   for (const auto &interval : inc.new_last_clean_interval) {
-    osd_info[interval.first].last_clean_begin = interval.second.first;
-    osd_info[interval.first].last_clean_end = interval.second.second;
+    auto& info = _mut(osd_info);
+    info[interval.first].last_clean_begin = interval.second.first;
+    info[interval.first].last_clean_end = interval.second.second;
   }
   
   for (const auto &lost : inc.new_lost)
-    osd_info[lost.first].lost_at = lost.second;
+    _mut(osd_info)[lost.first].lost_at = lost.second;
 
   // xinfo
   for (const auto &xinfo : inc.new_xinfo)
-    osd_xinfo[xinfo.first] = xinfo.second;
+    _mut(osd_xinfo)[xinfo.first] = xinfo.second;
 
   // uuid
   for (const auto &uuid : inc.new_uuid)
-    (*osd_uuid)[uuid.first] = uuid.second;
+    _mut(osd_uuid)[uuid.first] = uuid.second;
 
   // pg rebuild
-  for (const auto &pg : inc.new_pg_temp) {
-    if (pg.second.empty())
-      pg_temp->erase(pg.first);
-    else
-      pg_temp->set(pg.first, pg.second);
-  }
   if (!inc.new_pg_temp.empty()) {
+    auto& temp = _mut(pg_temp);
+    for (const auto &pg : inc.new_pg_temp) {
+      if (pg.second.empty())
+	temp.erase(pg.first);
+      else
+	temp.set(pg.first, pg.second);
+    }
     // make sure pg_temp is efficiently stored
-    pg_temp->rebuild();
+    temp.rebuild();
   }
 
   for (const auto &pg : inc.new_primary_temp) {
     if (pg.second == -1)
-      primary_temp->erase(pg.first);
+      _mut(primary_temp).erase(pg.first);
     else
-      (*primary_temp)[pg.first] = pg.second;
+      _mut(primary_temp)[pg.first] = pg.second;
   }
 
   for (auto& p : inc.new_pg_upmap) {
-    pg_upmap[p.first] = p.second;
+    _mut(pg_upmap)[p.first] = p.second;
   }
   for (auto& pg : inc.old_pg_upmap) {
-    pg_upmap.erase(pg);
+    _mut(pg_upmap).erase(pg);
   }
   for (auto& p : inc.new_pg_upmap_items) {
-    pg_upmap_items[p.first] = p.second;
+    _mut(pg_upmap_items)[p.first] = p.second;
   }
   for (auto& pg : inc.old_pg_upmap_items) {
-    pg_upmap_items.erase(pg);
+    _mut(pg_upmap_items).erase(pg);
   }
 
   // blocklist
@@ -2445,7 +2455,7 @@ void OSDMap::_pg_to_raw_osds(
   // what crush rule?
   int ruleno = crush->find_rule(pool.get_crush_rule(), pool.get_type(), size);
   if (ruleno >= 0)
-    crush->do_rule(ruleno, pps, *osds, size, osd_weight, pg.pool());
+    crush->do_rule(ruleno, pps, *osds, size, *osd_weight, pg.pool());
 
   _remove_nonexistent_osds(pool, *osds);
 
@@ -2466,12 +2476,12 @@ int OSDMap::_pick_primary(const vector<int>& osds) const
 void OSDMap::_apply_upmap(const pg_pool_t& pi, pg_t raw_pg, vector<int> *raw) const
 {
   pg_t pg = pi.raw_pg_to_pg(raw_pg);
-  auto p = pg_upmap.find(pg);
-  if (p != pg_upmap.end()) {
+  auto p = pg_upmap->find(pg);
+  if (p != pg_upmap->end()) {
     // make sure targets aren't marked out
     for (auto osd : p->second) {
       if (osd != CRUSH_ITEM_NONE && osd < max_osd && osd >= 0 &&
-          osd_weight[osd] == 0) {
+          (*osd_weight)[osd] == 0) {
 	// reject/ignore the explicit mapping
 	return;
       }
@@ -2480,8 +2490,8 @@ void OSDMap::_apply_upmap(const pg_pool_t& pi, pg_t raw_pg, vector<int> *raw) co
     // continue to check and apply pg_upmap_items if any
   }
 
-  auto q = pg_upmap_items.find(pg);
-  if (q != pg_upmap_items.end()) {
+  auto q = pg_upmap_items->find(pg);
+  if (q != pg_upmap_items->end()) {
     // NOTE: this approach does not allow a bidirectional swap,
     // e.g., [[1,2],[2,1]] applied to [0,1,2] -> [0,2,1].
     for (auto& r : q->second) {
@@ -2498,7 +2508,7 @@ void OSDMap::_apply_upmap(const pg_pool_t& pi, pg_t raw_pg, vector<int> *raw) co
 	if (osd == r.first &&
 	    pos < 0 &&
 	    !(r.second != CRUSH_ITEM_NONE && r.second < max_osd &&
-	      r.second >= 0 && osd_weight[r.second] == 0)) {
+	      r.second >= 0 && (*osd_weight)[r.second] == 0)) {
 	  pos = i;
 	}
       }
@@ -2715,6 +2725,50 @@ void OSDMap::_pg_to_up_acting_osds(
     *acting_primary = _acting_primary;
 }
 
+void OSDMap::pg_range_to_up_acting_osds(
+  int64_t poolid, unsigned ps_begin, unsigned ps_end,
+  vector<vector<int>> *up, vector<int> *up_primary,
+  vector<vector<int>> *acting, vector<int> *acting_primary) const
+{
+  const pg_pool_t *pool = get_pg_pool(poolid);
+  ceph_assert(pool);
+  ceph_assert(ps_begin <= ps_end);
+  unsigned n = ps_end - ps_begin;
+  vector<int> pps(n);
+  for (unsigned i = 0; i < n; ++i) {
+    pps[i] = pool->raw_pg_to_pps(pg_t(ps_begin + i, poolid));
+  }
+  vector<vector<int>> raw;
+  unsigned size = pool->get_size();
+  int ruleno = crush->find_rule(pool->get_crush_rule(), pool->get_type(), size);
+  if (ruleno >= 0) {
+    crush->do_rule_batch(ruleno, pps, &raw, size, *osd_weight, poolid);
+  } else {
+    raw.resize(n);
+  }
+
+  up->resize(n);
+  up_primary->resize(n);
+  acting->resize(n);
+  acting_primary->resize(n);
+  for (unsigned i = 0; i < n; ++i) {
+    // same as _pg_to_up_acting_osds()
+    pg_t pg(ps_begin + i, poolid);
+    _remove_nonexistent_osds(*pool, raw[i]);
+    _get_temp_osds(*pool, pg, &(*acting)[i], &(*acting_primary)[i]);
+    _apply_upmap(*pool, pg, &raw[i]);
+    _raw_to_up_osds(*pool, raw[i], &(*up)[i]);
+    (*up_primary)[i] = _pick_primary((*up)[i]);
+    _apply_primary_affinity(pps[i], *pool, &(*up)[i], &(*up_primary)[i]);
+    if ((*acting)[i].empty()) {
+      (*acting)[i] = (*up)[i];
+      if ((*acting_primary)[i] == -1) {
+	(*acting_primary)[i] = (*up_primary)[i];
+      }
+    }
+  }
+}
+
 int OSDMap::calc_pg_role_broken(int osd, const vector<int>& acting, int nrep)
 {
   // This implementation is broken for EC PGs since the osd may appear
@@ -2829,13 +2883,13 @@ void OSDMap::encode_client_old(ceph::buffer::list& bl) const
 
   encode(max_osd, bl);
   {
-    uint32_t n = osd_state.size();
+    uint32_t n = osd_state->size();
     encode(n, bl);
-    for (auto s : osd_state) {
+    for (auto s : *osd_state) {
       encode((uint8_t)s, bl);
     }
   }
-  encode(osd_weight, bl);
+  encode(*osd_weight, bl);
   encode(osd_addrs->client_addrs, bl, 0);
 
   // for encode(pg_temp, bl);
@@ -2878,13 +2932,13 @@ void OSDMap::encode_classic(ceph::buffer::list& bl, uint64_t features) const
 
   encode(max_osd, bl);
   {
-    uint32_t n = osd_state.size();
+    uint32_t n = osd_state->size();
     encode(n, bl);
-    for (auto s : osd_state) {
+    for (auto s : *osd_state) {
       encode((uint8_t)s, bl);
     }
   }
-  encode(osd_weight, bl);
+  encode(*osd_weight, bl);
   encode(osd_addrs->client_addrs, bl, features);
 
   encode(*pg_temp, bl);
@@ -2898,13 +2952,13 @@ void OSDMap::encode_classic(ceph::buffer::list& bl, uint64_t features) const
   __u16 ev = 10;
   encode(ev, bl);
   encode(osd_addrs->hb_back_addrs, bl, features);
-  encode(osd_info, bl);
+  encode(*osd_info, bl);
   encode(blocklist, bl, features);
   encode(osd_addrs->cluster_addrs, bl, features);
   encode(cluster_snapshot_epoch, bl);
   encode(cluster_snapshot, bl);
   encode(*osd_uuid, bl);
-  encode(osd_xinfo, bl, features);
+  encode(*osd_xinfo, bl, features);
   encode(osd_addrs->hb_front_addrs, bl, features);
 }
 
@@ -2972,15 +3026,15 @@ void OSDMap::encode(ceph::buffer::list& bl, uint64_t features) const
 
     encode(max_osd, bl);
     if (v >= 5) {
-      encode(osd_state, bl);
+      encode(*osd_state, bl);
     } else {
-      uint32_t n = osd_state.size();
+      uint32_t n = osd_state->size();
       encode(n, bl);
-      for (auto s : osd_state) {
+      for (auto s : *osd_state) {
 	encode((uint8_t)s, bl);
       }
     }
-    encode(osd_weight, bl);
+    encode(*osd_weight, bl);
     if (v >= 8) {
       encode(osd_addrs->client_addrs, bl, features);
     } else {
@@ -3003,11 +3057,11 @@ void OSDMap::encode(ceph::buffer::list& bl, uint64_t features) const
     encode(erasure_code_profiles, bl);
 
     if (v >= 4) {
-      encode(pg_upmap, bl);
-      encode(pg_upmap_items, bl);
+      encode(*pg_upmap, bl);
+      encode(*pg_upmap_items, bl);
     } else {
-      ceph_assert(pg_upmap.empty());
-      ceph_assert(pg_upmap_items.empty());
+      ceph_assert(pg_upmap->empty());
+      ceph_assert(pg_upmap_items->empty());
     }
     if (v >= 6) {
       encode(crush_version, bl);
@@ -3046,7 +3100,7 @@ void OSDMap::encode(ceph::buffer::list& bl, uint64_t features) const
     } else {
       encode(osd_addrs->hb_back_addrs, bl, features);
     }
-    encode(osd_info, bl);
+    encode(*osd_info, bl);
     {
       // put this in a sorted, ordered map<> so that we encode in a
       // deterministic order.
@@ -3063,7 +3117,7 @@ void OSDMap::encode(ceph::buffer::list& bl, uint64_t features) const
     encode(cluster_snapshot_epoch, bl);
     encode(cluster_snapshot, bl);
     encode(*osd_uuid, bl);
-    encode(osd_xinfo, bl, features);
+    encode(*osd_xinfo, bl, features);
     if (target_v < 7) {
       encode_addrvec_pvec_as_addr(osd_addrs->hb_front_addrs, bl, features);
     } else {
@@ -3129,8 +3183,25 @@ void OSDMap::decode(ceph::buffer::list& bl)
   decode(p);
 }
 
+void OSDMap::_unshare()
+{
+  // decoding overwrites these in place; make sure we don't do that to
+  // copies we share with other maps
+  _reset_shared(osd_state);
+  _reset_shared(osd_addrs);
+  _reset_shared(osd_weight);
+  _reset_shared(osd_info);
+  _reset_shared(pg_temp);
+  _reset_shared(primary_temp);
+  _reset_shared(pg_upmap);
+  _reset_shared(pg_upmap_items);
+  _reset_shared(osd_uuid);
+  _reset_shared(osd_xinfo);
+}
+
 void OSDMap::decode_classic(ceph::buffer::list::const_iterator& p)
 {
+  _unshare();
   using ceph::decode;
   __u32 n, t;
   __u16 v;
@@ -3183,12 +3254,12 @@ void OSDMap::decode_classic(ceph::buffer::list::const_iterator& p)
   {
     vector<uint8_t> os;
     decode(os, p);
-    osd_state.resize(os.size());
+    osd_state->resize(os.size());
     for (unsigned i = 0; i < os.size(); ++i) {
-      osd_state[i] = os[i];
+      (*osd_state)[i] = os[i];
     }
   }
-  decode(osd_weight, p);
+  decode(*osd_weight, p);
   decode(osd_addrs->client_addrs, p);
   if (v <= 5) {
     pg_temp->clear();
@@ -3215,7 +3286,7 @@ void OSDMap::decode_classic(ceph::buffer::list::const_iterator& p)
   if (v >= 5)
     decode(ev, p);
   decode(osd_addrs->hb_back_addrs, p);
-  decode(osd_info, p);
+  decode(*osd_info, p);
   if (v < 5)
     decode(pool_name, p);
 
@@ -3236,9 +3307,9 @@ void OSDMap::decode_classic(ceph::buffer::list::const_iterator& p)
     osd_uuid->resize(max_osd);
   }
   if (ev >= 9)
-    decode(osd_xinfo, p);
+    decode(*osd_xinfo, p);
   else
-    osd_xinfo.resize(max_osd);
+    osd_xinfo->resize(max_osd);
 
   if (ev >= 10)
     decode(osd_addrs->hb_front_addrs, p);
@@ -3270,6 +3341,7 @@ void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
     decode_classic(bl);
     return;
   }
+  _unshare();
   /**
    * Since we made it past that hurdle, we can use our normal paths.
    */
@@ -3289,16 +3361,16 @@ void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
 
     decode(max_osd, bl);
     if (struct_v >= 5) {
-      decode(osd_state, bl);
+      decode(*osd_state, bl);
     } else {
       vector<uint8_t> os;
       decode(os, bl);
-      osd_state.resize(os.size());
+      osd_state->resize(os.size());
       for (unsigned i = 0; i < os.size(); ++i) {
-	osd_state[i] = os[i];
+	(*osd_state)[i] = os[i];
       }
     }
-    decode(osd_weight, bl);
+    decode(*osd_weight, bl);
     decode(osd_addrs->client_addrs, bl);
 
     decode(*pg_temp, bl);
@@ -3306,7 +3378,7 @@ void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
     // dates back to firefly. version increased from 2 to 3 still in firefly.
     // do we really still need to keep this around? even for old clients?
     if (struct_v >= 2) {
-      osd_primary_affinity.reset(new mempool::osdmap::vector<__u32>);
+      osd_primary_affinity = _make_shared<mempool::osdmap::vector<__u32>>();
       decode(*osd_primary_affinity, bl);
       if (osd_primary_affinity->empty())
 	osd_primary_affinity.reset();
@@ -3330,11 +3402,11 @@ void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
     // version increased from 3 to 4 still in luminous, so same as above
     // applies.
     if (struct_v >= 4) {
-      decode(pg_upmap, bl);
-      decode(pg_upmap_items, bl);
+      decode(*pg_upmap, bl);
+      decode(*pg_upmap_items, bl);
     } else {
-      pg_upmap.clear();
-      pg_upmap_items.clear();
+      pg_upmap->clear();
+      pg_upmap_items->clear();
     }
     // again, version increased from 5 to 6 still in luminous, so above
     // applies.
@@ -3357,13 +3429,13 @@ void OSDMap::decode(ceph::buffer::list::const_iterator& bl)
   {
     DECODE_START(10, bl); // extended, osd-only data
     decode(osd_addrs->hb_back_addrs, bl);
-    decode(osd_info, bl);
+    decode(*osd_info, bl);
     decode(blocklist, bl);
     decode(osd_addrs->cluster_addrs, bl);
     decode(cluster_snapshot_epoch, bl);
     decode(cluster_snapshot, bl);
     decode(*osd_uuid, bl);
-    decode(osd_xinfo, bl);
+    decode(*osd_xinfo, bl);
     decode(osd_addrs->hb_front_addrs, bl);
     // 
     if (struct_v >= 2) {
@@ -3595,14 +3667,14 @@ void OSDMap::dump(Formatter *f) const
     if (exists(i)) {
       f->open_object_section("xinfo");
       f->dump_int("osd", i);
-      osd_xinfo[i].dump(f);
+      (*osd_xinfo)[i].dump(f);
       f->close_section();
     }
   }
   f->close_section();
 
   f->open_array_section("pg_upmap");
-  for (auto& p : pg_upmap) {
+  for (auto& p : *pg_upmap) {
     f->open_object_section("mapping");
     f->dump_stream("pgid") << p.first;
     f->open_array_section("osds");
@@ -3614,7 +3686,7 @@ void OSDMap::dump(Formatter *f) const
   }
   f->close_section();
   f->open_array_section("pg_upmap_items");
-  for (auto& p : pg_upmap_items) {
+  for (auto& p : *pg_upmap_items) {
     f->open_object_section("mapping");
     f->dump_stream("pgid") << p.first;
     f->open_array_section("mappings");
@@ -3895,10 +3967,10 @@ void OSDMap::print(ostream& out) const
   print_osds(out);
   out << std::endl;
 
-  for (auto& p : pg_upmap) {
+  for (auto& p : *pg_upmap) {
     out << "pg_upmap " << p.first << " " << p.second << "\n";
   }
-  for (auto& p : pg_upmap_items) {
+  for (auto& p : *pg_upmap_items) {
     out << "pg_upmap_items " << p.first << " " << p.second << "\n";
   }
 
@@ -4835,8 +4907,8 @@ int OSDMap::calc_pg_upmaps(
       }
       // look for remaps we can un-remap
       for (auto pg : pgs) {
-	auto p = tmp.pg_upmap_items.find(pg);
-        if (p == tmp.pg_upmap_items.end())
+	auto p = tmp.pg_upmap_items->find(pg);
+        if (p == tmp.pg_upmap_items->end())
           continue;
         mempool::osdmap::vector<pair<int32_t,int32_t>> new_upmap_items;
         for (auto q : p->second) {
@@ -4875,8 +4947,8 @@ int OSDMap::calc_pg_upmaps(
 
       // try upmap
       for (auto pg : pgs) {
-        auto temp_it = tmp.pg_upmap.find(pg);
-        if (temp_it != tmp.pg_upmap.end()) {
+        auto temp_it = tmp.pg_upmap->find(pg);
+        if (temp_it != tmp.pg_upmap->end()) {
           // leave pg_upmap alone
           // it must be specified by admin since balancer does not
           // support pg_upmap yet
@@ -4888,14 +4960,14 @@ int OSDMap::calc_pg_upmaps(
         auto pg_pool_size = tmp.get_pg_pool_size(pg);
         mempool::osdmap::vector<pair<int32_t,int32_t>> new_upmap_items;
         set<int> existing;
-        auto it = tmp.pg_upmap_items.find(pg);
-        if (it != tmp.pg_upmap_items.end() &&
+        auto it = tmp.pg_upmap_items->find(pg);
+        if (it != tmp.pg_upmap_items->end() &&
             it->second.size() >= (size_t)pg_pool_size) {
           ldout(cct, 10) << " " << pg << " already has full-size pg_upmap_items "
                          << it->second << ", skipping"
                          << dendl;
           continue;
-        } else if (it != tmp.pg_upmap_items.end()) {
+        } else if (it != tmp.pg_upmap_items->end()) {
           ldout(cct, 10) << " " << pg << " already has pg_upmap_items "
                          << it->second
                          << dendl;
@@ -4978,8 +5050,8 @@ int OSDMap::calc_pg_upmaps(
       // look for remaps we can un-remap
       vector<pair<pg_t,
         mempool::osdmap::vector<pair<int32_t,int32_t>>>> candidates;
-      candidates.reserve(tmp.pg_upmap_items.size());
-      for (auto& i : tmp.pg_upmap_items) {
+      candidates.reserve(tmp.pg_upmap_items->size());
+      for (auto& i : *tmp.pg_upmap_items) {
         if (to_skip.count(i.first))
           continue;
         if (!only_pools.empty() && !only_pools.count(i.first.pool()))
@@ -5111,8 +5183,8 @@ int OSDMap::calc_pg_upmaps(
     deviation_osd = temp_deviation_osd;
     for (auto& i : to_unmap) {
       ldout(cct, 10) << " unmap pg " << i << dendl;
-      ceph_assert(tmp.pg_upmap_items.count(i));
-      tmp.pg_upmap_items.erase(i);
+      ceph_assert(tmp.pg_upmap_items->count(i));
+      _mut(tmp.pg_upmap_items).erase(i);
       pending_inc->old_pg_upmap_items.insert(i);
       ++num_changed;
     }
@@ -5120,7 +5192,7 @@ int OSDMap::calc_pg_upmaps(
       ldout(cct, 10) << " upmap pg " << i.first
                      << " new pg_upmap_items " << i.second
                      << dendl;
-      tmp.pg_upmap_items[i.first] = i.second;
+      _mut(tmp.pg_upmap_items)[i.first] = i.second;
       pending_inc->new_pg_upmap_items[i.first] = i.second;
       ++num_changed;
     }
@@ -5909,10 +5981,10 @@ void OSDMap::check_health(CephContext *cct,
       CEPH_OSD_NODOWN |
       CEPH_OSD_NOOUT;
     for (int i = 0; i < max_osd; ++i) {
-      if (osd_state[i] & flags) {
+      if ((*osd_state)[i] & flags) {
 	ostringstream ss;
 	set<string> states;
-	OSDMap::calc_state_set(osd_state[i] & flags, states);
+	OSDMap::calc_state_set((*osd_state)[i] & flags, states);
 	ss << "osd." << i << " has flags " << states;
 	detail.push_back(ss.str());
       }
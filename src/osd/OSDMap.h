@@ -81,6 +81,14 @@ struct osd_info_t {
   void encode(ceph::buffer::list& bl) const;
   void decode(ceph::buffer::list::const_iterator& bl);
   static void generate_test_instances(std::list<osd_info_t*>& o);
+  friend bool operator==(const osd_info_t& l, const osd_info_t& r) {
+    return l.last_clean_begin == r.last_clean_begin &&
+      l.last_clean_end == r.last_clean_end &&
+      l.up_from == r.up_from &&
+      l.up_thru == r.up_thru &&
+      l.down_at == r.down_at &&
+      l.lost_at == r.lost_at;
+  }
 };
 WRITE_CLASS_ENCODER(osd_info_t)
 
@@ -102,6 +110,15 @@ struct osd_xinfo_t {
   void encode(ceph::buffer::list& bl, uint64_t features) const;
   void decode(ceph::buffer::list::const_iterator& bl);
   static void generate_test_instances(std::list<osd_xinfo_t*>& o);
+  friend bool operator==(const osd_xinfo_t& l, const osd_xinfo_t& r) {
+    return l.down_stamp == r.down_stamp &&
+      l.laggy_probability == r.laggy_probability &&
+      l.laggy_interval == r.laggy_interval &&
+      l.features == r.features &&
+      l.old_weight == r.old_weight &&
+      l.last_purged_snaps_scrub == r.last_purged_snaps_scrub &&
+      l.dead_epoch == r.dead_epoch;
+  }
 };
 WRITE_CLASS_ENCODER_FEATURES(osd_xinfo_t)
 
@@ -529,7 +546,7 @@ private:
   int num_in_osd;      // not saved; see calc_num_osds
 
   int32_t max_osd;
-  std::vector<uint32_t> osd_state;
+  std::shared_ptr< mempool::osdmap::vector<uint32_t> > osd_state;
 
   mempool::osdmap::map<int32_t,uint32_t> crush_node_flags; // crush node -> CEPH_OSD_* flags
   mempool::osdmap::map<int32_t,uint32_t> device_class_flags; // device class -> CEPH_OSD_* flags
@@ -564,15 +581,15 @@ private:
 
   entity_addrvec_t _blank_addrvec;
 
-  mempool::osdmap::vector<__u32>   osd_weight;   // 16.16 fixed point, 0x10000 = "in", 0 = "out"
-  mempool::osdmap::vector<osd_info_t> osd_info;
+  std::shared_ptr< mempool::osdmap::vector<__u32> > osd_weight;   // 16.16 fixed point, 0x10000 = "in", 0 = "out"
+  std::shared_ptr< mempool::osdmap::vector<osd_info_t> > osd_info;
   std::shared_ptr<PGTempMap> pg_temp;  // temp pg mapping (e.g. while we rebuild)
   std::shared_ptr< mempool::osdmap::map<pg_t,int32_t > > primary_temp;  // temp primary mapping (e.g. while we rebuild)
   std::shared_ptr< mempool::osdmap::vector<__u32> > osd_primary_affinity; ///< 16.16 fixed point, 0x10000 = baseline
 
   // remap (post-CRUSH, pre-up)
-  mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>> pg_upmap; ///< remap pg
-  mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>> pg_upmap_items; ///< remap osds in up set
+  std::shared_ptr< mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>> > pg_upmap; ///< remap pg
+  std::shared_ptr< mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>> > pg_upmap_items; ///< remap osds in up set
 
   mempool::osdmap::map<int64_t,pg_pool_t> pools;
   mempool::osdmap::map<int64_t,std::string> pool_name;
@@ -580,7 +597,7 @@ private:
   mempool::osdmap::map<std::string,int64_t, std::less<>> name_pool;
 
   std::shared_ptr< mempool::osdmap::vector<uuid_d> > osd_uuid;
-  mempool::osdmap::vector<osd_xinfo_t> osd_xinfo;
+  std::shared_ptr< mempool::osdmap::vector<osd_xinfo_t> > osd_xinfo;
 
   mempool::osdmap::unordered_map<entity_addr_t,utime_t> blocklist;
 
@@ -635,10 +652,16 @@ private:
 	     flags(0),
 	     num_osd(0), num_up_osd(0), num_in_osd(0),
 	     max_osd(0),
-	     osd_addrs(std::make_shared<addrs_s>()),
-	     pg_temp(std::make_shared<PGTempMap>()),
-	     primary_temp(std::make_shared<mempool::osdmap::map<pg_t,int32_t>>()),
-	     osd_uuid(std::make_shared<mempool::osdmap::vector<uuid_d>>()),
+	     osd_state(_make_shared<mempool::osdmap::vector<uint32_t>>()),
+	     osd_addrs(_make_shared<addrs_s>()),
+	     osd_weight(_make_shared<mempool::osdmap::vector<__u32>>()),
+	     osd_info(_make_shared<mempool::osdmap::vector<osd_info_t>>()),
+	     pg_temp(_make_shared<PGTempMap>()),
+	     primary_temp(_make_shared<mempool::osdmap::map<pg_t,int32_t>>()),
+	     pg_upmap(_make_shared<mempool::osdmap::map<pg_t,mempool::osdmap::vector<int32_t>>>()),
+	     pg_upmap_items(_make_shared<mempool::osdmap::map<pg_t,mempool::osdmap::vector<std::pair<int32_t,int32_t>>>>()),
+	     osd_uuid(_make_shared<mempool::osdmap::vector<uuid_d>>()),
+	     osd_xinfo(_make_shared<mempool::osdmap::vector<osd_xinfo_t>>()),
 	     cluster_snapshot_epoch(0),
 	     new_blocklist_entries(false),
 	     cached_up_osd_features(0),
@@ -651,6 +674,35 @@ private:
 private:
   OSDMap(const OSDMap& other) = default;
   OSDMap& operator=(const OSDMap& other) = default;
+
+  /// members shared between maps are accounted in the osdmap mempool
+  template <typename T, typename... Args>
+  static std::shared_ptr<T> _make_shared(Args&&... args) {
+    return std::allocate_shared<T>(mempool::osdmap::pool_allocator<T>(),
+				   std::forward<Args>(args)...);
+  }
+  /// our own copy of a member that other maps may share, to modify it
+  template <typename T>
+  static T& _mut(std::shared_ptr<T>& p) {
+    if (p.use_count() > 1) {
+      p = _make_shared<T>(*p);
+    }
+    return *p;
+  }
+  /// share o's copy of a member if n's has the same content
+  template <typename T>
+  static void _dedup_member(const std::shared_ptr<T>& o,
+			    std::shared_ptr<T>& n) {
+    if (o != n && *o == *n) {
+      n = o;
+    }
+  }
+  template <typename T>
+  static void _reset_shared(std::shared_ptr<T>& p) {
+    p = _make_shared<T>();
+  }
+  /// replace the shared members with empty ones of our own
+  void _unshare();
 public:
 
   /// return feature mask subset that is relevant to OSDMap encoding
@@ -660,17 +712,14 @@ public:
 
   uint64_t get_encoding_features() const;
 
+  /*
+   * The per-osd vectors, the pg_temp/upmap tables and the address and
+   * uuid tables are shared with o until either map modifies them, at
+   * which point it takes its own copy (see _mut()), so that a copy plus
+   * apply_incremental() only duplicates what the incremental touches.
+   */
   void deepish_copy_from(const OSDMap& o) {
     *this = o;
-    primary_temp.reset(new mempool::osdmap::map<pg_t,int32_t>(*o.primary_temp));
-    pg_temp.reset(new PGTempMap(*o.pg_temp));
-    osd_uuid.reset(new mempool::osdmap::vector<uuid_d>(*o.osd_uuid));
-
-    if (o.osd_primary_affinity)
-      osd_primary_affinity.reset(new mempool::osdmap::vector<__u32>(*o.osd_primary_affinity));
-
-    // NOTE: this still references shared entity_addrvec_t's.
-    osd_addrs.reset(new addrs_s(*o.osd_addrs));
 
     // NOTE: we do not copy crush.  note that apply_incremental will
     // allocate a new CrushWrapper, though.
@@ -756,27 +805,27 @@ public:
 
   int get_state(int o) const {
     ceph_assert(o < max_osd);
-    return osd_state[o];
+    return (*osd_state)[o];
   }
   int get_state(int o, std::set<std::string>& st) const {
     ceph_assert(o < max_osd);
-    unsigned t = osd_state[o];
+    unsigned t = (*osd_state)[o];
     calc_state_set(t, st);
-    return osd_state[o];
+    return (*osd_state)[o];
   }
   void set_state(int o, unsigned s) {
     ceph_assert(o < max_osd);
-    osd_state[o] = s;
+    _mut(osd_state)[o] = s;
   }
   void set_weight(int o, unsigned w) {
     ceph_assert(o < max_osd);
-    osd_weight[o] = w;
+    _mut(osd_weight)[o] = w;
     if (w)
-      osd_state[o] |= CEPH_OSD_EXISTS;
+      _mut(osd_state)[o] |= CEPH_OSD_EXISTS;
   }
   unsigned get_weight(int o) const {
     ceph_assert(o < max_osd);
-    return osd_weight[o];
+    return (*osd_weight)[o];
   }
   float get_weightf(int o) const {
     return (float)get_weight(o) / (float)CEPH_OSD_IN;
@@ -786,10 +835,9 @@ public:
   void set_primary_affinity(int o, int w) {
     ceph_assert(o < max_osd);
     if (!osd_primary_affinity)
-      osd_primary_affinity.reset(
-	new mempool::osdmap::vector<__u32>(
-	  max_osd, CEPH_OSD_DEFAULT_PRIMARY_AFFINITY));
-    (*osd_primary_affinity)[o] = w;
+      osd_primary_affinity = _make_shared<mempool::osdmap::vector<__u32>>(
+	max_osd, CEPH_OSD_DEFAULT_PRIMARY_AFFINITY);
+    _mut(osd_primary_affinity)[o] = w;
   }
   unsigned get_primary_affinity(int o) const {
     ceph_assert(o < max_osd);
@@ -827,15 +875,15 @@ public:
 
   bool exists(int osd) const {
     //assert(osd >= 0);
-    return osd >= 0 && osd < max_osd && (osd_state[osd] & CEPH_OSD_EXISTS);
+    return osd >= 0 && osd < max_osd && ((*osd_state)[osd] & CEPH_OSD_EXISTS);
   }
 
   bool is_destroyed(int osd) const {
-    return exists(osd) && (osd_state[osd] & CEPH_OSD_DESTROYED);
+    return exists(osd) && ((*osd_state)[osd] & CEPH_OSD_DESTROYED);
   }
 
   bool is_up(int osd) const {
-    return exists(osd) && (osd_state[osd] & CEPH_OSD_UP);
+    return exists(osd) && ((*osd_state)[osd] & CEPH_OSD_UP);
   }
 
   bool has_been_up_since(int osd, epoch_t epoch) const {
@@ -848,7 +896,7 @@ public:
 
   bool is_stop(int osd) const {
     return exists(osd) && is_down(osd) &&
-           (osd_state[osd] & CEPH_OSD_STOP);
+           ((*osd_state)[osd] & CEPH_OSD_STOP);
   }
 
   bool is_out(int osd) const {
@@ -871,19 +919,19 @@ public:
   unsigned get_device_class_flags(int id) const;
 
   bool is_noup_by_osd(int osd) const {
-    return exists(osd) && (osd_state[osd] & CEPH_OSD_NOUP);
+    return exists(osd) && ((*osd_state)[osd] & CEPH_OSD_NOUP);
   }
 
   bool is_nodown_by_osd(int osd) const {
-    return exists(osd) && (osd_state[osd] & CEPH_OSD_NODOWN);
+    return exists(osd) && ((*osd_state)[osd] & CEPH_OSD_NODOWN);
   }
 
   bool is_noin_by_osd(int osd) const {
-    return exists(osd) && (osd_state[osd] & CEPH_OSD_NOIN);
+    return exists(osd) && ((*osd_state)[osd] & CEPH_OSD_NOIN);
   }
 
   bool is_noout_by_osd(int osd) const {
-    return exists(osd) && (osd_state[osd] & CEPH_OSD_NOOUT);
+    return exists(osd) && ((*osd_state)[osd] & CEPH_OSD_NOOUT);
   }
 
   bool is_noup(int osd) const {
@@ -987,24 +1035,24 @@ public:
 
   const epoch_t& get_up_from(int osd) const {
     ceph_assert(exists(osd));
-    return osd_info[osd].up_from;
+    return (*osd_info)[osd].up_from;
   }
   const epoch_t& get_up_thru(int osd) const {
     ceph_assert(exists(osd));
-    return osd_info[osd].up_thru;
+    return (*osd_info)[osd].up_thru;
   }
   const epoch_t& get_down_at(int osd) const {
     ceph_assert(exists(osd));
-    return osd_info[osd].down_at;
+    return (*osd_info)[osd].down_at;
   }
   const osd_info_t& get_info(int osd) const {
     ceph_assert(osd < max_osd);
-    return osd_info[osd];
+    return (*osd_info)[osd];
   }
 
   const osd_xinfo_t& get_xinfo(int osd) const {
     ceph_assert(osd < max_osd);
-    return osd_xinfo[osd];
+    return (*osd_xinfo)[osd];
   }
   
   int get_next_up_osd_after(int n) const {
@@ -1245,6 +1293,16 @@ public:
     int up_primary, acting_primary;
     pg_to_up_acting_osds(pg, &up, &up_primary, &acting, &acting_primary);
   }
+  /**
+   * pg_to_up_acting_osds() for pgs [ps_begin, ps_end) of a pool, with
+   * the crush mapping done for the whole range in one batch.  The
+   * results for ps are at index ps - ps_begin.
+   */
+  void pg_range_to_up_acting_osds(
+    int64_t pool, unsigned ps_begin, unsigned ps_end,
+    std::vector<std::vector<int>> *up, std::vector<int> *up_primary,
+    std::vector<std::vector<int>> *acting,
+    std::vector<int> *acting_primary) const;
   bool pg_is_ec(pg_t pg) const {
     auto i = pools.find(pg.pool());
     ceph_assert(i != pools.end());
@@ -1436,8 +1494,8 @@ public:
   int get_osds_by_bucket_name(const std::string &name, std::set<int> *osds) const;
 
   bool have_pg_upmaps(pg_t pg) const {
-    return pg_upmap.count(pg) ||
-      pg_upmap_items.count(pg);
+    return pg_upmap->count(pg) ||
+      pg_upmap_items->count(pg);
   }
 
   bool check_full(const std::set<pg_shard_t> &missing_on) const {
@@ -1493,8 +1551,8 @@ public:
   int validate_crush_rules(CrushWrapper *crush, std::ostream *ss) const;
 
   void clear_temp() {
-    pg_temp->clear();
-    primary_temp->clear();
+    _mut(pg_temp).clear();
+    _mut(primary_temp).clear();
   }
 
 private:
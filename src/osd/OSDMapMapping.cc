@@ -114,14 +114,15 @@ void OSDMapMapping::_update_range(
   ceph_assert(i != pools.end());
   ceph_assert(pg_begin <= pg_end);
   ceph_assert(pg_end <= i->second.pg_num);
+  std::vector<std::vector<int>> up, acting;
+  std::vector<int> up_primary, acting_primary;
+  osdmap.pg_range_to_up_acting_osds(
+    pool, pg_begin, pg_end,
+    &up, &up_primary, &acting, &acting_primary);
   for (unsigned ps = pg_begin; ps < pg_end; ++ps) {
-    std::vector<int> up, acting;
-    int up_primary, acting_primary;
-    osdmap.pg_to_up_acting_osds(
-      pg_t(ps, pool),
-      &up, &up_primary, &acting, &acting_primary);
-    i->second.set(ps, std::move(up), up_primary,
-		  std::move(acting), acting_primary);
+    unsigned j = ps - pg_begin;
+    i->second.set(ps, std::move(up[j]), up_primary[j],
+		  std::move(acting[j]), acting_primary[j]);
   }
 }
 
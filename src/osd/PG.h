@@ -574,6 +574,9 @@ public:
     OpRequestRef& op,
     ThreadPool::TPHandle &handle
   ) = 0;
+  /// bracket ops run back to back under a single pg lock acquisition
+  virtual void start_op_batch() {}
+  virtual void finish_op_batch() {}
   virtual void clear_cache() = 0;
   virtual int get_cache_obj_count() = 0;
 
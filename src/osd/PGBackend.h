@@ -36,6 +36,7 @@ struct inconsistent_obj_wrapper;
 //forward declaration
 class OSDMap;
 class PGLog;
+class ECStripeCache;
 typedef std::shared_ptr<const OSDMap> OSDMapRef;
 
  /**
@@ -119,6 +120,16 @@ typedef std::shared_ptr<const OSDMap> OSDMapRef;
        const eversion_t &v
        ) = 0;
 
+     /**
+      * Called when a shard committed a write to soid at v but couldn't
+      * bring its copy up to date, leaving it to be repaired
+      */
+     virtual void on_failed_sub_write(
+       pg_shard_t from,
+       const hobject_t &soid,
+       const eversion_t &v
+       ) = 0;
+
      /**
       * Called when a pull on soid cannot be completed due to
       * down peers
@@ -289,6 +300,8 @@ typedef std::shared_ptr<const OSDMap> OSDMapRef;
      virtual entity_name_t get_cluster_msgr_name() = 0;
 
      virtual PerfCounters *get_logger() = 0;
+     /// the OSD's EC stripe cache, or nullptr if it is disabled
+     virtual ECStripeCache *get_ec_stripe_cache() { return nullptr; }
 
      virtual ceph_tid_t get_tid() = 0;
 
@@ -617,6 +617,17 @@ void PGLog::write_log_and_missing(
   const ghobject_t &log_oid,
   bool require_rollback)
 {
+  uint64_t chunk_entries =
+    cct ? cct->_conf.get_val<uint64_t>("osd_pg_log_chunk_entries") : 0;
+  if (chunk_entries != log_chunk_entries) {
+    // chunk boundaries depend on the chunk size, so a log is only ever
+    // stored with one layout; switching rewrites it as a whole
+    dout(10) << "write_log_and_missing switching log from "
+	     << log_chunk_entries << " to " << chunk_entries
+	     << " entries per key" << dendl;
+    mark_log_for_rewrite();
+    log_chunk_entries = chunk_entries;
+  }
   if (needs_write()) {
     dout(6) << "write_log_and_missing with: "
 	     << "dirty_to: " << dirty_to
@@ -641,7 +652,8 @@ void PGLog::write_log_and_missing(
       dirty_from_dups,
       write_from_dups,
       &may_include_deletes_in_missing_dirty,
-      (pg_log_debug ? &log_keys_debug : nullptr));
+      (pg_log_debug ? &log_keys_debug : nullptr),
+      log_chunk_entries);
     undirty();
   } else {
     dout(10) << "log is not dirty" << dendl;
@@ -825,63 +837,79 @@ void PGLog::_write_log_and_missing(
   eversion_t dirty_from_dups,
   eversion_t write_from_dups,
   bool *may_include_deletes_in_missing_dirty, // in/out param
-  set<string> *log_keys_debug
+  set<string> *log_keys_debug,
+  uint64_t log_chunk_entries
   ) {
   set<string> to_remove;
   to_remove.swap(trimmed_dups);
-  for (auto& t : trimmed) {
-    string key = t.get_key_name();
-    if (log_keys_debug) {
-      auto it = log_keys_debug->find(key);
-      ceph_assert(it != log_keys_debug->end());
-      log_keys_debug->erase(it);
-    }
-    to_remove.emplace(std::move(key));
-  }
-  trimmed.clear();
-
   if (touch_log)
     t.touch(coll, log_oid);
-  if (dirty_to != eversion_t()) {
-    t.omap_rmkeyrange(
-      coll, log_oid,
-      eversion_t().get_key_name(), dirty_to.get_key_name());
-    clear_up_to(log_keys_debug, dirty_to.get_key_name());
-  }
-  if (dirty_to != eversion_t::max() && dirty_from != eversion_t::max()) {
-    //   dout(10) << "write_log_and_missing, clearing from " << dirty_from << dendl;
-    t.omap_rmkeyrange(
-      coll, log_oid,
-      dirty_from.get_key_name(), eversion_t::max().get_key_name());
-    clear_after(log_keys_debug, dirty_from.get_key_name());
-  }
+  if (log_chunk_entries) {
+    _write_log_chunks(
+      t, km, log, coll, log_oid, log_chunk_entries,
+      dirty_to, dirty_from, writeout_from,
+      trimmed, &to_remove, log_keys_debug);
+    trimmed.clear();
+  } else {
+    for (auto& t : trimmed) {
+      string key = t.get_key_name();
+      if (log_keys_debug) {
+	auto it = log_keys_debug->find(key);
+	ceph_assert(it != log_keys_debug->end());
+	log_keys_debug->erase(it);
+      }
+      to_remove.emplace(std::move(key));
+    }
+    trimmed.clear();
+
+    if (dirty_to == eversion_t::max()) {
+      // drop a chunked layout left behind by an earlier configuration
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	get_log_chunk_key(0, 1), "chunk_~");
+      to_remove.insert("log_chunk_entries");
+    }
+    if (dirty_to != eversion_t()) {
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	eversion_t().get_key_name(), dirty_to.get_key_name());
+      clear_up_to(log_keys_debug, dirty_to.get_key_name());
+    }
+    if (dirty_to != eversion_t::max() && dirty_from != eversion_t::max()) {
+      //   dout(10) << "write_log_and_missing, clearing from " << dirty_from << dendl;
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	dirty_from.get_key_name(), eversion_t::max().get_key_name());
+      clear_after(log_keys_debug, dirty_from.get_key_name());
+    }
 
-  for (auto p = log.log.begin();
-       p != log.log.end() && p->version <= dirty_to;
-       ++p) {
-    bufferlist bl(sizeof(*p) * 2);
-    p->encode_with_checksum(bl);
-    (*km)[p->get_key_name()] = std::move(bl);
-  }
+    for (auto p = log.log.begin();
+	 p != log.log.end() && p->version <= dirty_to;
+	 ++p) {
+      bufferlist bl(sizeof(*p) * 2);
+      p->encode_with_checksum(bl);
+      (*km)[p->get_key_name()] = std::move(bl);
+    }
 
-  for (auto p = log.log.rbegin();
-       p != log.log.rend() &&
-	 (p->version >= dirty_from || p->version >= writeout_from) &&
-	 p->version >= dirty_to;
-       ++p) {
-    bufferlist bl(sizeof(*p) * 2);
-    p->encode_with_checksum(bl);
-    (*km)[p->get_key_name()] = std::move(bl);
-  }
+    for (auto p = log.log.rbegin();
+	 p != log.log.rend() &&
+	   (p->version >= dirty_from || p->version >= writeout_from) &&
+	   p->version >= dirty_to;
+	 ++p) {
+      bufferlist bl(sizeof(*p) * 2);
+      p->encode_with_checksum(bl);
+      (*km)[p->get_key_name()] = std::move(bl);
+    }
 
-  if (log_keys_debug) {
-    for (auto i = (*km).begin();
-	 i != (*km).end();
-	 ++i) {
-      if (i->first[0] == '_')
-	continue;
-      ceph_assert(!log_keys_debug->count(i->first));
-      log_keys_debug->insert(i->first);
+    if (log_keys_debug) {
+      for (auto i = (*km).begin();
+	   i != (*km).end();
+	   ++i) {
+	if (i->first[0] == '_')
+	  continue;
+	ceph_assert(!log_keys_debug->count(i->first));
+	log_keys_debug->insert(i->first);
+      }
     }
   }
 
@@ -955,6 +983,183 @@ void PGLog::_write_log_and_missing(
     t.omap_rmkeys(coll, log_oid, to_remove);
 }
 
+string PGLog::get_log_chunk_key(version_t v, uint64_t n)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "chunk_%020llu",
+	   (unsigned long long)(v - v % n));
+  return buf;
+}
+
+void PGLog::decode_log_chunk(
+  bufferlist::const_iterator &bp,
+  eversion_t tail,
+  std::list<pg_log_entry_t> *entries)
+{
+  DECODE_START(1, bp);
+  __u32 n;
+  decode(n, bp);
+  while (n--) {
+    pg_log_entry_t e;
+    e.decode_with_checksum(bp);
+    // a chunk outlives the trimming of its older entries
+    if (e.version > tail)
+      entries->push_back(std::move(e));
+  }
+  DECODE_FINISH(bp);
+}
+
+template <typename It>
+static void encode_log_chunk(It first, It last, bufferlist &bl)
+{
+  ENCODE_START(1, 1, bl);
+  encode((__u32)std::distance(first, last), bl);
+  for (; first != last; ++first)
+    first->encode_with_checksum(bl);
+  ENCODE_FINISH(bl);
+}
+
+// static
+void PGLog::_write_log_chunks(
+  ObjectStore::Transaction& t,
+  map<string,bufferlist>* km,
+  pg_log_t &log,
+  const coll_t& coll, const ghobject_t &log_oid,
+  uint64_t n,
+  eversion_t dirty_to,
+  eversion_t dirty_from,
+  eversion_t writeout_from,
+  const set<eversion_t> &trimmed,
+  set<string> *to_remove,
+  set<string> *log_keys_debug)
+{
+  // Entries are grouped into chunk keys covering n consecutive versions
+  // each.  The newest (open) chunk is not written as a chunk: its entries
+  // are appended under their own keys, and only once an entry of a later
+  // chunk shows up are they folded into a sealed chunk key, dropping the
+  // per-entry keys with a single range delete.  An append thus writes
+  // just the new entry, and trimming removes one key per n entries.  A
+  // sealed chunk is kept until none of its entries are left in the log;
+  // readers skip the ones at or before the tail.
+  constexpr uint64_t none = std::numeric_limits<uint64_t>::max();
+  auto chunk_of = [n](const pg_log_entry_t &e) {
+    return e.version.version / n;
+  };
+  uint64_t first_live_chunk = log.log.empty() ?
+    none : chunk_of(log.log.front());
+  uint64_t open_chunk = log.log.empty() ? none : chunk_of(log.log.back());
+  auto open_begin = log.log.end();
+  while (open_begin != log.log.begin() &&
+	 chunk_of(*std::prev(open_begin)) == open_chunk)
+    --open_begin;
+
+  // per-entry keys outside the open chunk are left to remove
+  bool fold = !trimmed.empty();
+  for (auto& v : trimmed) {
+    if (log_keys_debug) {
+      auto it = log_keys_debug->find(v.get_key_name());
+      ceph_assert(it != log_keys_debug->end());
+      log_keys_debug->erase(it);
+    }
+    if (v.version / n < first_live_chunk)
+      to_remove->insert(get_log_chunk_key(v.version, n));
+  }
+
+  // chunks [0, front_last] and [back_first, ..] are rewritten in full from
+  // memory; besides those only open chunk entries from `from` on are new
+  uint64_t front_last = none;
+  uint64_t back_first = none;
+  eversion_t from = std::min(dirty_from, writeout_from);
+  if (dirty_to == eversion_t::max()) {
+    // whole log rewrite, possibly from the per-entry layout
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      eversion_t().get_key_name(), eversion_t::max().get_key_name());
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      get_log_chunk_key(0, n), "chunk_~");
+    encode(n, (*km)["log_chunk_entries"]);
+    clear_up_to(log_keys_debug, dirty_to.get_key_name());
+    front_last = none - 1;
+    fold = false;
+  } else {
+    if (dirty_to != eversion_t()) {
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	get_log_chunk_key(0, n),
+	get_log_chunk_key(dirty_to.version + n, n));
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	eversion_t().get_key_name(), dirty_to.get_key_name());
+      clear_up_to(log_keys_debug, dirty_to.get_key_name());
+      front_last = dirty_to.version / n;
+      fold = true;
+    }
+    if (dirty_from != eversion_t::max()) {
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	get_log_chunk_key(dirty_from.version, n), "chunk_~");
+      t.omap_rmkeyrange(
+	coll, log_oid,
+	dirty_from.get_key_name(), eversion_t::max().get_key_name());
+      clear_after(log_keys_debug, dirty_from.get_key_name());
+      fold = true;
+    }
+    if (from != eversion_t::max()) {
+      // the newest entry that was already on disk decides whether its
+      // chunk, previously the open one, has to be sealed now
+      auto last_old = std::find_if(
+	log.log.rbegin(), log.log.rend(),
+	[&](const pg_log_entry_t &e) { return e.version < from; });
+      if (last_old == log.log.rend()) {
+	back_first = 0;
+      } else if (dirty_from != eversion_t::max() ||
+		 chunk_of(*last_old) != open_chunk) {
+	back_first = chunk_of(*last_old);
+	fold = true;
+      }
+    }
+  }
+  if (fold) {
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      eversion_t().get_key_name(),
+      open_begin == log.log.end() ?
+        eversion_t::max().get_key_name() : open_begin->get_key_name());
+  }
+
+  auto rewrite = [&](uint64_t c) {
+    return (front_last != none && c <= front_last) ||
+      (back_first != none && c >= back_first);
+  };
+  auto note_written = [&](const pg_log_entry_t &e) {
+    if (log_keys_debug && (e.version <= dirty_to || e.version >= from)) {
+      ceph_assert(!log_keys_debug->count(e.get_key_name()));
+      log_keys_debug->insert(e.get_key_name());
+    }
+  };
+  for (auto p = log.log.begin(); p != open_begin; ) {
+    auto q = p;
+    while (q != open_begin && chunk_of(*q) == chunk_of(*p))
+      ++q;
+    if (rewrite(chunk_of(*p))) {
+      std::for_each(p, q, note_written);
+      bufferlist bl(sizeof(*p) * 2 * std::distance(p, q));
+      encode_log_chunk(p, q, bl);
+      (*km)[get_log_chunk_key(p->version.version, n)] = std::move(bl);
+    }
+    p = q;
+  }
+  for (auto p = open_begin; p != log.log.end(); ++p) {
+    if (rewrite(open_chunk) || p->version >= from) {
+      note_written(*p);
+      bufferlist bl(sizeof(*p) * 2);
+      p->encode_with_checksum(bl);
+      (*km)[p->get_key_name()] = std::move(bl);
+    }
+  }
+}
+
 void PGLog::rebuild_missing_set_with_deletes(
   ObjectStore *store,
   ObjectStore::CollectionHandle& ch,
@@ -1030,10 +1235,25 @@ namespace {
     std::map<eversion_t, hobject_t> divergent_priors;
     bool must_rebuild = false;
     std::list<pg_log_entry_t> entries;
+    // entries under their own keys; newer than those in chunk keys
+    std::list<pg_log_entry_t> entries_by_key;
     std::list<pg_log_dup_t> dups;
+    uint64_t *log_chunk_entries = nullptr;
 
     std::optional<std::string> next;
 
+    void add_entry(std::list<pg_log_entry_t> &to, pg_log_entry_t &&e) {
+      ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
+      if (!to.empty()) {
+        pg_log_entry_t last_e(to.back());
+        ceph_assert(last_e.version.version < e.version.version);
+        ceph_assert(last_e.version.epoch <= e.version.epoch);
+      }
+      if (log_keys_debug)
+        log_keys_debug->insert(e.get_key_name());
+      to.push_back(std::move(e));
+    }
+
     void process_entry(crimson::os::FuturizedStore::OmapIteratorRef &p) {
       if (p->key()[0] == '_')
         return;
@@ -1067,18 +1287,21 @@ namespace {
           ceph_assert(dups.back().version < dup.version);
         }
         dups.push_back(dup);
+      } else if (p->key() == "log_chunk_entries") {
+        uint64_t n;
+        decode(n, bp);
+        if (log_chunk_entries)
+          *log_chunk_entries = n;
+      } else if (p->key().compare(0, 6, "chunk_") == 0) {
+        std::list<pg_log_entry_t> chunk;
+        PGLog::decode_log_chunk(bp, info.log_tail, &chunk);
+        for (auto& e : chunk) {
+          add_entry(entries, std::move(e));
+        }
       } else {
         pg_log_entry_t e;
         e.decode_with_checksum(bp);
-        ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
-        if (!entries.empty()) {
-          pg_log_entry_t last_e(entries.back());
-          ceph_assert(last_e.version.version < e.version.version);
-          ceph_assert(last_e.version.epoch <= e.version.epoch);
-        }
-        entries.push_back(e);
-        if (log_keys_debug)
-          log_keys_debug->insert(e.get_key_name());
+        add_entry(entries_by_key, std::move(e));
       }
     }
 
@@ -1087,6 +1310,8 @@ namespace {
       // will get overridden if recorded
       on_disk_can_rollback_to = info.last_update;
       missing.may_include_deletes = false;
+      if (log_chunk_entries)
+        *log_chunk_entries = 0;
 
       return store.get_omap_iterator(ch, pgmeta_oid).then([this](auto iter) {
         return seastar::do_until([iter] { return !iter->valid(); },
@@ -1095,6 +1320,11 @@ namespace {
           return iter->next();
         });
       }).then([this] {
+        if (!entries.empty() && !entries_by_key.empty()) {
+          ceph_assert(entries.back().version.version <
+                      entries_by_key.front().version.version);
+        }
+        entries.splice(entries.end(), entries_by_key);
         log = PGLog::IndexedLog(
              info.last_update,
              info.log_tail,
@@ -1115,7 +1345,8 @@ seastar::future<> PGLog::read_log_and_missing_crimson(
   std::set<std::string>* log_keys_debug,
   pg_missing_tracker_t &missing,
   ghobject_t pgmeta_oid,
-  const DoutPrefixProvider *dpp)
+  const DoutPrefixProvider *dpp,
+  uint64_t *log_chunk_entries)
 {
   ldpp_dout(dpp, 20) << "read_log_and_missing coll "
                      << ch->get_cid()
@@ -1123,7 +1354,8 @@ seastar::future<> PGLog::read_log_and_missing_crimson(
   return seastar::do_with(FuturizedStoreLogReader{
       store, info, log, log_keys_debug,
       missing, dpp},
-    [ch, pgmeta_oid](FuturizedStoreLogReader& reader) {
+    [ch, pgmeta_oid, log_chunk_entries](FuturizedStoreLogReader& reader) {
+    reader.log_chunk_entries = log_chunk_entries;
     return reader.read(ch, pgmeta_oid);
   });
 }
@@ -662,6 +662,8 @@ protected:
   bool dirty_log;
   bool clear_divergent_priors;
   bool may_include_deletes_in_missing_dirty = false;
+  /// entries per omap key of the log as it is on disk, 0 for a key per entry
+  uint64_t log_chunk_entries = 0;
 
   void mark_dirty_to(eversion_t to) {
     if (to > dirty_to)
@@ -1382,9 +1384,32 @@ public:
     eversion_t dirty_from_dups,
     eversion_t write_from_dups,
     bool *may_include_deletes_in_missing_dirty,
+    std::set<std::string> *log_keys_debug,
+    uint64_t log_chunk_entries = 0
+    );
+
+  static void _write_log_chunks(
+    ObjectStore::Transaction& t,
+    std::map<std::string,ceph::buffer::list>* km,
+    pg_log_t &log,
+    const coll_t& coll, const ghobject_t &log_oid,
+    uint64_t log_chunk_entries,
+    eversion_t dirty_to,
+    eversion_t dirty_from,
+    eversion_t writeout_from,
+    const std::set<eversion_t> &trimmed,
+    std::set<std::string> *to_remove,
     std::set<std::string> *log_keys_debug
     );
 
+  /// omap key of the log chunk holding version v with n entries per chunk
+  static std::string get_log_chunk_key(version_t v, uint64_t n);
+  /// decode the entries of a log chunk, skipping those at or before tail
+  static void decode_log_chunk(
+    ceph::buffer::list::const_iterator &bp,
+    eversion_t tail,
+    std::list<pg_log_entry_t> *entries);
+
   void read_log_and_missing(
     ObjectStore *store,
     ObjectStore::CollectionHandle& ch,
@@ -1401,7 +1426,8 @@ public:
       &clear_divergent_priors,
       this,
       (pg_log_debug ? &log_keys_debug : nullptr),
-      debug_verify_stored_missing);
+      debug_verify_stored_missing,
+      &log_chunk_entries);
   }
 
   template <typename missing_type>
@@ -1417,7 +1443,8 @@ public:
     bool *clear_divergent_priors = nullptr,
     const DoutPrefixProvider *dpp = nullptr,
     std::set<std::string> *log_keys_debug = nullptr,
-    bool debug_verify_stored_missing = false
+    bool debug_verify_stored_missing = false,
+    uint64_t *log_chunk_entries = nullptr
     ) {
     ldpp_dout(dpp, 20) << "read_log_and_missing coll " << ch->cid
 		       << " " << pgmeta_oid << dendl;
@@ -1438,6 +1465,22 @@ public:
     missing.may_include_deletes = false;
     std::list<pg_log_entry_t> entries;
     std::list<pg_log_dup_t> dups;
+    // entries under their own keys sort before the chunk keys but are
+    // the newest ones, so they are collected apart and appended last
+    std::list<pg_log_entry_t> entries_by_key;
+    auto add_entry = [&](std::list<pg_log_entry_t> &to, pg_log_entry_t &&e) {
+      ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
+      if (!to.empty()) {
+	pg_log_entry_t last_e(to.back());
+	ceph_assert(last_e.version.version < e.version.version);
+	ceph_assert(last_e.version.epoch <= e.version.epoch);
+      }
+      if (log_keys_debug)
+	log_keys_debug->insert(e.get_key_name());
+      to.push_back(std::move(e));
+    };
+    if (log_chunk_entries)
+      *log_chunk_entries = 0;
     if (p) {
       using ceph::decode;
       for (p->seek_to_first(); p->valid() ; p->next()) {
@@ -1475,21 +1518,31 @@ public:
 	    ceph_assert(dups.back().version < dup.version);
 	  }
 	  dups.push_back(dup);
+	} else if (p->key() == "log_chunk_entries") {
+	  uint64_t n;
+	  decode(n, bp);
+	  if (log_chunk_entries)
+	    *log_chunk_entries = n;
+	} else if (p->key().compare(0, 6, "chunk_") == 0) {
+	  std::list<pg_log_entry_t> chunk;
+	  decode_log_chunk(bp, info.log_tail, &chunk);
+	  for (auto& e : chunk) {
+	    add_entry(entries, std::move(e));
+	  }
 	} else {
 	  pg_log_entry_t e;
 	  e.decode_with_checksum(bp);
-	  ldpp_dout(dpp, 20) << "read_log_and_missing " << e << dendl;
-	  if (!entries.empty()) {
-	    pg_log_entry_t last_e(entries.back());
-	    ceph_assert(last_e.version.version < e.version.version);
-	    ceph_assert(last_e.version.epoch <= e.version.epoch);
-	  }
-	  entries.push_back(e);
-	  if (log_keys_debug)
-	    log_keys_debug->insert(e.get_key_name());
+	  add_entry(entries_by_key, std::move(e));
 	}
       }
     }
+    if (!entries.empty() && !entries_by_key.empty()) {
+      ceph_assert(entries.back().version.version <
+		  entries_by_key.front().version.version);
+      ceph_assert(entries.back().version.epoch <=
+		  entries_by_key.front().version.epoch);
+    }
+    entries.splice(entries.end(), entries_by_key);
     log = IndexedLog(
       info.last_update,
       info.log_tail,
@@ -1661,7 +1714,7 @@ public:
     return read_log_and_missing_crimson(
       store, ch, info,
       log, (pg_log_debug ? &log_keys_debug : nullptr),
-      missing, pgmeta_oid, this);
+      missing, pgmeta_oid, this, &log_chunk_entries);
   }
 
   static seastar::future<> read_log_and_missing_crimson(
@@ -1672,7 +1725,8 @@ public:
     std::set<std::string>* log_keys_debug,
     pg_missing_tracker_t &missing,
     ghobject_t pgmeta_oid,
-    const DoutPrefixProvider *dpp = nullptr);
+    const DoutPrefixProvider *dpp = nullptr,
+    uint64_t *log_chunk_entries = nullptr);
 
 #endif
 
@@ -1709,10 +1709,47 @@ void PrimaryLogPG::handle_backoff(OpRequestRef& op)
   session->ack_backoff(cct, m->pgid, m->id, begin, end);
 }
 
+void PrimaryLogPG::queue_transactions(
+  std::vector<ObjectStore::Transaction>& tls,
+  OpRequestRef op)
+{
+  if (in_op_batch && op && is_batchable_write(op)) {
+    for (auto& t : tls) {
+      batched_tls.push_back(std::move(t));
+    }
+    if (!batched_op) {
+      batched_op = op;
+    }
+    return;
+  }
+  flush_batched_transactions();
+  osd->store->queue_transactions(ch, tls, op, NULL);
+}
+
+void PrimaryLogPG::start_op_batch()
+{
+  ceph_assert(!in_op_batch);
+  in_op_batch = true;
+}
+
+void PrimaryLogPG::finish_op_batch()
+{
+  ceph_assert(in_op_batch);
+  if (batched_tls.size()) {
+    dout(20) << __func__ << " queueing " << batched_tls.size()
+	     << " batched transactions" << dendl;
+  }
+  flush_batched_transactions();
+  in_op_batch = false;
+}
+
 void PrimaryLogPG::do_request(
   OpRequestRef& op,
   ThreadPool::TPHandle &handle)
 {
+  if (!batched_tls.empty() && !is_batchable_write(op)) {
+    flush_batched_transactions();
+  }
   if (op->osd_trace) {
     op->pg_trace.init("pg op", &trace_endpoint, &op->osd_trace);
     op->pg_trace.event("do request");
@@ -12061,6 +12098,28 @@ void PrimaryLogPG::on_failed_pull(
   }
 }
 
+void PrimaryLogPG::on_failed_sub_write(
+  pg_shard_t from,
+  const hobject_t &soid,
+  const eversion_t &v)
+{
+  dout(0) << __func__ << " " << soid << " v " << v
+	  << " is stale on shard " << from << dendl;
+  osd->clog->error() << info.pgid << " shard " << from
+		     << " failed to update " << soid << ", repairing";
+  recovery_state.force_object_missing(from, soid, v);
+  if (is_clean()) {
+    state_set(PG_STATE_REPAIR);
+    state_clear(PG_STATE_CLEAN);
+  }
+  queue_peering_event(
+      PGPeeringEventRef(
+	std::make_shared<PGPeeringEvent>(
+	get_osdmap_epoch(),
+	get_osdmap_epoch(),
+	PeeringState::DoRecovery())));
+}
+
 eversion_t PrimaryLogPG::pick_newest_available(const hobject_t& oid)
 {
   eversion_t v;
@@ -316,6 +316,10 @@ public:
     const std::set<pg_shard_t> &from,
     const hobject_t &soid,
     const eversion_t &version) override;
+  void on_failed_sub_write(
+    pg_shard_t from,
+    const hobject_t &soid,
+    const eversion_t &version) override;
   void cancel_pull(const hobject_t &soid) override;
   void apply_stats(
     const hobject_t &soid,
@@ -342,12 +346,11 @@ public:
   }
   void queue_transaction(ObjectStore::Transaction&& t,
 			 OpRequestRef op) override {
+    flush_batched_transactions();
     osd->store->queue_transaction(ch, std::move(t), op);
   }
   void queue_transactions(std::vector<ObjectStore::Transaction>& tls,
-			  OpRequestRef op) override {
-    osd->store->queue_transactions(ch, tls, op, NULL);
-  }
+			  OpRequestRef op) override;
   epoch_t get_interval_start_epoch() const override {
     return info.history.same_interval_since;
   }
@@ -569,6 +572,9 @@ public:
   }
 
   PerfCounters *get_logger() override;
+  ECStripeCache *get_ec_stripe_cache() override {
+    return osd->ec_stripe_cache.get();
+  }
 
   ceph_tid_t get_tid() override { return osd->get_tid(); }
 
@@ -861,6 +867,27 @@ public:
 
 
 protected:
+  /**
+   * Replica writes (repops and EC sub-writes) run in an op batch only
+   * apply transactions, so they are held back and handed to the store
+   * as one group when the batch ends.  Anything else flushes them first,
+   * which keeps both the submission order and read-after-write intact.
+   */
+  bool in_op_batch = false;
+  std::vector<ObjectStore::Transaction> batched_tls;
+  OpRequestRef batched_op;
+
+  static bool is_batchable_write(const OpRequestRef& op) {
+    int type = op->get_req()->get_type();
+    return type == MSG_OSD_REPOP || type == MSG_OSD_EC_WRITE;
+  }
+  void flush_batched_transactions() {
+    if (!batched_tls.empty()) {
+      osd->store->queue_transactions(ch, batched_tls, batched_op, NULL);
+      batched_tls.clear();
+      batched_op.reset();
+    }
+  }
 
   /**
    * Grabs locks for OpContext, should be cleaned up in close_op_ctx
@@ -1506,6 +1533,8 @@ public:
   void do_request(
     OpRequestRef& op,
     ThreadPool::TPHandle &handle) override;
+  void start_op_batch() override;
+  void finish_op_batch() override;
   void do_op(OpRequestRef& op);
   void record_write_error(OpRequestRef op, const hobject_t &soid,
 			  MOSDOpReply *orig_reply, int r,
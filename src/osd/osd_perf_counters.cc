@@ -125,6 +125,10 @@ PerfCounters *build_osd_logger(CephContext *cct) {
     "Latency of IO before calling queue(before really queue into ShardedOpWq)"); // client io before queue op_wq latency
   osd_plb.add_time_avg(l_osd_op_before_dequeue_op_lat, "op_before_dequeue_op_lat",
     "Latency of IO before calling dequeue_op(already dequeued and get PG lock)"); // client io before dequeue_op latency
+  osd_plb.add_u64_avg(l_osd_op_batch_size, "op_batch_size",
+    "Ops run per PG lock acquisition by the op queue workers");
+  osd_plb.add_time_avg(l_osd_pg_lock_hold_lat, "pg_lock_hold_lat",
+    "Time the op queue workers hold a PG lock to run ops");
 
   osd_plb.add_u64_counter(
     l_osd_sop, "subop", "Suboperations");
@@ -278,6 +282,13 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_u64_counter(
     l_osd_pg_biginfo, "osd_pg_biginfo", "PG updated its biginfo attr");
 
+  osd_plb.add_u64_counter(
+    l_osd_ec_stripe_cache_hit, "ec_stripe_cache_hit",
+    "EC reads served from the stripe cache");
+  osd_plb.add_u64_counter(
+    l_osd_ec_stripe_cache_total, "ec_stripe_cache_total",
+    "EC reads looked up in the stripe cache");
+
   return osd_plb.create_perf_counters();
 }
  
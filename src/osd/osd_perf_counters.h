@@ -38,6 +38,8 @@ enum {
 
   l_osd_op_before_queue_op_lat,
   l_osd_op_before_dequeue_op_lat,
+  l_osd_op_batch_size,
+  l_osd_pg_lock_hold_lat,
 
   l_osd_sop,
   l_osd_sop_inb,
@@ -118,6 +120,9 @@ enum {
   l_osd_pg_fastinfo,
   l_osd_pg_biginfo,
 
+  l_osd_ec_stripe_cache_hit,
+  l_osd_ec_stripe_cache_total,
+
   l_osd_last,
 };
 
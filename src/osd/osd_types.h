@@ -1065,6 +1065,9 @@ public:
     DEDUP_TIER,
     DEDUP_CHUNK_ALGORITHM,
     DEDUP_CDC_CHUNK_SIZE,
+    MCLOCK_CLIENT_RES,  // per-client mclock reservation (IOPS)
+    MCLOCK_CLIENT_WGT,  // per-client mclock weight
+    MCLOCK_CLIENT_LIM,  // per-client mclock limit (IOPS)
   };
 
   enum type_t {
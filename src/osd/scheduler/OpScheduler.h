@@ -50,6 +50,9 @@ public:
   // Print human readable brief description with relevant parameters
   virtual void print(std::ostream &out) const = 0;
 
+  // Called with each new osdmap, for schedulers with per pool settings
+  virtual void update_from_osdmap(const OSDMap &osdmap) {}
+
   // Destructor
   virtual ~OpScheduler() {};
 };
@@ -33,6 +33,18 @@ void PGOpItem::run(
   pg->unlock();
 }
 
+void PGOpItem::run_batched(
+  OSD *osd,
+  OSDShard *sdata,
+  PGRef& pg,
+  ThreadPool::TPHandle &handle)
+{
+#ifdef HAVE_JAEGER
+  auto PGOpItem_span = jaeger_tracing::child_span("PGOpItem::run_batched", op->osd_parent_span);
+#endif
+  osd->dequeue_op(pg, op, handle);
+}
+
 void PGPeeringItem::run(
   OSD *osd,
   OSDShard *sdata,
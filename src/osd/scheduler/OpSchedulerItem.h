@@ -90,6 +90,15 @@ public:
     virtual void run(OSD *osd, OSDShard *sdata, PGRef& pg, ThreadPool::TPHandle &handle) = 0;
     virtual op_scheduler_class get_scheduler_class() const = 0;
 
+    /// Items which can run back to back under a single pg lock acquisition
+    virtual bool can_batch() const {
+      return false;
+    }
+    /// Like run(), but the pg lock stays held; only for can_batch() items
+    virtual void run_batched(OSD *osd, OSDShard *sdata, PGRef& pg, ThreadPool::TPHandle &handle) {
+      ceph_abort();
+    }
+
     virtual ~OpQueueable() {}
     friend std::ostream& operator<<(std::ostream& out, const OpQueueable& q) {
       return q.print(out);
@@ -147,6 +156,12 @@ public:
   void run(OSD *osd, OSDShard *sdata,PGRef& pg, ThreadPool::TPHandle &handle) {
     qitem->run(osd, sdata, pg, handle);
   }
+  bool can_batch() const {
+    return qitem->can_batch();
+  }
+  void run_batched(OSD *osd, OSDShard *sdata, PGRef& pg, ThreadPool::TPHandle &handle) {
+    qitem->run_batched(osd, sdata, pg, handle);
+  }
   unsigned get_priority() const { return priority; }
   int get_cost() const { return cost; }
   utime_t get_start_time() const { return start_time; }
@@ -254,6 +269,11 @@ public:
   }
 
   void run(OSD *osd, OSDShard *sdata, PGRef& pg, ThreadPool::TPHandle &handle) final;
+
+  bool can_batch() const final {
+    return true;
+  }
+  void run_batched(OSD *osd, OSDShard *sdata, PGRef& pg, ThreadPool::TPHandle &handle) final;
 };
 
 class PGPeeringItem : public PGOpQueueable {
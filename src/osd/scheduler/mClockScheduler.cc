@@ -17,7 +17,9 @@
 #include <functional>
 
 #include "osd/scheduler/mClockScheduler.h"
+#include "osd/OSDMap.h"
 #include "common/dout.h"
+#include "messages/MOSDOp.h"
 
 namespace dmc = crimson::dmclock;
 using namespace std::placeholders;
@@ -60,16 +62,68 @@ void mClockScheduler::ClientRegistry::update_from_config(const ConfigProxy &conf
     conf.get_val<uint64_t>("osd_mclock_scheduler_background_best_effort_res"),
     conf.get_val<uint64_t>("osd_mclock_scheduler_background_best_effort_wgt"),
     conf.get_val<uint64_t>("osd_mclock_scheduler_background_best_effort_lim"));
+
+  std::lock_guard l(pool_lock);
+  update_pool_client_infos();
+}
+
+bool mClockScheduler::ClientRegistry::update_from_osdmap(const OSDMap &osdmap)
+{
+  std::map<profile_id_t, pool_profile_t> profiles;
+  for (auto& [id, pool] : osdmap.get_pools()) {
+    pool_profile_t profile;
+    pool.opts.get(pool_opts_t::MCLOCK_CLIENT_RES, &profile.res);
+    pool.opts.get(pool_opts_t::MCLOCK_CLIENT_WGT, &profile.wgt);
+    pool.opts.get(pool_opts_t::MCLOCK_CLIENT_LIM, &profile.lim);
+    if (profile.res >= 0 || profile.wgt >= 0 || profile.lim >= 0) {
+      profiles[static_cast<profile_id_t>(id)] = profile;
+    }
+  }
+  std::lock_guard l(pool_lock);
+  if (profiles == pool_profiles) {
+    return false;
+  }
+  pool_profiles.swap(profiles);
+  update_pool_client_infos();
+  return true;
+}
+
+void mClockScheduler::ClientRegistry::update_pool_client_infos()
+{
+  ceph_assert(ceph_mutex_is_locked(pool_lock));
+  // pools which lost their settings go back to the defaults
+  for (auto& [id, info] : pool_client_infos) {
+    if (!pool_profiles.count(id)) {
+      info.update(default_external_client_info.reservation,
+		  default_external_client_info.weight,
+		  default_external_client_info.limit);
+    }
+  }
+  for (auto& [id, profile] : pool_profiles) {
+    double res = profile.res >= 0 ?
+      profile.res : default_external_client_info.reservation;
+    double wgt = profile.wgt >= 0 ?
+      profile.wgt : default_external_client_info.weight;
+    double lim = profile.lim >= 0 ?
+      profile.lim : default_external_client_info.limit;
+    auto [p, inserted] = pool_client_infos.try_emplace(id, res, wgt, lim);
+    if (!inserted) {
+      p->second.update(res, wgt, lim);
+    }
+  }
 }
 
 const dmc::ClientInfo *mClockScheduler::ClientRegistry::get_external_client(
   const client_profile_id_t &client) const
 {
   auto ret = external_client_infos.find(client);
-  if (ret == external_client_infos.end())
-    return &default_external_client_info;
-  else
+  if (ret != external_client_infos.end())
     return &(ret->second);
+  std::lock_guard l(pool_lock);
+  auto pool = pool_client_infos.find(client.profile_id);
+  if (pool != pool_client_infos.end())
+    return &(pool->second);
+  return &default_external_client_info;
 }
 
 const dmc::ClientInfo *mClockScheduler::ClientRegistry::get_info(
@@ -90,6 +144,37 @@ void mClockScheduler::dump(ceph::Formatter &f) const
 {
 }
 
+void mClockScheduler::update_from_osdmap(const OSDMap &osdmap)
+{
+  if (client_registry.update_from_osdmap(osdmap)) {
+    // the queue holds on to the ClientInfo it looked up when it first
+    // saw a client, which may be the default one from before its pool
+    // had a profile
+    scheduler.update_client_infos();
+  }
+}
+
+dmc::ReqParams mClockScheduler::get_req_params(const OpSchedulerItem &item)
+{
+  if (auto op = item.maybe_get_op();
+      op && (*op)->get_req()->get_type() == CEPH_MSG_OSD_OP) {
+    auto m = (*op)->get_req<MOSDOp>();
+    uint32_t delta = m->get_qos_delta();
+    // rho counts a subset of the replies counted by delta
+    return dmc::ReqParams(delta, std::min(m->get_qos_rho(), delta));
+  }
+  return dmc::ReqParams();
+}
+
+void mClockScheduler::set_phase(OpSchedulerItem &item, dmc::PhaseType phase)
+{
+  if (auto op = item.maybe_get_op();
+      op && (*op)->get_req()->get_type() == CEPH_MSG_OSD_OP) {
+    auto m = static_cast<MOSDOp*>((*op)->get_nonconst_req());
+    m->set_qos_phase(static_cast<int8_t>(phase));
+  }
+}
+
 void mClockScheduler::enqueue(OpSchedulerItem&& item)
 {
   auto id = get_scheduler_id(item);
@@ -100,9 +185,11 @@ void mClockScheduler::enqueue(OpSchedulerItem&& item)
   if (op_scheduler_class::immediate == item.get_scheduler_class()) {
     immediate.push_front(std::move(item));
   } else {
+    auto params = get_req_params(item);
     scheduler.add_request(
       std::move(item),
       id,
+      params,
       cost);
   }
 }
@@ -132,6 +219,7 @@ WorkItem mClockScheduler::dequeue()
       ceph_assert(result.is_retn());
 
       auto &retn = result.get_retn();
+      set_phase(*retn.request, retn.phase);
       return std::move(*retn.request);
     }
   }
@@ -25,6 +25,7 @@
 
 #include "osd/scheduler/OpScheduler.h"
 #include "common/config.h"
+#include "common/ceph_mutex.h"
 #include "include/cmp.h"
 #include "common/ceph_context.h"
 #include "common/mClockPriorityQueue.h"
@@ -56,7 +57,13 @@ WRITE_CMP_OPERATORS_2(scheduler_id_t, class_id, client_profile_id)
 /**
  * Scheduler implementation based on mclock.
  *
- * TODO: explain configs
+ * Client ops are scheduled per (client, pool): each client gets its own
+ * dmclock queue with the reservation/weight/limit from the pool's
+ * mclock_client_{res,wgt,lim} options, falling back to
+ * osd_mclock_scheduler_client_{res,wgt,lim}.  Clients which track their
+ * replies (objecter_mclock_service_tracker) send the dmclock delta/rho
+ * tags with each op so that the tags account for service received from
+ * other osds, and get the phase each op was served in back in the reply.
  */
 class mClockScheduler : public OpScheduler, md_config_obs_t {
 
@@ -73,10 +80,32 @@ class mClockScheduler : public OpScheduler, md_config_obs_t {
     crimson::dmclock::ClientInfo default_external_client_info = {1, 1, 1};
     std::map<client_profile_id_t,
 	     crimson::dmclock::ClientInfo> external_client_infos;
+
+    // per pool settings, -1 where unset; entries are never removed from
+    // pool_client_infos since the queue may still refer to them
+    struct pool_profile_t {
+      int64_t res = -1;
+      int64_t wgt = -1;
+      int64_t lim = -1;
+      bool operator==(const pool_profile_t &rhs) const {
+	return res == rhs.res && wgt == rhs.wgt && lim == rhs.lim;
+      }
+    };
+    // osdmaps come in under the shard lock, config changes on the
+    // config observer thread and lookups from the op threads
+    mutable ceph::mutex pool_lock =
+      ceph::make_mutex("mClockScheduler::ClientRegistry::pool_lock");
+    std::map<profile_id_t, pool_profile_t> pool_profiles;
+    std::map<profile_id_t,
+	     crimson::dmclock::ClientInfo> pool_client_infos;
+    void update_pool_client_infos();
+
     const crimson::dmclock::ClientInfo *get_external_client(
       const client_profile_id_t &client) const;
   public:
     void update_from_config(const ConfigProxy &conf);
+    /// returns true if any pool's profile changed
+    bool update_from_osdmap(const OSDMap &osdmap);
     const crimson::dmclock::ClientInfo *get_info(
       const scheduler_id_t &id) const;
   } client_registry;
@@ -91,15 +120,24 @@ class mClockScheduler : public OpScheduler, md_config_obs_t {
   std::list<OpSchedulerItem> immediate;
 
   static scheduler_id_t get_scheduler_id(const OpSchedulerItem &item) {
+    auto class_id = item.get_scheduler_class();
     return scheduler_id_t{
-      item.get_scheduler_class(),
+      class_id,
 	client_profile_id_t{
 	item.get_owner(),
-	  0
+	  class_id == op_scheduler_class::client ?
+	  static_cast<profile_id_t>(item.get_ordering_token().pool()) : 0
 	  }
     };
   }
 
+  /// dmclock tags sent along by the client, if any
+  static crimson::dmclock::ReqParams get_req_params(
+    const OpSchedulerItem &item);
+  /// remember the phase for the reply to report back to the client
+  static void set_phase(OpSchedulerItem &item,
+			crimson::dmclock::PhaseType phase);
+
 public:
   mClockScheduler(CephContext *cct);
 
@@ -120,6 +158,9 @@ public:
   // Formatted output of the queue
   void dump(ceph::Formatter &f) const final;
 
+  // Pick up per pool client profiles
+  void update_from_osdmap(const OSDMap &osdmap) final;
+
   void print(std::ostream &ostream) const final {
     ostream << "mClockScheduler";
   }
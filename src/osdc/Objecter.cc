@@ -58,6 +58,8 @@
 #include "common/async/waiter.h"
 #include "error_code.h"
 
+#include "dmclock/src/dmclock_client.h"
+
 
 using std::list;
 using std::make_pair;
@@ -164,6 +166,8 @@ enum {
   l_osdc_map_epoch,
   l_osdc_map_full,
   l_osdc_map_inc,
+  l_osdc_map_prebuilt,
+  l_osdc_map_lock_lat,
 
   l_osdc_osd_sessions,
   l_osdc_osd_session_open,
@@ -183,6 +187,9 @@ inline bs::error_code osdcode(int r) {
 }
 }
 
+// tracks the service we got from each osd, keyed by osd id
+struct Objecter::QosTracker : public crimson::dmclock::ServiceTracker<int> {};
+
 // config obs ----------------------------
 
 class Objecter::RequestStateHook : public AdminSocketHook {
@@ -353,6 +360,10 @@ void Objecter::init()
 			"Full OSD maps received");
     pcb.add_u64_counter(l_osdc_map_inc, "map_inc",
 			"Incremental OSD maps received");
+    pcb.add_u64_counter(l_osdc_map_prebuilt, "map_prebuilt",
+			"OSD map epochs built before taking the map lock");
+    pcb.add_time_avg(l_osdc_map_lock_lat, "map_lock_lat",
+		     "Time OSD map handling held the map lock exclusively");
 
     pcb.add_u64(l_osdc_osd_sessions, "osd_sessions",
 		"Open sessions");  // open sessions
@@ -1135,11 +1146,61 @@ void Objecter::_scan_requests(
   }
 }
 
+void Objecter::prebuild_osdmaps(MOSDMap *m, epoch_t *base,
+				std::map<epoch_t, prebuilt_osdmap_t> *out)
+{
+  // Decoding maps and applying incrementals is the expensive part of
+  // handle_osd_map.  Do it on private copies with rwlock held shared only,
+  // so op submission keeps going; handle_osd_map then just swaps them in.
+  std::unique_ptr<OSDMap> cur;
+  {
+    shared_lock rl(rwlock);
+    if (!initialized || !osdmap->get_epoch() ||
+	m->fsid != monc->get_fsid() ||
+	m->get_last() <= osdmap->get_epoch()) {
+      return;
+    }
+    *base = osdmap->get_epoch();
+    cur = std::make_unique<OSDMap>();
+    cur->deepish_copy_from(*osdmap);
+  }
+
+  for (epoch_t e = *base + 1; e <= m->get_last(); e++) {
+    prebuilt_osdmap_t pb;
+    if (auto p = m->incremental_maps.find(e);
+	p != m->incremental_maps.end()) {
+      pb.inc = std::make_unique<OSDMap::Incremental>(p->second);
+      pb.map = std::make_unique<OSDMap>();
+      pb.map->deepish_copy_from(*cur);
+      pb.map->apply_incremental(*pb.inc);
+    } else if (auto p = m->maps.find(e); p != m->maps.end()) {
+      pb.map = std::make_unique<OSDMap>();
+      pb.map->decode(p->second);
+    } else {
+      // leave gaps and jumps to handle_osd_map
+      break;
+    }
+    ceph_assert(pb.map->get_epoch() == e);
+    cur = std::make_unique<OSDMap>();
+    cur->deepish_copy_from(*pb.map);
+    out->emplace(e, std::move(pb));
+  }
+  ldout(cct, 10) << __func__ << " built " << out->size() << " epochs on top of "
+		 << *base << dendl;
+}
+
 void Objecter::handle_osd_map(MOSDMap *m)
 {
+  epoch_t prebuilt_base = 0;
+  std::map<epoch_t, prebuilt_osdmap_t> prebuilt;
+  if (cct->_conf.get_val<bool>("objecter_prebuild_osdmaps")) {
+    prebuild_osdmaps(m, &prebuilt_base, &prebuilt);
+  }
+
   ceph::shunique_lock sul(rwlock, acquire_unique);
   if (!initialized)
     return;
+  auto lock_start = mono_clock::now();
 
   ceph_assert(osdmap);
 
@@ -1172,6 +1233,10 @@ void Objecter::handle_osd_map(MOSDMap *m)
 		  << m->get_first() << "," << m->get_last()
 		  << "] > " << osdmap->get_epoch() << dendl;
 
+    if (prebuilt_base != osdmap->get_epoch()) {
+      // raced with another map update; the copies are stale
+      prebuilt.clear();
+    }
     if (osdmap->get_epoch()) {
       bool skipped_map = false;
       // we want incrementals
@@ -1179,7 +1244,20 @@ void Objecter::handle_osd_map(MOSDMap *m)
 	   e <= m->get_last();
 	   e++) {
 
-	if (osdmap->get_epoch() == e-1 &&
+	if (auto pb = prebuilt.find(e);
+	    pb != prebuilt.end() && osdmap->get_epoch() == e-1) {
+	  ldout(cct, 3) << "handle_osd_map using prebuilt epoch " << e << dendl;
+	  if (pb->second.inc) {
+	    emit_blocklist_events(*pb->second.inc);
+	    logger->inc(l_osdc_map_inc);
+	  } else {
+	    emit_blocklist_events(*osdmap, *pb->second.map);
+	    logger->inc(l_osdc_map_full);
+	  }
+	  osdmap = std::move(pb->second.map);
+	  logger->inc(l_osdc_map_prebuilt);
+	}
+	else if (osdmap->get_epoch() == e-1 &&
 	    m->incremental_maps.count(e)) {
 	  ldout(cct, 3) << "handle_osd_map decoding incremental epoch " << e
 			<< dendl;
@@ -1365,6 +1443,8 @@ void Objecter::handle_osd_map(MOSDMap *m)
   if (!waiting_for_map.empty()) {
     _maybe_request_map();
   }
+
+  logger->tinc(l_osdc_map_lock_lat, mono_clock::now() - lock_start);
 }
 
 void Objecter::enable_blocklist_events()
@@ -3148,6 +3228,11 @@ Objecter::MOSDOp *Objecter::_prepare_osd_op(Op *op)
     m->set_reqid(op->reqid);
   }
 
+  if (qos_tracker && op->target.osd >= 0) {
+    auto params = qos_tracker->get_req_params(op->target.osd);
+    m->set_qos_params(params.delta, params.rho);
+  }
+
   logger->inc(l_osdc_op_send);
   ssize_t sum = 0;
   for (unsigned i = 0; i < m->ops.size(); i++) {
@@ -3327,6 +3412,11 @@ void Objecter::handle_osd_op_reply(MOSDOpReply *m)
   Op *op = iter->second;
   op->trace.event("osd op reply");
 
+  if (qos_tracker && m->get_qos_phase() >= 0) {
+    qos_tracker->track_resp(
+      s->osd, static_cast<crimson::dmclock::PhaseType>(m->get_qos_phase()));
+  }
+
   if (retry_writes_after_first_reply && op->attempts == 1 &&
       (op->target.flags & CEPH_OSD_FLAG_WRITE)) {
     ldout(cct, 7) << "retrying write after first reply: " << tid << dendl;
@@ -4915,6 +5005,9 @@ Objecter::Objecter(CephContext *cct,
 {
   mon_timeout = cct->_conf.get_val<std::chrono::seconds>("rados_mon_op_timeout");
   osd_timeout = cct->_conf.get_val<std::chrono::seconds>("rados_osd_op_timeout");
+  if (cct->_conf.get_val<bool>("objecter_mclock_service_tracker")) {
+    qos_tracker = std::make_unique<QosTracker>();
+  }
 }
 
 Objecter::~Objecter()
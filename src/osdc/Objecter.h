@@ -1638,6 +1638,9 @@ public:
   ZTracer::Endpoint trace_endpoint{"0.0.0.0", 0, "Objecter"};
 private:
   std::unique_ptr<OSDMap> osdmap{std::make_unique<OSDMap>()};
+  // dmclock service tracker, if objecter_mclock_service_tracker
+  struct QosTracker;
+  std::unique_ptr<QosTracker> qos_tracker;
 public:
   using Dispatcher::cct;
   std::multimap<std::string,std::string> crush_location;
@@ -2660,6 +2663,17 @@ private:
   void handle_osd_map(class MOSDMap *m);
   void wait_for_osd_map(epoch_t e=0);
 
+ private:
+  /// an osdmap epoch decoded and applied ahead of handle_osd_map
+  struct prebuilt_osdmap_t {
+    std::unique_ptr<OSDMap> map;
+    std::unique_ptr<OSDMap::Incremental> inc; ///< null if built from a full map
+  };
+  void prebuild_osdmaps(class MOSDMap *m, epoch_t *base,
+			std::map<epoch_t, prebuilt_osdmap_t> *out);
+
+ public:
+
   template<typename CompletionToken>
   auto wait_for_osd_map(CompletionToken&& token) {
     boost::asio::async_completion<CompletionToken, void()> init(token);
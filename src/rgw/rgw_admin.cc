@@ -6816,6 +6816,7 @@ next:
 
     constexpr uint32_t NUM_ENTRIES = 1000;
     uint16_t expansion_factor = 1;
+    RGWRados::BucketListCursors cursors;
     while (is_truncated) {
       RGWRados::ent_map_t result;
       result.reserve(NUM_ENTRIES);
@@ -6826,7 +6827,7 @@ next:
 	NUM_ENTRIES, true, expansion_factor,
 	result, &is_truncated, &cls_filtered, &marker,
 	null_yield,
-	rgw_bucket_object_check_filter);
+	rgw_bucket_object_check_filter, &cursors);
       if (r < 0 && r != -ENOENT) {
         cerr << "ERROR: failed operation r=" << r << std::endl;
       } else if (r == -ENOENT) {
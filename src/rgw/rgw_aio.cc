@@ -14,6 +14,7 @@
  */
 
 #include <type_traits>
+#include <boost/asio/thread_pool.hpp>
 #include "include/rados/librados.hpp"
 #include "librados/librados_asio.h"
 
@@ -116,4 +117,29 @@ Aio::OpFunc Aio::librados_op(librados::ObjectWriteOperation&& op,
   return aio_abstract(std::move(op), y);
 }
 
+Aio::OpFunc Aio::work_op(boost::asio::thread_pool& pool, WorkFunc&& f,
+                         optional_yield y) {
+  if (y) {
+    return [&pool, f = std::move(f), yield = y.get_yield_context()]
+      (Aio* aio, AioResult& r) mutable {
+        // hand the result back on the yield_context's strand executor,
+        // like a librados completion
+        using namespace boost::asio;
+        async_completion<spawn::yield_context, void()> init(yield);
+        auto ex = get_associated_executor(init.completion_handler);
+
+        post(pool, [f = std::move(f), ex, aio, &r] () mutable {
+            r.result = std::move(f)(r.data);
+            post(ex, [aio, &r] { aio->put(r); });
+          });
+      };
+  }
+  return [&pool, f = std::move(f)] (Aio* aio, AioResult& r) mutable {
+      boost::asio::post(pool, [f = std::move(f), aio, &r] () mutable {
+          r.result = std::move(f)(r.data);
+          aio->put(r);
+        });
+    };
+}
+
 } // namespace rgw
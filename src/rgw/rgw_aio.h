@@ -29,6 +29,8 @@
 
 #include "include/function2.hpp"
 
+namespace boost::asio { class thread_pool; }
+
 namespace rgw {
 
 struct AioResult {
@@ -95,6 +97,12 @@ class Aio {
                             optional_yield y);
   static OpFunc librados_op(librados::ObjectWriteOperation&& op,
                             optional_yield y);
+
+  // runs f on a thread pool instead of sending a librados op. f fills in
+  // the result's data, and its return value is the result
+  using WorkFunc = fu2::unique_function<int(bufferlist& data) &&>;
+  static OpFunc work_op(boost::asio::thread_pool& pool, WorkFunc&& f,
+                        optional_yield y);
 };
 
 } // namespace rgw
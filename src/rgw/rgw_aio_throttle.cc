@@ -13,6 +13,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "include/rados/librados.hpp"
 
 #include "rgw_aio_throttle.h"
@@ -199,4 +201,77 @@ AioResultList YieldingAioThrottle::drain()
   }
   return std::move(completed);
 }
+
+uint64_t WindowBudget::try_reserve(uint64_t bytes, uint64_t limit)
+{
+  if (!limit) {
+    used += bytes;
+    return bytes;
+  }
+  uint64_t cur = used.load();
+  uint64_t got;
+  do {
+    got = cur < limit ? std::min(bytes, limit - cur) : 0;
+    if (!got) {
+      break;
+    }
+  } while (!used.compare_exchange_weak(cur, cur + got));
+  return got;
+}
+
+AdaptiveReadWindow::AdaptiveReadWindow(WindowBudget& budget,
+                                       uint64_t budget_limit,
+                                       uint64_t min, uint64_t initial,
+                                       uint64_t max)
+  : budget(budget), budget_limit(budget_limit),
+    min(min), max(std::max(min, max)), window(min)
+{
+  budget.reserve(min);
+  initial = std::clamp(initial, min, this->max);
+  window += budget.try_reserve(initial - min, budget_limit);
+}
+
+AdaptiveReadWindow::~AdaptiveReadWindow()
+{
+  budget.release(window);
+}
+
+void AdaptiveReadWindow::update()
+{
+  if (!latency_count || !client_bytes) {
+    return; // keep the initial window until we know both
+  }
+  // the client would empty a full window in window / rate; reads issued
+  // after it must complete before that, with some slack for variance
+  uint64_t want = max;
+  if (client_time > 0) {
+    const double latency = latency_sum / latency_count;
+    const double target = 2 * latency * client_bytes / client_time;
+    if (target < max) {
+      want = std::max(min, static_cast<uint64_t>(target));
+    }
+  }
+  if (want > window) {
+    window += budget.try_reserve(want - window, budget_limit);
+  } else if (want < window) {
+    budget.release(window - want);
+    window = want;
+  }
+}
+
+void AdaptiveReadWindow::add_read_latency(ceph::timespan latency)
+{
+  latency_sum = latency_sum * decay + ceph::to_seconds<double>(latency);
+  latency_count = latency_count * decay + 1;
+  update();
+}
+
+void AdaptiveReadWindow::add_client_write(uint64_t bytes,
+                                          ceph::timespan elapsed)
+{
+  client_bytes = client_bytes * decay + bytes;
+  client_time = client_time * decay + ceph::to_seconds<double>(elapsed);
+  update();
+}
+
 } // namespace rgw
@@ -16,8 +16,10 @@
 #pragma once
 
 #include "include/rados/librados_fwd.hpp"
+#include <atomic>
 #include <memory>
 #include "common/ceph_mutex.h"
+#include "common/ceph_time.h"
 #include "common/async/completion.h"
 #include "common/async/yield_context.h"
 #include "services/svc_rados.h"
@@ -112,6 +114,56 @@ class YieldingAioThrottle final : public Aio, private Throttle {
   AioResultList drain() override final;
 };
 
+// a byte budget shared by concurrent requests, so that the memory pinned
+// by their aio windows adds up to no more than a limit. reservations
+// don't wait: a request that can't get more keeps what it has
+class WindowBudget {
+  std::atomic<uint64_t> used{0};
+ public:
+  // reserve up to 'bytes' without going over 'limit' (0 for no limit),
+  // returns how much was reserved
+  uint64_t try_reserve(uint64_t bytes, uint64_t limit);
+  // reserve regardless of the limit
+  void reserve(uint64_t bytes) { used += bytes; }
+  void release(uint64_t bytes) { used -= bytes; }
+  uint64_t get_used() const { return used; }
+};
+
+// the window of a single object read. it aims to keep enough reads in
+// flight to cover the rados read latency at the rate the client takes the
+// data: a fast client far from the osds gets a large window, a slow one a
+// small window. the window stays within [min, max], and all of it is
+// reserved from the shared budget, though min is granted even when the
+// budget is exhausted so that every request makes progress
+class AdaptiveReadWindow {
+  WindowBudget& budget;
+  const uint64_t budget_limit;
+  const uint64_t min;
+  const uint64_t max;
+  uint64_t window;
+
+  // exponentially decayed sums of the samples
+  static constexpr double decay = 0.75;
+  double latency_sum = 0; // seconds
+  double latency_count = 0;
+  double client_bytes = 0;
+  double client_time = 0; // seconds
+
+  void update();
+
+ public:
+  AdaptiveReadWindow(WindowBudget& budget, uint64_t budget_limit,
+                     uint64_t min, uint64_t initial, uint64_t max);
+  ~AdaptiveReadWindow();
+
+  uint64_t get() const { return window; }
+
+  // a read that was waited on took this long to complete
+  void add_read_latency(ceph::timespan latency);
+  // the client took this long to accept this many bytes
+  void add_client_write(uint64_t bytes, ceph::timespan elapsed);
+};
+
 // return a smart pointer to Aio
 inline auto make_throttle(uint64_t window_size, optional_yield y)
 {
@@ -955,6 +955,7 @@ int RGWBucket::check_object_index(RGWBucketAdminOpState& op_state,
   Formatter *formatter = flusher.get_formatter();
   formatter->open_object_section("objects");
   uint16_t expansion_factor = 1;
+  RGWRados::BucketListCursors cursors;
   while (is_truncated) {
     RGWRados::ent_map_t result;
     result.reserve(listing_max_entries);
@@ -963,7 +964,7 @@ int RGWBucket::check_object_index(RGWBucketAdminOpState& op_state,
       bucket_info, RGW_NO_SHARD, marker, prefix, empty_delimiter,
       listing_max_entries, true, expansion_factor,
       result, &is_truncated, &cls_filtered, &marker,
-      y, rgw_bucket_object_check_filter);
+      y, rgw_bucket_object_check_filter, &cursors);
     if (r == -ENOENT) {
       break;
     } else if (r < 0 && r != -ENOENT) {
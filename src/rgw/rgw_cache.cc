@@ -5,20 +5,86 @@
 #include "rgw_perf_counters.h"
 
 #include <errno.h>
+#include <algorithm>
 
 #define dout_subsys ceph_subsys_rgw
 
 
-int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
+void ObjectCache::set_ctx(CephContext *_cct)
 {
+  cct = _cct;
+  expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
+				  "rgw_cache_expiry_interval"));
+
+  unsigned long lru_size = std::max<int64_t>(cct->_conf->rgw_cache_lru_size, 1);
+  auto num_shards = std::clamp<unsigned long>(
+    cct->_conf.get_val<uint64_t>("rgw_cache_shards"), 1, lru_size);
+  shard_size = lru_size / num_shards;
+  shards.clear();
+  for (unsigned long i = 0; i < num_shards; ++i) {
+    shards.push_back(std::make_unique<Shard>());
+  }
 
-  std::shared_lock rl{lock};
+  // the builder keeps pointers to the names
+  counter_names.clear();
+  counter_names.reserve(num_shards * l_rgw_cache_shard_counters);
+  PerfCountersBuilder plb(cct, "rgw_cache", 0,
+			  1 + num_shards * l_rgw_cache_shard_counters);
+  for (unsigned long i = 0; i < num_shards; ++i) {
+    int first = 1 + i * l_rgw_cache_shard_counters;
+    auto name = [&](const char *counter) {
+      counter_names.push_back("shard_" + std::to_string(i) + "_" + counter);
+      return counter_names.back().c_str();
+    };
+    plb.add_u64_counter(first + l_rgw_cache_shard_hit, name("hit"),
+			"Cache hits in the shard");
+    plb.add_u64_counter(first + l_rgw_cache_shard_miss, name("miss"),
+			"Cache misses in the shard");
+    plb.add_u64_counter(first + l_rgw_cache_shard_contended, name("contended"),
+			"Accesses that had to wait for the shard's lock");
+    plb.add_u64_counter(first + l_rgw_cache_shard_evict, name("evict"),
+			"Entries evicted from the shard");
+  }
+  if (logger) {
+    cct->get_perfcounters_collection()->remove(logger);
+    delete logger;
+  }
+  logger = plb.create_perf_counters();
+  cct->get_perfcounters_collection()->add(logger);
+}
+
+std::shared_lock<ceph::shared_mutex> ObjectCache::lock_shared(size_t shard)
+{
+  std::shared_lock l{shards[shard]->lock, std::try_to_lock};
+  if (!l.owns_lock()) {
+    inc(shard, l_rgw_cache_shard_contended);
+    l.lock();
+  }
+  return l;
+}
+
+std::unique_lock<ceph::shared_mutex> ObjectCache::lock_unique(size_t shard)
+{
+  std::unique_lock l{shards[shard]->lock, std::try_to_lock};
+  if (!l.owns_lock()) {
+    inc(shard, l_rgw_cache_shard_contended);
+    l.lock();
+  }
+  return l;
+}
+
+int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
+{
   if (!enabled) {
     return -ENOENT;
   }
-  auto iter = cache_map.find(name);
-  if (iter == cache_map.end()) {
+  size_t shard = shard_of(name);
+  Shard& s = *shards[shard];
+  auto rl = lock_shared(shard);
+  auto iter = s.cache_map.find(name);
+  if (iter == s.cache_map.end()) {
     ldout(cct, 10) << "cache get: name=" << name << " : miss" << dendl;
+    inc(shard, l_rgw_cache_shard_miss);
     if (perfcounter) {
       perfcounter->inc(l_rgw_cache_miss);
     }
@@ -29,15 +95,13 @@ int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, r
        (ceph::coarse_mono_clock::now() - iter->second.info.time_added) > expiry) {
     ldout(cct, 10) << "cache get: name=" << name << " : expiry miss" << dendl;
     rl.unlock();
-    std::unique_lock wl{lock};  // write lock for insertion
+    auto wl = lock_unique(shard);  // write lock for removal
     // check that wasn't already removed by other thread
-    iter = cache_map.find(name);
-    if (iter != cache_map.end()) {
-      for (auto &kv : iter->second.chained_entries)
-        kv.first->invalidate(kv.second);
-      remove_lru(name, iter->second.lru_iter);
-      cache_map.erase(iter);
+    iter = s.cache_map.find(name);
+    if (iter != s.cache_map.end()) {
+      erase(s, iter);
     }
+    inc(shard, l_rgw_cache_shard_miss);
     if (perfcounter) {
       perfcounter->inc(l_rgw_cache_miss);
     }
@@ -45,30 +109,16 @@ int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, r
   }
 
   ObjectCacheEntry *entry = &iter->second;
-
-  if (lru_counter - entry->lru_promotion_ts > lru_window) {
-    ldout(cct, 20) << "cache get: touching lru, lru_counter=" << lru_counter
-                   << " promotion_ts=" << entry->lru_promotion_ts << dendl;
-    rl.unlock();
-    std::unique_lock wl{lock};  // write lock for insertion
-    /* need to redo this because entry might have dropped off the cache */
-    iter = cache_map.find(name);
-    if (iter == cache_map.end()) {
-      ldout(cct, 10) << "lost race! cache get: name=" << name << " : miss" << dendl;
-      if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
-      return -ENOENT;
-    }
-
-    entry = &iter->second;
-    /* check again, we might have lost a race here */
-    if (lru_counter - entry->lru_promotion_ts > lru_window) {
-      touch_lru(name, *entry, iter->second.lru_iter);
-    }
+  // second chance for the clock; skip the store if it's already set so
+  // that hits on hot entries don't bounce the cache line around
+  if (!entry->referenced.load(std::memory_order_relaxed)) {
+    entry->referenced.store(true, std::memory_order_relaxed);
   }
 
   ObjectCacheInfo& src = iter->second.info;
   if(src.status == -ENOENT) {
     ldout(cct, 10) << "cache get: name=" << name << " : hit (negative entry)" << dendl;
+    inc(shard, l_rgw_cache_shard_hit);
     if (perfcounter) perfcounter->inc(l_rgw_cache_hit);
     return -ENODATA;
   }
@@ -76,6 +126,7 @@ int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, r
     ldout(cct, 10) << "cache get: name=" << name << " : type miss (requested=0x"
                    << std::hex << mask << ", cached=0x" << src.flags
                    << std::dec << ")" << dendl;
+    inc(shard, l_rgw_cache_shard_miss);
     if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
     return -ENOENT;
   }
@@ -88,6 +139,7 @@ int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, r
     cache_info->cache_locator = name;
     cache_info->gen = entry->gen;
   }
+  inc(shard, l_rgw_cache_shard_hit);
   if(perfcounter) perfcounter->inc(l_rgw_cache_hit);
 
   return 0;
@@ -96,18 +148,29 @@ int ObjectCache::get(const string& name, ObjectCacheInfo& info, uint32_t mask, r
 bool ObjectCache::chain_cache_entry(std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 				    RGWChainedCache::Entry *chained_entry)
 {
-  std::unique_lock l{lock};
-
   if (!enabled) {
     return false;
   }
 
+  // the entries may live in different shards; lock them in order
+  std::vector<size_t> locked;
+  for (auto cache_info : cache_info_entries) {
+    locked.push_back(shard_of(cache_info->cache_locator));
+  }
+  std::sort(locked.begin(), locked.end());
+  locked.erase(std::unique(locked.begin(), locked.end()), locked.end());
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  for (auto shard : locked) {
+    locks.push_back(lock_unique(shard));
+  }
+
   std::vector<ObjectCacheEntry*> entries;
   entries.reserve(cache_info_entries.size());
   /* first verify that all entries are still valid */
   for (auto cache_info : cache_info_entries) {
     ldout(cct, 10) << "chain_cache_entry: cache_locator="
 		   << cache_info->cache_locator << dendl;
+    auto& cache_map = shards[shard_of(cache_info->cache_locator)]->cache_map;
     auto iter = cache_map.find(cache_info->cache_locator);
     if (iter == cache_map.end()) {
       ldout(cct, 20) << "chain_cache_entry: couldn't find cache locator" << dendl;
@@ -138,29 +201,33 @@ bool ObjectCache::chain_cache_entry(std::initializer_list<rgw_cache_entry_info*>
 
 void ObjectCache::put(const string& name, ObjectCacheInfo& info, rgw_cache_entry_info *cache_info)
 {
-  std::unique_lock l{lock};
-
   if (!enabled) {
     return;
   }
 
+  size_t shard = shard_of(name);
+  Shard& s = *shards[shard];
+  auto l = lock_unique(shard);
+
   ldout(cct, 10) << "cache put: name=" << name << " info.flags=0x"
                  << std::hex << info.flags << std::dec << dendl;
 
-  auto [iter, inserted] = cache_map.emplace(name, ObjectCacheEntry{});
+  auto [iter, inserted] = s.cache_map.try_emplace(name);
   ObjectCacheEntry& entry = iter->second;
   entry.info.time_added = ceph::coarse_mono_clock::now();
   if (inserted) {
-    entry.lru_iter = lru.end();
+    // just behind the hand: the last entry it will get to
+    entry.clock_iter = s.clock.insert(s.hand, name);
+    ldout(cct, 10) << "adding " << name << " to cache" << dendl;
   }
   ObjectCacheInfo& target = entry.info;
 
-  invalidate_lru(entry);
+  invalidate_chained(entry);
 
   entry.chained_entries.clear();
   entry.gen++;
 
-  touch_lru(name, entry, entry.lru_iter);
+  trim(shard, name);
 
   target.status = info.status;
 
@@ -213,80 +280,59 @@ void ObjectCache::put(const string& name, ObjectCacheInfo& info, rgw_cache_entry
 
 bool ObjectCache::remove(const string& name)
 {
-  std::unique_lock l{lock};
-
   if (!enabled) {
     return false;
   }
 
-  auto iter = cache_map.find(name);
-  if (iter == cache_map.end())
+  size_t shard = shard_of(name);
+  Shard& s = *shards[shard];
+  auto l = lock_unique(shard);
+
+  auto iter = s.cache_map.find(name);
+  if (iter == s.cache_map.end())
     return false;
 
   ldout(cct, 10) << "removing " << name << " from cache" << dendl;
-  ObjectCacheEntry& entry = iter->second;
-
-  for (auto& kv : entry.chained_entries) {
-    kv.first->invalidate(kv.second);
-  }
-
-  remove_lru(name, iter->second.lru_iter);
-  cache_map.erase(iter);
+  erase(s, iter);
   return true;
 }
 
-void ObjectCache::touch_lru(const string& name, ObjectCacheEntry& entry,
-			    std::list<string>::iterator& lru_iter)
+void ObjectCache::trim(size_t shard, const string& keep)
 {
-  while (lru_size > (size_t)cct->_conf->rgw_cache_lru_size) {
-    auto iter = lru.begin();
-    if ((*iter).compare(name) == 0) {
-      /*
-       * if the entry we're touching happens to be at the lru end, don't remove it,
-       * lru shrinking can wait for next time
-       */
-      break;
+  Shard& s = *shards[shard];
+  // every entry the hand passes loses its reference bit, so this takes
+  // at most two turns of the clock
+  while (s.cache_map.size() > shard_size) {
+    if (s.hand == s.clock.end()) {
+      s.hand = s.clock.begin();
     }
-    auto map_iter = cache_map.find(*iter);
-    ldout(cct, 10) << "removing entry: name=" << *iter << " from cache LRU" << dendl;
-    if (map_iter != cache_map.end()) {
-      ObjectCacheEntry& entry = map_iter->second;
-      invalidate_lru(entry);
-      cache_map.erase(map_iter);
+    auto iter = s.cache_map.find(*s.hand);
+    ceph_assert(iter != s.cache_map.end());
+    if (*s.hand == keep ||
+	iter->second.referenced.exchange(false, std::memory_order_relaxed)) {
+      ++s.hand;
+      continue;
     }
-    lru.pop_front();
-    lru_size--;
-  }
-
-  if (lru_iter == lru.end()) {
-    lru.push_back(name);
-    lru_size++;
-    lru_iter--;
-    ldout(cct, 10) << "adding " << name << " to cache LRU end" << dendl;
-  } else {
-    ldout(cct, 10) << "moving " << name << " to cache LRU end" << dendl;
-    lru.erase(lru_iter);
-    lru.push_back(name);
-    lru_iter = lru.end();
-    --lru_iter;
+    ldout(cct, 10) << "removing entry: name=" << *s.hand
+		   << " from cache CLOCK" << dendl;
+    inc(shard, l_rgw_cache_shard_evict);
+    erase(s, iter);
   }
-
-  lru_counter++;
-  entry.lru_promotion_ts = lru_counter;
 }
 
-void ObjectCache::remove_lru(const string& name,
-			     std::list<string>::iterator& lru_iter)
+void ObjectCache::erase(Shard& s,
+			std::unordered_map<string, ObjectCacheEntry>::iterator iter)
 {
-  if (lru_iter == lru.end())
-    return;
-
-  lru.erase(lru_iter);
-  lru_size--;
-  lru_iter = lru.end();
+  ObjectCacheEntry& entry = iter->second;
+  invalidate_chained(entry);
+  if (s.hand == entry.clock_iter) {
+    ++s.hand;
+  }
+  s.clock.erase(entry.clock_iter);
+  s.cache_map.erase(iter);
 }
 
-void ObjectCache::invalidate_lru(ObjectCacheEntry& entry)
+void ObjectCache::invalidate_chained(ObjectCacheEntry& entry)
 {
   for (auto iter = entry.chained_entries.begin();
        iter != entry.chained_entries.end(); ++iter) {
@@ -297,8 +343,6 @@ void ObjectCache::invalidate_lru(ObjectCacheEntry& entry)
 
 void ObjectCache::set_enabled(bool status)
 {
-  std::unique_lock l{lock};
-
   enabled = status;
 
   if (!enabled) {
@@ -308,32 +352,34 @@ void ObjectCache::set_enabled(bool status)
 
 void ObjectCache::invalidate_all()
 {
-  std::unique_lock l{lock};
-
   do_invalidate_all();
 }
 
 void ObjectCache::do_invalidate_all()
 {
-  cache_map.clear();
-  lru.clear();
-
-  lru_size = 0;
-  lru_counter = 0;
-  lru_window = 0;
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    locks.push_back(lock_unique(i));
+  }
+  for (auto& s : shards) {
+    s->cache_map.clear();
+    s->clock.clear();
+    s->hand = s->clock.end();
+  }
 
+  std::lock_guard l{chained_lock};
   for (auto& cache : chained_cache) {
     cache->invalidate_all();
   }
 }
 
 void ObjectCache::chain_cache(RGWChainedCache *cache) {
-  std::unique_lock l{lock};
+  std::lock_guard l{chained_lock};
   chained_cache.push_back(cache);
 }
 
 void ObjectCache::unchain_cache(RGWChainedCache *cache) {
-  std::unique_lock l{lock};
+  std::lock_guard l{chained_lock};
 
   auto iter = chained_cache.begin();
   for (; iter != chained_cache.end(); ++iter) {
@@ -350,5 +396,8 @@ ObjectCache::~ObjectCache()
   for (auto cache : chained_cache) {
     cache->unregistered();
   }
+  if (logger) {
+    cct->get_perfcounters_collection()->remove(logger);
+    delete logger;
+  }
 }
-
@@ -4,13 +4,17 @@
 #ifndef CEPH_RGWCACHE_H
 #define CEPH_RGWCACHE_H
 
-#include <string>
+#include <atomic>
+#include <list>
 #include <map>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include "include/types.h"
 #include "include/utime.h"
 #include "include/ceph_assert.h"
 #include "common/ceph_mutex.h"
+#include "common/perf_counters.h"
 
 #include "cls/version/cls_version_types.h"
 #include "rgw_common.h"
@@ -146,37 +150,69 @@ public:
 
 struct ObjectCacheEntry {
   ObjectCacheInfo info;
-  std::list<string>::iterator lru_iter;
-  uint64_t lru_promotion_ts;
-  uint64_t gen;
+  std::list<string>::iterator clock_iter;
+  std::atomic<bool> referenced = {false};  ///< hit since the clock hand last passed
+  uint64_t gen = 0;
   std::vector<pair<RGWChainedCache *, string> > chained_entries;
-
-  ObjectCacheEntry() : lru_promotion_ts(0), gen(0) {}
 };
 
+/*
+ * The cache is split into shards by hash of the object name, each with
+ * its own lock, map and eviction state, so that lookups of unrelated
+ * objects don't serialize.  Eviction follows the CLOCK (second chance)
+ * algorithm: a hit only sets the entry's referenced bit under the
+ * shard's shared lock, and a put into a full shard sweeps the shard's
+ * clock hand to evict the first entry that was not referenced since
+ * the hand last passed it.
+ */
 class ObjectCache {
-  std::unordered_map<string, ObjectCacheEntry> cache_map;
-  std::list<string> lru;
-  unsigned long lru_size;
-  unsigned long lru_counter;
-  unsigned long lru_window;
-  ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache");
+  struct Shard {
+    ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache::Shard");
+    std::unordered_map<string, ObjectCacheEntry> cache_map;
+    std::list<string> clock;
+    std::list<string>::iterator hand = clock.end();
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  unsigned long shard_size = 0;
   CephContext *cct;
 
+  ceph::mutex chained_lock = ceph::make_mutex("ObjectCache::chained_lock");
   vector<RGWChainedCache *> chained_cache;
 
-  bool enabled;
+  std::atomic<bool> enabled;
   ceph::timespan expiry;
 
-  void touch_lru(const string& name, ObjectCacheEntry& entry,
-		 std::list<string>::iterator& lru_iter);
-  void remove_lru(const string& name, std::list<string>::iterator& lru_iter);
-  void invalidate_lru(ObjectCacheEntry& entry);
+  // per shard perf counters
+  enum {
+    l_rgw_cache_shard_hit,
+    l_rgw_cache_shard_miss,
+    l_rgw_cache_shard_contended,
+    l_rgw_cache_shard_evict,
+    l_rgw_cache_shard_counters,
+  };
+  PerfCounters *logger = nullptr;
+  std::vector<std::string> counter_names;
+
+  size_t shard_of(const std::string& name) const {
+    return std::hash<std::string>{}(name) % shards.size();
+  }
+  void inc(size_t shard, int counter) {
+    if (logger) {
+      logger->inc(1 + shard * l_rgw_cache_shard_counters + counter);
+    }
+  }
+  std::shared_lock<ceph::shared_mutex> lock_shared(size_t shard);
+  std::unique_lock<ceph::shared_mutex> lock_unique(size_t shard);
+
+  void trim(size_t shard, const string& keep);
+  void erase(Shard& s, std::unordered_map<string, ObjectCacheEntry>::iterator iter);
+  void invalidate_chained(ObjectCacheEntry& entry);
 
   void do_invalidate_all();
 
 public:
-  ObjectCache() : lru_size(0), lru_counter(0), lru_window(0), cct(NULL), enabled(false) { }
+  ObjectCache() : cct(NULL), enabled(false) { }
   ~ObjectCache();
   int get(const std::string& name, ObjectCacheInfo& bl, uint32_t mask, rgw_cache_entry_info *cache_info);
   std::optional<ObjectCacheInfo> get(const std::string& name) {
@@ -187,12 +223,14 @@ public:
 
   template<typename F>
   void for_each(const F& f) {
-    std::shared_lock l{lock};
     if (enabled) {
       auto now  = ceph::coarse_mono_clock::now();
-      for (const auto& [name, entry] : cache_map) {
-        if (expiry.count() && (now - entry.info.time_added) < expiry) {
-          f(name, entry);
+      for (auto& s : shards) {
+        std::shared_lock l{s->lock};
+        for (const auto& [name, entry] : s->cache_map) {
+          if (expiry.count() && (now - entry.info.time_added) < expiry) {
+            f(name, entry);
+          }
         }
       }
     }
@@ -200,12 +238,7 @@ public:
 
   void put(const std::string& name, ObjectCacheInfo& bl, rgw_cache_entry_info *cache_info);
   bool remove(const std::string& name);
-  void set_ctx(CephContext *_cct) {
-    cct = _cct;
-    lru_window = cct->_conf->rgw_cache_lru_size / 2;
-    expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
-						"rgw_cache_expiry_interval"));
-  }
+  void set_ctx(CephContext *_cct);
   bool chain_cache_entry(std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 			 RGWChainedCache::Entry *chained_entry);
 
@@ -214,6 +247,10 @@ public:
   void chain_cache(RGWChainedCache *cache);
   void unchain_cache(RGWChainedCache *cache);
   void invalidate_all();
+
+  size_t get_num_shards() const {
+    return shards.size();
+  }
 };
 
 #endif
@@ -39,41 +39,47 @@ int rgw_compression_info_from_attrset(const map<string, bufferlist>& attrs,
 
 //------------RGWPutObj_Compress---------------
 
-int RGWPutObj_Compress::process(bufferlist&& in, uint64_t logical_offset)
+int RGWPutObj_Compress::transform(bufferlist& in, uint64_t logical_offset,
+                                  bufferlist& out)
 {
-  bufferlist out;
-  if (in.length() > 0) {
-    // compression stuff
-    if ((logical_offset > 0 && compressed) || // if previous part was compressed
-        (logical_offset == 0)) {              // or it's the first part
-      ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
-      int cr = compressor->compress(in, out, compressor_message);
-      if (cr < 0) {
-        if (logical_offset > 0) {
-          lderr(cct) << "Compression failed with exit code " << cr
-              << " for next part, compression process failed" << dendl;
-          return -EIO;
-        }
-        compressed = false;
-        ldout(cct, 5) << "Compression failed with exit code " << cr
-            << " for first part, storing uncompressed" << dendl;
-        out = std::move(in);
-      } else {
-        compressed = true;
-    
-        compression_block newbl;
-        size_t bs = blocks.size();
-        newbl.old_ofs = logical_offset;
-        newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
-        newbl.len = out.length();
-        blocks.push_back(newbl);
-      }
-    } else {
-      compressed = false;
-      out = std::move(in);
+  ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
+  boost::optional<int32_t> message;
+  int cr = compressor->compress(in, out, message);
+  if (cr >= 0 && message) {
+    std::lock_guard l{message_lock};
+    compressor_message = message;
+  }
+  return cr;
+}
+
+int RGWPutObj_Compress::complete(int cr, bufferlist&& in, bufferlist&& out,
+                                 uint64_t logical_offset)
+{
+  // compression stuff
+  if (logical_offset > 0 && !compressed) {
+    // the first part was stored uncompressed, so are the rest
+    out = std::move(in);
+  } else if (cr < 0) {
+    if (logical_offset > 0) {
+      lderr(cct) << "Compression failed with exit code " << cr
+          << " for next part, compression process failed" << dendl;
+      return -EIO;
     }
-    // end of compression stuff
+    compressed = false;
+    ldout(cct, 5) << "Compression failed with exit code " << cr
+        << " for first part, storing uncompressed" << dendl;
+    out = std::move(in);
+  } else {
+    compressed = true;
+
+    compression_block newbl;
+    size_t bs = blocks.size();
+    newbl.old_ofs = logical_offset;
+    newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
+    newbl.len = out.length();
+    blocks.push_back(newbl);
   }
+  // end of compression stuff
   return Pipe::process(std::move(out), logical_offset);
 }
 
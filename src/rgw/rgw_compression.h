@@ -7,7 +7,8 @@
 #include <vector>
 
 #include "compressor/Compressor.h"
-#include "rgw_putobj.h"
+#include "common/ceph_mutex.h"
+#include "rgw_putobj_transform.h"
 #include "rgw_op.h"
 #include "rgw_compression_types.h"
 
@@ -40,19 +41,27 @@ public:
 
 };
 
-class RGWPutObj_Compress : public rgw::putobj::Pipe
+class RGWPutObj_Compress : public rgw::putobj::TransformPipe
 {
   CephContext* cct;
   bool compressed{false};
   CompressorRef compressor;
+  ceph::mutex message_lock = ceph::make_mutex("RGWPutObj_Compress::message_lock");
   boost::optional<int32_t> compressor_message;
   std::vector<compression_block> blocks;
+protected:
+  int transform(bufferlist& in, uint64_t logical_offset,
+                bufferlist& out) override;
+  int complete(int r, bufferlist&& in, bufferlist&& out,
+               uint64_t logical_offset) override;
 public:
   RGWPutObj_Compress(CephContext* cct_, CompressorRef compressor,
-                     rgw::putobj::DataProcessor *next)
-    : Pipe(next), cct(cct_), compressor(compressor) {}
-
-  int process(bufferlist&& data, uint64_t logical_offset) override;
+                     rgw::putobj::DataProcessor *next,
+                     boost::asio::thread_pool *pool = nullptr,
+                     optional_yield y = null_yield)
+    : TransformPipe(next, pool, cct_->_conf->rgw_put_obj_min_window_size, y),
+      cct(cct_), compressor(compressor) {}
+  ~RGWPutObj_Compress() override { cancel(); }
 
   bool is_compressed() { return compressed; }
   vector<compression_block>& get_compression_blocks() { return blocks; }
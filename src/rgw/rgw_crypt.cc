@@ -529,14 +529,30 @@ int RGWGetObj_BlockDecrypt::flush() {
 
 RGWPutObj_BlockEncrypt::RGWPutObj_BlockEncrypt(CephContext* cct,
                                                rgw::putobj::DataProcessor *next,
-                                               std::unique_ptr<BlockCrypt> crypt)
-  : Pipe(next),
+                                               std::unique_ptr<BlockCrypt> crypt,
+                                               boost::asio::thread_pool *pool,
+                                               optional_yield y)
+  : TransformPipe(next, pool, cct->_conf->rgw_put_obj_min_window_size, y),
     cct(cct),
     crypt(std::move(crypt)),
     block_size(this->crypt->get_block_size())
 {
 }
 
+RGWPutObj_BlockEncrypt::~RGWPutObj_BlockEncrypt()
+{
+  cancel();
+}
+
+int RGWPutObj_BlockEncrypt::transform(bufferlist& in, uint64_t logical_offset,
+                                      bufferlist& out)
+{
+  if (!crypt->encrypt(in, 0, in.length(), out, logical_offset)) {
+    return -ERR_INTERNAL_ERROR;
+  }
+  return 0;
+}
+
 int RGWPutObj_BlockEncrypt::process(bufferlist&& data, uint64_t logical_offset)
 {
   ldout(cct, 25) << "Encrypt " << data.length() << " bytes" << dendl;
@@ -553,12 +569,9 @@ int RGWPutObj_BlockEncrypt::process(bufferlist&& data, uint64_t logical_offset)
     proc_size = cache.length();
   }
   if (proc_size > 0) {
-    bufferlist in, out;
+    bufferlist in;
     cache.splice(0, proc_size, &in);
-    if (!crypt->encrypt(in, 0, proc_size, out, logical_offset)) {
-      return -ERR_INTERNAL_ERROR;
-    }
-    int r = Pipe::process(std::move(out), logical_offset);
+    int r = TransformPipe::process(std::move(in), logical_offset);
     logical_offset += proc_size;
     if (r < 0)
       return r;
@@ -566,7 +579,7 @@ int RGWPutObj_BlockEncrypt::process(bufferlist&& data, uint64_t logical_offset)
 
   if (flush) {
     /*replicate 0-sized handle_data*/
-    return Pipe::process({}, logical_offset);
+    return TransformPipe::process({}, logical_offset);
   }
   return 0;
 }
@@ -13,7 +13,7 @@
 #include <rgw/rgw_op.h>
 #include <rgw/rgw_rest.h>
 #include <rgw/rgw_rest_s3.h>
-#include "rgw_putobj.h"
+#include "rgw_putobj_transform.h"
 
 /**
  * \brief Interface for block encryption methods
@@ -119,17 +119,23 @@ public:
 }; /* RGWGetObj_BlockDecrypt */
 
 
-class RGWPutObj_BlockEncrypt : public rgw::putobj::Pipe
+class RGWPutObj_BlockEncrypt : public rgw::putobj::TransformPipe
 {
   CephContext* cct;
   std::unique_ptr<BlockCrypt> crypt; /**< already configured stateless BlockCrypt
                                           for operations when enough data is accumulated */
   bufferlist cache; /**< stores extra data that could not (yet) be processed by BlockCrypt */
   const size_t block_size; /**< snapshot of \ref BlockCrypt.get_block_size() */
+protected:
+  int transform(bufferlist& in, uint64_t logical_offset,
+                bufferlist& out) override;
 public:
   RGWPutObj_BlockEncrypt(CephContext* cct,
                          rgw::putobj::DataProcessor *next,
-                         std::unique_ptr<BlockCrypt> crypt);
+                         std::unique_ptr<BlockCrypt> crypt,
+                         boost::asio::thread_pool *pool = nullptr,
+                         optional_yield y = null_yield);
+  ~RGWPutObj_BlockEncrypt() override;
 
   int process(bufferlist&& data, uint64_t logical_offset) override;
 }; /* RGWPutObj_BlockEncrypt */
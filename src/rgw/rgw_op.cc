@@ -3884,7 +3884,8 @@ void RGWPutObj::execute(optional_yield y)
         ldpp_dout(this, 1) << "Cannot load plugin for compression type "
             << compression_type << dendl;
       } else {
-        compressor.emplace(s->cct, plugin, filter);
+        compressor.emplace(s->cct, plugin, filter,
+                           rgw::putobj::get_transform_pool(s->cct), s->yield);
         filter = &*compressor;
       }
     }
@@ -4194,7 +4195,8 @@ void RGWPostObj::execute(optional_yield y)
           ldpp_dout(this, 1) << "Cannot load plugin for compression type "
                            << compression_type << dendl;
         } else {
-          compressor.emplace(s->cct, plugin, filter);
+          compressor.emplace(s->cct, plugin, filter,
+                             rgw::putobj::get_transform_pool(s->cct), s->yield);
           filter = &*compressor;
         }
       }
@@ -7017,7 +7019,8 @@ int RGWBulkUploadOp::handle_file(const std::string_view path,
       ldpp_dout(this, 1) << "Cannot load plugin for rgw_compression_type "
           << compression_type << dendl;
     } else {
-      compressor.emplace(s->cct, plugin, filter);
+      compressor.emplace(s->cct, plugin, filter,
+                         rgw::putobj::get_transform_pool(s->cct), s->yield);
       filter = &*compressor;
     }
   }
@@ -59,6 +59,10 @@ int rgw_perf_start(CephContext *cct)
   plb.add_u64_counter(l_rgw_pubsub_push_failed, "pubsub_push_failed", "Pubsub events failed to be pushed to an endpoint");
   plb.add_u64(l_rgw_pubsub_push_pending, "pubsub_push_pending", "Pubsub events pending reply from endpoint");
   plb.add_u64_counter(l_rgw_pubsub_missing_conf, "pubsub_missing_conf", "Pubsub events could not be handled because of missing configuration");
+
+  plb.add_time_avg(l_rgw_list_ordered_lat, "list_ordered_lat", "Ordered bucket listing page latency");
+  plb.add_u64_counter(l_rgw_list_ordered_index_reads, "list_ordered_index_reads", "Bucket index shard reads for ordered listings");
+  plb.add_u64_counter(l_rgw_list_ordered_index_prefetch, "list_ordered_index_prefetch", "Bucket index shard reads for ordered listings issued ahead of need");
   
   perfcounter = plb.create_perf_counters();
   cct->get_perfcounters_collection()->add(perfcounter);
@@ -50,6 +50,10 @@ enum {
   l_rgw_pubsub_push_pending,
   l_rgw_pubsub_missing_conf,
 
+  l_rgw_list_ordered_lat,
+  l_rgw_list_ordered_index_reads,
+  l_rgw_list_ordered_index_prefetch,
+
   l_rgw_last,
 };
 
@@ -0,0 +1,121 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include <boost/asio/thread_pool.hpp>
+
+#include "rgw_aio_throttle.h"
+#include "rgw_putobj_transform.h"
+
+namespace rgw::putobj {
+
+boost::asio::thread_pool* get_transform_pool(CephContext* cct)
+{
+  static const uint64_t threads =
+    cct->_conf.get_val<uint64_t>("rgw_put_obj_transform_threads");
+  if (!threads) {
+    return nullptr;
+  }
+  static boost::asio::thread_pool pool(threads);
+  return &pool;
+}
+
+TransformPipe::TransformPipe(DataProcessor *next,
+                             boost::asio::thread_pool *pool,
+                             uint64_t window, optional_yield y)
+  : Pipe(next), pool(pool), window(window), y(y)
+{
+  if (pool) {
+    aio = make_throttle(window, y);
+  }
+}
+
+TransformPipe::~TransformPipe()
+{
+  cancel();
+}
+
+void TransformPipe::cancel()
+{
+  if (aio) {
+    aio->drain();
+  }
+}
+
+int TransformPipe::complete(int r, bufferlist&& in, bufferlist&& out,
+                            uint64_t offset)
+{
+  if (r < 0) {
+    return r;
+  }
+  return Pipe::process(std::move(out), offset);
+}
+
+int TransformPipe::process_completed(AioResultList&& results)
+{
+  auto cmp = [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; };
+  results.sort(cmp); // merge() requires results to be sorted first
+  completed.merge(results, cmp); // merge results in sorted order
+
+  while (!completed.empty() && !pending.empty() &&
+         completed.front().id == pending.begin()->first) {
+    auto& e = completed.front();
+    const int result = e.result;
+    const uint64_t offset = e.id;
+    auto out = std::move(e.data);
+    completed.pop_front_and_dispose(std::default_delete<AioResultEntry>{});
+
+    auto in = std::move(pending.begin()->second);
+    pending.erase(pending.begin());
+
+    int r = complete(result, std::move(in), std::move(out), offset);
+    if (r < 0) {
+      return r;
+    }
+  }
+  return 0;
+}
+
+int TransformPipe::process(bufferlist&& data, uint64_t offset)
+{
+  if (aio) {
+    // flushes, and buffers the throttle couldn't take, wait for the
+    // transforms in progress so that the output stays in order
+    if (data.length() == 0 || data.length() > window) {
+      int r = process_completed(aio->drain());
+      if (r < 0) {
+        return r;
+      }
+    }
+    if (data.length() == 0) {
+      return Pipe::process({}, offset);
+    }
+    if (data.length() <= window) {
+      pending.emplace(offset, data);
+      auto f = [this, in = std::move(data), offset] (bufferlist& out) mutable {
+        return transform(in, offset, out);
+      };
+      const uint64_t cost = pending.rbegin()->second.length();
+      return process_completed(
+        aio->get(RGWSI_RADOS::Obj{}, Aio::work_op(*pool, std::move(f), y),
+                 cost, offset));
+    }
+  } else if (data.length() == 0) {
+    return Pipe::process({}, offset);
+  }
+
+  bufferlist out;
+  int r = transform(data, offset, out);
+  return complete(r, std::move(data), std::move(out), offset);
+}
+
+} // namespace rgw::putobj
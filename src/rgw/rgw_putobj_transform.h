@@ -0,0 +1,66 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "rgw_aio.h"
+#include "rgw_putobj.h"
+
+namespace rgw::putobj {
+
+// the threads that upload transforms run on, or nullptr if
+// rgw_put_obj_transform_threads is 0
+boost::asio::thread_pool* get_transform_pool(CephContext* cct);
+
+// pipe for a cpu-bound transform of the data, like compression or
+// encryption. without a thread pool each buffer is transformed when it is
+// processed. with one, the transforms of several buffers run on the pool
+// at once, up to a window of bytes, while the request goes on reading
+// from the client and writing out earlier results. results are passed to
+// complete() in offset order either way, so the next processor sees the
+// same buffers at the same offsets
+class TransformPipe : public Pipe {
+  boost::asio::thread_pool *pool;
+  uint64_t window;
+  optional_yield y;
+  std::unique_ptr<Aio> aio;
+  std::map<uint64_t, bufferlist> pending; // inputs of transforms by offset
+  AioResultList completed; // completed transforms, sorted by offset
+
+  int process_completed(AioResultList&& results);
+ protected:
+  // transform 'in', which starts at the given object offset, into 'out'.
+  // with a pool this runs on its threads, concurrently with other calls
+  virtual int transform(bufferlist& in, uint64_t offset, bufferlist& out) = 0;
+
+  // called in offset order with the result of each transform. passes the
+  // output on unless the transform failed
+  virtual int complete(int r, bufferlist&& in, bufferlist&& out,
+                       uint64_t offset);
+
+  // wait for any transforms in progress and drop their results. derived
+  // classes must call this on destruction, as transforms use their state
+  void cancel();
+ public:
+  TransformPipe(DataProcessor *next, boost::asio::thread_pool *pool,
+                uint64_t window, optional_yield y);
+  ~TransformPipe() override;
+
+  // an empty bufferlist waits for all transforms before it's passed on
+  int process(bufferlist&& data, uint64_t offset) override;
+};
+
+} // namespace rgw::putobj
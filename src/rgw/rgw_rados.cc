@@ -42,6 +42,7 @@
 #include "osd/osd_types.h"
 
 #include "rgw_tools.h"
+#include "rgw_perf_counters.h"
 #include "rgw_coroutine.h"
 #include "rgw_compression.h"
 #include "rgw_etag_verifier.h"
@@ -1771,6 +1772,7 @@ int RGWRados::Bucket::List::list_objects_ordered(
   RGWRados *store = target->get_store();
   CephContext *cct = store->ctx();
   int shard_id = target->get_shard_id();
+  const auto start = ceph::mono_clock::now();
 
   int count = 0;
   bool truncated = true;
@@ -1778,6 +1780,9 @@ int RGWRados::Bucket::List::list_objects_ordered(
   const int64_t max = // protect against memory issues and negative vals
     std::min(bucket_list_objects_absolute_max, std::max(int64_t(0), max_p));
   int read_ahead = std::max(cct->_conf->rgw_list_bucket_min_readahead, max);
+  // what was read from the index shards, so that later attempts only
+  // read from the shards that ran out
+  RGWRados::BucketListCursors cursors;
 
   result->clear();
 
@@ -1842,7 +1847,9 @@ int RGWRados::Bucket::List::list_objects_ordered(
 					   &truncated,
 					   &cls_filtered,
 					   &cur_marker,
-                                           y);
+                                           y,
+					   nullptr,
+					   &cursors);
     if (r < 0) {
       return r;
     }
@@ -2018,6 +2025,9 @@ done:
   if (is_truncated) {
     *is_truncated = truncated;
   }
+  if (perfcounter) {
+    perfcounter->tinc(l_rgw_list_ordered_lat, ceph::mono_clock::now() - start);
+  }
 
   return 0;
 } // list_objects_ordered
@@ -6296,19 +6306,40 @@ int RGWRados::Object::Read::read(int64_t ofs, int64_t end, bufferlist& bl, optio
   return bl.length();
 }
 
+// shared by all object reads, to bound the memory their windows pin
+static rgw::WindowBudget get_obj_window_budget;
+
 struct get_obj_data {
   RGWRados* store;
   RGWGetDataCB* client_cb;
   rgw::Aio* aio;
+  rgw::AdaptiveReadWindow* window;
   uint64_t offset; // next offset to write to client
+  uint64_t outstanding = 0; // bytes issued but not yet written to client
+  std::map<uint64_t, ceph::mono_time> issued; // start of pending reads by id
   rgw::AioResultList completed; // completed read results, sorted by offset
   optional_yield yield;
 
   get_obj_data(RGWRados* store, RGWGetDataCB* cb, rgw::Aio* aio,
+               rgw::AdaptiveReadWindow* window,
                uint64_t offset, optional_yield yield)
-    : store(store), client_cb(cb), aio(aio), offset(offset), yield(yield) {}
+    : store(store), client_cb(cb), aio(aio), window(window),
+      offset(offset), yield(yield) {}
+
+  // waited is true if the results are what we blocked on, so that the
+  // time since they were issued is their latency
+  int flush(rgw::AioResultList&& results, bool waited = false) {
+    const auto now = ceph::mono_clock::now();
+    for (auto& e : results) {
+      auto i = issued.find(e.id);
+      if (i != issued.end()) {
+        if (waited) {
+          window->add_read_latency(now - i->second);
+        }
+        issued.erase(i);
+      }
+    }
 
-  int flush(rgw::AioResultList&& results) {
     int r = rgw::check_for_errors(results);
     if (r < 0) {
       return r;
@@ -6322,8 +6353,34 @@ struct get_obj_data {
       auto bl = std::move(completed.front().data);
       completed.pop_front_and_dispose(std::default_delete<rgw::AioResultEntry>{});
 
-      offset += bl.length();
-      int r = client_cb->handle_data(bl, 0, bl.length());
+      const uint64_t len = bl.length();
+      offset += len;
+      outstanding -= std::min(outstanding, len);
+      const auto start = ceph::mono_clock::now();
+      int r = client_cb->handle_data(bl, 0, len);
+      if (r < 0) {
+        return r;
+      }
+      window->add_client_write(len, ceph::mono_clock::now() - start);
+    }
+    return 0;
+  }
+
+  // flush the next completions, waiting for one if there are none
+  int wait_and_flush() {
+    auto c = aio->poll();
+    const bool waited = c.empty();
+    if (waited) {
+      c = aio->wait();
+    }
+    return flush(std::move(c), waited);
+  }
+
+  // hand completed reads to the client until another read of len bytes
+  // fits in the window
+  int throttle(uint64_t len) {
+    while (!issued.empty() && outstanding + len > window->get()) {
+      int r = wait_and_flush();
       if (r < 0) {
         return r;
       }
@@ -6337,16 +6394,14 @@ struct get_obj_data {
   }
 
   int drain() {
-    auto c = aio->wait();
-    while (!c.empty()) {
-      int r = flush(std::move(c));
+    while (!issued.empty()) {
+      int r = wait_and_flush();
       if (r < 0) {
         cancel();
         return r;
       }
-      c = aio->wait();
     }
-    return flush(std::move(c));
+    return flush(aio->drain());
   }
 };
 
@@ -6404,6 +6459,13 @@ int RGWRados::get_obj_iterate_cb(const rgw_raw_obj& read_obj, off_t obj_ofs,
   const uint64_t cost = len;
   const uint64_t id = obj_ofs; // use logical object offset for sorting replies
 
+  r = d->throttle(cost);
+  if (r < 0) {
+    return r;
+  }
+  d->issued[id] = ceph::mono_clock::now();
+  d->outstanding += cost;
+
   auto completed = d->aio->get(obj, rgw::Aio::librados_op(std::move(op), d->yield), cost, id);
 
   return d->flush(std::move(completed));
@@ -6417,9 +6479,17 @@ int RGWRados::Object::Read::iterate(int64_t ofs, int64_t end, RGWGetDataCB *cb,
   RGWObjectCtx& obj_ctx = source->get_ctx();
   const uint64_t chunk_size = cct->_conf->rgw_get_obj_max_req_size;
   const uint64_t window_size = cct->_conf->rgw_get_obj_window_size;
-
-  auto aio = rgw::make_throttle(window_size, y);
-  get_obj_data data(store, cb, &*aio, ofs, y);
+  const uint64_t max_window_size = std::max<uint64_t>(chunk_size,
+      cct->_conf.get_val<Option::size_t>("rgw_get_obj_max_window_size"));
+  const uint64_t window_budget =
+    cct->_conf.get_val<Option::size_t>("rgw_get_obj_window_budget");
+
+  // the throttle only enforces the largest window; the adaptive window
+  // below decides how much of it this read uses
+  auto aio = rgw::make_throttle(max_window_size, y);
+  rgw::AdaptiveReadWindow window(get_obj_window_budget, window_budget,
+                                 chunk_size, window_size, max_window_size);
+  get_obj_data data(store, cb, &*aio, &window, ofs, y);
 
   int r = store->iterate_obj(obj_ctx, source->get_bucket_info(), state.obj,
                              ofs, end, chunk_size, _get_obj_iterate_cb, &data, y);
@@ -8290,6 +8360,276 @@ uint32_t RGWRados::calc_ordered_bucket_list_per_shard(uint32_t num_entries,
 }
 
 
+void RGWRados::BucketListCursors::reset()
+{
+  if (aio) {
+    // the reads issued ahead decode into the shards
+    aio->drain();
+    aio.reset();
+  }
+  shards.clear();
+  last_name.clear();
+  consumed = 0;
+  cls_filtered = true;
+  valid = false;
+}
+
+void RGWRados::BucketListCursors::set_result(Shard& s,
+					     rgw_cls_list_ret&& result)
+{
+  s.result = std::move(result);
+  s.cursor = s.result.dir.m.begin();
+  if (!s.result.dir.m.empty()) {
+    s.next_start = s.result.dir.m.rbegin()->second.key;
+  }
+  cls_filtered = cls_filtered && s.result.cls_filtered;
+}
+
+// how many entries to ask a shard for: its share of what was merged so
+// far (smoothed, so shards yet to contribute aren't starved) of what is
+// still needed, with some margin
+static uint32_t calc_ordered_bucket_list_refill(
+  const RGWRados::BucketListCursors& cursors,
+  const RGWRados::BucketListCursors::Shard& s,
+  uint32_t remaining)
+{
+  constexpr uint32_t min_read = 8;
+  const double share = double(s.consumed + 1) /
+    (cursors.consumed + cursors.shards.size());
+  const uint32_t want = 1 + static_cast<uint32_t>(2 * remaining * share);
+  return std::clamp(want, min_read, std::max(remaining, min_read));
+}
+
+int RGWRados::BucketListCursors::merge(CephContext *cct,
+				       uint32_t num_entries,
+				       const read_func& read,
+				       const prefetch_func& prefetch,
+				       const visit_func& visit,
+				       uint32_t *count,
+				       bool *is_truncated,
+				       std::optional<rgw_obj_index_key> *last_entry)
+{
+  // a shard that is truncated must be read again once its entries run
+  // out, as its next entry could be anybody's next; a read that returns
+  // nothing although truncated (everything it scanned was filtered) is
+  // retried with a larger request a few times before giving up on the
+  // page, as S3 and swift protocols allow returning fewer than what was
+  // requested
+  constexpr int max_empty_reads = 4;
+  auto refill = [&](Shard& s, uint32_t remaining) {
+    uint32_t want = calc_ordered_bucket_list_refill(*this, s, remaining);
+    for (int i = 0; i < max_empty_reads && s.at_end() &&
+	   s.result.is_truncated; ++i) {
+      ldout(cct, 20) << "RGWRados::" << __func__ << " reading " << want <<
+	" more entries from shard " << s.shard_id << dendl;
+      int r = read(s, want);
+      if (r < 0) {
+	return r;
+      }
+      want *= 2;
+    }
+    return 0;
+  };
+  // start reading a shard ahead if it is expected to run out before
+  // this merge is done
+  auto maybe_prefetch = [&](Shard& s, uint32_t remaining) {
+    if (!prefetch || s.prefetching || !s.result.is_truncated ||
+	s.result.dir.m.empty()) {
+      return;
+    }
+    const double share = double(s.consumed + 1) /
+      (consumed + shards.size());
+    if (remaining * share <= s.left()) {
+      return;
+    }
+    prefetch(s, calc_ordered_bucket_list_refill(*this, s,
+						remaining - s.left()));
+  };
+
+  // min-heap of the shards by their next entry; ties are common
+  // prefixes found in several shards, of which only the first is kept
+  auto heap_cmp = [&](size_t a, size_t b) {
+    return shards[a]->cursor->first > shards[b]->cursor->first;
+  };
+  std::vector<size_t> heap;
+  heap.reserve(shards.size());
+  for (size_t i = 0; i < shards.size(); ++i) {
+    auto& s = *shards[i];
+    int r = refill(s, num_entries);
+    if (r < 0) {
+      return r;
+    }
+    if (!s.at_end()) {
+      heap.push_back(i);
+    } else if (s.result.is_truncated) {
+      // can't tell what comes next, so nothing the other shards have
+      // can be returned either
+      ldout(cct, 10) << "RGWRados::" << __func__ << " shard " << s.shard_id <<
+	" has no entries to merge although truncated" << dendl;
+      *count = 0;
+      *is_truncated = true;
+      last_entry->reset();
+      valid = false;
+      return 0;
+    }
+  }
+  std::make_heap(heap.begin(), heap.end(), heap_cmp);
+
+  std::optional<rgw_obj_index_key> last_entry_visited;
+  // a common prefix may have been returned by the previous merge
+  bool have_last = !last_name.empty();
+  std::string last = last_name;
+  *count = 0;
+  bool stalled = false;
+  while (*count < num_entries && !heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+    const size_t idx = heap.back();
+    heap.pop_back();
+    auto& s = *shards[idx];
+
+    const string& name = s.cursor->first;
+    rgw_bucket_dir_entry& dirent = s.cursor->second;
+
+    if (have_last && name == last) {
+      ldout(cct, 20) << "RGWRados::" << __func__ << " skipping duplicate " <<
+	name << " from shard " << s.shard_id << dendl;
+    } else {
+      ldout(cct, 20) << "RGWRados::" << __func__ << " currently processing " <<
+	dirent.key << " from shard " << s.shard_id << dendl;
+
+      last_entry_visited = dirent.key;
+      int r = visit(s, name, dirent);
+      if (r < 0 && r != -ENOENT) {
+	return r;
+      }
+      last = name;
+      have_last = true;
+      if (r >= 0) {
+	++*count;
+      }
+    }
+
+    ++s.cursor;
+    ++s.consumed;
+    ++consumed;
+
+    int r = refill(s, num_entries - *count);
+    if (r < 0) {
+      return r;
+    }
+    if (!s.at_end()) {
+      maybe_prefetch(s, num_entries - *count);
+      heap.push_back(idx);
+      std::push_heap(heap.begin(), heap.end(), heap_cmp);
+    } else if (s.result.is_truncated) {
+      // can't tell what comes next
+      stalled = true;
+      break;
+    }
+  } // while we haven't provided requested # of result entries
+
+  // determine truncation by checking if all the returned entries are
+  // consumed or not
+  *is_truncated = false;
+  for (const auto& s : shards) {
+    if (!s->at_end() || s->result.is_truncated) {
+      *is_truncated = true;
+      break;
+    }
+  }
+
+  if (last_entry_visited) {
+    // a following merge starting here can continue from the cursors
+    marker = *last_entry_visited;
+    last_name = last;
+    if (stalled) {
+      valid = false;
+    }
+  } else {
+    valid = false;
+  }
+  *last_entry = std::move(last_entry_visited);
+  return 0;
+}
+
+// note the results of the reads issued ahead that completed
+static void ordered_bucket_list_prefetched(
+  RGWRados::BucketListCursors& cursors,
+  rgw::AioResultList&& completed)
+{
+  for (auto& c : completed) {
+    // the shards are in shard id order
+    auto s = std::lower_bound(
+      cursors.shards.begin(), cursors.shards.end(), int(c.id),
+      [] (const auto& s, int id) { return s->shard_id < id; });
+    ceph_assert(s != cursors.shards.end() && (*s)->shard_id == int(c.id));
+    (*s)->prefetch_done = true;
+    (*s)->prefetch_result = c.result;
+  }
+}
+
+static void ordered_bucket_list_prefetch(
+  RGWRados::BucketListCursors& cursors,
+  RGWRados::BucketListCursors::Shard& s,
+  uint32_t num_entries,
+  optional_yield y)
+{
+  if (!cursors.aio) {
+    // a shard has one read ahead at most, so issuing one never waits
+    // for room in the window
+    cursors.aio = rgw::make_throttle(cursors.shards.size(), y);
+  }
+  librados::ObjectReadOperation op;
+  s.prefetched = rgw_cls_list_ret();
+  cls_rgw_bucket_list_op(op, s.next_start, cursors.prefix, cursors.delimiter,
+			 num_entries, cursors.list_versions, &s.prefetched);
+  s.prefetching = true;
+  s.prefetch_done = false;
+  s.last_read = num_entries;
+  ordered_bucket_list_prefetched(
+    cursors, cursors.aio->get(s.obj, rgw::Aio::librados_op(std::move(op), y),
+			      1, s.shard_id));
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_list_ordered_index_prefetch);
+  }
+}
+
+// get the entries following those merged from a shard, from a read
+// issued ahead if there is one
+static int ordered_bucket_list_refill(
+  RGWRados::BucketListCursors& cursors,
+  RGWRados::BucketListCursors::Shard& s,
+  uint32_t num_entries,
+  optional_yield y)
+{
+  if (s.prefetching) {
+    // yields rather than blocks when there's a yield context
+    while (!s.prefetch_done) {
+      ordered_bucket_list_prefetched(cursors, cursors.aio->wait());
+    }
+    s.prefetching = false;
+    if (s.prefetch_result >= 0) {
+      cursors.set_result(s, std::move(s.prefetched));
+      return 0;
+    }
+    // read it again below
+  }
+  rgw_cls_list_ret result;
+  librados::ObjectReadOperation op;
+  cls_rgw_bucket_list_op(op, s.next_start, cursors.prefix, cursors.delimiter,
+			 num_entries, cursors.list_versions, &result);
+  int r = rgw_rados_operate(cursors.ioctx, s.oid, &op, nullptr, y);
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_list_ordered_index_reads);
+  }
+  if (r < 0) {
+    return r;
+  }
+  s.last_read = num_entries;
+  cursors.set_result(s, std::move(result));
+  return 0;
+}
+
 int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
 				      const int shard_id,
 				      const rgw_obj_index_key& start_after,
@@ -8303,7 +8643,8 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
 				      bool* cls_filtered,
 				      rgw_obj_index_key *last_entry,
                                       optional_yield y,
-				      check_filter_t force_check_filter)
+				      check_filter_t force_check_filter,
+				      BucketListCursors *cursors)
 {
   /* expansion_factor allows the number of entries to read to grow
    * exponentially; this is used when earlier reads are producing too
@@ -8320,196 +8661,136 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
 
   m.clear();
 
-  RGWSI_RADOS::Pool index_pool;
-  // key   - oid (for different shards if there is any)
-  // value - list result for the corresponding oid (shard), it is filled by
-  //         the AIO callback
-  map<int, string> shard_oids;
-  int r = svc.bi_rados->open_bucket_index(bucket_info, shard_id,
-					  &index_pool, &shard_oids,
-					  nullptr);
-  if (r < 0) {
-    return r;
+  BucketListCursors local_cursors;
+  if (!cursors) {
+    cursors = &local_cursors;
   }
-
-  const uint32_t shard_count = shard_oids.size();
-  uint32_t num_entries_per_shard;
-  if (expansion_factor == 0) {
-    num_entries_per_shard =
-      calc_ordered_bucket_list_per_shard(num_entries, shard_count);
-  } else if (expansion_factor <= 11) {
-    // we'll max out the exponential multiplication factor at 1024 (2<<10)
-    num_entries_per_shard =
-      std::min(num_entries,
-	       (uint32_t(1 << (expansion_factor - 1)) *
-		calc_ordered_bucket_list_per_shard(num_entries, shard_count)));
+  if (cursors->valid &&
+      cursors->shard_id == shard_id &&
+      cursors->prefix == prefix &&
+      cursors->delimiter == delimiter &&
+      cursors->list_versions == list_versions &&
+      cursors->marker == start_after) {
+    ldout(cct, 10) << "RGWRados::" << __func__ <<
+      " continuing from the entries read from " << cursors->shards.size() <<
+      " shard(s)" << dendl;
   } else {
-    num_entries_per_shard = num_entries;
-  }
+    cursors->reset();
+
+    RGWSI_RADOS::Pool index_pool;
+    // key   - oid (for different shards if there is any)
+    // value - list result for the corresponding oid (shard), it is filled by
+    //         the AIO callback
+    map<int, string> shard_oids;
+    int r = svc.bi_rados->open_bucket_index(bucket_info, shard_id,
+					    &index_pool, &shard_oids,
+					    nullptr);
+    if (r < 0) {
+      return r;
+    }
 
-  ldout(cct, 10) << "RGWRados::" << __func__ <<
-    " request from each of " << shard_count <<
-    " shard(s) for " << num_entries_per_shard << " entries to get " <<
-    num_entries << " total entries" << dendl;
+    const uint32_t shard_count = shard_oids.size();
+    uint32_t num_entries_per_shard;
+    if (expansion_factor == 0) {
+      num_entries_per_shard =
+	calc_ordered_bucket_list_per_shard(num_entries, shard_count);
+    } else if (expansion_factor <= 11) {
+      // we'll max out the exponential multiplication factor at 1024 (2<<10)
+      num_entries_per_shard =
+	std::min(num_entries,
+		 (uint32_t(1 << (expansion_factor - 1)) *
+		  calc_ordered_bucket_list_per_shard(num_entries, shard_count)));
+    } else {
+      num_entries_per_shard = num_entries;
+    }
 
-  auto& ioctx = index_pool.ioctx();
-  map<int, rgw_cls_list_ret> shard_list_results;
-  cls_rgw_obj_key start_after_key(start_after.name, start_after.instance);
-  r = CLSRGWIssueBucketList(ioctx, start_after_key, prefix, delimiter,
-			    num_entries_per_shard,
-			    list_versions, shard_oids, shard_list_results,
-			    cct->_conf->rgw_bucket_index_max_aio)();
-  if (r < 0) {
-    return r;
-  }
+    ldout(cct, 10) << "RGWRados::" << __func__ <<
+      " request from each of " << shard_count <<
+      " shard(s) for " << num_entries_per_shard << " entries to get " <<
+      num_entries << " total entries" << dendl;
+
+    map<int, rgw_cls_list_ret> shard_list_results;
+    cls_rgw_obj_key start_after_key(start_after.name, start_after.instance);
+    r = CLSRGWIssueBucketList(index_pool.ioctx(), start_after_key, prefix,
+			      delimiter, num_entries_per_shard,
+			      list_versions, shard_oids, shard_list_results,
+			      cct->_conf->rgw_bucket_index_max_aio)();
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_list_ordered_index_reads, shard_count);
+    }
+    if (r < 0) {
+      return r;
+    }
 
-  // to manage the iterators through each shard's list results
-  struct ShardTracker {
-    const size_t shard_idx;
-    rgw_cls_list_ret& result;
-    const std::string& oid_name;
-    RGWRados::ent_map_t::iterator cursor;
-    RGWRados::ent_map_t::iterator end;
-
-    // manages an iterator through a shard and provides other
-    // accessors
-    ShardTracker(size_t _shard_idx,
-		 rgw_cls_list_ret& _result,
-		 const std::string& _oid_name):
-      shard_idx(_shard_idx),
-      result(_result),
-      oid_name(_oid_name),
-      cursor(_result.dir.m.begin()),
-      end(_result.dir.m.end())
-    {}
-
-    inline const std::string& entry_name() const {
-      return cursor->first;
-    }
-    rgw_bucket_dir_entry& dir_entry() const {
-      return cursor->second;
-    }
-    inline bool is_truncated() const {
-      return result.is_truncated;
-    }
-    inline ShardTracker& advance() {
-      ++cursor;
-      // return a self-reference to allow for chaining of calls, such
-      // as x.advance().at_end()
-      return *this;
-    }
-    inline bool at_end() const {
-      return cursor == end;
-    }
-  }; // ShardTracker
-
-  // add the next unique candidate, or return false if we reach the end
-  auto next_candidate = [] (CephContext *cct, ShardTracker& t,
-                            std::map<std::string, size_t>& candidates,
-                            size_t tracker_idx) {
-    while (!t.at_end()) {
-      if (candidates.emplace(t.entry_name(), tracker_idx).second) {
-        return;
-      }
-      t.advance(); // skip duplicate common prefixes
+    cursors->shard_id = shard_id;
+    cursors->prefix = prefix;
+    cursors->delimiter = delimiter;
+    cursors->list_versions = list_versions;
+    cursors->ioctx = index_pool.ioctx();
+    // one cursor per shard requested (may not be all shards)
+    cursors->shards.reserve(shard_list_results.size());
+    for (auto& r : shard_list_results) {
+      auto s = std::make_unique<BucketListCursors::Shard>();
+      s->shard_id = r.first;
+      s->oid = shard_oids[r.first];
+      s->next_start = start_after_key;
+      s->last_read = num_entries_per_shard;
+      s->obj = svc.rados->obj(index_pool, s->oid);
+      cursors->set_result(*s, std::move(r.second));
+      cursors->shards.push_back(std::move(s));
     }
-  };
+    cursors->valid = true;
+  }
 
-  // one tracker per shard requested (may not be all shards)
-  std::vector<ShardTracker> results_trackers;
-  results_trackers.reserve(shard_list_results.size());
-  for (auto& r : shard_list_results) {
-    results_trackers.emplace_back(r.first, r.second, shard_oids[r.first]);
-
-    // if any *one* shard's result is trucated, the entire result is
-    // truncated
-    *is_truncated = *is_truncated || r.second.is_truncated;
-
-    // unless *all* are shards are cls_filtered, the entire result is
-    // not filtered
-    *cls_filtered = *cls_filtered && r.second.cls_filtered;
-  }
-
-  // create a map to track the next candidate entry from ShardTracker
-  // (key=candidate, value=index into results_trackers); as we consume
-  // entries from shards, we replace them with the next entries in the
-  // shards until we run out
-  map<string, size_t> candidates;
-  size_t tracker_idx = 0;
-  for (auto& t : results_trackers) {
-    // it's important that the values in the map refer to the index
-    // into the results_trackers vector, which may not be the same
-    // as the shard number (i.e., when not all shards are requested)
-    next_candidate(cct, t, candidates, tracker_idx);
-    ++tracker_idx;
-  }
-
-  rgw_bucket_dir_entry*
-    last_entry_visited = nullptr; // to set last_entry (marker)
   map<string, bufferlist> updates;
-  uint32_t count = 0;
-  while (count < num_entries && !candidates.empty()) {
-    r = 0;
-    // select the next entry in lexical order (first key in map);
-    // again tracker_idx is not necessarily shard number, but is index
-    // into results_trackers vector
-    tracker_idx = candidates.begin()->second;
-    auto& tracker = results_trackers.at(tracker_idx);
-
-    const string& name = tracker.entry_name();
-    rgw_bucket_dir_entry& dirent = tracker.dir_entry();
-
-    ldout(cct, 20) << "RGWRados::" << __func__ << " currently processing " <<
-      dirent.key << " from shard " << tracker.shard_idx << dendl;
-
+  auto visit = [&](BucketListCursors::Shard& s, const string& name,
+		   rgw_bucket_dir_entry& dirent) {
     const bool force_check =
       force_check_filter && force_check_filter(dirent.key.name);
 
+    int r = 0;
     if ((!dirent.exists &&
 	 !dirent.is_delete_marker() &&
 	 !dirent.is_common_prefix()) ||
-        !dirent.pending_map.empty() ||
-        force_check) {
+	!dirent.pending_map.empty() ||
+	force_check) {
       /* there are uncommitted ops. We need to check the current
        * state, and if the tags are old we need to do clean-up as
        * well. */
       librados::IoCtx sub_ctx;
-      sub_ctx.dup(ioctx);
+      sub_ctx.dup(cursors->ioctx);
       r = check_disk_state(sub_ctx, bucket_info, dirent, dirent,
-			   updates[tracker.oid_name], y);
+			   updates[s.oid], y);
       if (r < 0 && r != -ENOENT) {
 	return r;
       }
-    } else {
-      r = 0;
     }
 
     if (r >= 0) {
       ldout(cct, 10) << "RGWRados::" << __func__ << ": got " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
       m[name] = std::move(dirent);
-      last_entry_visited = &(m[name]);
-      ++count;
     } else {
       ldout(cct, 10) << "RGWRados::" << __func__ << ": skipping " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
-      last_entry_visited = &tracker.dir_entry();
     }
+    return r;
+  };
 
-    // refresh the candidates map
-    candidates.erase(candidates.begin());
-    tracker.advance();
-
-    next_candidate(cct, tracker, candidates, tracker_idx);
-
-    if (tracker.at_end() && tracker.is_truncated()) {
-      // once we exhaust one shard that is truncated, we need to stop,
-      // as we cannot be certain that one of the next entries needs to
-      // come from that shard; S3 and swift protocols allow returning
-      // fewer than what was requested
-      break;
-    }
-  } // while we haven't provided requested # of result entries
+  uint32_t count = 0;
+  std::optional<rgw_obj_index_key> last_entry_visited; // to set last_entry (marker)
+  int r = cursors->merge(
+    cct, num_entries,
+    [&](BucketListCursors::Shard& s, uint32_t n) {
+      return ordered_bucket_list_refill(*cursors, s, n, y);
+    },
+    [&](BucketListCursors::Shard& s, uint32_t n) {
+      ordered_bucket_list_prefetch(*cursors, s, n, y);
+    },
+    visit, &count, is_truncated, &last_entry_visited);
+  if (r < 0) {
+    return r;
+  }
 
   // suggest updates if there are any
   for (auto& miter : updates) {
@@ -8519,20 +8800,16 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
       // we don't care if we lose suggested updates, send them off blindly
       AioCompletion *c =
 	librados::Rados::aio_create_completion(nullptr, nullptr);
-      ioctx.aio_operate(miter.first, c, &o);
+      cursors->ioctx.aio_operate(miter.first, c, &o);
       c->release();
     }
   } // updates loop
 
-  // determine truncation by checking if all the returned entries are
-  // consumed or not
-  *is_truncated = false;
-  for (const auto& t : results_trackers) {
-    if (!t.at_end() || t.is_truncated()) {
-      *is_truncated = true;
-      break;
-    }
-  }
+  // unless *all* are shards are cls_filtered, the entire result is
+  // not filtered; the cursors remember this across calls, so don't
+  // fold in what the caller started with, which would keep a caller
+  // that starts out with false from ever trusting the OSD's grouping
+  *cls_filtered = cursors->cls_filtered;
 
   ldout(cct, 20) << "RGWRados::" << __func__ <<
     ": returning, count=" << count << ", is_truncated=" << *is_truncated <<
@@ -8544,11 +8821,11 @@ int RGWRados::cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
       count << ", which is truncated" << dendl;
   }
 
-  if (last_entry_visited != nullptr && last_entry) {
-    *last_entry = last_entry_visited->key;
+  if (last_entry_visited && last_entry) {
+    *last_entry = *last_entry_visited;
     ldout(cct, 20) << "RGWRados::" << __func__ <<
       ": returning, last_entry=" << *last_entry << dendl;
-  } else {
+  } else if (!last_entry_visited) {
     ldout(cct, 20) << "RGWRados::" << __func__ <<
       ": returning, last_entry NOT SET" << dendl;
   }
@@ -14,6 +14,7 @@
 #include "common/ceph_time.h"
 #include "rgw_common.h"
 #include "cls/rgw/cls_rgw_types.h"
+#include "cls/rgw/cls_rgw_ops.h"
 #include "cls/version/cls_version_types.h"
 #include "cls/log/cls_log_types.h"
 #include "cls/timeindex/cls_timeindex_types.h"
@@ -27,6 +28,7 @@
 #include "rgw_trim_bilog.h"
 #include "rgw_service.h"
 #include "rgw_sal.h"
+#include "rgw_aio.h"
 
 #include "services/svc_rados.h"
 #include "services/svc_bi_rados.h"
@@ -1382,6 +1384,78 @@ public:
 
   using check_filter_t = bool (*)(const std::string&);
 
+  /**
+   * The entries read from each index shard for an ordered listing and
+   * how far the merge got in each of them.  When the same cursors are
+   * passed to a call of cls_bucket_list_ordered() that continues where
+   * the previous one stopped, only the shards whose entries ran out are
+   * read again.
+   */
+  struct BucketListCursors {
+    struct Shard {
+      int shard_id;
+      std::string oid;
+      RGWSI_RADOS::Obj obj;        ///< for the reads issued ahead
+      rgw_cls_list_ret result;
+      decltype(rgw_bucket_dir::m)::iterator cursor;
+      cls_rgw_obj_key next_start;  ///< where the next read starts after
+      uint32_t consumed = 0;       ///< entries merged from this shard
+      uint32_t last_read = 0;      ///< size of the last request
+      /// read of the entries following result, issued ahead of need
+      bool prefetching = false;
+      bool prefetch_done = false;
+      int prefetch_result = 0;
+      rgw_cls_list_ret prefetched;
+
+      size_t left() const {
+	return result.dir.m.end() - cursor;
+      }
+      bool at_end() const {
+	return cursor == result.dir.m.end();
+      }
+    };
+
+    /// replaces a shard's entries with those following them
+    using read_func = std::function<int(Shard& s, uint32_t num_entries)>;
+    /// may start reading the entries following a shard's ahead of need
+    using prefetch_func = std::function<void(Shard& s, uint32_t num_entries)>;
+    /// given each entry not merged before; returns 0 to keep it,
+    /// -ENOENT to drop it, or another error to stop the merge
+    using visit_func = std::function<int(Shard& s, const std::string& name,
+					 rgw_bucket_dir_entry& dirent)>;
+
+    bool valid = false;
+    int shard_id = -1;
+    std::string prefix;
+    std::string delimiter;
+    bool list_versions = false;
+    rgw_obj_index_key marker;  ///< where the previous call stopped
+    std::string last_name;     ///< and the name of that entry
+    bool cls_filtered = true;
+    librados::IoCtx ioctx;
+    std::vector<std::unique_ptr<Shard>> shards;
+    uint32_t consumed = 0;
+    std::unique_ptr<rgw::Aio> aio;  ///< the reads issued ahead
+
+    BucketListCursors() = default;
+    BucketListCursors(const BucketListCursors&) = delete;
+    BucketListCursors& operator=(const BucketListCursors&) = delete;
+    ~BucketListCursors() {
+      reset();
+    }
+    /// drop everything read, waiting for reads in flight
+    void reset();
+    /// replace what was read from a shard with the entries that follow
+    void set_result(Shard& s, rgw_cls_list_ret&& result);
+    /// merge the shards' entries in name order, from where the previous
+    /// merge stopped, until num_entries of them were kept or a truncated
+    /// shard can't tell what comes next
+    int merge(CephContext *cct, uint32_t num_entries,
+	      const read_func& read, const prefetch_func& prefetch,
+	      const visit_func& visit, uint32_t *count, bool *is_truncated,
+	      std::optional<rgw_obj_index_key> *last_entry);
+  };
+
   int cls_bucket_list_ordered(RGWBucketInfo& bucket_info,
 			      const int shard_id,
 			      const rgw_obj_index_key& start_after,
@@ -1395,7 +1469,8 @@ public:
 			      bool* cls_filtered,
 			      rgw_obj_index_key *last_entry,
                               optional_yield y,
-			      check_filter_t force_check_filter = nullptr);
+			      check_filter_t force_check_filter = nullptr,
+			      BucketListCursors *cursors = nullptr);
   int cls_bucket_list_unordered(RGWBucketInfo& bucket_info,
 				int shard_id,
 				const rgw_obj_index_key& start_after,
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "rgw/rgw_service.h"
 #include "rgw/rgw_cache.h"
 
@@ -139,12 +142,23 @@ template <class T>
 class RGWChainedCacheImpl : public RGWChainedCache {
   RGWSI_SysObj_Cache *svc{nullptr};
   ceph::timespan expiry;
-  RWLock lock;
 
-  std::unordered_map<std::string, std::pair<T, ceph::coarse_mono_time>> entries;
+  // partitioned like the ObjectCache (into rgw_cache_shards) so lookups
+  // of different keys don't contend on one lock
+  struct Shard {
+    ceph::shared_mutex lock = ceph::make_shared_mutex("RGWChainedCacheImpl::lock");
+    std::unordered_map<std::string, std::pair<T, ceph::coarse_mono_time>> entries;
+  };
+  std::vector<std::unique_ptr<Shard>> shards;
+
+  Shard& shard_of(const string& key) {
+    return *shards[std::hash<std::string>{}(key) % shards.size()];
+  }
 
 public:
-  RGWChainedCacheImpl() : lock("RGWChainedCacheImpl::lock") {}
+  RGWChainedCacheImpl() {
+    shards.push_back(std::make_unique<Shard>());
+  }
   ~RGWChainedCacheImpl() {
     if (!svc) {
       return;
@@ -160,6 +174,13 @@ public:
     if (!_svc) {
       return;
     }
+    // sized before registering, as nothing is chained to it until then
+    const auto num_shards = std::max<uint64_t>(
+      _svc->ctx()->_conf.get_val<uint64_t>("rgw_cache_shards"), 1);
+    shards.clear();
+    for (uint64_t i = 0; i < num_shards; ++i) {
+      shards.push_back(std::make_unique<Shard>());
+    }
     svc = _svc;
     svc->register_chained_cache(this);
     expiry = std::chrono::seconds(svc->ctx()->_conf.get_val<uint64_t>(
@@ -167,9 +188,10 @@ public:
   }
 
   boost::optional<T> find(const string& key) {
-    std::shared_lock rl{lock};
-    auto iter = entries.find(key);
-    if (iter == entries.end()) {
+    auto& s = shard_of(key);
+    std::shared_lock rl{s.lock};
+    auto iter = s.entries.find(key);
+    if (iter == s.entries.end()) {
       return boost::none;
     }
     if (expiry.count() &&
@@ -194,20 +216,25 @@ public:
 
   void chain_cb(const string& key, void *data) override {
     T *entry = static_cast<T *>(data);
-    std::unique_lock wl{lock};
-    entries[key].first = *entry;
+    auto& s = shard_of(key);
+    std::unique_lock wl{s.lock};
+    auto& e = s.entries[key];
+    e.first = *entry;
     if (expiry.count() > 0) {
-      entries[key].second = ceph::coarse_mono_clock::now();
+      e.second = ceph::coarse_mono_clock::now();
     }
   }
 
   void invalidate(const string& key) override {
-    std::unique_lock wl{lock};
-    entries.erase(key);
+    auto& s = shard_of(key);
+    std::unique_lock wl{s.lock};
+    s.entries.erase(key);
   }
 
   void invalidate_all() override {
-    std::unique_lock wl{lock};
-    entries.clear();
+    for (auto& s : shards) {
+      std::unique_lock wl{s->lock};
+      s->entries.clear();
+    }
   }
 }; /* RGWChainedCacheImpl */
@@ -22,6 +22,9 @@
 #include <limits.h>
 #include <errno.h>
 #include <sys/uio.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "include/buffer.h"
 #include "include/buffer_raw.h"
@@ -149,6 +152,137 @@ TEST(Buffer, BenchAlloc) {
   bench_buffer_alloc(4, 1000000);
 }
 
+TEST(Buffer, create_pooled) {
+  for (unsigned len : {1u, 255u, 256u, 4095u, 4096u, 65536u, 65537u}) {
+    for (unsigned align : {8u, 512u, (unsigned)CEPH_PAGE_SIZE}) {
+      bufferptr ptr(buffer::create_pooled(len, align,
+					  mempool::mempool_buffer_anon));
+      EXPECT_EQ(len, ptr.length());
+      EXPECT_EQ(0u, (uintptr_t)ptr.c_str() & (align - 1));
+      ::memset(ptr.c_str(), 'X', len);
+      bufferptr clone = ptr.clone();
+      EXPECT_EQ(0u, (uintptr_t)clone.c_str() & (align - 1));
+      EXPECT_EQ(0, ::memcmp(clone.c_str(), ptr.c_str(), len));
+    }
+  }
+  // slots released on one thread are reused by another
+  std::vector<bufferptr> v;
+  std::thread producer([&v] {
+    for (int i = 0; i < 1000; ++i) {
+      v.emplace_back(buffer::create_pooled(4096, CEPH_PAGE_SIZE,
+					   mempool::mempool_buffer_anon));
+      ::memset(v.back().c_str(), i, 4096);
+    }
+  });
+  producer.join();
+  std::thread consumer([&v] {
+    for (int i = 0; i < 1000; ++i) {
+      EXPECT_EQ((char)i, v[i].c_str()[4095]);
+    }
+    v.clear();
+  });
+  consumer.join();
+  size_t slab_bytes = buffer::get_pool_slab_bytes();
+  for (int i = 0; i < 1000; ++i) {
+    v.emplace_back(buffer::create_pooled(4096, CEPH_PAGE_SIZE,
+					 mempool::mempool_buffer_anon));
+  }
+  EXPECT_EQ(slab_bytes, buffer::get_pool_slab_bytes());
+}
+
+static size_t get_rss_bytes()
+{
+  size_t size = 0, resident = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%zu %zu", &size, &resident) != 2)
+      resident = 0;
+    fclose(f);
+  }
+  return resident * CEPH_PAGE_SIZE;
+}
+
+// allocate on one thread and release on another, with a working set of
+// mixed sizes: the pattern of messenger receive buffers freed by the
+// osd op threads.
+void bench_buffer_alloc_handoff(bool pooled, unsigned align, int num)
+{
+  constexpr unsigned batch = 256;
+  size_t rss_start = get_rss_bytes();
+  utime_t start = ceph_clock_now();
+  std::mutex lock;
+  std::condition_variable cond;
+  std::vector<bufferptr> handoff;
+  bool done = false;
+  std::thread consumer([&] {
+    std::vector<bufferptr> v;
+    std::unique_lock l(lock);
+    while (true) {
+      cond.wait(l, [&] { return done || !handoff.empty(); });
+      if (handoff.empty()) {
+	break;
+      }
+      v.swap(handoff);
+      cond.notify_all();
+      l.unlock();
+      v.clear();
+      l.lock();
+    }
+  });
+  std::vector<bufferptr> v;
+  for (int i = 0; i < num; ++i) {
+    unsigned len = 512u << (i % 8);
+    v.push_back(pooled ?
+		bufferptr(buffer::create_pooled(len, align,
+						mempool::mempool_buffer_anon)) :
+		bufferptr(buffer::create_aligned(len, align)));
+    if (v.size() == batch) {
+      std::unique_lock l(lock);
+      cond.wait(l, [&] { return handoff.empty(); });
+      handoff.swap(v);
+      cond.notify_all();
+    }
+  }
+  {
+    std::lock_guard l(lock);
+    done = true;
+    cond.notify_all();
+  }
+  consumer.join();
+  utime_t end = ceph_clock_now();
+  cout << num << (pooled ? " pooled" : " heap") << " handoff alloc align "
+       << align << " in " << (end - start)
+       << " rss +" << ((int64_t)get_rss_bytes() - (int64_t)rss_start) / 1024
+       << "k pool slabs " << buffer::get_pool_slab_bytes() / 1024 << "k"
+       << std::endl;
+}
+
+void bench_buffer_alloc_pooled(int size, unsigned align, int num)
+{
+  utime_t start = ceph_clock_now();
+  for (int i=0; i<num; ++i) {
+    bufferptr p = buffer::create_pooled(size, align,
+					mempool::mempool_buffer_anon);
+    p.zero();
+  }
+  utime_t end = ceph_clock_now();
+  cout << num << " pooled alloc of size " << size << " align " << align
+       << " in " << (end - start) << std::endl;
+}
+
+TEST(Buffer, BenchAllocPooled) {
+  bench_buffer_alloc_pooled(65536, 8, 1000000);
+  bench_buffer_alloc_pooled(16384, 8, 1000000);
+  bench_buffer_alloc_pooled(4096, 8, 1000000);
+  bench_buffer_alloc_pooled(4096, CEPH_PAGE_SIZE, 1000000);
+  bench_buffer_alloc_pooled(1024, 8, 1000000);
+  bench_buffer_alloc_pooled(256, 8, 1000000);
+  bench_buffer_alloc_handoff(false, 8, 1000000);
+  bench_buffer_alloc_handoff(true, 8, 1000000);
+  bench_buffer_alloc_handoff(false, CEPH_PAGE_SIZE, 1000000);
+  bench_buffer_alloc_handoff(true, CEPH_PAGE_SIZE, 1000000);
+}
+
 TEST(BufferRaw, ostream) {
   bufferptr ptr(1);
   std::ostringstream stream;
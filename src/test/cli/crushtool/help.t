@@ -100,6 +100,8 @@
         [--simulate]       simulate placements using a random
                            number generator in place of the CRUSH
                            algorithm
+     -i mapfn --benchmark  time the mapping of the --test inputs and
+                           report mappings/sec
      --show-utilization    show OSD usage
      --show-utilization-all
                            include zero weight items
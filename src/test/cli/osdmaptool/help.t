@@ -36,4 +36,6 @@
      --test-crush [--range-first <first> --range-last <last>] map pgs to acting osds
      --adjust-crush-weight <osdid:weight>[,<osdid:weight>,<...>] change <osdid> CRUSH <weight> (but do not persist)
      --save                  write modified osdmap with upmap or crush-adjust changes
+     --test-map-sharing <epochs> compare the memory used by a cache of <epochs>
+                             maps built from incrementals with and without sharing
   [1]
@@ -517,18 +517,20 @@ TEST_F(cls_rgw, index_list_delimited)
   auto id_entry_map = it->second.dir.m;
   bool truncated = it->second.is_truncated;
 
-  // the cls code will make 4 tries to get 1000 entries; however
-  // because each of the subdirectories is so large, each attempt will
-  // only retrieve the first part of the subdirectory
+  // each of the subdirectories is larger than a full read, but once
+  // the cls code has skipped past one it only reads a few keys to find
+  // the next, so all of them fit in a single call
 
-  ASSERT_EQ(48u, id_entry_map.size()) <<
-    "We should get 40 top-level entries and the tops of 8 \"subdirectories\".";
-  ASSERT_EQ(true, truncated) << "We did not get all entries.";
+  ASSERT_EQ(65u, id_entry_map.size()) <<
+    "We should get 55 top-level entries and the tops of 10 \"subdirectories\".";
+  ASSERT_EQ(false, truncated) << "We got all entries.";
 
   ASSERT_EQ("a-0", id_entry_map.cbegin()->first);
-  ASSERT_EQ("p/", id_entry_map.crbegin()->first);
+  ASSERT_EQ("u-4", id_entry_map.crbegin()->first);
+  ASSERT_EQ(1u, id_entry_map.count("p/"));
+  ASSERT_EQ(0u, id_entry_map.count("p/f-0"));
 
-  // now let's get the rest of the entries
+  // starting after a subdirectory skips all of it
 
   list_results.clear();
   
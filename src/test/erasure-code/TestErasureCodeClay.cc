@@ -360,6 +360,55 @@ TEST(ErasureCodeClay, encode_decode_shortening_case)
   }
 }
 
+TEST(ErasureCodeClay, repair_pft_fast)
+{
+  ErasureCodeClay clay(g_conf().get_val<std::string>("erasure_code_dir"));
+  ErasureCodeProfile profile;
+  profile["k"] = "4";
+  profile["m"] = "3";
+  profile["d"] = "5";
+  EXPECT_EQ(0, clay.init(profile, &cerr));
+  // jerasure reed_sol_van is a byte-wise code
+  EXPECT_TRUE(clay.pft_fast);
+
+  bufferlist in;
+  for (unsigned i = 0; i < clay.get_chunk_size(1) * 4; i++) {
+    in.append((char)(i * 31 + 7));
+  }
+  set<int> want_to_encode;
+  for (int i = 0; i < 7; i++) {
+    want_to_encode.insert(i);
+  }
+  map<int, bufferlist> encoded;
+  EXPECT_EQ(0, clay.encode(want_to_encode, in, &encoded));
+  unsigned length = encoded[0].length();
+  int sc_size = length/clay.sub_chunk_no;
+
+  // the region op and the scalar code repair every chunk alike
+  for (bool fast : {true, false}) {
+    clay.pft_fast = fast;
+    for (int i = 0; i < 7; i++) {
+      set<int> want_to_read = {i};
+      set<int> available = want_to_encode;
+      available.erase(i);
+      map<int, vector<pair<int,int>>> minimum;
+      EXPECT_EQ(0, clay.minimum_to_decode(want_to_read, available, &minimum));
+      map<int, bufferlist> helper;
+      for (auto& [chunk, sub_chunks] : minimum) {
+	for (auto& [index, count] : sub_chunks) {
+	  bufferlist temp;
+	  temp.substr_of(encoded[chunk], index*sc_size, count*sc_size);
+	  helper[chunk].append(temp);
+	}
+      }
+      map<int, bufferlist> decoded;
+      EXPECT_EQ(0, clay.decode(want_to_read, helper, &decoded, length));
+      EXPECT_EQ(1u, decoded.size());
+      EXPECT_TRUE(decoded[i].contents_equal(encoded[i]));
+    }
+  }
+}
+
 TEST(ErasureCodeClay, minimum_to_decode)
 {
   ErasureCodeClay clay(g_conf().get_val<std::string>("erasure_code_dir"));
@@ -366,6 +366,52 @@ TEST_F(IsaErasureCodeTest, encode)
   }
 }
 
+TEST_F(IsaErasureCodeTest, parity_delta)
+{
+  // m=1 updates the parity with a plain xor, m>1 with the gf tables
+  for (int m = 1; m <= 2; m++) {
+    ErasureCodeIsaDefault Isa(tcache);
+    ErasureCodeProfile profile;
+    profile["k"] = "3";
+    profile["m"] = stringify(m);
+    Isa.init(profile, &cerr);
+
+    bufferlist in;
+    in.append_zero(Isa.get_alignment() * 3);
+    for (unsigned i = 0; i < in.length(); i++)
+      in.c_str()[i] = i * 13;
+    set<int> want;
+    for (int i = 0; i < 3 + m; i++)
+      want.insert(i);
+    map<int, bufferlist> encoded;
+    EXPECT_EQ(0, Isa.encode(want, in, &encoded));
+    unsigned length = encoded[0].length();
+
+    // overwrite parts of the first and last data chunks
+    map<int, bufferlist> modified;
+    map<int, bufferlist> deltas;
+    for (int i : { 0, 2 }) {
+      modified[i].append(encoded[i].c_str(), length);
+      memset(modified[i].c_str() + i * 8, 'Y', 32);
+      Isa.encode_delta(encoded[i], modified[i], &deltas[i]);
+    }
+    map<int, bufferlist> coding;
+    for (int i = 3; i < 3 + m; i++)
+      coding[i].append(encoded[i].c_str(), length);
+    Isa.apply_delta(deltas, coding);
+
+    bufferlist new_in;
+    new_in.append(modified[0]);
+    new_in.append(encoded[1].c_str(), length);
+    new_in.append(modified[2]);
+    map<int, bufferlist> reencoded;
+    EXPECT_EQ(0, Isa.encode(want, new_in, &reencoded));
+    for (int i = 3; i < 3 + m; i++) {
+      EXPECT_EQ(0, memcmp(coding[i].c_str(), reencoded[i].c_str(), length));
+    }
+  }
+}
+
 TEST_F(IsaErasureCodeTest, sanity_check_k)
 {
   ErasureCodeIsaDefault Isa(tcache);
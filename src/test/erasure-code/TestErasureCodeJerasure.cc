@@ -129,6 +129,51 @@ TYPED_TEST(ErasureCodeTest, encode_decode)
   }
 }
 
+TYPED_TEST(ErasureCodeTest, parity_delta)
+{
+  TypeParam jerasure;
+  ErasureCodeProfile profile;
+  profile["k"] = "2";
+  profile["m"] = "2";
+  profile["packetsize"] = "8";
+  jerasure.init(profile, &cerr);
+
+  bufferlist in;
+  in.append_zero(LARGE_ENOUGH);
+  for (unsigned i = 0; i < in.length(); i++)
+    in.c_str()[i] = i * 7;
+  int want_to_encode[] = { 0, 1, 2, 3 };
+  set<int> want(want_to_encode, want_to_encode+4);
+  map<int, bufferlist> encoded;
+  EXPECT_EQ(0, jerasure.encode(want, in, &encoded));
+  unsigned length = encoded[0].length();
+
+  // overwrite part of the second data chunk
+  bufferlist modified;
+  modified.append(encoded[1].c_str(), length);
+  memset(modified.c_str() + 16, 'X', 64);
+  bufferlist delta;
+  jerasure.encode_delta(encoded[1], modified, &delta);
+  EXPECT_EQ(length, delta.length());
+
+  map<int, bufferlist> coding;
+  for (int i = 2; i < 4; i++)
+    coding[i].append(encoded[i].c_str(), length);
+  map<int, bufferlist> deltas;
+  deltas[1] = delta;
+  jerasure.apply_delta(deltas, coding);
+
+  bufferlist new_in;
+  new_in.append(encoded[0].c_str(), length);
+  new_in.append(modified);
+  map<int, bufferlist> reencoded;
+  EXPECT_EQ(0, jerasure.encode(want, new_in, &reencoded));
+  for (int i = 2; i < 4; i++) {
+    EXPECT_EQ(length, coding[i].length());
+    EXPECT_EQ(0, memcmp(coding[i].c_str(), reencoded[i].c_str(), length));
+  }
+}
+
 TYPED_TEST(ErasureCodeTest, minimum_to_decode)
 {
   TypeParam jerasure;
@@ -50,7 +50,8 @@ int ErasureCodeBench::setup(int argc, char** argv) {
     ("plugin,p", po::value<string>()->default_value("jerasure"),
      "erasure code plugin name")
     ("workload,w", po::value<string>()->default_value("encode"),
-     "run either encode or decode")
+     "run either encode, decode or repair (single chunk repair from "
+     "sub-chunks, for codes that support it such as clay)")
     ("erasures,e", po::value<int>()->default_value(1),
      "number of erasures when decoding")
     ("erased", po::value<vector<int> >(),
@@ -149,6 +150,8 @@ int ErasureCodeBench::run() {
 
   if (workload == "encode")
     return encode();
+  else if (workload == "repair")
+    return repair();
   else
     return decode();
 }
@@ -316,6 +319,80 @@ int ErasureCodeBench::decode()
   return 0;
 }
 
+int ErasureCodeBench::repair()
+{
+  ErasureCodePluginRegistry &instance = ErasureCodePluginRegistry::instance();
+  ErasureCodeInterfaceRef erasure_code;
+  stringstream messages;
+  int code = instance.factory(plugin,
+			      g_conf().get_val<std::string>("erasure_code_dir"),
+			      profile, &erasure_code, &messages);
+  if (code) {
+    cerr << messages.str() << endl;
+    return code;
+  }
+
+  bufferlist in;
+  in.append(string(in_size, 'X'));
+  in.rebuild_aligned(ErasureCode::SIMD_ALIGN);
+
+  set<int> want_to_encode;
+  for (int i = 0; i < k + m; i++) {
+    want_to_encode.insert(i);
+  }
+
+  map<int,bufferlist> encoded;
+  code = erasure_code->encode(want_to_encode, in, &encoded);
+  if (code)
+    return code;
+
+  int lost = erased.size() > 0 ? erased[0] : rand() % (k + m);
+  set<int> want_to_read = { lost };
+  set<int> available = want_to_encode;
+  available.erase(lost);
+
+  // fetch only the sub-chunks the code asks for, as recovery does
+  map<int, vector<pair<int, int>>> minimum;
+  code = erasure_code->minimum_to_decode(want_to_read, available, &minimum);
+  if (code)
+    return code;
+  unsigned chunk_size = encoded[0].length();
+  unsigned sub_chunk_size = chunk_size / erasure_code->get_sub_chunk_count();
+  map<int,bufferlist> helpers;
+  uint64_t helper_bytes = 0;
+  for (auto& [chunk, sub_chunks] : minimum) {
+    for (auto& [index, count] : sub_chunks) {
+      bufferlist bl;
+      bl.substr_of(encoded[chunk], index * sub_chunk_size, count * sub_chunk_size);
+      helpers[chunk].append(bl);
+    }
+    helpers[chunk].rebuild_aligned(ErasureCode::SIMD_ALIGN);
+    helper_bytes += helpers[chunk].length();
+  }
+  if (verbose)
+    cout << "repair chunk " << lost << " from " << helper_bytes
+	 << " bytes of " << helpers.size() << " chunks" << endl;
+
+  utime_t begin_time = ceph_clock_now();
+  for (int i = 0; i < max_iterations; i++) {
+    map<int,bufferlist> decoded;
+    code = erasure_code->decode(want_to_read, helpers, &decoded, chunk_size);
+    if (code)
+      return code;
+    if (i == 0 && !decoded[lost].contents_equal(encoded[lost])) {
+      cerr << "chunk " << lost
+	   << " content and repaired content are different" << endl;
+      return -1;
+    }
+  }
+  utime_t end_time = ceph_clock_now();
+  double elapsed = end_time - begin_time;
+  cout << (end_time - begin_time) << "\t" << (max_iterations * (in_size / 1024))
+       << "\t" << (elapsed > 0 ? (double)max_iterations * chunk_size / elapsed / 1e9 : 0)
+       << " GB/s" << endl;
+  return 0;
+}
+
 int main(int argc, char** argv) {
   ErasureCodeBench ecbench;
   try {
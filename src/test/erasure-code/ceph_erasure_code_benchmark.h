@@ -49,6 +49,7 @@ public:
 		      ErasureCodeInterfaceRef erasure_code);
   int decode();
   int encode();
+  int repair();
 };
 
 #endif
@@ -0,0 +1,156 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+// Measures librados op submission throughput against a live cluster as
+// the number of submitting threads grows.  Each thread keeps a window of
+// small aio stats in flight on its own set of objects; run it while OSD
+// maps churn (e.g. "ceph osd pool set <pool> pg_num ...") to see how map
+// handling interferes with op submission.
+//
+//   ceph_test_rados_submit_speed [pool [seconds [max_threads [window]]]]
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/rados/librados.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr int objects_per_thread = 16;
+
+std::string obj_name(int thread, int i)
+{
+  return "submit_speed." + std::to_string(thread) + "." + std::to_string(i);
+}
+
+struct Window {
+  std::mutex lock;
+  std::condition_variable cond;
+  int in_flight = 0;
+};
+
+void stat_done(librados::completion_t, void *arg)
+{
+  auto w = static_cast<Window*>(arg);
+  std::lock_guard l(w->lock);
+  --w->in_flight;
+  w->cond.notify_one();
+}
+
+uint64_t run(librados::IoCtx& ioctx, int thread, int window,
+	     const std::atomic<bool>& stop)
+{
+  Window w;
+  uint64_t ops = 0;
+  std::vector<librados::AioCompletion*> done;
+  while (!stop) {
+    {
+      std::unique_lock l(w.lock);
+      w.cond.wait(l, [&] { return w.in_flight < window; });
+      ++w.in_flight;
+    }
+    auto c = librados::Rados::aio_create_completion(&w, stat_done);
+    ioctx.aio_stat(obj_name(thread, ops % objects_per_thread), c,
+		   nullptr, nullptr);
+    done.push_back(c);
+    ++ops;
+    if (done.size() >= (size_t)window * 4) {
+      // release completions that have fired so memory stays bounded
+      std::vector<librados::AioCompletion*> pending;
+      for (auto p : done) {
+	if (p->is_complete()) {
+	  p->release();
+	} else {
+	  pending.push_back(p);
+	}
+      }
+      done.swap(pending);
+    }
+  }
+  {
+    // callbacks fire after completion; wait for them before w goes away
+    std::unique_lock l(w.lock);
+    w.cond.wait(l, [&] { return w.in_flight == 0; });
+  }
+  for (auto p : done) {
+    p->release();
+  }
+  return ops;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  std::string pool = argc > 1 ? argv[1] : "rbd";
+  int seconds = argc > 2 ? atoi(argv[2]) : 10;
+  int max_threads = argc > 3 ? atoi(argv[3]) : 128;
+  int window = argc > 4 ? atoi(argv[4]) : 16;
+
+  librados::Rados rados;
+  int r = rados.init_with_context(nullptr);
+  if (r == 0) {
+    r = rados.conf_read_file(nullptr);
+  }
+  if (r == 0) {
+    r = rados.conf_parse_env(nullptr);
+  }
+  if (r == 0) {
+    r = rados.connect();
+  }
+  if (r < 0) {
+    std::cerr << "unable to connect: " << r << std::endl;
+    return 1;
+  }
+  librados::IoCtx ioctx;
+  r = rados.ioctx_create(pool.c_str(), ioctx);
+  if (r < 0) {
+    std::cerr << "unable to open pool " << pool << ": " << r << std::endl;
+    return 1;
+  }
+
+  for (int t = 0; t < max_threads; t++) {
+    for (int i = 0; i < objects_per_thread; i++) {
+      ioctx.create(obj_name(t, i), false);
+    }
+  }
+
+  std::cout << "threads\tops/sec" << std::endl;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> total = 0;
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+      workers.emplace_back([&, t] {
+	total += run(ioctx, t, window, stop);
+      });
+    }
+    std::this_thread::sleep_for(seconds * 1s);
+    stop = true;
+    for (auto& w : workers) {
+      w.join();
+    }
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    std::cout << threads << "\t" << (uint64_t)(total / elapsed.count())
+	      << std::endl;
+  }
+
+  for (int t = 0; t < max_threads; t++) {
+    for (int i = 0; i < objects_per_thread; i++) {
+      ioctx.remove(obj_name(t, i));
+    }
+  }
+  rados.shutdown();
+  return 0;
+}
@@ -164,3 +164,94 @@ TEST(pgmap, dump_object_stat_sum_2)
   ASSERT_EQ(percentify(0), tbl.get(0, col++));
   ASSERT_EQ(stringify(byte_u_t(avail/pool.size)), tbl.get(0, col++));
 }
+
+// purged_snaps is maintained by apply_incremental() between digests and
+// must match what a full recompute finds
+TEST(pgmap, incremental_purged_snaps)
+{
+  PGMap pg_map;
+  auto apply = [&](PGMap::Incremental& inc) {
+    inc.version = pg_map.get_version() + 1;
+    inc.stamp = utime_t(inc.version, 0);
+    pg_map.apply_incremental(nullptr, inc);
+    pg_map.calc_purged_snaps();
+    PGMap full = pg_map;
+    full.calc_stats();
+    full.calc_purged_snaps();
+    ASSERT_EQ(full.purged_snaps, pg_map.purged_snaps);
+  };
+  auto stat = [](uint64_t state, snapid_t purged) {
+    pg_stat_t s;
+    s.state = state;
+    if (purged > 1) {
+      s.purged_snaps.insert(1, purged - 1);
+    }
+    return s;
+  };
+  const uint64_t active = PG_STATE_ACTIVE | PG_STATE_CLEAN;
+
+  // two pools of 8 pgs, one pg of the second one still unknown
+  {
+    PGMap::Incremental inc;
+    for (unsigned ps = 0; ps < 8; ++ps) {
+      inc.pg_stat_updates[pg_t(ps, 1)] = stat(active, 10);
+      inc.pg_stat_updates[pg_t(ps, 2)] = stat(ps ? active : 0, 10);
+    }
+    apply(inc);
+    ASSERT_EQ(1u, pg_map.purged_snaps.count(1));
+    ASSERT_EQ(0u, pg_map.purged_snaps.count(2));
+  }
+  // stats change, purged snaps don't
+  {
+    PGMap::Incremental inc;
+    pg_stat_t s = stat(active, 10);
+    s.stats.sum.num_objects = 100;
+    inc.pg_stat_updates[pg_t(3, 1)] = s;
+    apply(inc);
+  }
+  // the unknown pg reports
+  {
+    PGMap::Incremental inc;
+    inc.pg_stat_updates[pg_t(0, 2)] = stat(active, 10);
+    apply(inc);
+    ASSERT_EQ(1u, pg_map.purged_snaps.count(2));
+  }
+  // trimming makes progress on some pgs, then all of them
+  {
+    PGMap::Incremental inc;
+    inc.pg_stat_updates[pg_t(0, 1)] = stat(active, 20);
+    inc.pg_stat_updates[pg_t(1, 1)] = stat(active, 20);
+    apply(inc);
+    ASSERT_EQ(9u, pg_map.purged_snaps[1].size());
+  }
+  {
+    PGMap::Incremental inc;
+    for (unsigned ps = 2; ps < 8; ++ps) {
+      inc.pg_stat_updates[pg_t(ps, 1)] = stat(active, 20);
+    }
+    apply(inc);
+    ASSERT_EQ(19u, pg_map.purged_snaps[1].size());
+  }
+  // pgs are added (split) and removed (merged)
+  {
+    PGMap::Incremental inc;
+    inc.pg_stat_updates[pg_t(8, 1)] = stat(active, 15);
+    apply(inc);
+    ASSERT_EQ(14u, pg_map.purged_snaps[1].size());
+  }
+  {
+    PGMap::Incremental inc;
+    inc.pg_remove.insert(pg_t(8, 1));
+    apply(inc);
+    ASSERT_EQ(19u, pg_map.purged_snaps[1].size());
+  }
+  // a pool goes away
+  {
+    PGMap::Incremental inc;
+    for (unsigned ps = 0; ps < 8; ++ps) {
+      inc.pg_remove.insert(pg_t(ps, 2));
+    }
+    apply(inc);
+    ASSERT_EQ(0u, pg_map.purged_snaps.count(2));
+  }
+}
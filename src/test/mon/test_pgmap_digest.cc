@@ -0,0 +1,128 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+// Measures how long the mgr spends producing a PGMapDigest for the mon on
+// each report tick.  A PGMap with many pgs is built, then synthetic
+// Incrementals updating a fraction of the pgs and every osd are applied
+// and the digest encoded after each; the cost of rebuilding all the
+// aggregates from scratch is shown for comparison.
+//
+//   ceph_test_mon_pgmap_digest [pgs [osds [updates [iterations]]]]
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "common/ceph_argparse.h"
+#include "global/global_context.h"
+#include "global/global_init.h"
+#include "mon/PGMap.h"
+#include "osd/OSDMap.h"
+
+using namespace std;
+
+namespace {
+
+constexpr int num_pools = 4;
+
+using ms = chrono::duration<double, milli>;
+
+pg_stat_t make_stat(int osds, unsigned seed, snapid_t purged)
+{
+  pg_stat_t s;
+  s.state = PG_STATE_ACTIVE | PG_STATE_CLEAN;
+  for (int i = 0; i < 3; ++i) {
+    s.up.push_back((seed + i) % osds);
+  }
+  s.acting = s.up;
+  s.up_primary = s.acting_primary = s.up[0];
+  s.stats.sum.num_objects = seed % 1000;
+  s.stats.sum.num_bytes = (seed % 1000) << 22;
+  s.purged_snaps.insert(1, purged);
+  return s;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  vector<const char*> args;
+  auto cct = global_init(nullptr, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  unsigned pgs = argc > 1 ? atoi(argv[1]) : 1000000;
+  int osds = argc > 2 ? atoi(argv[2]) : 1000;
+  unsigned updates = argc > 3 ? atoi(argv[3]) : 10000;
+  int iterations = argc > 4 ? atoi(argv[4]) : 20;
+
+  OSDMap osdmap;
+  uuid_d fsid;
+  osdmap.build_simple(g_ceph_context, 1, fsid, osds);
+  for (int i = 0; i < osds; ++i) {
+    osdmap.crush->set_item_class(i, i % 2 ? "hdd" : "ssd");
+  }
+
+  PGMap pg_map;
+  auto apply = [&](PGMap::Incremental& inc) {
+    inc.version = pg_map.get_version() + 1;
+    inc.stamp = ceph_clock_now();
+    pg_map.apply_incremental(g_ceph_context, inc);
+  };
+  {
+    PGMap::Incremental inc;
+    for (unsigned i = 0; i < pgs; ++i) {
+      inc.pg_stat_updates[pg_t(i / num_pools, i % num_pools + 1)] =
+	make_stat(osds, i, 100);
+    }
+    for (int i = 0; i < osds; ++i) {
+      inc.update_stat(i, osd_stat_t());
+    }
+    apply(inc);
+  }
+  cout << pgs << " pgs, " << osds << " osds, " << updates
+       << " pg updates per incremental" << std::endl;
+
+  mt19937 rng(0);
+  ms apply_time{0}, digest_time{0};
+  size_t digest_len = 0;
+  for (int it = 0; it < iterations; ++it) {
+    PGMap::Incremental inc;
+    for (unsigned u = 0; u < updates; ++u) {
+      unsigned i = rng() % pgs;
+      // snap trimming makes progress in one pool every few ticks
+      snapid_t purged = (it % 5 == 4 && i % num_pools == 0) ? 100 + it : 100;
+      inc.pg_stat_updates[pg_t(i / num_pools, i % num_pools + 1)] =
+	make_stat(osds, i + it, purged);
+    }
+    for (int i = 0; i < osds; ++i) {
+      osd_stat_t s;
+      s.seq = it + 1;
+      s.statfs.total = 1ull << 40;
+      s.statfs.available = (1ull << 40) - rng() % (1ull << 30);
+      inc.update_stat(i, s);
+    }
+    auto start = chrono::steady_clock::now();
+    apply(inc);
+    auto applied = chrono::steady_clock::now();
+    bufferlist bl;
+    pg_map.encode_digest(osdmap, bl, CEPH_FEATURES_ALL);
+    auto done = chrono::steady_clock::now();
+    apply_time += applied - start;
+    digest_time += done - applied;
+    digest_len = bl.length();
+  }
+  cout << "apply_incremental\t" << apply_time.count() / iterations << " ms"
+       << std::endl;
+  cout << "encode_digest\t" << digest_time.count() / iterations << " ms ("
+       << digest_len << " bytes)" << std::endl;
+
+  auto start = chrono::steady_clock::now();
+  pg_map.calc_stats();
+  bufferlist bl;
+  pg_map.encode_digest(osdmap, bl, CEPH_FEATURES_ALL);
+  ms full = chrono::steady_clock::now() - start;
+  cout << "full recompute\t" << full.count() << " ms" << std::endl;
+  return 0;
+}
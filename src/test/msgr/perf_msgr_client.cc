@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <string>
 #include <unistd.h>
+#include <sys/resource.h>
 #include <iostream>
 
 using namespace std;
@@ -173,6 +174,7 @@ void usage(const string &name) {
   cout << "       [ios]: how much messages sent for each client" << std::endl;
   cout << "       [thinktime]: sleep time when do fast dispatching(match client logic)" << std::endl;
   cout << "       [msg length]: message data bytes" << std::endl;
+  cout << "       the network stack follows ms_type, e.g. --ms_type async+uring" << std::endl;
 }
 
 int main(int argc, char **argv)
@@ -211,10 +213,24 @@ int main(int argc, char **argv)
 
   client.ready(concurrent, numjobs, ios, len);
   Cycles::init();
+  struct rusage ru_start, ru_stop;
+  getrusage(RUSAGE_SELF, &ru_start);
   uint64_t start = Cycles::rdtsc();
   client.start();
   uint64_t stop = Cycles::rdtsc();
-  cout << " Total op " << (ios * numjobs) << " run time " << Cycles::to_microseconds(stop - start) << "us." << std::endl;
+  getrusage(RUSAGE_SELF, &ru_stop);
+  uint64_t total_ops = (uint64_t)ios * numjobs;
+  uint64_t run_us = Cycles::to_microseconds(stop - start);
+  auto tv_us = [](const struct timeval &tv) {
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+  };
+  uint64_t cpu_us = tv_us(ru_stop.ru_utime) - tv_us(ru_start.ru_utime) +
+                    tv_us(ru_stop.ru_stime) - tv_us(ru_start.ru_stime);
+  cout << " Total op " << total_ops << " run time " << run_us << "us." << std::endl;
+  if (run_us && total_ops) {
+    cout << " " << total_ops * 1000000 / run_us << " ops/s, "
+         << (double)cpu_us / total_ops << " cpu us/op" << std::endl;
+  }
 
   return 0;
 }
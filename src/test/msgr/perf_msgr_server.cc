@@ -140,6 +140,7 @@ void usage(const string &name) {
   cerr << "       [bind ip:port]: The ip:port pair to bind, client need to specify this pair to connect" << std::endl;
   cerr << "       [server worker threads]: threads will process incoming messages and reply(matching pg threads)" << std::endl;
   cerr << "       [thinktime]: sleep time when do dispatching(match fast dispatch logic in OSD.cc)" << std::endl;
+  cerr << "       the network stack follows ms_type, e.g. --ms_type async+uring" << std::endl;
 }
 
 int main(int argc, char **argv)
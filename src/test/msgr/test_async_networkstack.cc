@@ -1061,6 +1061,9 @@ INSTANTIATE_TEST_SUITE_P(
   ::testing::Values(
 #ifdef HAVE_DPDK
     "dpdk",
+#endif
+#ifdef HAVE_LIBURING
+    "uring",
 #endif
     "posix"
   )
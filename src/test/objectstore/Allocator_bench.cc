@@ -5,6 +5,7 @@
  * Author: Igor Fedotov, ifedotov@suse.com
  */
 #include <iostream>
+#include <thread>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 
@@ -326,6 +327,80 @@ TEST_P(AllocTest, test_alloc_bench_10_300)
   doOverwriteTest(capacity, prefill, overwrite);
 }
 
+TEST_P(AllocTest, test_alloc_bench_threads)
+{
+  uint64_t capacity = uint64_t(64) * 1024 * 1024 * 1024;
+  uint64_t alloc_unit = 4096;
+  const uint64_t ops_per_thread = 100000;
+  const size_t working_set = 64;
+
+  init_alloc(capacity, alloc_unit);
+  alloc->init_add_free(0, capacity);
+
+  // age it first: fill half of the space, then free every other extent
+  gen_type rng(0);
+  boost::uniform_int<> u1(0, 7); // 4K-512K
+  PExtentVector aged;
+  for (uint64_t used = 0; used < capacity / 2; ) {
+    PExtentVector tmp;
+    uint64_t want = alloc_unit << u1(rng);
+    auto r = alloc->allocate(want, alloc_unit, 0, 0, &tmp);
+    ASSERT_EQ(static_cast<int64_t>(want), r);
+    used += r;
+    aged.insert(aged.end(), tmp.begin(), tmp.end());
+  }
+  for (size_t i = 0; i < aged.size(); i += 2) {
+    interval_set<uint64_t> release_set;
+    release_set.insert(aged[i].offset, aged[i].length);
+    alloc->release(release_set);
+  }
+  std::cout << "aged: avail " << alloc->get_free() / _1m << " MB"
+	    << ", fragmentation score " << alloc->get_fragmentation_score()
+	    << std::endl;
+
+  std::cout << "threads\tallocs/sec\tfragmentation score" << std::endl;
+  for (unsigned threads = 1; threads <= 16; threads *= 2) {
+    std::atomic<uint64_t> failed = 0;
+    std::vector<std::thread> workers;
+    utime_t start = ceph_clock_now();
+    for (unsigned t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+	gen_type rng(t + 1);
+	boost::uniform_int<> u(0, 7); // 4K-512K
+	// each thread keeps a small working set, replacing the oldest
+	// allocation with a new one
+	std::vector<PExtentVector> slots(working_set);
+	for (uint64_t i = 0; i < ops_per_thread; ++i) {
+	  auto& slot = slots[i % working_set];
+	  if (!slot.empty()) {
+	    alloc->release(slot);
+	    slot.clear();
+	  }
+	  uint64_t want = alloc_unit << u(rng);
+	  if (alloc->allocate(want, alloc_unit, 0, 0, &slot) !=
+	      static_cast<int64_t>(want)) {
+	    ++failed;
+	  }
+	}
+	for (auto& slot : slots) {
+	  if (!slot.empty()) {
+	    alloc->release(slot);
+	  }
+	}
+      });
+    }
+    for (auto& w : workers) {
+      w.join();
+    }
+    double elapsed = ceph_clock_now() - start;
+    EXPECT_EQ(0u, failed);
+    std::cout << threads << "\t"
+	      << uint64_t(threads * ops_per_thread / elapsed) << "\t"
+	      << alloc->get_fragmentation_score() << std::endl;
+  }
+  dump_mempools();
+}
+
 TEST_P(AllocTest, mempoolAccounting)
 {
   uint64_t bytes = mempool::bluestore_alloc::allocated_bytes();
@@ -361,4 +436,4 @@ TEST_P(AllocTest, mempoolAccounting)
 INSTANTIATE_TEST_SUITE_P(
   Allocator,
   AllocTest,
-  ::testing::Values("stupid", "bitmap", "avl", "hybrid"));
+  ::testing::Values("stupid", "bitmap", "avl", "hybrid", "sharded"));
@@ -272,6 +272,9 @@ TEST_P(AllocTest, test_alloc_fragmentation)
   } else if (GetParam() == string("hybrid")) {
     // AVL allocator uses a different allocating strategy
     GTEST_SKIP() << "skipping for Hybrid allocator";
+  } else if (GetParam() == string("sharded")) {
+    // a single hybrid allocator at this capacity
+    GTEST_SKIP() << "skipping for Sharded allocator";
   }
 
   for (size_t i = 0; i < allocated.size(); i += 2)
@@ -482,6 +485,58 @@ TEST_P(AllocTest, test_alloc_contiguous)
   alloc->shutdown();
 }
 
+TEST_P(AllocTest, test_alloc_release_span)
+{
+  // big enough for the sharded allocator to use several regions
+  uint64_t block = 0x1000;
+  uint64_t unit = 0x100000;
+  uint64_t gb = uint64_t(1) << 30;
+  uint64_t capacity = 4 * gb;
+
+  init_alloc(capacity, block);
+  alloc->init_add_free(0, capacity);
+  alloc->init_rm_free(gb - unit, 2 * unit);
+  EXPECT_EQ(capacity - 2 * unit, alloc->get_free());
+  alloc->init_add_free(gb - unit, 2 * unit);
+  EXPECT_EQ(capacity, alloc->get_free());
+
+  PExtentVector extents;
+  EXPECT_EQ(static_cast<int64_t>(capacity),
+	    alloc->allocate(capacity, unit, 0, &extents));
+  EXPECT_EQ(0u, alloc->get_free());
+  uint64_t total = 0;
+  for (auto& e : extents) {
+    total += e.length;
+  }
+  EXPECT_EQ(capacity, total);
+
+  // free a range crossing the 1G and 3G marks, then take it back
+  interval_set<uint64_t> release_set;
+  release_set.insert(gb - unit, 2 * unit);
+  release_set.insert(3 * gb - unit, 2 * unit);
+  alloc->release(release_set);
+  EXPECT_EQ(4 * unit, alloc->get_free());
+
+  PExtentVector again;
+  EXPECT_EQ(static_cast<int64_t>(4 * unit),
+	    alloc->allocate(4 * unit, unit, 0, &again));
+  interval_set<uint64_t> got;
+  for (auto& e : again) {
+    got.insert(e.offset, e.length);
+  }
+  EXPECT_EQ(release_set, got);
+  EXPECT_EQ(-ENOSPC, alloc->allocate(unit, unit, 0, &again));
+
+  interval_set<uint64_t> rest;
+  for (auto& e : extents) {
+    rest.insert(e.offset, e.length);
+  }
+  rest.subtract(release_set);
+  alloc->release(rest);
+  alloc->release(got);
+  EXPECT_EQ(capacity, alloc->get_free());
+}
+
 TEST_P(AllocTest, test_alloc_47883)
 {
   uint64_t block = 0x1000;
@@ -503,4 +558,4 @@ TEST_P(AllocTest, test_alloc_47883)
 INSTANTIATE_TEST_SUITE_P(
   Allocator,
   AllocTest,
-  ::testing::Values("stupid", "bitmap", "avl", "hybrid"));
+  ::testing::Values("stupid", "bitmap", "avl", "hybrid", "sharded"));
@@ -5067,6 +5067,23 @@ TEST_P(StoreTestSpecificAUSize, SyntheticMatrixNoCsum) {
   do_matrix(m, std::bind(&StoreTest::doSyntheticTest, this, _1, _2, _3, _4));
 }
 
+TEST_P(StoreTestSpecificAUSize, SyntheticMatrixKVSyncShards) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  const char *m[][10] = {
+    { "bluestore_min_alloc_size", "4096", 0 }, // to be the first!
+    { "max_write", "65536", 0 },
+    { "max_size", "1048576", 0 },
+    { "alignment", "512", 0 },
+    { "bluestore_kv_sync_shards", "1", "4", 0 },
+    { "bluestore_sync_submit_transaction", "true", "false", 0 },
+    { "bluestore_debug_randomize_serial_transaction", "10", 0 },
+    { 0 },
+  };
+  do_matrix(m, std::bind(&StoreTest::doSyntheticTest, this, _1, _2, _3, _4));
+}
+
 TEST_P(StoreTestSpecificAUSize, SyntheticMatrixPreferDeferred) {
   if (string(GetParam()) != "bluestore")
     return;
@@ -8488,6 +8505,73 @@ TEST_P(StoreTest, BluestoreStatistics) {
   cout << std::endl;
 }
 
+TEST_P(StoreTest, BluestoreAllocSnapshot) {
+  if (string(GetParam()) != "bluestore")
+    return;
+
+  SetVal(g_conf(), "bluestore_alloc_snapshot", "true");
+  g_ceph_context->_conf.apply_changes(nullptr);
+
+  BlueStore* bstore = dynamic_cast<BlueStore*> (store.get());
+  const PerfCounters* logger = store->get_perf_counters();
+  uint64_t loads = logger->get(l_bluestore_alloc_snapshot_loads);
+
+  coll_t cid;
+  auto ch = store->create_new_collection(cid);
+  bufferlist bl;
+  bl.append(std::string(65536, 'a'));
+  ghobject_t hoid(hobject_t("alloc_snapshot", "", CEPH_NOSNAP, 0, 0, ""));
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.write(cid, hoid, 0, bl.length(), bl);
+    int r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  ch.reset();
+
+  // a clean restart loads what umount saved
+  ASSERT_EQ(bstore->umount(), 0);
+  ASSERT_EQ(bstore->mount(), 0);
+  ASSERT_EQ(logger->get(l_bluestore_alloc_snapshot_loads), loads + 1);
+
+  // space in use must not be handed out again
+  ch = store->open_collection(cid);
+  bufferlist other;
+  other.append(std::string(65536, 'b'));
+  for (unsigned i = 0; i < 64; ++i) {
+    ObjectStore::Transaction t;
+    ghobject_t o(hobject_t("alloc_snapshot." + stringify(i), "", CEPH_NOSNAP,
+			   0, 0, ""));
+    t.write(cid, o, 0, other.length(), other);
+    int r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  {
+    bufferlist readback;
+    int r = store->read(ch, hoid, 0, bl.length(), readback);
+    ASSERT_EQ(static_cast<int>(bl.length()), r);
+    ASSERT_TRUE(bl_eq(bl, readback));
+  }
+  ch.reset();
+
+  // without the option the freelist is scanned, and the snapshot dropped
+  ASSERT_EQ(bstore->umount(), 0);
+  SetVal(g_conf(), "bluestore_alloc_snapshot", "false");
+  g_ceph_context->_conf.apply_changes(nullptr);
+  ASSERT_EQ(bstore->mount(), 0);
+  ASSERT_EQ(logger->get(l_bluestore_alloc_snapshot_loads), loads + 1);
+  ASSERT_EQ(bstore->umount(), 0);
+  SetVal(g_conf(), "bluestore_alloc_snapshot", "true");
+  g_ceph_context->_conf.apply_changes(nullptr);
+  ASSERT_EQ(bstore->mount(), 0);
+  ASSERT_EQ(logger->get(l_bluestore_alloc_snapshot_loads), loads + 1);
+
+  ASSERT_EQ(bstore->umount(), 0);
+  ASSERT_EQ(bstore->fsck(false), 0);
+  ASSERT_EQ(bstore->mount(), 0);
+}
+
 TEST_P(StoreTest, BluestorePerPoolOmapFixOnMount)
 {
   if (string(GetParam()) != "bluestore")
@@ -1203,6 +1203,91 @@ void clear_and_dispose(BlueStore::old_extent_map_t& old_em)
   }
 }
 
+static uint64_t onode_cache_bytes()
+{
+  return mempool::bluestore_cache_onode::allocated_bytes() +
+    mempool::bluestore_cache_onode_compact::allocated_bytes() +
+    mempool::bluestore_cache_meta::allocated_bytes() +
+    mempool::bluestore_cache_other::allocated_bytes() +
+    mempool::bluestore_Extent::allocated_bytes() +
+    mempool::bluestore_Blob::allocated_bytes() +
+    mempool::bluestore_SharedBlob::allocated_bytes() +
+    mempool::bluestore_inline_bl::allocated_bytes();
+}
+
+TEST(OnodeCacheShard, compact_footprint)
+{
+  const unsigned num_onodes = 2000;
+  const unsigned num_extents = 16;
+  BlueStore store(g_ceph_context, "", 4096);
+  BlueStore::OnodeCacheShard *oc = BlueStore::OnodeCacheShard::create(
+    g_ceph_context, "compact", NULL);
+  BlueStore::BufferCacheShard *bc = BlueStore::BufferCacheShard::create(
+    g_ceph_context, "lru", NULL);
+  auto coll = ceph::make_ref<BlueStore::Collection>(&store, oc, bc, coll_t());
+
+  uint64_t base = onode_cache_bytes();
+  oc->set_max(num_onodes);
+  oc->set_compact_max(0);
+  vector<ghobject_t> oids;
+  for (unsigned i = 0; i < num_onodes; ++i) {
+    ghobject_t oid(hobject_t(sobject_t("obj" + stringify(i), CEPH_NOSNAP)));
+    BlueStore::OnodeRef o(new BlueStore::Onode(coll.get(), oid, ""));
+    o->exists = true;
+    o->onode.nid = i + 1;
+    o->onode.size = num_extents * 0x10000;
+    for (unsigned j = 0; j < num_extents; ++j) {
+      BlueStore::BlobRef b = coll->new_blob();
+      b->dirty_blob().allocated_test(
+	bluestore_pextent_t(0x1000000ull * i + 0x20000 * j, 0x10000));
+      b->get_ref(coll.get(), 0, 0x10000);
+      o->extent_map.extent_map.insert(
+	*new BlueStore::Extent(0x10000 * j, 0, 0x10000, b));
+    }
+    o->extent_map.update(KeyValueDB::Transaction(), true);
+    coll->onode_map.add(oid, o);
+    oids.push_back(oid);
+  }
+  uint64_t full = onode_cache_bytes() - base;
+  ASSERT_EQ(num_onodes, oc->_get_num());
+
+  // keep a single decoded onode, everything else gets encoded
+  oc->set_compact_max(1ull << 30);
+  oc->set_max(1);
+  oc->trim();
+  ASSERT_EQ(1u, oc->_get_num());
+  uint64_t compact =
+    mempool::bluestore_cache_onode_compact::allocated_bytes();
+  ASSERT_LT(onode_cache_bytes() - base, full);
+
+  double full_per_onode = (double)full / num_onodes;
+  double compact_per_onode = (double)compact / (num_onodes - 1);
+  cout << num_onodes << " onodes, " << num_extents << " extents each"
+       << std::endl;
+  cout << "decoded: " << full_per_onode << " bytes/onode, "
+       << (uint64_t)((1ull << 30) / full_per_onode) << " onodes/GiB"
+       << std::endl;
+  cout << "encoded: " << compact_per_onode << " bytes/onode, "
+       << (uint64_t)((1ull << 30) / compact_per_onode) << " onodes/GiB"
+       << std::endl;
+
+  // inflate them again
+  auto start = ceph::mono_clock::now();
+  for (unsigned i = 0; i < num_onodes - 1; ++i) {
+    bufferlist v;
+    ASSERT_TRUE(coll->onode_map.take_compact(oids[i], &v));
+    BlueStore::OnodeRef o(BlueStore::Onode::decode(coll, oids[i], "", v));
+    ASSERT_EQ(i + 1, o->onode.nid);
+    ASSERT_EQ(num_extents, o->extent_map.extent_map.size());
+  }
+  auto dur = ceph::mono_clock::now() - start;
+  cout << "inflate: " << dur / (num_onodes - 1) << " per onode" << std::endl;
+  ASSERT_EQ(0u, mempool::bluestore_cache_onode_compact::allocated_bytes());
+  ASSERT_FALSE(coll->onode_map.take_compact(oids[0], nullptr));
+
+  coll->onode_map.clear();
+}
+
 TEST(GarbageCollector, BasicTest)
 {
   BlueStore::OnodeCacheShard *oc = BlueStore::OnodeCacheShard::create(
@@ -493,6 +493,69 @@ TEST_P(KVTest, RocksDBShardingIteratorTest) {
   fini();
 }
 
+TEST_P(KVTest, RocksDBIteratorBounds) {
+  if(string(GetParam()) != "rocksdb")
+    return;
+
+  // keys of A are sharded by their first two characters
+  std::string cfs("A(4,0-2)");
+  ASSERT_EQ(0, db->init(g_conf()->bluestore_rocksdb_options));
+  ASSERT_EQ(0, db->create_and_open(cout, cfs));
+  {
+    KeyValueDB::Transaction t = db->get_transaction();
+    for (auto p : {"A", "B", "C"}) {
+      for (auto g : {"aa", "bb", "cc"}) {
+	for (int v = 100; v <= 199; v++) {
+	  std::string key = g + to_string(v);
+	  bufferlist val;
+	  val.append(key);
+	  t->set(p, key, val);
+	}
+      }
+    }
+    ASSERT_EQ(0, db->submit_transaction_sync(t));
+  }
+  auto check = [&](const std::string& prefix,
+		   const std::string& lower,
+		   const std::string& upper,
+		   const std::string& first,
+		   const std::string& last,
+		   int count) {
+    KeyValueDB::IteratorBounds bounds;
+    bounds.lower_bound = lower;
+    bounds.upper_bound = upper;
+    KeyValueDB::Iterator it = db->get_iterator(
+      prefix,
+      KeyValueDB::ITERATOR_SCAN | KeyValueDB::ITERATOR_NOCACHE,
+      std::move(bounds));
+    ASSERT_EQ(0, it->seek_to_first());
+    ASSERT_TRUE(it->valid());
+    ASSERT_EQ(first, it->key());
+    int n = 0;
+    std::string key;
+    for (; it->valid(); it->next()) {
+      key = it->key();
+      ASSERT_EQ(key, it->value().to_str());
+      ASSERT_GE(key, lower);
+      ASSERT_LT(key, upper);
+      n++;
+    }
+    ASSERT_EQ(last, key);
+    ASSERT_EQ(count, n);
+    // seeking past the upper bound finds nothing
+    ASSERT_EQ(0, it->lower_bound(upper));
+    ASSERT_FALSE(it->valid());
+  };
+  // within one shard
+  check("A", "bb120", "bb130", "bb120", "bb129", 10);
+  // across shards
+  check("A", "aa150", "bb150", "aa150", "bb149", 100);
+  // default column family: stays within the prefix
+  check("B", "bb190", "zz", "bb190", "cc199", 110);
+  check("C", "", "aa110", "aa100", "aa109", 10);
+  fini();
+}
+
 TEST_P(KVTest, RocksDBCFMerge) {
   if(string(GetParam()) != "rocksdb")
     return;
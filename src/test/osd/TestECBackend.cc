@@ -17,6 +17,7 @@
 #include <errno.h>
 #include <signal.h>
 #include "osd/ECBackend.h"
+#include "osd/ECMsgTypes.h"
 #include "gtest/gtest.h"
 
 TEST(ECUtil, stripe_info_t)
@@ -58,3 +59,48 @@ TEST(ECUtil, stripe_info_t)
             make_pair((uint64_t)0, 2*swidth));
 }
 
+
+TEST(ECSubWrite, parity_deltas_encoding)
+{
+  hobject_t h(object_t("obj"), "", CEPH_NOSNAP, 0, 1, "");
+  ECSubWrite w;
+  w.tid = 12;
+  w.at_version = eversion_t(10, 301);
+  w.parity_deltas[h][4096][0].append("delta0");
+  w.parity_deltas[h][4096][1].append("delta1");
+  w.parity_deltas[h][8192][1].append("delta2");
+
+  bufferlist bl;
+  encode(w, bl);
+  // struct_v, then struct_compat: shards that would ignore the deltas
+  // must not decode a sub-write carrying them
+  ASSERT_EQ(5, bl[0]);
+  ASSERT_EQ(5, bl[1]);
+
+  ECSubWrite d;
+  auto p = bl.cbegin();
+  decode(d, p);
+  ASSERT_EQ(12u, d.tid);
+  ASSERT_EQ(eversion_t(10, 301), d.at_version);
+  ASSERT_EQ(1u, d.parity_deltas.size());
+  auto &chunks = d.parity_deltas[h];
+  ASSERT_EQ(2u, chunks.size());
+  ASSERT_EQ(2u, chunks[4096].size());
+  ASSERT_TRUE(chunks[4096][0].contents_equal(w.parity_deltas[h][4096][0]));
+  ASSERT_TRUE(chunks[4096][1].contents_equal(w.parity_deltas[h][4096][1]));
+  ASSERT_EQ(1u, chunks[8192].size());
+  ASSERT_TRUE(chunks[8192][1].contents_equal(w.parity_deltas[h][8192][1]));
+
+  // without deltas older shards can still decode it
+  ECSubWrite plain;
+  plain.tid = 13;
+  bufferlist plain_bl;
+  encode(plain, plain_bl);
+  ASSERT_EQ(5, plain_bl[0]);
+  ASSERT_EQ(1, plain_bl[1]);
+  ECSubWrite plain_d;
+  p = plain_bl.cbegin();
+  decode(plain_d, p);
+  ASSERT_EQ(13u, plain_d.tid);
+  ASSERT_TRUE(plain_d.parity_deltas.empty());
+}
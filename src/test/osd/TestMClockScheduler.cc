@@ -6,6 +6,7 @@
 #include "global/global_init.h"
 #include "common/common_init.h"
 
+#include "osd/OSDMap.h"
 #include "osd/scheduler/mClockScheduler.h"
 #include "osd/scheduler/OpSchedulerItem.h"
 
@@ -41,10 +42,13 @@ public:
   struct MockDmclockItem : public PGOpQueueable {
     op_scheduler_class scheduler_class;
 
-    MockDmclockItem(op_scheduler_class _scheduler_class) :
-      PGOpQueueable(spg_t()),
+    MockDmclockItem(op_scheduler_class _scheduler_class, spg_t pgid) :
+      PGOpQueueable(pgid),
       scheduler_class(_scheduler_class) {}
 
+    MockDmclockItem(op_scheduler_class _scheduler_class) :
+      MockDmclockItem(_scheduler_class, spg_t()) {}
+
     MockDmclockItem()
       : MockDmclockItem(op_scheduler_class::background_best_effort) {}
 
@@ -159,3 +163,98 @@ TEST_F(mClockSchedulerTest, TestMultiClientOrderedEnqueueDequeue) {
   }
   ASSERT_TRUE(q.empty());
 }
+
+TEST_F(mClockSchedulerTest, TestPoolProfile) {
+  OSDMap osdmap;
+  uuid_d fsid;
+  osdmap.build_simple(g_ceph_context, 0, fsid, 1);
+  OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+  inc.fsid = osdmap.get_fsid();
+  inc.new_pool_max = osdmap.get_pool_max();
+  pg_pool_t empty;
+  // clients of this pool get no reservation and may do 1 op/s
+  int64_t limited = ++inc.new_pool_max;
+  pg_pool_t *p = inc.get_new_pool(limited, &empty);
+  p->size = 1;
+  p->set_pg_num(8);
+  p->set_pgp_num(8);
+  p->opts.set(pool_opts_t::MCLOCK_CLIENT_RES, static_cast<int64_t>(0));
+  p->opts.set(pool_opts_t::MCLOCK_CLIENT_LIM, static_cast<int64_t>(1));
+  inc.new_pool_names[limited] = "limited";
+  int64_t unlimited = ++inc.new_pool_max;
+  p = inc.get_new_pool(unlimited, &empty);
+  p->size = 1;
+  p->set_pg_num(8);
+  p->set_pgp_num(8);
+  inc.new_pool_names[unlimited] = "unlimited";
+  osdmap.apply_incremental(inc);
+  q.update_from_osdmap(osdmap);
+
+  spg_t limited_pg(pg_t(0, limited));
+  spg_t unlimited_pg(pg_t(0, unlimited));
+  q.enqueue(create_item(100, client1, op_scheduler_class::client,
+			limited_pg));
+  q.enqueue(create_item(101, client1, op_scheduler_class::client,
+			limited_pg));
+
+  auto r = get_item(q.dequeue());
+  ASSERT_EQ(100u, r.get_map_epoch());
+  // over its limit, nothing to do for now
+  ASSERT_TRUE(std::holds_alternative<double>(q.dequeue()));
+
+  // other pools are not held back
+  q.enqueue(create_item(102, client2, op_scheduler_class::client,
+			unlimited_pg));
+  r = get_item(q.dequeue());
+  ASSERT_EQ(client2, r.get_owner());
+  ASSERT_EQ(102u, r.get_map_epoch());
+  ASSERT_TRUE(std::holds_alternative<double>(q.dequeue()));
+}
+
+TEST_F(mClockSchedulerTest, TestPoolProfileChangeWhileQueued) {
+  OSDMap osdmap;
+  uuid_d fsid;
+  osdmap.build_simple(g_ceph_context, 0, fsid, 1);
+  OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+  inc.fsid = osdmap.get_fsid();
+  inc.new_pool_max = osdmap.get_pool_max();
+  pg_pool_t empty;
+  int64_t pool = ++inc.new_pool_max;
+  pg_pool_t *p = inc.get_new_pool(pool, &empty);
+  p->size = 1;
+  p->set_pg_num(8);
+  p->set_pgp_num(8);
+  inc.new_pool_names[pool] = "pool";
+  osdmap.apply_incremental(inc);
+  q.update_from_osdmap(osdmap);
+
+  // client1 is first seen while its pool has no profile of its own
+  spg_t pg(pg_t(0, pool));
+  q.enqueue(create_item(100, client1, op_scheduler_class::client, pg));
+  q.enqueue(create_item(101, client1, op_scheduler_class::client, pg));
+  auto r = get_item(q.dequeue());
+  ASSERT_EQ(100u, r.get_map_epoch());
+
+  // limit the pool to 1 op/s while client1 still has an op queued
+  OSDMap::Incremental inc2(osdmap.get_epoch() + 1);
+  inc2.fsid = osdmap.get_fsid();
+  p = inc2.get_new_pool(pool, osdmap.get_pg_pool(pool));
+  p->opts.set(pool_opts_t::MCLOCK_CLIENT_RES, static_cast<int64_t>(0));
+  p->opts.set(pool_opts_t::MCLOCK_CLIENT_LIM, static_cast<int64_t>(1));
+  osdmap.apply_incremental(inc2);
+  q.update_from_osdmap(osdmap);
+
+  q.enqueue(create_item(102, client1, op_scheduler_class::client, pg));
+  q.enqueue(create_item(103, client1, op_scheduler_class::client, pg));
+  // the new limit holds back client1 without it having to go idle first
+  unsigned served = 0;
+  while (!q.empty()) {
+    auto item = q.dequeue();
+    if (std::holds_alternative<double>(item)) {
+      break;
+    }
+    ++served;
+  }
+  ASSERT_FALSE(q.empty());
+  ASSERT_GE(1u, served);
+}
@@ -295,6 +295,39 @@ TEST_F(OSDMapTest, MapFunctionsMatch) {
   EXPECT_EQ(acting_osds, acting_osds_two);
 }
 
+TEST_F(OSDMapTest, MapPGRangeMatches) {
+  set_up_map();
+
+  // include a pg_temp so the temp handling is covered too
+  pg_t temp_pgid = osdmap.raw_pg_to_pg(pg_t(3, my_rep_pool));
+  vector<int> temp_osds, up_osds;
+  osdmap.pg_to_up_acting_osds(temp_pgid, up_osds, temp_osds);
+  std::reverse(temp_osds.begin(), temp_osds.end());
+  OSDMap::Incremental pgtemp_map(osdmap.get_epoch() + 1);
+  pgtemp_map.new_pg_temp[temp_pgid] = mempool::osdmap::vector<int>(
+    temp_osds.begin(), temp_osds.end());
+  osdmap.apply_incremental(pgtemp_map);
+
+  for (int64_t pool : {my_ec_pool, my_rep_pool}) {
+    unsigned pg_num = osdmap.get_pg_pool(pool)->get_pg_num();
+    vector<vector<int>> up, acting;
+    vector<int> up_primary, acting_primary;
+    osdmap.pg_range_to_up_acting_osds(pool, 0, pg_num, &up, &up_primary,
+				      &acting, &acting_primary);
+    ASSERT_EQ(pg_num, up.size());
+    for (unsigned ps = 0; ps < pg_num; ++ps) {
+      vector<int> one_up, one_acting;
+      int one_up_primary, one_acting_primary;
+      osdmap.pg_to_up_acting_osds(pg_t(ps, pool), &one_up, &one_up_primary,
+				  &one_acting, &one_acting_primary);
+      EXPECT_EQ(one_up, up[ps]);
+      EXPECT_EQ(one_up_primary, up_primary[ps]);
+      EXPECT_EQ(one_acting, acting[ps]);
+      EXPECT_EQ(one_acting_primary, acting_primary[ps]);
+    }
+  }
+}
+
 /** This test must be removed or modified appropriately when we allow
  * other ways to specify a primary. */
 TEST_F(OSDMapTest, PrimaryIsFirst) {
@@ -525,6 +558,51 @@ TEST_F(OSDMapTest, PrimaryAffinity) {
   }
 }
 
+TEST_F(OSDMapTest, CopyOnWrite) {
+  set_up_map();
+
+  size_t before = mempool::osdmap::allocated_bytes();
+  OSDMap next;
+  next.deepish_copy_from(osdmap);
+  size_t copied = mempool::osdmap::allocated_bytes() - before;
+
+  OSDMap::Incremental inc(osdmap.get_epoch() + 1);
+  inc.fsid = osdmap.get_fsid();
+  inc.new_up_thru[0] = inc.epoch;
+  inc.new_weight[1] = CEPH_OSD_OUT;
+  pg_t pgid(0, my_rep_pool);
+  inc.new_pg_temp[pgid] = {3, 4, 5};
+  ASSERT_EQ(0, next.apply_incremental(inc));
+
+  // the original is untouched
+  ASSERT_EQ(0u, osdmap.get_up_thru(0));
+  ASSERT_EQ((unsigned)CEPH_OSD_IN, osdmap.get_weight(1));
+  ASSERT_EQ(0u, osdmap.get_num_pg_temp());
+  ASSERT_EQ(inc.epoch, next.get_up_thru(0));
+  ASSERT_EQ((unsigned)CEPH_OSD_OUT, next.get_weight(1));
+  ASSERT_EQ(1u, next.get_num_pg_temp());
+
+  // and the copy is the same map as a decoded one, only smaller
+  OSDMap decoded;
+  {
+    bufferlist bl;
+    osdmap.encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+    before = mempool::osdmap::allocated_bytes();
+    decoded.decode(bl);
+    ASSERT_LT(copied, mempool::osdmap::allocated_bytes() - before);
+  }
+  ASSERT_EQ(0, decoded.apply_incremental(inc));
+  bufferlist a, b;
+  next.encode(a, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+  decoded.encode(b, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+  ASSERT_TRUE(a.contents_equal(b));
+
+  // dedup shares whatever is equal again
+  size_t deduped = mempool::osdmap::allocated_bytes();
+  OSDMap::dedup(&next, &decoded);
+  ASSERT_GT(deduped, mempool::osdmap::allocated_bytes());
+}
+
 TEST_F(OSDMapTest, get_osd_crush_node_flags) {
   set_up_map();
 
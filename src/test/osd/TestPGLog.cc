@@ -2371,6 +2371,180 @@ TEST_F(PGLogTestRebuildMissing, MissingNotInLog) {
   run_rebuild_missing_test(expected);
 }
 
+class PGLogChunkTest : public PGLogTest, public StoreTestFixture {
+public:
+  PGLogChunkTest() : PGLogTest(), StoreTestFixture("memstore") {}
+  void SetUp() override {
+    StoreTestFixture::SetUp();
+    ObjectStore::Transaction t;
+    test_coll = coll_t(spg_t(pg_t(1, 1)));
+    ch = store->create_new_collection(test_coll);
+    t.create_collection(test_coll, 0);
+    store->queue_transaction(ch, std::move(t));
+    log_oid = ghobject_t(mk_obj(100));
+    info.last_backfill = hobject_t::get_max();
+  }
+
+  void TearDown() override {
+    clear();
+    g_ceph_context->_conf.set_val_or_die("osd_pg_log_chunk_entries", "0");
+    StoreTestFixture::TearDown();
+  }
+
+  pg_info_t info;
+  coll_t test_coll;
+  ghobject_t log_oid;
+
+  void set_chunk_entries(const char *n) {
+    g_ceph_context->_conf.set_val_or_die("osd_pg_log_chunk_entries", n);
+  }
+
+  void append(version_t from, version_t to) {
+    for (version_t v = from; v <= to; ++v) {
+      add(mk_ple_mod(mk_obj(v), mk_evt(10, v), mk_evt(10, v - 1)));
+    }
+    info.last_update = info.last_complete = log.head;
+  }
+
+  void write(map<string, bufferlist> *written = nullptr) {
+    ObjectStore::Transaction t;
+    map<string, bufferlist> km;
+    write_log_and_missing(t, &km, test_coll, log_oid, false);
+    if (!km.empty()) {
+      t.omap_setkeys(test_coll, log_oid, km);
+    }
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+    if (written) {
+      written->swap(km);
+    }
+  }
+
+  void read_back() {
+    list<eversion_t> expected;
+    for (auto& e : log.log) {
+      expected.push_back(e.version);
+    }
+    clear();
+    ostringstream err;
+    read_log_and_missing(store.get(), ch, log_oid, info, err, false);
+    list<eversion_t> actual;
+    for (auto& e : log.log) {
+      actual.push_back(e.version);
+    }
+    ASSERT_EQ(expected, actual);
+  }
+
+  // number of per-entry keys and of chunk keys the log is stored in
+  pair<unsigned, unsigned> count_keys() {
+    pair<unsigned, unsigned> r;
+    auto p = store->get_omap_iterator(ch, log_oid);
+    for (p->seek_to_first(); p->valid(); p->next()) {
+      if (isdigit(p->key()[0]))
+	++r.first;
+      else if (p->key().compare(0, 6, "chunk_") == 0)
+	++r.second;
+    }
+    return r;
+  }
+};
+
+TEST_F(PGLogChunkTest, AppendAndTrim) {
+  set_chunk_entries("4");
+  append(1, 6);
+  write();
+  append(7, 10);
+  write();
+  // chunks 1-3 and 4-7, 8-10 still under their own keys
+  EXPECT_EQ(make_pair(3u, 2u), count_keys());
+  read_back();
+  EXPECT_EQ(10u, log.log.size());
+
+  // the chunk holding 7 stays until 7 itself is trimmed
+  trim(mk_evt(10, 6), info);
+  write();
+  EXPECT_EQ(make_pair(3u, 1u), count_keys());
+  read_back();
+  ASSERT_EQ(4u, log.log.size());
+  EXPECT_EQ(mk_evt(10, 7), log.log.front().version);
+
+  trim(mk_evt(10, 9), info);
+  append(11, 13);
+  write();
+  // chunk 8-11, now holding 10 and 11, and 12-13 under their own keys
+  EXPECT_EQ(make_pair(2u, 1u), count_keys());
+  read_back();
+  ASSERT_EQ(4u, log.log.size());
+  EXPECT_EQ(mk_evt(10, 10), log.log.front().version);
+  EXPECT_EQ(mk_evt(10, 13), log.log.back().version);
+}
+
+TEST_F(PGLogChunkTest, AppendWritesOnlyNewEntries) {
+  set_chunk_entries("8");
+  append(1, 20);
+  write();
+
+  // an append inside the newest chunk writes just that entry
+  append(21, 21);
+  map<string, bufferlist> km;
+  write(&km);
+  ASSERT_EQ(1u, km.size());
+  EXPECT_EQ(mk_evt(10, 21).get_key_name(), km.begin()->first);
+  bufferlist bl;
+  log.log.back().encode_with_checksum(bl);
+  EXPECT_EQ(bl.length(), km.begin()->second.length());
+
+  append(22, 23);
+  write(&km);
+  EXPECT_EQ(2u, km.size());
+
+  // the first entry of the next chunk seals 16-23 into one key
+  append(24, 24);
+  write(&km);
+  ASSERT_EQ(2u, km.size());
+  EXPECT_EQ(1u, km.count(get_log_chunk_key(16, 8)));
+  EXPECT_EQ(1u, km.count(mk_evt(10, 24).get_key_name()));
+  EXPECT_EQ(make_pair(1u, 3u), count_keys());
+  read_back();
+  EXPECT_EQ(24u, log.log.size());
+}
+
+TEST_F(PGLogChunkTest, Rewind) {
+  set_chunk_entries("4");
+  append(1, 10);
+  write();
+  // the tail of the log diverged; rewrite from version 6 on
+  while (log.log.back().version > mk_evt(10, 5)) {
+    log.unindex(log.log.back());
+    log.log.pop_back();
+  }
+  log.head = mk_evt(10, 5);
+  mark_dirty_from(mk_evt(10, 6));
+  info.last_update = info.last_complete = log.head;
+  write();
+  // chunk 1-3; 4-5 are the newest chunk again and go back to their own keys
+  EXPECT_EQ(make_pair(2u, 1u), count_keys());
+  read_back();
+  EXPECT_EQ(5u, log.log.size());
+}
+
+TEST_F(PGLogChunkTest, SwitchLayout) {
+  append(1, 10);
+  write();
+  EXPECT_EQ(make_pair(10u, 0u), count_keys());
+
+  set_chunk_entries("8");
+  write();
+  EXPECT_EQ(make_pair(3u, 1u), count_keys());
+  read_back();
+  EXPECT_EQ(10u, log.log.size());
+
+  set_chunk_entries("0");
+  write();
+  EXPECT_EQ(make_pair(10u, 0u), count_keys());
+  read_back();
+  EXPECT_EQ(10u, log.log.size());
+}
+
 
 class PGLogMergeDupsTest : protected PGLog, public StoreTestFixture {
 
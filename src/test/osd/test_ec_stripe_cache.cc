@@ -0,0 +1,144 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <gtest/gtest.h>
+#include "osd/ECStripeCache.h"
+
+#include "test/unit.cc"
+
+static bufferlist make_bl(uint64_t len, char c)
+{
+  bufferlist bl;
+  bl.append(std::string(len, c));
+  return bl;
+}
+
+static hobject_t make_oid(const std::string &name)
+{
+  return hobject_t(object_t(name), "", CEPH_NOSNAP, 0, 1, "");
+}
+
+static extent_set make_set(uint64_t off, uint64_t len)
+{
+  extent_set out;
+  out.insert(off, len);
+  return out;
+}
+
+TEST(ecstripecache, hit_and_miss)
+{
+  ECStripeCache c(g_ceph_context);
+  spg_t pgid(pg_t(0, 1), shard_id_t(0));
+  hobject_t oid = make_oid("foo");
+
+  extent_map out;
+  ASSERT_FALSE(c.lookup(pgid, oid, make_set(0, 8192), &out));
+
+  c.insert(pgid, oid, 0, make_bl(4096, 'a'));
+  c.insert(pgid, oid, 4096, make_bl(4096, 'b'));
+  ASSERT_EQ(8192u, c.get_bytes());
+  ASSERT_EQ(1u, c.get_num_objects());
+
+  ASSERT_TRUE(c.lookup(pgid, oid, make_set(4096, 4096), &out));
+  ASSERT_EQ(make_set(4096, 4096), out.get_interval_set());
+  ASSERT_TRUE(out.begin().get_val().contents_equal(make_bl(4096, 'b')));
+
+  // partially cached is a miss
+  extent_map out2;
+  ASSERT_FALSE(c.lookup(pgid, oid, make_set(4096, 8192), &out2));
+  ASSERT_TRUE(out2.empty());
+
+  // overwrite replaces what was there
+  c.insert(pgid, oid, 0, make_bl(4096, 'c'));
+  ASSERT_EQ(8192u, c.get_bytes());
+  extent_map out3;
+  ASSERT_TRUE(c.lookup(pgid, oid, make_set(0, 4096), &out3));
+  ASSERT_TRUE(out3.begin().get_val().contents_equal(make_bl(4096, 'c')));
+
+  // same object in another pg is another object
+  spg_t other(pg_t(1, 1), shard_id_t(0));
+  ASSERT_FALSE(c.lookup(other, oid, make_set(0, 4096), &out3));
+}
+
+TEST(ecstripecache, invalidate)
+{
+  ECStripeCache c(g_ceph_context);
+  spg_t pgid(pg_t(0, 1), shard_id_t(0));
+  spg_t other(pg_t(1, 1), shard_id_t(0));
+  hobject_t foo = make_oid("foo");
+  hobject_t bar = make_oid("bar");
+
+  c.insert(pgid, foo, 0, make_bl(4096, 'a'));
+  c.insert(pgid, bar, 0, make_bl(4096, 'a'));
+  c.insert(other, foo, 0, make_bl(4096, 'a'));
+  ASSERT_EQ(3u, c.get_num_objects());
+
+  c.invalidate(pgid, foo);
+  extent_map out;
+  ASSERT_FALSE(c.lookup(pgid, foo, make_set(0, 4096), &out));
+  ASSERT_TRUE(c.lookup(pgid, bar, make_set(0, 4096), &out));
+  ASSERT_EQ(8192u, c.get_bytes());
+
+  c.clear_pg(pgid);
+  ASSERT_FALSE(c.lookup(pgid, bar, make_set(0, 4096), &out));
+  ASSERT_TRUE(c.lookup(other, foo, make_set(0, 4096), &out));
+  ASSERT_EQ(4096u, c.get_bytes());
+  ASSERT_EQ(1u, c.get_num_objects());
+}
+
+TEST(ecstripecache, lru)
+{
+  g_ceph_context->_conf.set_val("osd_ec_stripe_cache_size", "12288");
+  ECStripeCache c(g_ceph_context);
+  g_ceph_context->_conf.rm_val("osd_ec_stripe_cache_size");
+  spg_t pgid(pg_t(0, 1), shard_id_t(0));
+  hobject_t a = make_oid("a");
+  hobject_t b = make_oid("b");
+  hobject_t d = make_oid("d");
+
+  c.insert(pgid, a, 0, make_bl(4096, 'a'));
+  c.insert(pgid, b, 0, make_bl(4096, 'b'));
+  c.insert(pgid, d, 0, make_bl(4096, 'd'));
+  ASSERT_EQ(12288u, c.get_bytes());
+
+  // touch a so that b is the oldest
+  extent_map out;
+  ASSERT_TRUE(c.lookup(pgid, a, make_set(0, 4096), &out));
+
+  c.insert(pgid, d, 4096, make_bl(4096, 'd'));
+  ASSERT_EQ(12288u, c.get_bytes());
+  ASSERT_FALSE(c.lookup(pgid, b, make_set(0, 4096), &out));
+  ASSERT_TRUE(c.lookup(pgid, a, make_set(0, 4096), &out));
+  ASSERT_TRUE(c.lookup(pgid, d, make_set(0, 8192), &out));
+}
+
+TEST(ecstripecache, autotune)
+{
+  ECStripeCache c(g_ceph_context);
+  spg_t pgid(pg_t(0, 1), shard_id_t(0));
+  hobject_t oid = make_oid("foo");
+
+  c.insert(pgid, oid, 0, make_bl(4096, 'a'));
+  ASSERT_EQ(4096,
+	    c.request_cache_bytes(PriorityCache::Priority::PRI1, 1 << 20));
+
+  // nothing committed yet: everything goes
+  c.set_autotune(true);
+  ASSERT_EQ(0u, c.get_bytes());
+
+  c.set_cache_bytes(PriorityCache::Priority::PRI1, 1 << 20);
+  ASSERT_LE(1 << 20, c.commit_cache_size(64 << 20));
+  c.insert(pgid, oid, 0, make_bl(4096, 'a'));
+  ASSERT_EQ(4096u, c.get_bytes());
+  ASSERT_EQ(0,
+	    c.request_cache_bytes(PriorityCache::Priority::PRI1, 1 << 20));
+}
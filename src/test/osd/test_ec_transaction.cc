@@ -15,6 +15,8 @@
 #include <gtest/gtest.h>
 #include "osd/PGTransaction.h"
 #include "osd/ECTransaction.h"
+#include "erasure-code/ErasureCode.h"
+#include "test/objectstore/store_test_fixture.h"
 
 #include "test/unit.cc"
 
@@ -122,3 +124,252 @@ TEST(ectransaction, many_writes)
   ASSERT_EQ(0u, plan.to_read.size());
   ASSERT_EQ(1u, plan.will_write.size());
 }
+
+TEST(ectransaction, parity_delta_shards)
+{
+  hobject_t h;
+  bufferlist a;
+  a.append_zero(512);
+
+  // k=2, 4096 byte chunks, object already 16 stripes long
+  ECUtil::stripe_info_t sinfo(2, 8192);
+  auto get_hinfo = [&](const hobject_t &i) {
+    ECUtil::HashInfoRef ref(new ECUtil::HashInfo(1));
+    ref->set_projected_total_logical_size(sinfo, 16 * 8192);
+    return ref;
+  };
+
+  {
+    // two small writes, each within a single chunk
+    PGTransactionUPtr t(new PGTransaction);
+    t->write(h, 8192 + 100, a.length(), a, 0);
+    t->write(h, 5 * 8192 + 4096, a.length(), a, 0);
+    auto plan = ECTransaction::get_write_plan(
+      sinfo, std::move(t), get_hinfo, &dpp);
+    ASSERT_EQ(1u, plan.delta_shards.size());
+    auto &stripes = plan.delta_shards[h];
+    ASSERT_EQ(2u, stripes.size());
+    ASSERT_EQ(std::set<int>{0}, stripes[8192]);
+    ASSERT_EQ(std::set<int>{1}, stripes[5 * 8192]);
+    ASSERT_EQ(2u, plan.to_read[h].num_intervals());
+  }
+
+  {
+    // spans both data chunks of the stripe: a full rmw is as cheap
+    PGTransactionUPtr t(new PGTransaction);
+    t->write(h, 8192 + 4000, a.length(), a, 0);
+    auto plan = ECTransaction::get_write_plan(
+      sinfo, std::move(t), get_hinfo, &dpp);
+    ASSERT_TRUE(plan.delta_shards.empty());
+  }
+
+  {
+    // extends the object
+    PGTransactionUPtr t(new PGTransaction);
+    t->write(h, 16 * 8192 - 100, a.length(), a, 0);
+    auto plan = ECTransaction::get_write_plan(
+      sinfo, std::move(t), get_hinfo, &dpp);
+    ASSERT_TRUE(plan.delta_shards.empty());
+  }
+}
+
+// k=2, m=1: the coding chunk is the xor of the two data chunks
+class ErasureCodeXor final : public ceph::ErasureCode {
+public:
+  unsigned int get_chunk_count() const override {
+    return 3;
+  }
+  unsigned int get_data_chunk_count() const override {
+    return 2;
+  }
+  unsigned int get_chunk_size(unsigned int object_size) const override {
+    return object_size / 2;
+  }
+  int encode_chunks(const std::set<int> &want_to_encode,
+		    std::map<int, bufferlist> *encoded) override {
+    const char *a = (*encoded)[0].c_str();
+    const char *b = (*encoded)[1].c_str();
+    char *c = (*encoded)[2].c_str();
+    for (unsigned i = 0; i < (*encoded)[2].length(); ++i) {
+      c[i] = a[i] ^ b[i];
+    }
+    return 0;
+  }
+  int decode_chunks(const std::set<int> &want_to_read,
+		    const std::map<int, bufferlist> &chunks,
+		    std::map<int, bufferlist> *decoded) override {
+    ceph_abort();
+    return 0;
+  }
+};
+
+class ECParityDeltaTest : public StoreTestFixture {
+public:
+  ECParityDeltaTest() : StoreTestFixture("memstore") {}
+};
+
+TEST_F(ECParityDeltaTest, matches_full_encode)
+{
+  ceph::ErasureCodeInterfaceRef ec(new ErasureCodeXor);
+  ECUtil::stripe_info_t sinfo(2, 8192);
+  const uint64_t chunk_size = sinfo.get_chunk_size();
+  const uint64_t size = 4 * sinfo.get_stripe_width();
+  const std::set<int> all_shards = {0, 1, 2};
+  pg_t pgid(0, 1);
+  hobject_t head(object_t("obj"), "", CEPH_NOSNAP, 0, 1, "");
+  hobject_t h = head.make_temp_hobject("parity_delta");
+
+  bufferptr old_ptr(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    old_ptr[i] = (char)(i * 7 + i / 4096);
+  }
+  bufferlist old_data;
+  old_data.append(old_ptr);
+  std::map<int, bufferlist> old_shards;
+  ASSERT_EQ(0, ECUtil::encode(sinfo, ec, old_data, all_shards, &old_shards));
+
+  std::map<shard_id_t, ObjectStore::CollectionHandle> chs;
+  for (int shard : all_shards) {
+    coll_t cid(spg_t(pgid, shard_id_t(shard)));
+    auto ch = store->create_new_collection(cid);
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.write(cid, ghobject_t(h, ghobject_t::NO_GEN, shard_id_t(shard)),
+	    0, old_shards[shard].length(), old_shards[shard]);
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+    chs[shard_id_t(shard)] = ch;
+  }
+
+  // overwrite part of the first data chunk of stripe 1 and of the
+  // second data chunk of stripe 3
+  bufferlist a, b;
+  a.append(std::string(512, 'a'));
+  b.append(std::string(100, 'b'));
+  const uint64_t a_off = 8192 + 100;
+  const uint64_t b_off = 3 * 8192 + 4096 + 3000;
+  PGTransactionUPtr pgt(new PGTransaction);
+  pgt->write(h, a_off, a.length(), a, 0);
+  pgt->write(h, b_off, b.length(), b, 0);
+  auto plan = ECTransaction::get_write_plan(
+    sinfo,
+    std::move(pgt),
+    [&](const hobject_t &i) {
+      ECUtil::HashInfoRef ref(new ECUtil::HashInfo(3));
+      ref->set_total_chunk_size_clear_hash(size / 2);
+      ref->set_projected_total_logical_size(sinfo, size);
+      return ref;
+    },
+    &dpp);
+  ASSERT_EQ(1u, plan.delta_shards.size());
+  plan.parity_delta = true;
+
+  // what ECBackend reads before the write: just the chunks that change
+  std::map<hobject_t, extent_map> partial_extents;
+  for (auto &&[stripe_off, shards] : plan.delta_shards[h]) {
+    for (int shard : shards) {
+      uint64_t off = stripe_off + shard * chunk_size;
+      bufferlist chunk;
+      chunk.substr_of(old_data, off, chunk_size);
+      partial_extents[h].insert(off, chunk_size, chunk);
+    }
+  }
+
+  std::vector<pg_log_entry_t> entries;
+  std::map<hobject_t, extent_map> written;
+  std::map<shard_id_t, ObjectStore::Transaction> transactions;
+  for (int shard : all_shards) {
+    transactions[shard_id_t(shard)];
+  }
+  std::set<hobject_t> temp_added, temp_removed;
+  std::map<shard_id_t, ECTransaction::parity_delta_map_t> parity_deltas;
+  ECTransaction::generate_transactions(
+    plan, ec, pgid, sinfo, partial_extents, entries, &written,
+    &transactions, &temp_added, &temp_removed, &dpp,
+    ceph_release_t::pacific, &parity_deltas);
+
+  // only the coding shard gets deltas, one per stripe written
+  ASSERT_EQ(1u, parity_deltas.size());
+  ASSERT_EQ(2u, parity_deltas[shard_id_t(2)][h].size());
+
+  for (int shard : all_shards) {
+    auto &t = transactions[shard_id_t(shard)];
+    if (parity_deltas.count(shard_id_t(shard))) {
+      ASSERT_EQ(0, ECTransaction::apply_parity_deltas(
+	ec, store.get(), chs[shard_id_t(shard)], shard_id_t(shard),
+	parity_deltas[shard_id_t(shard)], &t, &dpp));
+    }
+    ASSERT_EQ(0, store->queue_transaction(chs[shard_id_t(shard)],
+					  std::move(t)));
+  }
+
+  bufferlist new_data;
+  new_data.substr_of(old_data, 0, a_off);
+  new_data.append(a);
+  bufferlist mid;
+  mid.substr_of(old_data, a_off + a.length(), b_off - a_off - a.length());
+  new_data.append(mid);
+  new_data.append(b);
+  bufferlist tail;
+  tail.substr_of(old_data, b_off + b.length(), size - b_off - b.length());
+  new_data.append(tail);
+  ASSERT_EQ(size, new_data.length());
+  std::map<int, bufferlist> new_shards;
+  ASSERT_EQ(0, ECUtil::encode(sinfo, ec, new_data, all_shards, &new_shards));
+
+  for (int shard : all_shards) {
+    bufferlist bl;
+    ASSERT_EQ((int)(size / 2),
+	      store->read(chs[shard_id_t(shard)],
+			  ghobject_t(h, ghobject_t::NO_GEN, shard_id_t(shard)),
+			  0, size / 2, bl));
+    ASSERT_TRUE(bl.contents_equal(new_shards[shard])) << "shard " << shard;
+  }
+}
+
+TEST_F(ECParityDeltaTest, unreadable_coding_chunk)
+{
+  ceph::ErasureCodeInterfaceRef ec(new ErasureCodeXor);
+  const uint64_t chunk_size = 4096;
+  pg_t pgid(0, 1);
+  hobject_t head(object_t("obj"), "", CEPH_NOSNAP, 0, 1, "");
+  hobject_t h = head.make_temp_hobject("parity_delta");
+  const shard_id_t shard(2);
+  coll_t cid(spg_t(pgid, shard));
+  ghobject_t goid(h, ghobject_t::NO_GEN, shard);
+
+  // the coding shard only has the chunk of the first stripe
+  auto ch = store->create_new_collection(cid);
+  bufferlist old_chunk;
+  old_chunk.append(std::string(chunk_size, 'p'));
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.write(cid, goid, 0, old_chunk.length(), old_chunk);
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+  }
+
+  ECTransaction::parity_delta_map_t deltas;
+  for (uint64_t off : {(uint64_t)0, chunk_size}) {
+    bufferlist delta;
+    delta.append(std::string(chunk_size, 'd'));
+    deltas[h][off][0] = delta;
+  }
+
+  // the chunk of the second stripe can't be read: nothing is written,
+  // not even the update of the first one
+  ObjectStore::Transaction t;
+  ASSERT_EQ(-EIO, ECTransaction::apply_parity_deltas(
+	      ec, store.get(), ch, shard, deltas, &t, &dpp));
+  ASSERT_TRUE(t.empty());
+
+  // nor when the chunk is gone altogether
+  {
+    ObjectStore::Transaction rm;
+    rm.remove(cid, goid);
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(rm)));
+  }
+  deltas[h].erase(chunk_size);
+  ASSERT_EQ(-ENOENT, ECTransaction::apply_parity_deltas(
+	      ec, store.get(), ch, shard, deltas, &t, &dpp));
+  ASSERT_TRUE(t.empty());
+}
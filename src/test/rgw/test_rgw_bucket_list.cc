@@ -0,0 +1,184 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ */
+
+#include "rgw/rgw_rados.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+using Cursors = RGWRados::BucketListCursors;
+
+// an index shard, listed after a key the way cls_rgw does
+struct FakeShard {
+  std::vector<std::string> names; // sorted
+  bool stuck = false; // scans only entries that are filtered out
+  int reads = 0;
+
+  rgw_cls_list_ret list(const std::string& after, uint32_t max) {
+    rgw_cls_list_ret ret;
+    auto i = std::upper_bound(names.begin(), names.end(), after);
+    if (stuck) {
+      ret.is_truncated = true;
+      return ret;
+    }
+    for (; i != names.end() && ret.dir.m.size() < max; ++i) {
+      rgw_bucket_dir_entry e;
+      e.key.name = *i;
+      e.exists = true;
+      ret.dir.m.emplace(*i, std::move(e));
+    }
+    ret.is_truncated = (i != names.end());
+    return ret;
+  }
+};
+
+class BucketListMerge : public ::testing::Test {
+protected:
+  std::vector<FakeShard> fakes;
+  Cursors cursors;
+  std::vector<std::string> listed;
+  uint32_t count = 0;
+  bool truncated = false;
+  std::optional<rgw_obj_index_key> last;
+
+  void init(std::vector<FakeShard>&& shards, uint32_t first_read) {
+    fakes = std::move(shards);
+    for (size_t i = 0; i < fakes.size(); ++i) {
+      auto s = std::make_unique<Cursors::Shard>();
+      s->shard_id = i;
+      s->last_read = first_read;
+      cursors.set_result(*s, fakes[i].list("", first_read));
+      cursors.shards.push_back(std::move(s));
+    }
+    cursors.valid = true;
+  }
+
+  int merge(uint32_t num_entries) {
+    listed.clear();
+    return cursors.merge(
+      g_ceph_context, num_entries,
+      [this] (Cursors::Shard& s, uint32_t n) {
+	auto& fake = fakes[s.shard_id];
+	++fake.reads;
+	cursors.set_result(s, fake.list(s.next_start.name, n));
+	return 0;
+      },
+      nullptr,
+      [this] (Cursors::Shard& s, const std::string& name,
+	      rgw_bucket_dir_entry& dirent) {
+	listed.push_back(name);
+	return 0;
+      },
+      &count, &truncated, &last);
+  }
+};
+
+using Names = std::vector<std::string>;
+
+} // anonymous namespace
+
+TEST_F(BucketListMerge, CommonPrefixAcrossShards)
+{
+  init({{{"a", "dir/", "z"}}, {{"dir/", "m"}}, {{"dir/"}}}, 8);
+
+  ASSERT_EQ(0, merge(10));
+  EXPECT_EQ(Names({"a", "dir/", "m", "z"}), listed);
+  EXPECT_EQ(4u, count);
+  EXPECT_FALSE(truncated);
+  ASSERT_TRUE(last);
+  EXPECT_EQ("z", last->name);
+}
+
+TEST_F(BucketListMerge, CommonPrefixAcrossCalls)
+{
+  init({{{"a", "dir/"}}, {{"dir/", "m"}}}, 8);
+
+  // stops with the common prefix of one shard merged and the other's
+  // still under its cursor
+  ASSERT_EQ(0, merge(2));
+  EXPECT_EQ(Names({"a", "dir/"}), listed);
+  EXPECT_TRUE(truncated);
+  ASSERT_TRUE(last);
+  EXPECT_EQ("dir/", last->name);
+  EXPECT_TRUE(cursors.valid);
+  EXPECT_EQ("dir/", cursors.marker.name);
+  EXPECT_EQ("dir/", cursors.last_name);
+
+  // continuing with the same cursors doesn't return it again
+  ASSERT_EQ(0, merge(2));
+  EXPECT_EQ(Names({"m"}), listed);
+  EXPECT_EQ(1u, count);
+  EXPECT_FALSE(truncated);
+  EXPECT_EQ(0, fakes[0].reads);
+  EXPECT_EQ(0, fakes[1].reads);
+}
+
+TEST_F(BucketListMerge, RefillTruncatedShard)
+{
+  init({{{"a", "c", "e", "g", "i", "k"}}, {{"b", "d"}}}, 2);
+  ASSERT_TRUE(cursors.shards[0]->result.is_truncated);
+
+  // only the shard that ran out is read again, and the merge goes on
+  ASSERT_EQ(0, merge(20));
+  EXPECT_EQ(Names({"a", "b", "c", "d", "e", "g", "i", "k"}), listed);
+  EXPECT_EQ(8u, count);
+  EXPECT_FALSE(truncated);
+  EXPECT_EQ(1, fakes[0].reads);
+  EXPECT_EQ(0, fakes[1].reads);
+}
+
+TEST_F(BucketListMerge, RefillAcrossCalls)
+{
+  init({{{"a", "c", "e", "g"}}, {{"b", "d", "f", "h"}}}, 2);
+
+  ASSERT_EQ(0, merge(3));
+  EXPECT_EQ(Names({"a", "b", "c"}), listed);
+  EXPECT_TRUE(truncated);
+  EXPECT_TRUE(cursors.valid);
+
+  ASSERT_EQ(0, merge(10));
+  EXPECT_EQ(Names({"d", "e", "f", "g", "h"}), listed);
+  EXPECT_FALSE(truncated);
+}
+
+TEST_F(BucketListMerge, TruncatedShardRunsDry)
+{
+  init({{{"a"}}, {{"b", "c"}}}, 8);
+  // the shard claims there is more, but every read comes back empty
+  cursors.shards[0]->result.is_truncated = true;
+  fakes[0].stuck = true;
+
+  ASSERT_EQ(0, merge(10));
+  EXPECT_EQ(Names({"a"}), listed);
+  EXPECT_EQ(1u, count);
+  EXPECT_TRUE(truncated);
+  EXPECT_EQ(4, fakes[0].reads);
+  // what comes next is unknown, so a following call starts over
+  EXPECT_FALSE(cursors.valid);
+
+  // stuck from its first read: everything it scanned was filtered out
+  cursors.reset();
+  init({{{"a", "b"}, true}, {{"c", "d"}}}, 8);
+  ASSERT_TRUE(cursors.shards[0]->at_end());
+  ASSERT_TRUE(cursors.shards[0]->result.is_truncated);
+
+  // nothing of shard 1 can be returned, as shard 0 may sort before it
+  ASSERT_EQ(0, merge(10));
+  EXPECT_TRUE(listed.empty());
+  EXPECT_EQ(0u, count);
+  EXPECT_TRUE(truncated);
+  EXPECT_FALSE(last);
+  EXPECT_EQ(4, fakes[0].reads);
+  EXPECT_EQ(0, fakes[1].reads);
+  EXPECT_FALSE(cursors.valid);
+}
@@ -0,0 +1,124 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ */
+
+#include "rgw/rgw_cache.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+struct Chained : public RGWChainedCache {
+  std::set<std::string> keys;
+  void chain_cb(const std::string& key, void *data) override {
+    keys.insert(key);
+  }
+  void invalidate(const std::string& key) override {
+    keys.erase(key);
+  }
+  void invalidate_all() override {
+    keys.clear();
+  }
+};
+
+class ObjectCacheTest : public ::testing::Test {
+protected:
+  ObjectCache cache;
+
+  void init(int64_t lru_size, uint64_t shards) {
+    auto& conf = g_ceph_context->_conf;
+    conf.set_val_or_die("rgw_cache_lru_size", std::to_string(lru_size));
+    conf.set_val_or_die("rgw_cache_shards", std::to_string(shards));
+    cache.set_ctx(g_ceph_context);
+    cache.set_enabled(true);
+  }
+  void put(const std::string& name, rgw_cache_entry_info *cache_info = nullptr) {
+    ObjectCacheInfo info;
+    info.flags = CACHE_FLAG_DATA;
+    info.data.append(name);
+    cache.put(name, info, cache_info);
+  }
+  bool cached(const std::string& name) {
+    ObjectCacheInfo info;
+    return cache.get(name, info, CACHE_FLAG_DATA, nullptr) == 0 &&
+      info.data.to_str() == name;
+  }
+};
+
+} // anonymous namespace
+
+TEST_F(ObjectCacheTest, PutGetRemove)
+{
+  init(1000, 8);
+  ASSERT_EQ(8u, cache.get_num_shards());
+  for (int i = 0; i < 100; ++i) {
+    put("obj" + std::to_string(i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(cached("obj" + std::to_string(i)));
+  }
+  EXPECT_FALSE(cached("other"));
+  EXPECT_TRUE(cache.remove("obj1"));
+  EXPECT_FALSE(cache.remove("obj1"));
+  EXPECT_FALSE(cached("obj1"));
+  cache.invalidate_all();
+  EXPECT_FALSE(cached("obj2"));
+}
+
+TEST_F(ObjectCacheTest, ClockSecondChance)
+{
+  init(4, 1);
+  put("a");
+  put("b");
+  put("c");
+  put("d");
+  // a was used since it was added, so the clock passes it over
+  ASSERT_TRUE(cached("a"));
+  put("e");
+  EXPECT_FALSE(cached("b"));
+  EXPECT_TRUE(cached("a"));
+  EXPECT_TRUE(cached("c"));
+  EXPECT_TRUE(cached("d"));
+  EXPECT_TRUE(cached("e"));
+  // all referenced now: the hand goes around once and takes the next one
+  put("f");
+  EXPECT_FALSE(cached("c"));
+  EXPECT_TRUE(cached("f"));
+}
+
+TEST_F(ObjectCacheTest, ChainedInvalidate)
+{
+  init(4, 2);
+  Chained chained;
+  cache.chain_cache(&chained);
+
+  rgw_cache_entry_info a, b;
+  put("a", &a);
+  put("b", &b);
+  const std::string key = "ab";
+  RGWChainedCache::Entry entry(&chained, key, nullptr);
+  ASSERT_TRUE(cache.chain_cache_entry({&a, &b}, &entry));
+  EXPECT_EQ(1u, chained.keys.count("ab"));
+
+  // any of the entries it was built from going away drops it
+  cache.remove("b");
+  EXPECT_EQ(0u, chained.keys.count("ab"));
+  ASSERT_FALSE(cache.chain_cache_entry({&a, &b}, &entry));
+
+  // as does an update of one of them
+  put("b", &b);
+  ASSERT_TRUE(cache.chain_cache_entry({&a, &b}, &entry));
+  put("a");
+  EXPECT_EQ(0u, chained.keys.count("ab"));
+  ASSERT_FALSE(cache.chain_cache_entry({&a, &b}, &entry));
+
+  cache.unchain_cache(&chained);
+}
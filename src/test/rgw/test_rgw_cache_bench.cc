@@ -0,0 +1,108 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+// Measures metadata cache lookup throughput as the number of threads
+// grows, with the cache in a single shard and in the configured number
+// of shards.  Each thread looks up random keys out of a working set that
+// fits the cache, and once in a while updates one, roughly what the
+// frontends do with user and bucket info.  The per shard perf counters
+// are dumped at the end.
+//
+//   ceph_test_rgw_cache_bench [max_threads [seconds [keys [put_permille]]]]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/ceph_argparse.h"
+#include "common/Formatter.h"
+#include "global/global_context.h"
+#include "global/global_init.h"
+#include "rgw/rgw_cache.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+uint64_t run(ObjectCache& cache, int keys, int put_permille, int seed,
+	     const std::atomic<bool>& stop)
+{
+  std::mt19937 rng(seed);
+  uint64_t ops = 0;
+  ObjectCacheInfo info;
+  while (!stop) {
+    auto name = "bucket.instance:" + std::to_string(rng() % keys);
+    if ((int)(rng() % 1000) < put_permille) {
+      ObjectCacheInfo update;
+      update.flags = CACHE_FLAG_DATA | CACHE_FLAG_XATTRS;
+      update.data.append(name);
+      cache.put(name, update, nullptr);
+    } else {
+      cache.get(name, info, CACHE_FLAG_DATA, nullptr);
+    }
+    ++ops;
+  }
+  return ops;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  std::vector<const char*> args;
+  auto cct = global_init(nullptr, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  int max_threads = argc > 1 ? atoi(argv[1]) : 64;
+  int seconds = argc > 2 ? atoi(argv[2]) : 5;
+  int keys = argc > 3 ? atoi(argv[3]) : 5000;
+  int put_permille = argc > 4 ? atoi(argv[4]) : 1;
+
+  auto& conf = g_ceph_context->_conf;
+  auto num_shards = conf.get_val<uint64_t>("rgw_cache_shards");
+  std::cout << "shards\tthreads\tops/sec" << std::endl;
+  for (auto shards : {uint64_t(1), num_shards}) {
+    conf.set_val_or_die("rgw_cache_shards", std::to_string(shards));
+    ObjectCache cache;
+    cache.set_ctx(g_ceph_context);
+    cache.set_enabled(true);
+    for (int i = 0; i < keys; ++i) {
+      ObjectCacheInfo info;
+      info.flags = CACHE_FLAG_DATA;
+      cache.put("bucket.instance:" + std::to_string(i), info, nullptr);
+    }
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+      std::atomic<bool> stop = false;
+      std::atomic<uint64_t> total = 0;
+      std::vector<std::thread> workers;
+      auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < threads; t++) {
+	workers.emplace_back([&, t] {
+	  total += run(cache, keys, put_permille, t, stop);
+	});
+      }
+      std::this_thread::sleep_for(seconds * 1s);
+      stop = true;
+      for (auto& w : workers) {
+	w.join();
+      }
+      std::chrono::duration<double> elapsed =
+	std::chrono::steady_clock::now() - start;
+      std::cout << cache.get_num_shards() << "\t" << threads << "\t"
+		<< (uint64_t)(total / elapsed.count()) << std::endl;
+    }
+
+    JSONFormatter f(true);
+    g_ceph_context->get_perfcounters_collection()->dump_formatted(
+      &f, false, "rgw_cache");
+    f.flush(std::cout);
+    std::cout << std::endl;
+  }
+  return 0;
+}
@@ -2,6 +2,8 @@
 // vim: ts=8 sw=2 smarttab
 #include "gtest/gtest.h"
 
+#include <boost/asio/thread_pool.hpp>
+
 #include "rgw/rgw_compression.h"
 
 class ut_get_sink : public RGWGetObj_Filter {
@@ -184,3 +186,70 @@ TEST(Compress, BillionZeros)
 
   ASSERT_EQ(d_sink.get_sink().length() , size*1000);
 }
+
+TEST(Compress, Pipelined)
+{
+  CompressorRef plugin;
+  plugin = Compressor::create(g_ceph_context, Compressor::COMP_ALG_ZLIB);
+  ASSERT_NE(plugin.get(), nullptr);
+
+  constexpr size_t size = 100000;
+  constexpr int parts = 64;
+  std::vector<bufferlist> data(parts);
+  for (int i = 0; i < parts; i++) {
+    std::string s(size, 'a' + i % 26);
+    for (size_t j = 0; j < size; j += 97) {
+      s[j] = 'A' + (i * j) % 26;
+    }
+    data[i].append(s);
+  }
+
+  ut_put_sink inline_sink;
+  RGWPutObj_Compress inline_compressor(g_ceph_context, plugin, &inline_sink);
+  for (int i = 0; i < parts; i++) {
+    ASSERT_EQ(0, inline_compressor.process(bufferlist{data[i]}, size*i));
+  }
+  ASSERT_EQ(0, inline_compressor.process({}, size*parts));
+
+  // transforms on the pool finish in any order; the output must be the
+  // same as without it
+  boost::asio::thread_pool pool(4);
+  ut_put_sink c_sink;
+  RGWPutObj_Compress compressor(g_ceph_context, plugin, &c_sink, &pool);
+  for (int i = 0; i < parts; i++) {
+    ASSERT_EQ(0, compressor.process(bufferlist{data[i]}, size*i));
+  }
+  ASSERT_EQ(0, compressor.process({}, size*parts));
+
+  ASSERT_TRUE(compressor.is_compressed());
+  ASSERT_TRUE(c_sink.get_sink().contents_equal(inline_sink.get_sink()));
+  auto& blocks = compressor.get_compression_blocks();
+  auto& inline_blocks = inline_compressor.get_compression_blocks();
+  ASSERT_EQ(inline_blocks.size(), blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    EXPECT_EQ(inline_blocks[i].old_ofs, blocks[i].old_ofs);
+    EXPECT_EQ(inline_blocks[i].new_ofs, blocks[i].new_ofs);
+    EXPECT_EQ(inline_blocks[i].len, blocks[i].len);
+  }
+
+  RGWCompressionInfo cs_info;
+  cs_info.compression_type = plugin->get_type_name();
+  cs_info.orig_size = size*parts;
+  cs_info.compressor_message = compressor.get_compressor_message();
+  cs_info.blocks = move(blocks);
+
+  ut_get_sink d_sink;
+  RGWGetObj_Decompress decompress(g_ceph_context, &cs_info, false, &d_sink);
+  off_t f_begin = 0;
+  off_t f_end = size*parts - 1;
+  decompress.fixup_range(f_begin, f_end);
+  decompress.handle_data(c_sink.get_sink(), 0, c_sink.get_sink().length());
+  bufferlist empty;
+  decompress.handle_data(empty, 0, 0);
+
+  bufferlist expected;
+  for (auto& bl : data) {
+    expected.append(bl);
+  }
+  ASSERT_TRUE(d_sink.get_sink().contents_equal(expected));
+}
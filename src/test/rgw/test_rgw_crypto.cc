@@ -12,6 +12,7 @@
  *
  */
 #include <iostream>
+#include <boost/asio/thread_pool.hpp>
 #include "global/global_init.h"
 #include "common/ceph_argparse.h"
 #include "rgw/rgw_common.h"
@@ -746,6 +747,62 @@ TEST(TestRGWCrypto, verify_RGWPutObj_BlockEncrypt_chunks)
 }
 
 
+TEST(TestRGWCrypto, verify_RGWPutObj_BlockEncrypt_pipelined)
+{
+  const off_t test_size = 4*1024*1024 + 1234;
+  bufferptr buf(test_size);
+  char* p = buf.c_str();
+  for(size_t i = 0; i < buf.length(); i++)
+    p[i] = i + i*i + (i >> 2);
+
+  bufferlist input;
+  input.append(buf);
+
+  uint8_t key[32];
+  for(size_t i=0;i<sizeof(key);i++)
+    key[i] = i;
+
+  // the chunks are encrypted on the pool, possibly out of order, but
+  // must reach the sink in order
+  boost::asio::thread_pool pool(4);
+  ut_put_sink put_sink;
+  auto cbc = AES_256_CBC_create(g_ceph_context, &key[0], 32);
+  ASSERT_NE(cbc.get(), nullptr);
+  RGWPutObj_BlockEncrypt encrypt(g_ceph_context, &put_sink,
+                                 std::move(cbc), &pool);
+
+  off_t pos = 0;
+  do
+  {
+    off_t size = 2 << ((pos * 17 + pos / 113) % 18);
+    size = (pos + 1117) * (pos + 2229) % size + 1;
+    if (pos + size > test_size)
+      size = test_size - pos;
+
+    bufferlist bl;
+    bl.append(input.c_str()+pos, size);
+    ASSERT_EQ(0, encrypt.process(std::move(bl), pos));
+
+    pos = pos + size;
+  } while (pos < test_size);
+  ASSERT_EQ(0, encrypt.process({}, pos));
+
+  ASSERT_EQ(put_sink.get_sink().length(), static_cast<size_t>(test_size));
+
+  cbc = AES_256_CBC_create(g_ceph_context, &key[0], 32);
+  ASSERT_NE(cbc.get(), nullptr);
+
+  bufferlist encrypted;
+  bufferlist decrypted;
+  encrypted.append(put_sink.get_sink());
+  ASSERT_TRUE(cbc->decrypt(encrypted, 0, test_size, decrypted, 0));
+
+  ASSERT_EQ(decrypted.length(), test_size);
+  ASSERT_EQ(std::string_view(decrypted.c_str(), test_size),
+            std::string_view(input.c_str(), test_size));
+}
+
+
 TEST(TestRGWCrypto, verify_Encrypt_Decrypt)
 {
   uint8_t key[32];
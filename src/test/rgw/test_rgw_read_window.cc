@@ -0,0 +1,107 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_aio_throttle.h"
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace rgw {
+
+constexpr uint64_t MB = 1 << 20;
+
+TEST(WindowBudget, TryReserve)
+{
+  WindowBudget budget;
+  EXPECT_EQ(10u, budget.try_reserve(10, 16));
+  EXPECT_EQ(6u, budget.try_reserve(10, 16));
+  EXPECT_EQ(0u, budget.try_reserve(10, 16));
+  budget.reserve(4); // the limit doesn't apply
+  EXPECT_EQ(20u, budget.get_used());
+  EXPECT_EQ(0u, budget.try_reserve(1, 16));
+  EXPECT_EQ(10u, budget.try_reserve(10, 0));
+  budget.release(30);
+  EXPECT_EQ(0u, budget.get_used());
+}
+
+TEST(AdaptiveReadWindow, InitialWithinBounds)
+{
+  WindowBudget budget;
+  {
+    AdaptiveReadWindow w(budget, 0, 4 * MB, 16 * MB, 64 * MB);
+    EXPECT_EQ(16 * MB, w.get());
+    EXPECT_EQ(16 * MB, budget.get_used());
+    AdaptiveReadWindow small(budget, 0, 4 * MB, 1 * MB, 64 * MB);
+    EXPECT_EQ(4 * MB, small.get());
+  }
+  EXPECT_EQ(0u, budget.get_used());
+}
+
+TEST(AdaptiveReadWindow, FastClientGrows)
+{
+  WindowBudget budget;
+  AdaptiveReadWindow w(budget, 0, 4 * MB, 16 * MB, 64 * MB);
+  // 100ms to the osds and a client taking 1GB/s
+  w.add_read_latency(100ms);
+  for (int i = 0; i < 10; ++i) {
+    w.add_client_write(4 * MB, 4ms);
+  }
+  EXPECT_EQ(64 * MB, w.get());
+  EXPECT_EQ(64 * MB, budget.get_used());
+}
+
+TEST(AdaptiveReadWindow, SlowClientShrinks)
+{
+  WindowBudget budget;
+  AdaptiveReadWindow w(budget, 0, 4 * MB, 16 * MB, 64 * MB);
+  // 10ms to the osds and a client taking 10MB/s
+  w.add_read_latency(10ms);
+  for (int i = 0; i < 10; ++i) {
+    w.add_client_write(4 * MB, 400ms);
+  }
+  EXPECT_EQ(4 * MB, w.get());
+  EXPECT_EQ(4 * MB, budget.get_used());
+
+  // the client speeds up
+  for (int i = 0; i < 20; ++i) {
+    w.add_client_write(4 * MB, 10ms);
+  }
+  EXPECT_GT(w.get(), 4 * MB);
+  EXPECT_LT(w.get(), 16 * MB);
+}
+
+TEST(AdaptiveReadWindow, SharedBudget)
+{
+  WindowBudget budget;
+  const uint64_t limit = 40 * MB;
+  AdaptiveReadWindow a(budget, limit, 4 * MB, 16 * MB, 64 * MB);
+  AdaptiveReadWindow b(budget, limit, 4 * MB, 16 * MB, 64 * MB);
+  EXPECT_EQ(32 * MB, budget.get_used());
+  for (auto w : {&a, &b}) {
+    w->add_read_latency(100ms);
+    w->add_client_write(4 * MB, 4ms);
+  }
+  // a got what was left, b has to keep its window
+  EXPECT_EQ(24 * MB, a.get());
+  EXPECT_EQ(16 * MB, b.get());
+  EXPECT_EQ(limit, budget.get_used());
+
+  // past the budget, a new read still gets the minimum
+  {
+    AdaptiveReadWindow c(budget, limit, 4 * MB, 16 * MB, 64 * MB);
+    EXPECT_EQ(4 * MB, c.get());
+    EXPECT_EQ(limit + 4 * MB, budget.get_used());
+  }
+  EXPECT_EQ(limit, budget.get_used());
+}
+
+} // namespace rgw
@@ -650,6 +650,9 @@ int do_trim_pg_log(ObjectStore *store, const coll_t &coll,
   size_t trim_at_once = g_ceph_context->_conf->osd_pg_log_trim_max;
   eversion_t new_tail;
   bool done = false;
+  // entries under their own keys sort before the chunk keys of a chunked
+  // log, so once they are past trim_to the older chunks are still due
+  bool chunks_only = false;
 
   while (!done) {
     // gather keys so we can delete them in a batch without
@@ -659,7 +662,15 @@ int do_trim_pg_log(ObjectStore *store, const coll_t &coll,
     ObjectMap::ObjectMapIterator p = store->get_omap_iterator(ch, oid);
     if (!p)
       break;
-    for (p->seek_to_first(); p->valid(); p->next()) {
+    if (chunks_only)
+      p->lower_bound("chunk_");
+    else
+      p->seek_to_first();
+    for (; p->valid(); p->next()) {
+      if (chunks_only && p->key().substr(0, 6) != string("chunk_")) {
+	done = true;
+	break;
+      }
       if (p->key()[0] == '_')
 	continue;
       if (p->key() == "can_rollback_to")
@@ -674,9 +685,37 @@ int do_trim_pg_log(ObjectStore *store, const coll_t &coll,
 	continue;
       if (p->key().substr(0, 4) == string("dup_"))
 	continue;
+      if (p->key() == "log_chunk_entries")
+	continue;
 
       bufferlist bl = p->value();
       auto bp = bl.cbegin();
+      if (p->key().substr(0, 6) == string("chunk_")) {
+	// a chunk goes once all of its entries are trimmed; the new tail
+	// hides the trimmed part of the one it stops in
+	std::list<pg_log_entry_t> chunk;
+	try {
+	  PGLog::decode_log_chunk(bp, eversion_t(), &chunk);
+	} catch (const buffer::error &e) {
+	  cerr << "Error reading pg log chunk: " << e.what() << std::endl;
+	}
+	for (auto& e : chunk) {
+	  if (debug) {
+	    cerr << "read entry " << e << std::endl;
+	  }
+	  if (e.version.version > trim_to) {
+	    done = true;
+	    break;
+	  }
+	  new_tail = std::max(new_tail, e.version);
+	}
+	if (done)
+	  break;
+	keys_to_trim.insert(p->key());
+	if (keys_to_trim.size() >= trim_at_once)
+	  break;
+	continue;
+      }
       pg_log_entry_t e;
       try {
 	e.decode_with_checksum(bp);
@@ -687,7 +726,7 @@ int do_trim_pg_log(ObjectStore *store, const coll_t &coll,
 	cerr << "read entry " << e << std::endl;
       }
       if (e.version.version > trim_to) {
-	done = true;
+	chunks_only = true;
 	break;
       }
       keys_to_trim.insert(p->key());
@@ -208,6 +208,8 @@ void usage()
   cout << "      [--simulate]       simulate placements using a random\n";
   cout << "                         number generator in place of the CRUSH\n";
   cout << "                         algorithm\n";
+  cout << "   -i mapfn --benchmark  time the mapping of the --test inputs and\n";
+  cout << "                         report mappings/sec\n";
   cout << "   --show-utilization    show OSD usage\n";
   cout << "   --show-utilization-all\n";
   cout << "                         include zero weight items\n";
@@ -385,6 +387,7 @@ int main(int argc, const char **argv)
   bool check = false;
   int max_id = -1;
   bool test = false;
+  bool benchmark = false;
   bool display = false;
   bool tree = false;
   bool bucket_tree = false;
@@ -534,6 +537,8 @@ int main(int argc, const char **argv)
       check = true;
     } else if (ceph_argparse_flag(args, i, "-t", "--test", (char*)NULL)) {
       test = true;
+    } else if (ceph_argparse_flag(args, i, "--benchmark", (char*)NULL)) {
+      benchmark = true;
     } else if (ceph_argparse_witharg(args, i, &full_location, err, "--show-location", (char*)NULL)) {
     } else if (ceph_argparse_flag(args, i, "-s", "--simulate", (char*)NULL)) {
       tester.set_random_placement();
@@ -834,7 +839,7 @@ int main(int argc, const char **argv)
     cerr << "cannot specify more than one of compile, decompile, and build" << std::endl;
     return EXIT_FAILURE;
   }
-  if (!check && !compile && !decompile && !build && !test && !reweight && !adjust && !tree && !dump &&
+  if (!check && !compile && !decompile && !build && !test && !benchmark && !reweight && !adjust && !tree && !dump &&
       add_item < 0 && !add_bucket && !move_item && !add_rule && !del_rule && full_location < 0 &&
       !bucket_tree &&
       !reclassify && !rebuild_class_roots &&
@@ -1278,6 +1283,12 @@ int main(int argc, const char **argv)
       return EXIT_FAILURE;
   }
 
+  if (benchmark) {
+    int r = tester.benchmark();
+    if (r < 0)
+      return EXIT_FAILURE;
+  }
+
   if (compare.size()) {
     CrushWrapper crush2;
     bufferlist in;
@@ -66,6 +66,8 @@ void usage()
   cout << "   --test-crush [--range-first <first> --range-last <last>] map pgs to acting osds" << std::endl;
   cout << "   --adjust-crush-weight <osdid:weight>[,<osdid:weight>,<...>] change <osdid> CRUSH <weight> (but do not persist)" << std::endl;
   cout << "   --save                  write modified osdmap with upmap or crush-adjust changes" << std::endl;
+  cout << "   --test-map-sharing <epochs> compare the memory used by a cache of <epochs>" << std::endl;
+  cout << "                           maps built from incrementals with and without sharing" << std::endl;
   exit(1);
 }
 
@@ -100,6 +102,64 @@ void print_inc_upmaps(const OSDMap::Incremental& pending_inc, int fd)
   }
 }
 
+void test_map_sharing(const OSDMap& osdmap, int epochs)
+{
+  // a stream of typical incrementals: up_thru, in/out and pg_temp churn
+  vector<OSDMap::Incremental> incs;
+  int max_osd = osdmap.get_max_osd();
+  for (int i = 0; i < epochs; i++) {
+    OSDMap::Incremental inc(osdmap.get_epoch() + i + 1);
+    inc.fsid = osdmap.get_fsid();
+    for (int j = 0; j < 4; j++) {
+      int osd = ceph::util::generate_random_number(0, max_osd - 1);
+      inc.new_up_thru[osd] = inc.epoch;
+    }
+    if (i % 8 == 0) {
+      int osd = ceph::util::generate_random_number(0, max_osd - 1);
+      inc.new_weight[osd] = (i / 8) % 2 ? CEPH_OSD_IN : CEPH_OSD_OUT;
+    }
+    for (auto& p : osdmap.get_pools()) {
+      pg_t pgid(ceph::util::generate_random_number(0u, p.second.get_pg_num() - 1),
+		p.first);
+      inc.new_pg_temp[pgid] = { ceph::util::generate_random_number(0, max_osd - 1) };
+    }
+    incs.push_back(std::move(inc));
+  }
+
+  // keep all the maps around, as the osd map cache does
+  auto build = [&](bool share) {
+    size_t before = mempool::osdmap::allocated_bytes();
+    std::list<std::unique_ptr<OSDMap>> maps;
+    const OSDMap *prev = &osdmap;
+    for (auto& inc : incs) {
+      auto o = std::make_unique<OSDMap>();
+      if (share) {
+	o->deepish_copy_from(*prev);
+      } else {
+	bufferlist bl;
+	prev->encode(bl, CEPH_FEATURES_SUPPORTED_DEFAULT | CEPH_FEATURE_RESERVED);
+	o->decode(bl);
+      }
+      int r = o->apply_incremental(inc);
+      ceph_assert(r == 0);
+      prev = o.get();
+      maps.push_back(std::move(o));
+    }
+    return mempool::osdmap::allocated_bytes() - before;
+  };
+  size_t decoded = build(false);
+  size_t shared = build(true);
+  cout << "osdmap mempool bytes for " << epochs << " maps of "
+       << max_osd << " osds:" << std::endl;
+  cout << "  decoded: " << decoded << " (" << decoded / epochs << " per map)"
+       << std::endl;
+  cout << "  shared:  " << shared << " (" << shared / epochs << " per map)"
+       << std::endl;
+  if (shared) {
+    cout << "  reduction: " << (double)decoded / shared << "x" << std::endl;
+  }
+}
+
 int main(int argc, const char **argv)
 {
   vector<const char*> args;
@@ -158,6 +218,7 @@ int main(int argc, const char **argv)
   int64_t pg_num = -1;
   bool test_map_pgs_dump_all = false;
   bool save = false;
+  int test_sharing_epochs = 0;
 
   std::string val;
   std::ostringstream err;
@@ -261,6 +322,11 @@ int main(int argc, const char **argv)
       adjust_crush_weight = val;
     } else if (ceph_argparse_flag(args, i, "--save", (char*)NULL)) {
       save = true;
+    } else if (ceph_argparse_witharg(args, i, &test_sharing_epochs, err, "--test-map-sharing", (char*)NULL)) {
+      if (!err.str().empty()) {
+	cerr << err.str() << std::endl;
+	exit(EXIT_FAILURE);
+      }
     } else {
       ++i;
     }
@@ -784,11 +850,20 @@ skip_upmap:
     }
   }
 
+  if (test_sharing_epochs > 0) {
+    if (osdmap.get_max_osd() < 1) {
+      cerr << me << ": map has no osds" << std::endl;
+      exit(1);
+    }
+    test_map_sharing(osdmap, test_sharing_epochs);
+  }
+
   if (!print && !health && !tree && !modified &&
       export_crush.empty() && import_crush.empty() && 
       test_map_pg.empty() && test_map_object.empty() &&
       !test_map_pgs && !test_map_pgs_dump && !test_map_pgs_dump_all &&
-      adjust_crush_weight.empty() && !upmap && !upmap_cleanup) {
+      adjust_crush_weight.empty() && !upmap && !upmap_cleanup &&
+      test_sharing_epochs <= 0) {
     cerr << me << ": no action specified?" << std::endl;
     usage();
   }